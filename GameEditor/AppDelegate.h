@@ -32,5 +32,9 @@
 
 @property (assign) IBOutlet NSWindow *window;
 @property (assign) IBOutlet SKView *skView;
+@property (readonly) NSTimeInterval selectionUpdateDuration;
+@property (readonly) NSTimeInterval selectionPaintDuration;
+@property (readonly) NSTimeInterval startupDuration;
+@property (readonly) NSTimeInterval exportDuration;
 
 @end
@@ -27,11 +27,22 @@
 #import "InspectorTableView.h"
 #import "LibraryView.h"
 #import <SceneKit/SceneKit.h>
+#import <stdatomic.h>
 #import "LuaContext.h"
 #import "LuaExport.h"
 #import "UserDataView.h"
 #import "ValueTransformers.h"
 #import "NSBundle+ProxyBundle.h"
+#import "AttributeSchema.h"
+#import "SceneArchive.h"
+#import "ThumbnailService.h"
+#import "FileWatcher.h"
+#import "ShaderRegistry.h"
+#import "TextureRegistry.h"
+#import "ScriptContextPool.h"
+#import "ScriptExporter.h"
+#import "NodeClipboard.h"
+#import "EmitterPrewarmer.h"
 
 #pragma mark Main Window
 
@@ -110,7 +121,6 @@
 	NSBundle *_sceneBundle;
 	NSString *_sceneBundlePath;
 	NSArray *_exportedClasses;
-	LuaContext *_sharedScriptingContext;
 	NSPropertyListFormat _sceneFormat;
 	NSMutableArray *_objectLibraryItems;
 	NSMutableArray *_mediaLibraryItems;
@@ -119,11 +129,27 @@
 	NSMutableArray *_objectLibraryContext;
 	NSMutableArray *_mediaLibraryContext;
 	NSMutableDictionary *_inspectorViewExpansionInfo;
+	dispatch_queue_t _selectionQueue;
+	_Atomic(NSUInteger) _selectionGeneration;
+	NSTimeInterval _selectionUpdateDuration;
+	NSTimeInterval _selectionPaintDuration;
+	NSTimeInterval _startupDuration;
+	NSProgressIndicator *_saveProgressIndicator;
+	ThumbnailService *_thumbnailService;
+	EmitterPrewarmer *_emitterPrewarmer;
+	FileWatcher *_mediaLibraryWatcher;
+	NSMutableDictionary *_mediaLibraryItemsByName;
+	NSMutableDictionary *_mediaLibraryFilesByName;
+	BOOL _mediaLibraryScanned;
+	NSUInteger _pendingThumbnailLoadCount;
+	ScriptContextPool *_scriptContextPool;
 }
 
 @synthesize window = _window;
 
 - (void)applicationDidFinishLaunching:(NSNotification *)aNotification {
+	CFAbsoluteTime startupTime = CFAbsoluteTimeGetCurrent();
+
 	/* Sprite Kit applies additional optimizations to improve rendering performance */
 	self.skView.ignoresSiblingOrder = YES;
 
@@ -158,6 +184,7 @@
 	/* Setup the attributes inspector */
 	[_inspectorTabView selectTabViewItemAtIndex:_inspectorTabButtons.selectedColumn];
 	_inspectorViewExpansionInfo = [NSMutableDictionary dictionary];
+	_selectionQueue = dispatch_queue_create("developer.GameEditor.selection", DISPATCH_QUEUE_SERIAL);
 
 	/* Setup the library */
 	[_libraryTabView selectTabViewItemAtIndex:_libraryTabButtons.selectedColumn];
@@ -167,10 +194,6 @@
 	_mediaSelectedLibraryItem = NSNotFound;
 	_objectLibraryCollectionView.mode = _objectLibraryModeButton.state ? LibraryViewModeIcons : LibraryViewModeList;
 	_mediaLibraryCollectionView.mode = _mediaLibraryModeButton.state ? LibraryViewModeIcons : LibraryViewModeList;
-	[self populateObjectLibrary];
-
-	/* Initialize the scripting support */
-	_sharedScriptingContext = [LuaContext new];
 
 	/* Cache the exported classes */
 	_exportedClasses = @[[SKColor class],
@@ -182,12 +205,28 @@
 						 [SKShapeNode class],
 						 [SKLabelNode class],
 						 [SKFieldNode class]];
+	NSMutableDictionary *scriptingGlobals = [NSMutableDictionary dictionary];
 	for (Class class in _exportedClasses) {
-		[self exportClass:class toContext:_sharedScriptingContext];
+		scriptingGlobals[[class className]] = class;
 	}
 
+	/* The classes are exported to Lua in the background, when the library scripts are parsed */
+	_scriptContextPool = [[ScriptContextPool alloc] initWithGlobals:scriptingGlobals];
+	[self populateObjectLibrary];
+
 	/* Set focus on the editor view */
 	[[self window] makeFirstResponder:_editorView];
+
+	_startupDuration = CFAbsoluteTimeGetCurrent() - startupTime;
+	if ([[NSUserDefaults standardUserDefaults] boolForKey:@"LogStartupTimings"]) {
+		NSLog(@"Launched in %.1f ms with %lu classes available to Lua", _startupDuration * 1000.0, (unsigned long)_exportedClasses.count);
+
+		/* The classes are exported once the library scripts queued at launch are prepared */
+		[_scriptContextPool performWhenPrewarmed:^{
+			ScriptExporter *exporter = [ScriptExporter sharedExporter];
+			NSLog(@"Exported %lu classes to Lua in %.1f ms", (unsigned long)exporter.exportedClassCount, exporter.exportDuration * 1000.0);
+		}];
+	}
 }
 
 - (void)applicationDidBecomeActive:(NSNotification *)notification {
@@ -198,6 +237,11 @@
 	}
 }
 
+- (void)applicationWillTerminate:(NSNotification *)notification {
+	/* Keep the metadata of the classes exported to Lua for the next launch */
+	[[ScriptExporter sharedExporter] saveMetadata];
+}
+
 - (BOOL)applicationShouldTerminateAfterLastWindowClosed:(NSApplication *)sender {
 	return YES;
 }
@@ -210,27 +254,24 @@
 
 		NSMutableArray *expansionInfo = [_navigatorView expansionInfoWithNode:_navigatorTreeController.selectedNodes.firstObject];
 
-		NSData *clipData = [NSKeyedArchiver archivedDataWithRootObject:@[selection, expansionInfo]];
+		NSData *clipData = [NodeClipboard dataWithNode:selection.node expansionInfo:expansionInfo];
 		NSPasteboard *cb = [NSPasteboard generalPasteboard];
 
-		[cb declareTypes:[NSArray arrayWithObjects:@"public.binary", nil] owner:self];
-		[cb setData:clipData forType:@"public.binary"];
+		[cb declareTypes:[NSArray arrayWithObjects:NodeClipboardType, nil] owner:self];
+		[cb setData:clipData forType:NodeClipboardType];
 	}
 }
 
 - (IBAction)paste:(id)sender {
 	NSPasteboard *cb = [NSPasteboard generalPasteboard];
-	NSString *type = [cb availableTypeFromArray:[NSArray arrayWithObjects:@"public.binary", nil]];
+	NSString *type = [cb availableTypeFromArray:[NSArray arrayWithObjects:NodeClipboardType, nil]];
 
 	if (type) {
-		NSData *clipData = [cb dataForType:type];
-		id object = [NSKeyedUnarchiver unarchiveObjectWithData:clipData];
-		NSIndexPath *insertionIndexPath = nil;
-
 		NSIndexPath *selectionIndexPath = _navigatorTreeController.selectionIndexPath;
 
 #if 0
 		/* Insert as sibling */
+		NSIndexPath *insertionIndexPath = nil;
 		if (selectionIndexPath.length > 1) {
 			/* IndexPath as a sibling of the selected node */
 			NSInteger index = [selectionIndexPath indexAtPosition:selectionIndexPath.length - 1];
@@ -240,15 +281,50 @@
 			NSInteger numberOfChildren = [_navigatorTreeController.selectedNodes.firstObject childNodes].count;
 			insertionIndexPath = [selectionIndexPath indexPathByAddingIndex:numberOfChildren];
 		}
+		[self insertNodesWithClipboardData:[cb dataForType:type] count:1 atIndexPath:insertionIndexPath];
 #else
 		/* Insert as child */
-		insertionIndexPath = [selectionIndexPath indexPathByAddingIndex:0];
+		[self insertNodesWithClipboardData:[cb dataForType:type] count:1 atIndexPath:[selectionIndexPath indexPathByAddingIndex:0]];
 #endif
+	}
+}
+
+- (IBAction)duplicate:(id)sender {
+	NavigationNode *selection = _navigatorTreeController.selectedObjects.firstObject;
+	if (selection && selection.node.parent) {
+		NSMutableArray *expansionInfo = [_navigatorView expansionInfoWithNode:_navigatorTreeController.selectedNodes.firstObject];
+		NSData *clipData = [NodeClipboard dataWithNode:selection.node expansionInfo:expansionInfo];
 
-		[self insertObject:object atIndexPath:insertionIndexPath];
+		/* The copies go after the selected node, as many as the DuplicateCount default says */
+		NSUInteger count = MAX(1, [[NSUserDefaults standardUserDefaults] integerForKey:@"DuplicateCount"]);
+		NSIndexPath *selectionIndexPath = _navigatorTreeController.selectionIndexPath;
+		NSUInteger index = [selectionIndexPath indexAtPosition:selectionIndexPath.length - 1];
+		[self insertNodesWithClipboardData:clipData count:count atIndexPath:[[selectionIndexPath indexPathByRemovingLastIndex] indexPathByAddingIndex:index + 1]];
 	}
 }
 
+- (void)insertNodesWithClipboardData:(NSData *)clipData count:(NSUInteger)count atIndexPath:(NSIndexPath *)indexPath {
+	id expansionInfo = nil;
+	NSError *error = nil;
+	NSArray *nodes = [NodeClipboard nodesWithData:clipData count:count expansionInfo:&expansionInfo error:&error];
+	if (!nodes) {
+		[NSApp presentError:error modalForWindow:self.window delegate:nil didPresentSelector:nil contextInfo:NULL];
+		return;
+	}
+
+	/* The navigation nodes of the pasted descendants are created when the navigator shows them */
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:nodes.count];
+	NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:nodes.count];
+	NSIndexPath *parentIndexPath = [indexPath indexPathByRemovingLastIndex];
+	NSUInteger index = [indexPath indexAtPosition:indexPath.length - 1];
+	for (SKNode *node in nodes) {
+		[objects addObject:@[[NavigationNode navigationNodeWithNode:node], expansionInfo ?: [NSMutableArray array]]];
+		[indexPaths addObject:[parentIndexPath indexPathByAddingIndex:index++]];
+	}
+
+	[self insertObjects:objects atIndexPaths:indexPaths];
+}
+
 - (IBAction)delete:(id)sender {
 	NavigationNode *selection = _navigatorTreeController.selectedObjects.firstObject;
 	if (selection && selection.node.parent) {
@@ -261,9 +337,53 @@
 	[self delete:sender];
 }
 
+- (void)insertObjects:(NSArray *)objects atIndexPaths:(NSArray *)indexPaths {
+	if (objects.count == 1) {
+		[self insertObject:objects[0] atIndexPath:indexPaths[0]];
+		return;
+	}
+
+	/* A single undo entry and a single update of the navigator for all the objects */
+	NSMutableArray *navigationNodes = [NSMutableArray arrayWithCapacity:objects.count];
+	for (NSArray *object in objects) {
+		[navigationNodes addObject:object[0]];
+	}
+
+	[[self.window.undoManager prepareWithInvocationTarget:self] removeObjectsAtIndexPaths:indexPaths];
+	[_navigatorTreeController insertObjects:navigationNodes atArrangedObjectIndexPaths:indexPaths];
+
+	[objects enumerateObjectsUsingBlock:^(NSArray *object, NSUInteger index, BOOL *stop) {
+		[_editorView updateIndexForNode:[object[0] node]];
+		[_navigatorView expandNode:[_navigatorTreeController.arrangedObjects descendantNodeAtIndexPath:indexPaths[index]] withInfo:object[1]];
+	}];
+}
+
+- (void)removeObjectsAtIndexPaths:(NSArray *)indexPaths {
+	if (indexPaths.count == 1) {
+		[self removeObjectAtIndexPath:indexPaths[0]];
+		return;
+	}
+
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:indexPaths.count];
+	for (NSIndexPath *indexPath in indexPaths) {
+		NSTreeNode *treeNode = [_navigatorTreeController.arrangedObjects descendantNodeAtIndexPath:indexPath];
+		[objects addObject:@[treeNode.representedObject, [_navigatorView expansionInfoWithNode:treeNode]]];
+	}
+
+	/* Make the current selection to be the parent of the removed nodes */
+	[_editorView setNode:[objects.firstObject[0] node].parent];
+
+	[[self.window.undoManager prepareWithInvocationTarget:self] insertObjects:objects atIndexPaths:indexPaths];
+	for (NSArray *object in objects) {
+		[_editorView removeIndexForNode:[object[0] node]];
+	}
+	[_navigatorTreeController removeObjectsAtArrangedObjectIndexPaths:indexPaths];
+}
+
 - (void)insertObject:(id)object atIndexPath:(NSIndexPath *)indexPath {
 	[[self.window.undoManager prepareWithInvocationTarget:self] removeObjectAtIndexPath:indexPath];
 	[_navigatorTreeController insertObject:object[0] atArrangedObjectIndexPath:indexPath];
+	[_editorView updateIndexForNode:[object[0] node]];
 
 	[_navigatorView expandNode:[_navigatorTreeController.arrangedObjects descendantNodeAtIndexPath:indexPath] withInfo:object[1]];
 }
@@ -277,6 +397,7 @@
 	NSMutableArray *expansionInfo = [_navigatorView expansionInfoWithNode:[_navigatorTreeController.arrangedObjects descendantNodeAtIndexPath:indexPath]];
 
 	[[self.window.undoManager prepareWithInvocationTarget:self] insertObject:@[object, expansionInfo] atIndexPath:indexPath];
+	[_editorView removeIndexForNode:object.node];
 	[_navigatorTreeController removeObjectAtArrangedObjectIndexPath:indexPath];
 }
 
@@ -290,10 +411,17 @@
 	[self updateSelectionWithNode:[object node]];
 }
 
+- (void)navigatorView:(NavigatorView *)navigatorView didMoveObject:(id)object {
+	/* The node's frame in the scene changes with its new parent */
+	[_editorView updateIndexForNode:[object node]];
+}
+
 - (void)updateSelectionWithNode:(id)node {
 	if (_selectedNode == node)
 		return;
 
+	CFAbsoluteTime selectionTime = CFAbsoluteTimeGetCurrent();
+
 	/* Save attributes view position and expansion info */
 	for (id item in [[_nodeInspectorTreeController arrangedObjects] childNodes]) {
 		NSString *name = [[item representedObject] valueForKey:@"name"];
@@ -306,103 +434,48 @@
 
 	/* Save the scroll position*/
 	NSScrollView *nodeScrollView = _nodeInspectorView.enclosingScrollView;
-	CGFloat nodeScrollPosition = nodeScrollView.documentVisibleRect.origin.y;
+	__block CGFloat nodeScrollPosition = nodeScrollView.documentVisibleRect.origin.y;
 
 	_selectedNode = node;
 
 	[_editorView setNode:node];
 
-	// TODO: enable Grand Central Dispatch and add a custom queue to process input events
-#if UPDATE_SELECTION_USING_GCD
-	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-#endif
-		/* Build the tree of attributes in the background thread */
-		NSMutableArray *nodeInspectorContents = [self attributesForAllClassesWithNode:node];
-		NSMutableArray *identityInspectorContents = @[@{@"name": @"Header",
-														@"identifier": @"header",
-														@"isLeaf": @NO,
-														@"isEditable": @NO,
-														@"isCollapsible": @YES,
-														@"children": @[@{@"name": @"Attrinute",
-																		 @"identifier": @"generic attribute",
-																		 @"isLeaf": @YES,
-																		 @"isEditable": @NO
-																		 }.mutableCopy
-																	   ].mutableCopy
-														}.mutableCopy,
-#if 1 // Dummy user data table
-													  @{@"name": @"User Data",
-														@"identifier": @"header",
-														@"isLeaf": @NO,
-														@"isEditable": @NO,
-														@"isCollapsible": @YES,
-														@"children": @[@{@"name": @"userData",
-																		 @"identifier": @"@\"NSMutableDictionary\"",
-																		 @"isLeaf": @NO,
-																		 @"isEditable": @NO,
-																		 @"content": [UserDataDictionary controllerWithNode:_selectedNode]
-																		 }.mutableCopy
-																	   ].mutableCopy
-														}.mutableCopy,
-#endif
-													  @{@"name": @"Header",
-														@"identifier": @"header",
-														@"isLeaf": @NO,
-														@"isEditable": @NO,
-														@"isCollapsible": @YES,
-														@"children": @[@{@"name": @"Attrinute",
-																		 @"identifier": @"generic attribute",
-																		 @"isLeaf": @YES,
-																		 @"isEditable": @NO
-																		 }.mutableCopy
-																	   ].mutableCopy
-														}.mutableCopy,
-													  @{@"name": @"Header",
-														@"identifier": @"header",
-														@"isLeaf": @NO,
-														@"isEditable": @NO,
-														@"isCollapsible": @YES,
-														@"children": @[@{@"name": @"Attrinute",
-																		 @"identifier": @"generic attribute",
-																		 @"isLeaf": @YES,
-																		 @"isEditable": @NO
-																		 }.mutableCopy,
-																	   @{@"name": @"Attrinute",
-																		 @"identifier": @"generic attribute",
-																		 @"isLeaf": @YES,
-																		 @"isEditable": @NO
-																		 }.mutableCopy
-																	   ].mutableCopy
-														}.mutableCopy
-													  ].mutableCopy;
-
-		/* Look up for the row to be selected */
-		NSInteger row = [_navigatorView rowForItem:[self navigationNodeOfObject:node inNodes:[[_navigatorTreeController arrangedObjects] childNodes]]];
-
-#if UPDATE_SELECTION_USING_GCD
+	/* Any build still in progress belongs to a previous selection now */
+	NSUInteger generation = atomic_fetch_add(&_selectionGeneration, 1) + 1;
+
+	/* The node is only read here, the background thread builds from the snapshot */
+	NSDictionary *snapshot = [self attributeSnapshotWithNode:node class:[node class]];
+
+	dispatch_async(_selectionQueue, ^{
+		/* Skip the selections that were replaced while waiting in the queue */
+		if (generation != atomic_load(&_selectionGeneration))
+			return;
+
+		/* Build the tree of attributes in the background thread, the attributes are bound to the node later in the main thread */
+		NSMutableArray *nodeInspectorContents = [self attributesForAllClassesWithNode:node snapshot:snapshot];
+
 		dispatch_async(dispatch_get_main_queue(), ^{
-#endif
+			/* Only the latest selection gets applied */
+			if (generation != atomic_load(&_selectionGeneration))
+				return;
+
+			[self bindAttributes:nodeInspectorContents];
+
+			/* The user data controller normalizes the node's dictionary, so it's created in the main thread */
+			NSMutableArray *identityInspectorContents = [self identityAttributesWithNode:node];
+
 			/* Replace the attributes table */
 			[_nodeInspectorTreeController setContent:nodeInspectorContents];
 			[_identityInspectorTreeController setContent:identityInspectorContents];
 
-			/* Restore attributes view position and expansion info */
-			for (id item in [[_nodeInspectorTreeController arrangedObjects] childNodes]) {
-				NSString *name = [[item representedObject] valueForKey:@"name"];
-				NSNumber *expansionInfo = _inspectorViewExpansionInfo[name];
-				[_nodeInspectorView expandItem:item expandChildren:YES];
-				if (expansionInfo && ![expansionInfo boolValue]) {
-					[_nodeInspectorView collapseItem:item];
-				}
-			}
-			for (id item in [[_identityInspectorTreeController arrangedObjects] childNodes]) {
+			/* Restore attributes view position and expansion info, each inspector lays out its rows once */
+			BOOL (^wasCollapsed)(id) = ^BOOL(id item) {
 				NSString *name = [[item representedObject] valueForKey:@"name"];
 				NSNumber *expansionInfo = _inspectorViewExpansionInfo[name];
-				[_identityInspectorView expandItem:item expandChildren:YES];
-				if (expansionInfo && ![expansionInfo boolValue]) {
-					[_identityInspectorView collapseItem:item];
-				}
-			}
+				return expansionInfo && ![expansionInfo boolValue];
+			};
+			[_nodeInspectorView expandItems:[[_nodeInspectorTreeController arrangedObjects] childNodes] collapsingItemsPassingTest:wasCollapsed];
+			[_identityInspectorView expandItems:[[_identityInspectorTreeController arrangedObjects] childNodes] collapsingItemsPassingTest:wasCollapsed];
 
 			/* Restore the scroll position  */
 			CGFloat nodeScrollContentHeight = [(NSView *)nodeScrollView.documentView frame].size.height;
@@ -414,24 +487,168 @@
 			/* Ask the editor view to repaint the selection */
 			[_editorView setNeedsDisplay:YES];
 
-			/* Update the selection in the navigator view */
+			/* Look up for the row to be selected and update the selection in the navigator view */
+			NSInteger row = [_navigatorView rowForItem:[self navigationNodeOfObject:node]];
 			[_navigatorView selectRowIndexes:[NSIndexSet indexSetWithIndex:row] byExtendingSelection:NO];
-#if UPDATE_SELECTION_USING_GCD
+
+			/* Time from the click to the inspector being ready */
+			_selectionUpdateDuration = CFAbsoluteTimeGetCurrent() - selectionTime;
+			if ([[NSUserDefaults standardUserDefaults] boolForKey:@"LogSelectionUpdateDuration"]) {
+				NSLog(@"Selection of %@ updated in %.1f ms", [node class], _selectionUpdateDuration * 1000.0);
+			}
+
+			/* Time from the click to the inspector showing the node */
+			[_nodeInspectorView performOnNextPaint:^{
+				if (generation != atomic_load(&_selectionGeneration))
+					return;
+				_selectionPaintDuration = CFAbsoluteTimeGetCurrent() - selectionTime;
+				if ([[NSUserDefaults standardUserDefaults] boolForKey:@"LogSelectionUpdateDuration"]) {
+					NSLog(@"Selection of %@ painted in %.1f ms", [node class], _selectionPaintDuration * 1000.0);
+				}
+			}];
 		});
 	});
-#endif
+}
+
+- (NSTimeInterval)selectionUpdateDuration {
+	return _selectionUpdateDuration;
+}
+
+- (NSTimeInterval)selectionPaintDuration {
+	return _selectionPaintDuration;
+}
+
+- (NSTimeInterval)startupDuration {
+	return _startupDuration;
+}
+
+- (NSTimeInterval)exportDuration {
+	return [ScriptExporter sharedExporter].exportDuration;
+}
+
+- (void)bindAttributes:(NSArray *)attributes {
+	/* Bind the attributes built in the background thread, including the ones in nested rows */
+	for (id attribute in attributes) {
+		if ([attribute isKindOfClass:[AttributeNode class]]) {
+			[attribute bindValues];
+			[self bindAttributes:[attribute children]];
+		} else if ([attribute isKindOfClass:[NSDictionary class]]) {
+			/* The uniforms controller writes to the shader and the node, it's created in the main thread */
+			id shader = attribute[@"shader"];
+			if (shader) {
+				attribute[@"content"] = [UserDataUniformsArray controllerWithShader:shader != [NSNull null] ? shader : nil
+																			node:attribute[@"shaderNode"]
+																			 key:attribute[@"shaderKey"]];
+				[attribute removeObjectsForKeys:@[@"shader", @"shaderNode", @"shaderKey"]];
+			}
+			[self bindAttributes:attribute[@"children"]];
+		}
+	}
 }
 
 #pragma mark Attributes creation
 
-- (NSMutableArray *)attributesForAllClassesWithNode:(id)node {
+- (NSMutableArray *)identityAttributesWithNode:(id)node {
+	NSMutableArray *identityInspectorContents = @[@{@"name": @"Header",
+													@"identifier": @"header",
+													@"isLeaf": @NO,
+													@"isEditable": @NO,
+													@"isCollapsible": @YES,
+													@"children": @[@{@"name": @"Attrinute",
+																	 @"identifier": @"generic attribute",
+																	 @"isLeaf": @YES,
+																	 @"isEditable": @NO
+																	 }.mutableCopy
+																   ].mutableCopy
+													}.mutableCopy,
+#if 1 // Dummy user data table
+												  @{@"name": @"User Data",
+													@"identifier": @"header",
+													@"isLeaf": @NO,
+													@"isEditable": @NO,
+													@"isCollapsible": @YES,
+													@"children": @[@{@"name": @"userData",
+																	 @"identifier": @"@\"NSMutableDictionary\"",
+																	 @"isLeaf": @NO,
+																	 @"isEditable": @NO,
+																	 @"content": [UserDataDictionary controllerWithNode:node]
+																	 }.mutableCopy
+																   ].mutableCopy
+													}.mutableCopy,
+#endif
+												  @{@"name": @"Header",
+													@"identifier": @"header",
+													@"isLeaf": @NO,
+													@"isEditable": @NO,
+													@"isCollapsible": @YES,
+													@"children": @[@{@"name": @"Attrinute",
+																	 @"identifier": @"generic attribute",
+																	 @"isLeaf": @YES,
+																	 @"isEditable": @NO
+																	 }.mutableCopy
+																   ].mutableCopy
+													}.mutableCopy,
+												  @{@"name": @"Header",
+													@"identifier": @"header",
+													@"isLeaf": @NO,
+													@"isEditable": @NO,
+													@"isCollapsible": @YES,
+													@"children": @[@{@"name": @"Attrinute",
+																	 @"identifier": @"generic attribute",
+																	 @"isLeaf": @YES,
+																	 @"isEditable": @NO
+																	 }.mutableCopy,
+																   @{@"name": @"Attrinute",
+																	 @"identifier": @"generic attribute",
+																	 @"isLeaf": @YES,
+																	 @"isEditable": @NO
+																	 }.mutableCopy
+																   ].mutableCopy
+													}.mutableCopy
+												  ].mutableCopy;
+
+	return identityInspectorContents;
+}
+
+- (NSDictionary *)attributeSnapshotWithNode:(id)node class:(Class)classType {
+	/* Values of the properties the attributes are built from, nested for the properties with attributes of their own */
+	NSMutableDictionary *values = [NSMutableDictionary dictionary];
+	NSMutableDictionary *snapshots = [NSMutableDictionary dictionary];
+	BOOL isScene = [node isKindOfClass:[SKScene class]];
+
+	for (Class aClass = classType; aClass != nil && aClass != [SKNode superclass] && aClass != [NSObject class]; aClass = [aClass superclass]) {
+		AttributeSchema *schema = [AttributeSchema schemaForClass:aClass];
+		for (AttributeDescriptor *descriptor in isScene ? schema.sceneAttributes : schema.attributes) {
+			switch (descriptor.kind) {
+				case AttributeDescriptorKindPhysicsBody:
+				case AttributeDescriptorKindPhysicsWorld: {
+					id value = [node valueForKey:descriptor.name];
+					values[descriptor.name] = value ?: [NSNull null];
+					snapshots[descriptor.name] = [self attributeSnapshotWithNode:value class:descriptor.propertyClass];
+					break;
+				}
+
+				case AttributeDescriptorKindShader:
+					values[descriptor.name] = [node valueForKey:descriptor.name] ?: [NSNull null];
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+
+	return @{@"class": classType, @"isScene": @(isScene), @"values": values, @"snapshots": snapshots};
+}
+
+- (NSMutableArray *)attributesForAllClassesWithNode:(id)node snapshot:(NSDictionary *)snapshot {
 
 	NSMutableArray *classesArray = [NSMutableArray array];
 
-	Class classType = [node class];
+	Class classType = snapshot[@"class"];
 
 	do {
-		NSMutableArray *attributesArray = [self attributesForClass:classType node:node];
+		NSMutableArray *attributesArray = [self attributesForClass:classType node:node snapshot:snapshot];
 
 		if (attributesArray.count > 0) {
 			[classesArray addObject:@{@"name": [classType description],
@@ -451,353 +668,68 @@
 	return classesArray;
 }
 
-- (NSMutableArray *)attributesForClass:(Class)classType node:(id)node {
-	unsigned int count;
-	objc_property_t *properties = class_copyPropertyList(classType, &count);
-
-	NSMutableArray *attributesArray = [NSMutableArray array];
-
-	BOOL hasZPositionRotation = NO;
-	BOOL hasSpeed = NO;
-	BOOL hasEmissionAngle = NO;
-	BOOL hasLifetime = NO;
-	BOOL hasXYAcceleration = NO;
-	BOOL hasXYScale = NO;
-	BOOL hasXYRotation = NO;
-	BOOL hasParticleZPositionRangeSpeed = NO;
-	BOOL hasParticleScaleRangeSpeed = NO;
-	BOOL hasParticleRotationRangeSpeed = NO;
-	BOOL hasParticleAlphaRangeSpeed = NO;
-	BOOL hasParticleColorBlendFactor = NO;
-	BOOL hasParticleColorRed = NO;
-	BOOL hasParticleColorGreen = NO;
-	BOOL hasParticleColorBlue = NO;
-	BOOL hasParticleColorAlpha = NO;
-
-	if (count) {
-		for (unsigned int i = 0; i < count; i++) {
-			//printf("%s::%s %s\n", [classType description].UTF8String, property_getName(properties[i]), property_getAttributes(properties[i])+1);
-			NSString *propertyAttributes = [NSString stringWithUTF8String:property_getAttributes(properties[i])+1];
-
-			/* Skip read-only attributes that are not class instances */
-			BOOL isReadonlyNonClass = [propertyAttributes rangeOfString:@"^[^@]*,R(,|$)" options:NSRegularExpressionSearch].location != NSNotFound;
-			if (isReadonlyNonClass)
-				continue;
-
-			NSString *propertyName = [NSString stringWithUTF8String:property_getName(properties[i])];
-
-			BOOL isPrivateProperty = [propertyName rangeOfString:@"^_" options:NSRegularExpressionSearch].location != NSNotFound;
-			if (isPrivateProperty)
-				continue;
-
-			NSString *propertyType = [[propertyAttributes componentsSeparatedByString:@","] firstObject];
-
-			if ([node isKindOfClass:[SKScene class]]
-				&& ([propertyName isEqualToString:@"position"]
-					|| [propertyName isEqualToString:@"zPosition"]
-					|| [propertyName isEqualToString:@"zRotation"]
-					|| [propertyName isEqualToString:@"xScale"]
-					|| [propertyName isEqualToString:@"yScale"]
-					|| [propertyName isEqualToString:@"visibleRect"]
-					|| [propertyName isEqualToString:@"visibleRectCenter"]
-					|| [propertyName isEqualToString:@"visibleRectSize"])) {
-				[attributesArray addObject:[AttributeNode attributeForNonEditableValue:propertyName identifier:propertyType]];
-
-			} else if ([propertyName rangeOfString:@"^z(Position|Rotation)$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasZPositionRotation) {
-					AttributeNode *attribute = [AttributeNode attributeWithName:@"z,zPosition,zRotation"
-																		   node:node
-																	 identifier:@"{dd}"
-																	  formatter:@[[NSNumberFormatter integerFormatter],
-																				  [NSNumberFormatter degreesFormatter]]
-															   valueTransformer:@[[NSNull null],
-																				  [DegreesTransformer transformer]]];
-					attribute.labels = @[@"Position", @"Rotation"];
-					[attributesArray addObject:attribute];
-					hasZPositionRotation = YES;
-				}
+- (NSMutableArray *)attributesForClass:(Class)classType node:(id)node snapshot:(NSDictionary *)snapshot {
+	/* The reflection is done once per class, only the binding to the node is done per selection */
+	AttributeSchema *schema = [AttributeSchema schemaForClass:classType];
+	NSArray *descriptors = [snapshot[@"isScene"] boolValue] ? schema.sceneAttributes : schema.attributes;
 
-			} else if ([propertyName rangeOfString:@"^emissionAngle(Range)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasEmissionAngle) {
-					AttributeNode *attribute = [AttributeNode attributeWithName:@"emissionAngle,emissionAngle,emissionAngleRange"
-																		   node:node
-																	 identifier:@"{dd}"
-																	  formatter:[NSNumberFormatter degreesFormatter]
-															   valueTransformer:[DegreesTransformer transformer]];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasEmissionAngle = YES;
-				}
+	NSMutableArray *attributesArray = [NSMutableArray arrayWithCapacity:descriptors.count];
 
-			} else if ([propertyName rangeOfString:@"^particleColorRed(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleColorRed) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"red,particleColorRedSpeed,particleColorRedRange" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasParticleColorRed = YES;
-				}
+	for (AttributeDescriptor *descriptor in descriptors) {
+		NSString *propertyName = descriptor.name;
 
-			} else if ([propertyName rangeOfString:@"^particleColorGreen(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleColorGreen) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"green,particleColorGreenSpeed,particleColorGreenRange" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasParticleColorGreen = YES;
-				}
+		switch (descriptor.kind) {
+			case AttributeDescriptorKindPhysicsBody: {
+				/* Populate the SKPhysicsBody property's attributes */
+				id value = snapshot[@"values"][propertyName];
+				NSMutableArray *attributes = [self attributesForClass:descriptor.propertyClass node:value != [NSNull null] ? value : nil
+															 snapshot:snapshot[@"snapshots"][propertyName]];
 
-			} else if ([propertyName rangeOfString:@"^particleColorBlue(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleColorBlue) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"blue,particleColorBlueSpeed,particleColorBlueRange" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasParticleColorBlue = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleColorAlpha(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleColorAlpha) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"alpha,particleColorAlphaSpeed,particleColorAlphaRange" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasParticleColorAlpha = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleSpeed(Range)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasSpeed) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"speed,particleSpeed,particleSpeedRange" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasSpeed = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleLifetime(Range)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasLifetime) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"lifetime,particleLifetime,particleLifetimeRange" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"Start", @"Range"];
-					[attributesArray addObject:attribute];
-					hasLifetime = YES;
-				}
+				/* Insert the SKNode's body type property in the first row */
+				[attributes insertObject:[AttributeNode attributeWithName:@"bodyType" node:node identifier:@"bodyType"] atIndex:0];
 
-			} else if ([propertyName rangeOfString:@"^(x|y)Acceleration$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasXYAcceleration) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"acceleration,xAcceleration,yAcceleration" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"X", @"Y"];
-					[attributesArray addObject:attribute];
-					hasXYAcceleration = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^(x|y)Scale$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasXYScale) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"scale,xScale,yScale" node:node identifier:@"{dd}"];
-					attribute.labels = @[@"X", @"Y"];
-					[attributesArray addObject:attribute];
-					hasXYScale = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^(x|y)Rotation$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasXYRotation) {
-					AttributeNode *attribute = [AttributeNode attributeWithName:@"rotation,xRotation,yRotation"
-																		   node:node
-																	 identifier:@"{dd}"
-																	  formatter:[NSNumberFormatter degreesFormatter]
-															   valueTransformer:[DegreesTransformer transformer]];
-
-					attribute.labels = @[@"X", @"Y"];
-					[attributesArray addObject:attribute];
-					hasXYRotation = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleZPosition(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleZPositionRangeSpeed) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"zPosition,particleZPosition,particleZPositionRange,particleZPositionSpeed"
-																								node:node
-																						  identifier:@"{ddd}"];
-
-					attribute.labels = @[@"Start", @"Range", @"Speed"];
-					[attributesArray addObject:attribute];
-					hasParticleZPositionRangeSpeed = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleScale(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleScaleRangeSpeed) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"scale,particleScale,particleScaleRange,particleScaleSpeed"
-																								node:node
-																						  identifier:@"{ddd}"];
-
-					attribute.labels = @[@"Start", @"Range", @"Speed"];
-					[attributesArray addObject:attribute];
-					hasParticleScaleRangeSpeed = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleRotation(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleRotationRangeSpeed) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"rotation,particleRotation,particleRotationRange,particleRotationSpeed"
-																								node:node
-																						  identifier:@"{ddd}"];
-
-					attribute.labels = @[@"Start", @"Range", @"Speed"];
-					[attributesArray addObject:attribute];
-					hasParticleRotationRangeSpeed = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleAlpha(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleAlphaRangeSpeed) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"alpha,particleAlpha,particleAlphaRange,particleAlphaSpeed"
-																								node:node
-																						  identifier:@"{ddd}"];
-
-					attribute.labels = @[@"Start", @"Range", @"Speed"];
-					[attributesArray addObject:attribute];
-					hasParticleAlphaRangeSpeed = YES;
-				}
-
-			} else if ([propertyName rangeOfString:@"^particleColorBlendFactor(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				if (!hasParticleColorBlendFactor) {
-					AttributeNode *attribute = [AttributeNode attributeForHighPrecisionValueWithName:@"colorBlendFactor,particleColorBlendFactor,particleColorBlendFactorRange,particleColorBlendFactorSpeed"
-																								node:node
-																						  identifier:@"{ddd}"];
-
-					attribute.labels = @[@"Start", @"Range", @"Speed"];
-					[attributesArray addObject:attribute];
-					hasParticleColorBlendFactor = YES;
-				}
-
-			} else if ([propertyName isEqualToString:@"bodyType"]) {
-				/* Do nothing, the body type will be added with the SKPhysicsNode property */
-
-			} else if ([propertyName rangeOfString:@"[bB]lendMode$" options:NSRegularExpressionSearch].location != NSNotFound) {
-				[attributesArray addObject:[AttributeNode attributeWithName:propertyName node:node identifier:@"blendMode"]];
-
-			} else if ([propertyName isEqualToString:@"scaleMode"]
-					   || [propertyName isEqualToString:@"lineCap"]
-					   || [propertyName isEqualToString:@"lineJoin"]
-					   || [propertyName isEqualToString:@"verticalAlignmentMode"]
-					   || [propertyName isEqualToString:@"horizontalAlignmentMode"]
-					   || [propertyName isEqualToString:@"fontName"]) {
-				[attributesArray addObject:[AttributeNode attributeWithName:propertyName node:node identifier:propertyName]];
-
-			} else {
-
-				Class propertyClass = [propertyType classType];
-
-				if ([propertyType isEqualToEncodedType:@encode(NSMutableDictionary)]) {
-					/* Do nothing, this will be added to the Identity inspector */
-
-				} else if ([propertyType isEqualToEncodedType:@encode(NSString)]) {
-					[attributesArray addObject:[AttributeNode attributeWithName:propertyName node:node identifier:propertyType]];
-
-				} else if ([propertyType isEqualToEncodedType:@encode(NSColor)]) {
-					[attributesArray addObject:[AttributeNode attributeWithName:propertyName node:node identifier:propertyType]];
-
-				} else if (propertyClass == [SKTexture class]) {
-					AttributeNode *attribute = [AttributeNode attributeWithName:propertyName
-																		   node:node
-																	 identifier:propertyType
-																	  formatter:nil
-															   valueTransformer:[TextureTransformer transformer]];
-					[attributesArray addObject:attribute];
-
-				} else if (propertyClass == [SKPhysicsBody class]) {
-					/* Populate the SKPhysicsBody property's attributes */
-					NSMutableArray *attributes = [self attributesForClass:propertyClass node:[node valueForKey:propertyName]];
-					
-					/* Insert the SKNode's body type property in the first row */
-					[attributes insertObject:[AttributeNode attributeWithName:@"bodyType" node:node identifier:@"bodyType"] atIndex:0];
+				/* Add the property's attributes */
+				[attributesArray addObject:[AttributeNode attributeWithName:propertyName node:node identifier:@"expandable" children:attributes]];
+				break;
+			}
 
-					/* Add the property's attributes */
-					[attributesArray addObject:[AttributeNode attributeWithName:propertyName node:node identifier:@"expandable" children:attributes]];
+			case AttributeDescriptorKindPhysicsWorld: {
+				id value = snapshot[@"values"][propertyName];
+				[attributesArray addObject:@{@"name": propertyName,
+											 @"identifier": @"expandable",
+											 @"isLeaf": @NO,
+											 @"isEditable": @NO,
+											 @"children":[self attributesForClass:descriptor.propertyClass node:value != [NSNull null] ? value : nil
+																		 snapshot:snapshot[@"snapshots"][propertyName]]}];
+				break;
+			}
 
-				} else if (propertyClass == [SKShader class]) {
-					AttributeNode *attribute = [AttributeNode attributeWithName:propertyName
-																		   node:node
-																	 identifier:propertyType
-																	  formatter:nil
-															   valueTransformer:[ShaderTransformer transformer]];
-					[attributesArray addObject:attribute];
+			case AttributeDescriptorKindShader:
+				[attributesArray addObject:[descriptor attributeWithNode:node]];
 
 #if 1 // Dummy shader uniforms table
-					[attributesArray addObject:@{@"name": @"Custom Shader Uniforms",
-												 @"identifier": @"header",
-												 @"isLeaf": @NO,
-												 @"isEditable": @NO,
-												 @"isCollapsible": @YES,
-												 @"children": @[@{@"name": @"uniforms",
-																  @"identifier": @"uniforms",
-																  @"isLeaf": @NO,
-																  @"isEditable": @NO,
-																  @"content": [UserDataUniformsArray controllerWithShader:[_selectedNode valueForKey:propertyName]]
-																  }.mutableCopy
-																].mutableCopy
-												 }.mutableCopy];
+				[attributesArray addObject:@{@"name": @"Custom Shader Uniforms",
+											 @"identifier": @"header",
+											 @"isLeaf": @NO,
+											 @"isEditable": @NO,
+											 @"isCollapsible": @YES,
+											 @"children": @[@{@"name": @"uniforms",
+															  @"identifier": @"uniforms",
+															  @"isLeaf": @NO,
+															  @"isEditable": @NO,
+															  @"shader": snapshot[@"values"][propertyName],
+															  @"shaderNode": node,
+															  @"shaderKey": propertyName
+															  }.mutableCopy
+															].mutableCopy
+											 }.mutableCopy];
 #endif
+				break;
 
-
-				} else if (propertyClass == [SKPhysicsWorld class]) {
-					[attributesArray addObject:@{@"name": propertyName,
-												 @"identifier": @"expandable",
-												 @"isLeaf": @NO,
-												 @"isEditable": @NO,
-												 @"children":[self attributesForClass:propertyClass node:[node valueForKey:propertyName]]}];
-
-				} else if ([propertyName rangeOfString:@"rotation" options:NSCaseInsensitiveSearch].location != NSNotFound) {
-					[attributesArray addObject:[AttributeNode  attributeForRotationAngleWithName:propertyName node:node]];
-
-				} else {
-					/* Skip remaining read-only attributes */
-					BOOL isReadOnly = [propertyAttributes rangeOfString:@",R(,|$)" options:NSRegularExpressionSearch].location != NSNotFound;
-					if (isReadOnly)
-						continue;
-
-					NSCharacterSet *nonEditableTypes = [NSCharacterSet characterSetWithCharactersInString:@"^?b:#@*v"];
-					BOOL editable = ![propertyType isEqualToString:@""] && [propertyType rangeOfCharacterFromSet:nonEditableTypes].location == NSNotFound;
-
-					AttributeNode *attribute;
-
-					if (editable) {
-						if (![propertyName containsString:@"anchorPoint"]
-							&& ![propertyName containsString:@"centerRect"]
-							&& ([propertyType isEqualToEncodedType:@encode(CGPoint)]
-								|| [propertyType isEqualToEncodedType:@encode(CGSize)]
-								|| [propertyType isEqualToEncodedType:@encode(CGRect)])) {
-							attribute = [AttributeNode attributeForNormalPrecisionValueWithName:propertyName node:node identifier:propertyType];
-
-						} else if ([propertyName containsString:@"colorBlendFactor"]
-								   || [propertyName containsString:@"alpha"]) {
-							attribute = [AttributeNode attributeForNormalizedValueWithName:propertyName node:node identifier:propertyType];
-
-						} else if ([propertyType isEqualToEncodedType:@encode(short)]
-								   || [propertyType isEqualToEncodedType:@encode(int)]
-								   || [propertyType isEqualToEncodedType:@encode(long)]
-								   || [propertyType isEqualToEncodedType:@encode(long long)]
-								   || [propertyType isEqualToEncodedType:@encode(unsigned short)]
-								   || [propertyType isEqualToEncodedType:@encode(unsigned int)]
-								   || [propertyType isEqualToEncodedType:@encode(unsigned long)]
-								   || [propertyType isEqualToEncodedType:@encode(unsigned long long)]) {
-							attribute = [AttributeNode attributeForIntegerValueWithName:propertyName node:node identifier:propertyType];
-
-						} else {
-							attribute = [AttributeNode attributeForHighPrecisionValueWithName:propertyName node:node identifier:propertyType];
-						}
-
-						if ([propertyType isEqualToEncodedType:@encode(CGPoint)]
-							|| [propertyType isEqualToEncodedType:@encode(CGVector)]) {
-							attribute.labels = @[@"X", @"Y"];
-						} else if ([propertyType isEqualToEncodedType:@encode(CGSize)]) {
-							attribute.labels = @[@"W", @"H"];
-						} else if ([propertyType isEqualToEncodedType:@encode(CGRect)]) {
-							attribute.labels = @[@"X", @"Y", @"W", @"H"];
-						}
-
-						[attributesArray addObject:attribute];
-					}
-#if 1// Show a dummy attribute for non-editable properties
-					else {
-						[attributesArray addObject:[AttributeNode attributeForNonEditableValue:propertyName identifier:propertyType]];
-					}
-#endif
-				}
-			}
+			default:
+				[attributesArray addObject:[descriptor attributeWithNode:node]];
+				break;
 		}
-		free(properties);
 	}
 
 	return attributesArray;
@@ -813,54 +745,93 @@
 	/* Retrieve scene file path from the application bundle */
 	//file = [[NSBundle mainBundle] pathForResource:file ofType:@"sks"];
 
-	NSData *data;
-
-	NSData *plistData = [NSData dataWithContentsOfFile:file];
-
-	id plist = [NSPropertyListSerialization propertyListWithData:plistData
-														 options:NSPropertyListImmutable
-														  format:&_sceneFormat
-														   error:error];
+	NSDictionary *timings = nil;
+	SKScene *scene = [SceneArchive rootObjectWithContentsOfFile:file
+														classes:@{@"SCNScene": [_SCNScene class]}
+														 format:&_sceneFormat
+														timings:&timings
+														  error:error];
 
 	_useXMLFormatButton.state = _sceneFormat == NSPropertyListXMLFormat_v1_0 ? 1 : 0;
 
-	if (_sceneFormat == NSPropertyListXMLFormat_v1_0) {
-		/* Convert scene data to binary before passing it to the unarchiver */
-		data = [NSPropertyListSerialization dataWithPropertyList:plist
-														  format:NSPropertyListBinaryFormat_v1_0
-														 options:0
-														   error:error];
-	} else {
-		data = plistData;
+	if (timings && [[NSUserDefaults standardUserDefaults] boolForKey:@"LogSceneLoadTimings"]) {
+		NSLog(@"Loaded %@ in %.1f ms (map %.1f ms, sniff %.3f ms, decode %.1f ms)", file.lastPathComponent,
+			  [timings[SceneArchiveTotalTimingKey] doubleValue] * 1000.0,
+			  [timings[SceneArchiveMapTimingKey] doubleValue] * 1000.0,
+			  [timings[SceneArchiveSniffTimingKey] doubleValue] * 1000.0,
+			  [timings[SceneArchiveDecodeTimingKey] doubleValue] * 1000.0);
 	}
 
-	NSKeyedUnarchiver *arch = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
-	[arch setClass:[_SCNScene class] forClassName:@"SCNScene"];
-	SKScene *scene = [arch decodeObjectForKey:NSKeyedArchiveRootObjectKey];
-	[arch finishDecoding];
-
 	return scene;
 }
 
-- (BOOL)archiveScene:(SKScene *)scene toFile:(NSString *)file {
+- (void)archiveScene:(SKScene *)scene toFile:(NSString *)file completionHandler:(void (^)(NSError *error))completionHandler {
 	/* Retrieve scene file path from the application bundle */
 	//file = [[NSBundle mainBundle] pathForResource:file ofType:@"sks"];
 
-	/* Archive the file to an SKScene object */
-	NSMutableData *data = [NSMutableData data];
-	NSKeyedArchiver *arch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
-
-	[arch setOutputFormat:_sceneFormat];
+	if (!scene || !file) {
+		if (completionHandler) {
+			completionHandler([NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteInvalidFileNameError userInfo:file ? @{NSFilePathErrorKey: file} : nil]);
+		}
+		return;
+	}
 
 	NSRect frame = scene.frame;
 	BOOL hasSingleNode = NSWidth(frame) == 1.0 && NSHeight(frame) == 1.0 && scene.children.count == 1;
 
 	id object = hasSingleNode ? scene.children.firstObject : scene;
 
-	[arch encodeObject:object forKey:NSKeyedArchiveRootObjectKey];
-	[arch finishEncoding];
+	/* The scene is archived here, the conversion and the writing happen in the background, the result comes in the main thread */
+	__block NSProgress *progress = nil;
+	progress = [SceneArchive writeRootObject:object
+									  toFile:file
+									  format:_sceneFormat
+						   completionHandler:^(NSError *error) {
+							   [self endShowingSaveProgress:progress];
+							   if (completionHandler) {
+								   completionHandler(error);
+							   } else if (error) {
+								   [NSApp presentError:error modalForWindow:self.window delegate:nil didPresentSelector:nil contextInfo:NULL];
+							   }
+						   }];
+	[self beginShowingSaveProgress:progress];
+}
+
+- (void)beginShowingSaveProgress:(NSProgress *)progress {
+	if (!_saveProgressIndicator) {
+		/* Small progress bar in the bottom right corner of the window */
+		NSView *contentView = self.window.contentView;
+		_saveProgressIndicator = [[NSProgressIndicator alloc] initWithFrame:NSMakeRect(NSWidth(contentView.bounds) - 128, 4, 120, 12)];
+		_saveProgressIndicator.style = NSProgressIndicatorBarStyle;
+		_saveProgressIndicator.controlSize = NSSmallControlSize;
+		_saveProgressIndicator.indeterminate = NO;
+		_saveProgressIndicator.minValue = 0.0;
+		_saveProgressIndicator.maxValue = 1.0;
+		_saveProgressIndicator.autoresizingMask = NSViewMinXMargin|NSViewMaxYMargin;
+		[contentView addSubview:_saveProgressIndicator];
+	}
+
+	_saveProgressIndicator.doubleValue = 0.0;
+	_saveProgressIndicator.hidden = NO;
 
-	return [data writeToFile:file atomically:YES];
+	[progress addObserver:self forKeyPath:@"fractionCompleted" options:0 context:(__bridge void *)_saveProgressIndicator];
+}
+
+- (void)endShowingSaveProgress:(NSProgress *)progress {
+	[progress removeObserver:self forKeyPath:@"fractionCompleted" context:(__bridge void *)_saveProgressIndicator];
+	_saveProgressIndicator.hidden = YES;
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+	if (context == (__bridge void *)_saveProgressIndicator) {
+		/* The progress is reported from the saving queue */
+		double fractionCompleted = [object fractionCompleted];
+		dispatch_async(dispatch_get_main_queue(), ^{
+			_saveProgressIndicator.doubleValue = fractionCompleted;
+		});
+	} else {
+		[super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+	}
 }
 
 - (BOOL)application:(NSApplication *)sender openFile:(NSString *)filename {
@@ -898,7 +869,7 @@
 
 - (IBAction)saveDocument:(id)sender {
 	if (_currentFilename) {
-		[self archiveScene:self.skView.scene toFile:_currentFilename];
+		[self archiveScene:self.skView.scene toFile:_currentFilename completionHandler:nil];
 	} else {
 		[self saveDocumentAs:sender];
 	}
@@ -927,7 +898,7 @@
 							  /* Store the selected file's path as a string */
 							  NSString *filename = [[selection path] stringByResolvingSymlinksInPath];
 							  /* Save to the selected the file */
-							  [self archiveScene:self.skView.scene toFile:filename];
+							  [self archiveScene:self.skView.scene toFile:filename completionHandler:nil];
 							  _currentFilename = filename;
 						  }
 					  }];
@@ -936,8 +907,7 @@
 - (IBAction)closeScene:(id)sender {
 	[self useScene:nil];
 	_currentFilename = nil;
-	_sceneBundle = nil;
-	[self populateMediaLibrary];
+	[self useSceneBundle:nil];
 
 	/* Clear the filename of last edited document */
 	NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
@@ -1103,6 +1073,11 @@
 		}
 	}
 
+	/* Prepare the contexts of the scripts before the first item is dropped */
+	[_objectLibraryContext enumerateObjectsUsingBlock:^(NSDictionary *contextData, NSUInteger index, BOOL *stop) {
+		[_scriptContextPool prewarmScript:contextData[@"script"] forKey:[self scriptContextKeyWithIndex:index mediaLibrary:NO]];
+	}];
+
 	[_objectLibraryArrayController setContent:_objectLibraryItems];
 
 	if (_objectSelectedLibraryItem == NSNotFound)
@@ -1110,6 +1085,11 @@
 	[_objectLibraryArrayController setSelectionIndex:_objectSelectedLibraryItem];
 }
 
+- (void)useSceneBundle:(NSBundle *)bundle {
+	_sceneBundle = bundle;
+	[self populateMediaLibrary];
+}
+
 - (void)populateMediaLibrary {
 	NSString *bundlePath = [_sceneBundle bundlePath];
 
@@ -1128,110 +1108,37 @@
 												   end
 												   )}.mutableCopy];
 		}
-
-		/* Clear the media library */
+		[_scriptContextPool prewarmScript:_mediaLibraryContext[0][@"script"] forKey:[self scriptContextKeyWithIndex:0 mediaLibrary:YES]];
+
+		/* Clear the media library, the thumbnails still loading belong to the previous bundle */
+		[_thumbnailService cancelAllLoads];
+		_pendingThumbnailLoadCount = 0;
+		_mediaLibraryScanned = NO;
+		[_mediaLibraryWatcher stop];
+		_mediaLibraryWatcher = nil;
 		_mediaLibraryItems = [NSMutableArray array];
+		_mediaLibraryItemsByName = [NSMutableDictionary dictionary];
+		_mediaLibraryFilesByName = [NSMutableDictionary dictionary];
+		[[ShaderRegistry sharedRegistry] removeAllShaders];
+		[[TextureRegistry sharedRegistry] removeAllTextures];
+
+		/* Store the scene bundle path, cleared along with the registries when there is no bundle */
+		_sceneBundlePath = bundlePath;
 
 		if (_sceneBundle) {
-			/* Store the scene bundle path */
-			_sceneBundlePath = bundlePath;
-
-			/* Get a list with all the files in the scene bundle */
-			NSString *mediaPath = [_sceneBundle resourcePath];
-			NSURL *mediaURL = [[NSURL alloc] initFileURLWithPath:mediaPath];
-			NSArray *keys = [NSArray arrayWithObject:NSURLIsDirectoryKey];
-			NSDirectoryEnumerator *enumerator = [[NSFileManager defaultManager]
-												 enumeratorAtURL:mediaURL
-												 includingPropertiesForKeys:keys
-												 options:0
-												 errorHandler:^(NSURL *url, NSError *error) {
-													 [NSApp presentError:error modalForWindow:self.window delegate:nil didPresentSelector:nil contextInfo:NULL];
-													 return NO;
-												 }];
-
-			/* Traverse all the files in the retrieved list */
-			NSMutableArray *loadedFiles = [NSMutableArray array];
-			for (NSURL *url in enumerator) {
-				NSError *error;
-				NSNumber *isDirectory = nil;
-				if ([url getResourceValue:&isDirectory forKey:NSURLIsDirectoryKey error:&error] && ![isDirectory boolValue]) {
-					NSString *fullPath = [url path];
-					NSString *filename = [fullPath lastPathComponent];
-
-					/* Check whether the file is an image */
-					CFStringRef fileExtension = (__bridge CFStringRef)[filename pathExtension];
-					CFStringRef fileUTI = UTTypeCreatePreferredIdentifierForTag(kUTTagClassFilenameExtension, fileExtension, NULL);
-					BOOL isImage = UTTypeConformsTo(fileUTI, kUTTypeImage);
-					CFRelease(fileUTI);
-
-					if (!isImage)
-						continue;
-
-					/* Check whether the image was already added with a different idiom */
-					NSRange range = [filename rangeOfString:@"~[^~\\.]*\\." options:NSRegularExpressionSearch];
-					if (range.location != NSNotFound)
-						filename = [filename stringByReplacingCharactersInRange:range withString:@"."];
-					filename = [filename stringByDeletingPathExtension];
-					if ([loadedFiles indexOfObject:filename] != NSNotFound)
-						continue;
-					[loadedFiles addObject:filename];
-
-					/* Retrieve an image reference from the image path */
-					CGImageSourceRef imageSource = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath:fullPath], NULL);
-
-					if (imageSource) {
-
-						/* Get the image properties */
-						NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
-												 [NSNumber numberWithBool:NO], (NSString *)kCGImageSourceShouldCache,
-												 nil];
-						CFDictionaryRef imageProperties = CGImageSourceCopyPropertiesAtIndex(imageSource, 0, (CFDictionaryRef)options);
-
-						if (imageProperties) {
-
-							/* Generate the image thumbnail */
-							NSNumber *width = (NSNumber *)CFDictionaryGetValue(imageProperties, kCGImagePropertyPixelWidth);
-							NSNumber *height = (NSNumber *)CFDictionaryGetValue(imageProperties, kCGImagePropertyPixelHeight);
-							CFRelease(imageProperties);
-
-							NSSize size = NSMakeSize([width floatValue], [height floatValue]);
-							CGFloat scale = MIN(1.0, 48.0 / MAX(size.width, size.height));
-							size.width *= scale;
-							size.height *= scale;
-
-							CGImageRef imageRef =  CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
-
-							NSImage *imageThumbnail = [[NSImage alloc] initWithCGImage:imageRef size:size];
-
-							CFRelease(imageRef);
-
-							if (imageThumbnail) {
-
-								NSRange nameRange = NSMakeRange(0, filename.length);
-								NSMutableAttributedString *filenameAttributedString = [[NSMutableAttributedString alloc] initWithString:filename];
-								[filenameAttributedString beginEditing];
-								[filenameAttributedString addAttribute:NSFontAttributeName
-																 value:[NSFont boldSystemFontOfSize:[NSFont smallSystemFontSize]]
-																 range:nameRange];
-								[filenameAttributedString endEditing];
-
-								/* Add the item to the library */
-								[_mediaLibraryItems addObject:@{@"name":filename,
-																	@"label":filenameAttributedString,
-																	@"image":imageThumbnail,
-																	@"showLabel":@(!_mediaLibraryModeButton.state),
-																	@"contextData":@(0)}.mutableCopy];
-							}
-						}
 
-						CFRelease(imageSource);
-					}
-				}
-				else if (error) {
-					[NSApp presentError:error modalForWindow:self.window delegate:nil didPresentSelector:nil contextInfo:NULL];
-					break;
-				}
-			}
+			/* The inspector looks the shaders up as soon as the scene is shown, the watcher keeps them up to date afterwards */
+			[[ShaderRegistry sharedRegistry] loadShadersWithPaths:[[NSBundle mainBundle] pathsForResourcesOfType:@"fsh"]];
+
+			/* The watcher lists the files in the scene bundle in the background and reports the changes made to them afterwards */
+			__weak AppDelegate *weakSelf = self;
+			_mediaLibraryWatcher = [[FileWatcher alloc] initWithPath:[_sceneBundle resourcePath]
+															 backend:FileWatcherBackendFSEvents
+															 handler:^(NSArray *addedFiles, NSArray *removedFiles, NSArray *modifiedFiles) {
+																 [[ShaderRegistry sharedRegistry] updateWithAddedFiles:addedFiles removedFiles:removedFiles modifiedFiles:modifiedFiles];
+																 [weakSelf updateMediaLibraryWithAddedFiles:addedFiles removedFiles:removedFiles modifiedFiles:modifiedFiles];
+															 }];
+			[_mediaLibraryWatcher start];
 		}
 	}
 
@@ -1242,6 +1149,191 @@
 	[_mediaLibraryArrayController setSelectionIndex:_mediaSelectedLibraryItem];
 }
 
+- (ThumbnailService *)thumbnailService {
+	if (!_thumbnailService) {
+		NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+		NSString *cacheDirectory = [[cachesPath stringByAppendingPathComponent:[[NSBundle mainBundle] bundleIdentifier]] stringByAppendingPathComponent:@"Thumbnails"];
+		_thumbnailService = [[ThumbnailService alloc] initWithCacheDirectory:cacheDirectory thumbnailSize:48.0];
+	}
+	return _thumbnailService;
+}
+
+- (NSImage *)placeholderThumbnail {
+	static NSImage *placeholderThumbnail;
+	if (!placeholderThumbnail) {
+		placeholderThumbnail = [[[NSWorkspace sharedWorkspace] iconForFileType:(NSString *)kUTTypeImage] copy];
+		placeholderThumbnail.size = NSMakeSize(48.0, 48.0);
+	}
+	return placeholderThumbnail;
+}
+
+- (void)updateMediaLibraryWithAddedFiles:(NSArray *)addedFiles removedFiles:(NSArray *)removedFiles modifiedFiles:(NSArray *)modifiedFiles {
+	/* The first call lists the whole bundle */
+	_mediaLibraryScanned = YES;
+
+	NSMutableArray *thumbnailItems = [NSMutableArray array];
+	NSMutableArray *thumbnailFiles = [NSMutableArray array];
+	BOOL itemsChanged = NO;
+
+	for (NSString *file in removedFiles) {
+		NSString *filename = [ThumbnailService libraryNameOfFile:file];
+		NSMutableArray *files = _mediaLibraryFilesByName[filename];
+		NSUInteger index = [files indexOfObject:file];
+		if (index == NSNotFound)
+			continue;
+
+		[files removeObjectAtIndex:index];
+		if (files.count == 0) {
+			[self removeMediaLibraryItemNamed:filename];
+			itemsChanged = YES;
+		} else if (index == 0) {
+			/* The thumbnail is taken from another idiom of the image */
+			[thumbnailItems addObject:_mediaLibraryItemsByName[filename]];
+			[thumbnailFiles addObject:files.firstObject];
+		}
+	}
+
+	for (NSString *file in addedFiles) {
+		/* Check whether the file is an image */
+		if (![ThumbnailService isImageFile:file])
+			continue;
+
+		/* Check whether the image was already added with a different idiom */
+		NSString *filename = [ThumbnailService libraryNameOfFile:file];
+		NSMutableArray *files = _mediaLibraryFilesByName[filename];
+		if (files) {
+			[files addObject:file];
+			continue;
+		}
+		_mediaLibraryFilesByName[filename] = [NSMutableArray arrayWithObject:file];
+
+		NSRange nameRange = NSMakeRange(0, filename.length);
+		NSMutableAttributedString *filenameAttributedString = [[NSMutableAttributedString alloc] initWithString:filename];
+		[filenameAttributedString beginEditing];
+		[filenameAttributedString addAttribute:NSFontAttributeName
+										 value:[NSFont boldSystemFontOfSize:[NSFont smallSystemFontSize]]
+										 range:nameRange];
+		[filenameAttributedString endEditing];
+
+		/* Add the item to the library, it shows a generic icon until its thumbnail is ready */
+		NSMutableDictionary *item = @{@"name":filename,
+									  @"label":filenameAttributedString,
+									  @"image":[self placeholderThumbnail],
+									  @"showLabel":@(!_mediaLibraryModeButton.state),
+									  @"contextData":@(0)}.mutableCopy;
+		[_mediaLibraryItems addObject:item];
+		_mediaLibraryItemsByName[filename] = item;
+		itemsChanged = YES;
+
+		[thumbnailItems addObject:item];
+		[thumbnailFiles addObject:file];
+	}
+
+	for (NSString *file in modifiedFiles) {
+		NSString *filename = [ThumbnailService libraryNameOfFile:file];
+		NSArray *files = _mediaLibraryFilesByName[filename];
+		if (![files containsObject:file])
+			continue;
+
+		/* Only the image that gives the thumbnail needs a new one */
+		if ([files.firstObject isEqualToString:file]) {
+			[thumbnailItems addObject:_mediaLibraryItemsByName[filename]];
+			[thumbnailFiles addObject:file];
+		}
+
+		[self reloadTexturesNamed:filename withContentsOfFile:file];
+	}
+
+	if (itemsChanged) {
+		[_mediaLibraryArrayController rearrangeObjects];
+	}
+
+	if (thumbnailFiles.count) {
+		[self loadThumbnailsOfItems:thumbnailItems files:thumbnailFiles];
+	}
+	/* Upload the new images ahead of their first use, optionally packed into an atlas */
+	NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+	if ([userDefaults boolForKey:@"PreloadMediaLibraryTextures"] && addedFiles.count) {
+		NSMutableDictionary *filesByName = [NSMutableDictionary dictionary];
+		for (NSString *file in addedFiles) {
+			NSString *filename = [ThumbnailService libraryNameOfFile:file];
+			if ([_mediaLibraryFilesByName[filename] containsObject:file] && !filesByName[filename]) {
+				filesByName[filename] = [_mediaLibraryFilesByName[filename] firstObject];
+			}
+		}
+		[[TextureRegistry sharedRegistry] preloadTexturesWithFiles:filesByName
+													 packIntoAtlas:[userDefaults boolForKey:@"PackMediaLibraryTextures"]
+												 completionHandler:nil];
+	}
+}
+
+- (BOOL)isMediaLibraryLoaded {
+	/* The bundle was listed and the thumbnails of its images are decoded */
+	return _mediaLibraryScanned && _pendingThumbnailLoadCount == 0;
+}
+
+- (void)removeMediaLibraryItemNamed:(NSString *)name {
+	NSMutableDictionary *item = _mediaLibraryItemsByName[name];
+	if (item) {
+		[_mediaLibraryItems removeObjectIdenticalTo:item];
+		[_mediaLibraryItemsByName removeObjectForKey:name];
+		[_mediaLibraryFilesByName removeObjectForKey:name];
+	}
+}
+
+- (void)loadThumbnailsOfItems:(NSArray *)items files:(NSArray *)files {
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+	/* Cancelled loads don't complete, the count is reset along with the library */
+	_pendingThumbnailLoadCount++;
+	[[self thumbnailService] loadThumbnailsOfFiles:files resultHandler:^(NSUInteger index, NSImage *thumbnail) {
+		NSMutableDictionary *item = items[index];
+		if (thumbnail) {
+			[item setValue:thumbnail forKey:@"image"];
+		} else if (_mediaLibraryItemsByName[item[@"name"]] == item) {
+			/* The file couldn't be decoded as an image */
+			[self removeMediaLibraryItemNamed:item[@"name"]];
+			[_mediaLibraryArrayController rearrangeObjects];
+		}
+	} completionHandler:^{
+		_pendingThumbnailLoadCount--;
+		if ([[NSUserDefaults standardUserDefaults] boolForKey:@"LogThumbnailTimings"]) {
+			NSLog(@"Loaded %lu thumbnails in %.1f ms", (unsigned long)files.count, (CFAbsoluteTimeGetCurrent() - startTime) * 1000.0);
+		}
+	}];
+}
+
+- (void)reloadTexturesNamed:(NSString *)name withContentsOfFile:(NSString *)file {
+	TextureRegistry *registry = [TextureRegistry sharedRegistry];
+	SKTexture *texture = [registry reloadTextureNamed:name withContentsOfFile:file];
+	if (!texture || !_editorView.scene)
+		return;
+
+	SKTexture *(^reloadedTexture)(SKTexture *) = ^SKTexture *(SKTexture *previousTexture) {
+		return [[registry nameOfTexture:previousTexture] isEqualToString:name] ? texture : previousTexture;
+	};
+
+	NSMutableArray *nodes = [NSMutableArray arrayWithObject:_editorView.scene];
+	while (nodes.count) {
+		SKNode *node = nodes.lastObject;
+		[nodes removeLastObject];
+		[nodes addObjectsFromArray:node.children];
+
+		if ([node isKindOfClass:[SKSpriteNode class]]) {
+			SKSpriteNode *sprite = (SKSpriteNode *)node;
+			sprite.texture = reloadedTexture(sprite.texture);
+			sprite.normalTexture = reloadedTexture(sprite.normalTexture);
+		} else if ([node isKindOfClass:[SKEmitterNode class]]) {
+			SKEmitterNode *emitter = (SKEmitterNode *)node;
+			emitter.particleTexture = reloadedTexture(emitter.particleTexture);
+		} else if ([node isKindOfClass:[SKShapeNode class]]) {
+			SKShapeNode *shape = (SKShapeNode *)node;
+			shape.fillTexture = reloadedTexture(shape.fillTexture);
+			shape.strokeTexture = reloadedTexture(shape.strokeTexture);
+		}
+	}
+}
+
 - (IBAction)libraryDidSwitchTab:(NSMatrix *)buttons {
 	[_libraryTabView selectTabViewItemAtIndex:buttons.selectedColumn];
 }
@@ -1259,11 +1351,7 @@
 }
 
 - (NSArray *)shadersLibrary {
-	NSMutableArray *result = [NSMutableArray array];
-	for (NSString *path in [[NSBundle mainBundle] pathsForResourcesOfType:@"fsh"]) {
-		[result addObject:[path lastPathComponent]];
-	}
-	return result;
+	return [[ShaderRegistry sharedRegistry] shaderNames];
 }
 
 #pragma mark Editor Dragging Destination
@@ -1277,6 +1365,61 @@
 	return NSDragOperationCopy;
 }
 
+- (id)scriptContextKeyWithIndex:(NSUInteger)index mediaLibrary:(BOOL)mediaLibrary {
+	return [NSString stringWithFormat:@"%@.%lu", mediaLibrary ? @"media" : @"object", (unsigned long)index];
+}
+
+- (NSArray *)createNodesWithLibraryItem:(NSDictionary *)libraryItem fromMediaLibrary:(BOOL)mediaLibrary atPositions:(NSArray *)positions error:(NSError * __autoreleasing *)error {
+	NSNumber *itemIndex = [libraryItem objectForKey:@"contextData"];
+	if (!itemIndex)
+		return nil;
+
+	NSDictionary *contextData = mediaLibrary ? _mediaLibraryContext[itemIndex.integerValue] : _objectLibraryContext[itemIndex.integerValue];
+	id key = [self scriptContextKeyWithIndex:itemIndex.unsignedIntegerValue mediaLibrary:mediaLibrary];
+
+	/* Take a context with the script already parsed from the pool */
+	LuaContext *scriptContext = [_scriptContextPool dequeueContextForKey:key script:contextData[@"script"] error:error];
+	if (!scriptContext)
+		return nil;
+
+	/* Esure the global variable scene is available in the context */
+	scriptContext[@"scene"] = _editorView.scene;
+
+	/* All the nodes are created in a single call to the script */
+	NSError *scriptError = nil;
+	NSArray *nodes = [ScriptContextPool createNodesAtPositions:positions name:[libraryItem objectForKey:@"name"] inContext:scriptContext error:&scriptError];
+	if (scriptError) {
+		if (error) {
+			*error = scriptError;
+		}
+		return nil;
+	}
+
+	[_scriptContextPool enqueueContext:scriptContext forKey:key];
+
+	NSMutableArray *createdNodes = [NSMutableArray arrayWithCapacity:nodes.count];
+	for (id node in nodes) {
+		if ([node isKindOfClass:[SKNode class]]) {
+			/* The script creates its own texture, the node uses the shared one instead */
+			[[TextureRegistry sharedRegistry] shareTexturesInNode:node];
+			[createdNodes addObject:node];
+		}
+	}
+	return createdNodes;
+}
+
+- (void)insertNodes:(NSArray *)nodes atIndexPath:(NSIndexPath *)indexPath {
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:nodes.count];
+	NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:nodes.count];
+	NSIndexPath *parentIndexPath = [indexPath indexPathByRemovingLastIndex];
+	NSUInteger index = [indexPath indexAtPosition:indexPath.length - 1];
+	for (SKNode *node in nodes) {
+		[objects addObject:@[[NavigationNode navigationNodeWithNode:node], @[@YES].mutableCopy]];
+		[indexPaths addObject:[parentIndexPath indexPathByAddingIndex:index++]];
+	}
+	[self insertObjects:objects atIndexPaths:indexPaths];
+}
+
 - (BOOL)editorView:(EditorView *)editorView performDragOperation:(id)item atLocation:(CGPoint)locationInSelection {
 	/* Check that there is a valid selection */
 	NSIndexPath *selectionIndexPath = [_navigatorTreeController selectionIndexPath];
@@ -1292,64 +1435,20 @@
 		libraryItem = [[_objectLibraryArrayController arrangedObjects] objectAtIndex:[item intValue]];
 	}
 
-	/* Retrieve a valid context from the cache for the item */
-	NSNumber *itemIndex = [libraryItem objectForKey:@"contextData"];
-	LuaContext *scriptContext = nil;
-	NSMutableDictionary *contextData = nil;
-	if (itemIndex) {
-		if (_libraryTabButtons.selectedColumn) {
-			contextData = [_mediaLibraryContext objectAtIndex:[itemIndex intValue]];
-		} else {
-			contextData = [_objectLibraryContext objectAtIndex:[itemIndex intValue]];
-		}
-		scriptContext = [contextData objectForKey:@"context"];
-	}
-
-	/* Create a new context if there isn't one already cached */
-	NSError *error = nil;
-	if (!scriptContext) {
-		/* Create the context */
-		scriptContext = [[LuaContext alloc] initWithVirtualMachine:_sharedScriptingContext.virtualMachine];
-
-		/* Copy the variables from the shared context */
-		for (Class class in _exportedClasses) {
-			scriptContext[[class className]] = class;
-		}
-		scriptContext[@"scene"] = _editorView.scene;
-
-		/* Retrieve the script */
-		NSString *script = [contextData objectForKey:@"script"];
-
-		/* Run the script */
-		[scriptContext parse:script error:&error];
-		if (error) {
-			[NSApp presentError:error modalForWindow:self.window delegate:nil didPresentSelector:nil contextInfo:NULL];
-			return NO;
-		}
-
-		/* Cache the scripting context if the script returned with no errors */
-		[contextData setObject:scriptContext forKey:@"context"];
-	}
-
-	/* Esure the global variable scene is available in the context */
-	else if (![scriptContext[@"scene"] isEqual:_editorView.scene]) {
-		scriptContext[@"scene"] = _editorView.scene;
-	}
-
 	/* Create the node from the script */
+	NSError *error = nil;
 	NSValue *position = [NSValue valueWithPoint:locationInSelection];
-	NSString *objectName = [libraryItem objectForKey:@"name"];
-	SKNode *node = [scriptContext call:@"createNodeAtPosition" with:@[position, objectName] error:&error];
+	NSArray *nodes = [self createNodesWithLibraryItem:libraryItem fromMediaLibrary:_libraryTabButtons.selectedColumn != 0 atPositions:@[position] error:&error];
 	if (error) {
 		[NSApp presentError:error modalForWindow:self.window delegate:nil didPresentSelector:nil contextInfo:NULL];
 		return NO;
 	}
-	if (!node) {
+	if (nodes.count == 0) {
 		return NO;
 	}
 
-	/* Insert the created node into the scene hierarchy */
-	[self insertObject:@[[NavigationNode navigationNodeWithNode:node], @[@YES].mutableCopy] atIndexPath:[selectionIndexPath indexPathByAddingIndex:0]];
+	/* Insert the created nodes into the scene hierarchy */
+	[self insertNodes:nodes atIndexPath:[selectionIndexPath indexPathByAddingIndex:0]];
 
 	/* Set focus on the editor view */
 	[[self window] makeFirstResponder:_editorView];
@@ -1390,20 +1489,20 @@
 	}
 
 	_currentFilename = filename;
-	_sceneBundle = bundle;
 
 	/* Save the filename to the last edited document */
 	NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
 	[userDefaults setValue:_currentFilename forKey:@"Last edited document"];
 	[userDefaults synchronize];
 
+	/* The registries of the media library are reset before the scene's nodes use them */
+	[self useSceneBundle:bundle];
+
 	[self useScene:scene];
 
 	/* Add the file to the 'Open Recent' file menu */
 	[self addRecentDocument:_currentFilename];
 
-	[self populateMediaLibrary];
-
 	return YES;
 }
 
@@ -1458,15 +1557,23 @@
 	[scene addChild:spaceShipNode];
 #endif
 
-	[self advanceEmittersInNode:self];
-
-	[scene setPaused:YES];
+	/* Emitters start warm, the ones unchanged since the last open are replaced by copies warmed back then */
+	if (!_emitterPrewarmer) {
+		_emitterPrewarmer = [[EmitterPrewarmer alloc] init];
+	}
+	[_emitterPrewarmer prewarmEmittersInNode:scene];
 }
 
 - (void)useScene:(SKScene *)scene {
 	_objectLibraryItems = nil;
 
+	/* The undo actions refer to the nodes of the previous scene */
+	[self.window.undoManager removeAllActions];
+
 	if (!scene) {
+		/* Drop the inspector builds in progress */
+		atomic_fetch_add(&_selectionGeneration, 1);
+
 		[_nodeInspectorTreeController setContent:nil];
 		[_identityInspectorTreeController setContent:nil];
 		[_navigatorTreeController setContent:nil];
@@ -1477,8 +1584,17 @@
 		return;
 	}
 
+	/* Nodes using the same image share one texture */
+	[[TextureRegistry sharedRegistry] shareTexturesInNode:scene];
+
+	/* Emitters may be replaced while preparing the scene, so it's done before the navigator references them */
+	[self prepareScene:scene];
+
 	[_navigatorTreeController setContent:[NavigationNode navigationNodeWithNode:scene]];
-	[_navigatorView expandItem:nil expandChildren:YES];
+
+	/* Only expand the first levels, the rest of the navigation nodes are created as the user expands them */
+	NSNumber *expansionDepth = [[NSUserDefaults standardUserDefaults] objectForKey:@"NavigatorExpansionDepth"];
+	[_navigatorView expandChildrenOfNode:[_navigatorTreeController arrangedObjects] toDepth:expansionDepth ? [expansionDepth unsignedIntegerValue] : 1];
 
 	/* Set the scale mode to scale to fit the window */
 	if (![scene isKindOfClass:[SKScene class]]) {
@@ -1489,10 +1605,14 @@
 
 	scene.scaleMode = SKSceneScaleModeAspectFit;
 
+	if ([[NSUserDefaults standardUserDefaults] boolForKey:@"LogTextureMemory"]) {
+		TextureRegistry *registry = [TextureRegistry sharedRegistry];
+		NSLog(@"%lu textures resident, %.1f MB", (unsigned long)registry.residentTextureCount, registry.residentTextureBytes / (1024.0 * 1024.0));
+	}
+
 	[self.skView presentScene:scene];
 
 	_editorView.scene = scene;
-	_sharedScriptingContext[@"scene"] = scene;
 
 	[_editorView updateVisibleRect];
 
@@ -1501,80 +1621,33 @@
 
 #pragma mark Helper methods
 
-- (id)navigationNodeOfObject:(id)anObject inNodes:(NSArray *)nodes {
-	for (int i = 0; i < nodes.count; ++i) {
-		NSTreeNode *node = nodes[i];
-		if ([[[node representedObject] node] isEqual:anObject]) {
-			return node;
-		}
-		if ([[node childNodes] count]) {
-			id result = [self navigationNodeOfObject:anObject inNodes:[node childNodes]];
-			if (result) {
-				[_navigatorView expandItem:node];
-				return result;
-			}
-		}
-	}
-	return nil;
-}
-
-- (void)advanceEmittersInNode:(id)node {
-	if ([node isKindOfClass:[SKEmitterNode class]]) {
-		SKEmitterNode *emitter = node;
-		[emitter advanceSimulationTime:0.41 * emitter.particleLifetime];
+- (id)navigationNodeOfObject:(id)anObject {
+	/* Collect the navigation nodes from the root down to the object's one */
+	NSMutableArray *path = [NSMutableArray array];
+	for (NavigationNode *navigationNode = [NavigationNode navigationNodeForNode:anObject]; navigationNode; navigationNode = navigationNode.parent) {
+		[path insertObject:navigationNode atIndex:0];
 	}
-	for (id child in [node children]) {
-		[self advanceEmittersInNode:child];
-	}
-}
-
-- (void)exportClass:(Class)class toContext:(LuaContext *)context {
-	// Create a protocol that inherits from LuaContext and with all the public methods and properties of the class
-	const char *protocolName = [NSString stringWithFormat:@"%sLuaExports", class_getName(class)].UTF8String;
-	Protocol *protocol = objc_getProtocol(protocolName);
-	if (!protocol) {
-		protocol = objc_allocateProtocol(protocolName);
-
-		protocol_addProtocol(protocol, @protocol(LuaExport));
-
-		// Add the public methods of the class to the protocol
-		unsigned int methodCount, classMethodCount, propertyCount;
-		Method *methods, *classMethods;
-		objc_property_t *properties;
 
-		methods = class_copyMethodList(class, &methodCount);
-		for (NSUInteger methodIndex = 0; methodIndex < methodCount; ++methodIndex) {
-			Method method = methods[methodIndex];
-			protocol_addMethodDescription(protocol, method_getName(method), method_getTypeEncoding(method), YES, YES);
+	/* Follow the path down the arranged tree, expanding the ancestors */
+	NSTreeNode *treeNode = [_navigatorTreeController arrangedObjects];
+	NavigationNode *parent = nil;
+	for (NavigationNode *navigationNode in path) {
+		NSArray *childNodes = [treeNode childNodes];
+		NSUInteger index = parent ? [parent indexOfChild:navigationNode] : 0;
+		if (index >= childNodes.count || [childNodes[index] representedObject] != navigationNode) {
+			/* The node was removed from the scene or is hidden by the filter */
+			return nil;
 		}
 
-		classMethods = class_copyMethodList(object_getClass(class), &classMethodCount);
-		for (NSUInteger methodIndex = 0; methodIndex < classMethodCount; ++methodIndex) {
-			Method method = classMethods[methodIndex];
-			protocol_addMethodDescription(protocol, method_getName(method), method_getTypeEncoding(method), YES, NO);
+		if (parent) {
+			[_navigatorView expandItem:treeNode];
 		}
 
-		properties = class_copyPropertyList(class, &propertyCount);
-		for (NSUInteger propertyIndex = 0; propertyIndex < propertyCount; ++propertyIndex) {
-			objc_property_t property = properties[propertyIndex];
-
-			unsigned int attributeCount;
-			objc_property_attribute_t *attributes = property_copyAttributeList(property, &attributeCount);
-			protocol_addProperty(protocol, property_getName(property), attributes, attributeCount, YES, YES);
-			free(attributes);
-		}
-
-		free(methods);
-		free(classMethods);
-		free(properties);
-
-		// Add the new protocol to the class
-		objc_registerProtocol(protocol);
+		treeNode = childNodes[index];
+		parent = navigationNode;
 	}
-	class_addProtocol(class, protocol);
 
-	NSString *className = [NSString stringWithCString:class_getName(class) encoding:NSUTF8StringEncoding];
-	context[className] = class;
+	return parent ? treeNode : nil;
 }
 
 @end
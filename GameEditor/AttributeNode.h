@@ -45,6 +45,11 @@
 - (NSArray *)componentsSeparatedInWords;
 @end
 
+/* Posted by an attribute, or the navigator when renaming, after it changes the value of the edited object, the object of the notification */
+extern NSString *const AttributeNodeDidChangeValueNotification;
+extern NSString *const AttributeNodeKeyPathKey;
+extern NSString *const AttributeNodeOldValueKey;
+
 @interface AttributeNode : NSObject
 + (instancetype)attributeWithName:(NSString *)name node:(SKNode *)node identifier:(NSString *)identifier children:(NSMutableArray *)children;
 + (instancetype)attributeWithName:(NSString *)name node:(SKNode *)node identifier:(NSString *)identifier formatter:(id)formatter valueTransformer:(id)valueTransformer;
@@ -62,4 +67,5 @@
 @property id formatter;
 @property id valueTransformer;
 @property NSArray *labels;
+- (void)bindValues;
 @end
@@ -27,6 +27,172 @@
 #import "ValueTransformers.h"
 #import <objc/runtime.h>
 
+NSString *const AttributeNodeDidChangeValueNotification = @"AttributeNodeDidChangeValueNotification";
+NSString *const AttributeNodeKeyPathKey = @"keyPath";
+NSString *const AttributeNodeOldValueKey = @"oldValue";
+
+#pragma mark Subindex keys
+
+typedef enum AttributeKeyKind {
+	AttributeKeyOther,
+	AttributeKeyLabel,
+	AttributeKeyValue
+} AttributeKeyKind;
+
+static const NSInteger kPrecomputedSubindexCount = 16;
+
+/* 1-based subindex key of a split value or struct field (value1, value2, etc.) */
+static NSString *AttributeValueKey(NSInteger subindex) {
+	static NSArray *keys = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		NSMutableArray *valueKeys = [NSMutableArray arrayWithCapacity:kPrecomputedSubindexCount];
+		for (NSInteger i = 1; i <= kPrecomputedSubindexCount; ++i) {
+			[valueKeys addObject:[NSString stringWithFormat:@"value%ld", (long)i]];
+		}
+		keys = valueKeys;
+	});
+	return subindex >= 1 && subindex <= kPrecomputedSubindexCount ? keys[subindex - 1] : [NSString stringWithFormat:@"value%ld", (long)subindex];
+}
+
+/* Splits a key like label2 or value1 into its kind and 0-based subindex */
+static AttributeKeyKind AttributeKeyKindOfKey(NSString *key, NSInteger *subindex) {
+	static NSDictionary *dispatchTable = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		NSMutableDictionary *table = [NSMutableDictionary dictionaryWithCapacity:2 * kPrecomputedSubindexCount];
+		for (NSInteger i = 1; i <= kPrecomputedSubindexCount; ++i) {
+			table[[NSString stringWithFormat:@"label%ld", (long)i]] = @(AttributeKeyLabel << 16 | (i - 1));
+			table[AttributeValueKey(i)] = @(AttributeKeyValue << 16 | (i - 1));
+		}
+		dispatchTable = table;
+	});
+
+	NSNumber *entry = dispatchTable[key];
+	if (entry) {
+		*subindex = entry.integerValue & 0xFFFF;
+		return (AttributeKeyKind)(entry.integerValue >> 16);
+	}
+
+	/* Subindexes out of the table */
+	NSUInteger length = key.length;
+	NSUInteger digits = length;
+	while (digits > 0 && [key characterAtIndex:digits - 1] >= '0' && [key characterAtIndex:digits - 1] <= '9') {
+		--digits;
+	}
+	if (digits == 0 || digits == length)
+		return AttributeKeyOther;
+
+	*subindex = [key substringFromIndex:digits].integerValue - 1;
+	NSString *baseKey = [key substringToIndex:digits];
+	if ([baseKey isEqualToString:@"label"])
+		return AttributeKeyLabel;
+	if ([baseKey isEqualToString:@"value"])
+		return AttributeKeyValue;
+	return AttributeKeyOther;
+}
+
+#pragma mark AttributeStructLayout
+
+/* Field offsets and types of an encoded struct, shared by the attributes with the same identifier */
+@interface AttributeStructLayout : NSObject
++ (instancetype)layoutWithIdentifier:(NSString *)identifier;
+@property (readonly) NSUInteger fieldCount;
+@property (readonly) NSUInteger size;
+- (NSUInteger)offsetOfField:(NSUInteger)field;
+- (const char *)typeOfField:(NSUInteger)field;
+@end
+
+@implementation AttributeStructLayout {
+	NSUInteger *_offsets;
+	char *_types;
+}
+
++ (instancetype)layoutWithIdentifier:(NSString *)identifier {
+	static NSMutableDictionary *layouts = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		layouts = [NSMutableDictionary dictionary];
+	});
+
+	/* Attributes are created in background threads while the inspector is built */
+	@synchronized(layouts) {
+		id layout = layouts[identifier];
+		if (!layout) {
+			layout = [[AttributeStructLayout alloc] initWithIdentifier:identifier] ?: [NSNull null];
+			layouts[identifier] = layout;
+		}
+		return layout != [NSNull null] ? layout : nil;
+	}
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier {
+	if (self = [super init]) {
+		/* Collect the field types, one character each, skipping the struct names */
+		const char *encoding = identifier.UTF8String;
+		size_t encodingLength = strlen(encoding);
+		char *types = malloc(encodingLength + 1);
+		NSUInteger typeCount = 0;
+		NSUInteger pendingStart = 0;
+		NSUInteger pendingCount = 0;
+		NSInteger level = 0;
+
+		for (size_t i = 0; i < encodingLength; ++i) {
+			char ch = encoding[i];
+			if (ch == '{') {
+				level++;
+				pendingCount = 0;
+			} else if (ch == '=') {
+				pendingCount = 0;
+			} else if (ch == '}') {
+				memmove(types + typeCount, encoding + pendingStart, pendingCount);
+				typeCount += pendingCount;
+				pendingCount = 0;
+				level--;
+			} else {
+				if (pendingCount == 0)
+					pendingStart = i;
+				pendingCount++;
+			}
+		}
+
+		if (typeCount == 0 || level != 0) {
+			free(types);
+			return nil;
+		}
+
+		/* Each type is stored NUL terminated, compute the offset of each field in the buffer */
+		_fieldCount = typeCount;
+		_types = malloc(2 * typeCount);
+		_offsets = malloc(typeCount * sizeof(NSUInteger));
+		for (NSUInteger field = 0; field < typeCount; ++field) {
+			_types[2 * field] = types[field];
+			_types[2 * field + 1] = '\0';
+			_offsets[field] = _size;
+			NSUInteger size;
+			NSGetSizeAndAlignment(_types + 2 * field, &size, NULL);
+			_size += size;
+		}
+		free(types);
+	}
+	return self;
+}
+
+- (void)dealloc {
+	free(_offsets);
+	free(_types);
+}
+
+- (NSUInteger)offsetOfField:(NSUInteger)field {
+	return _offsets[field];
+}
+
+- (const char *)typeOfField:(NSUInteger)field {
+	return _types + 2 * field;
+}
+
+@end
+
 #pragma mark AttributeNode
 
 @implementation AttributeNode {
@@ -35,9 +201,8 @@
 	BOOL _splitValue;
 	BOOL _structValue;
 	NSArray *_splitNames;
-	NSMutableArray *_types;
-	NSMutableArray *_typeSizes;
-	int _typeSize;
+	AttributeStructLayout *_structLayout;
+	BOOL _bound;
 	NSMutableData *_data;
 	unsigned char *_pdata;
 }
@@ -65,11 +230,13 @@ labels = _labels;
 		_structValue = NO;
 		_formatter = formatter;
 		_valueTransformer = valueTransformer;
-		_typeSize = 0;
 		_children = children;
 
-		/* Bind the property to the 'raw' value if there isn't an accessor */
-		[self bindValues];
+		/* Parse the name and type, the attributes built in a background thread are bound later in the main thread */
+		[self parseNameAndType];
+		if ([NSThread isMainThread]) {
+			[self bindValues];
+		}
 	}
 	return self;
 }
@@ -165,92 +332,81 @@ labels = _labels;
 	return _children == nil;
 }
 
+- (void)parseNameAndType {
+	if (!_node || _children || _splitNames)
+		return;
+
+	/* Try to get the separate values of a split value attribute */
+	_splitNames = [_name componentsSeparatedByString:@","];
+	if (_splitNames.count > 1) {
+		_name = _splitNames[0];
+		_splitValue = YES;
+		_value = [NSMutableArray array];
+		for (int i=1; i<_splitNames.count; ++i) {
+			[_value addObject:[NSNull null]];
+		}
+
+	} else {
+		/* Try to get the encoded type fields of the struct */
+		_structLayout = [AttributeStructLayout layoutWithIdentifier:_identifier];
+		if (_structLayout) {
+			/* Allocate the data buffer to hold the struct fields */
+			_data = [NSMutableData dataWithLength:_structLayout.size];
+			_pdata = [_data mutableBytes];
+
+			_structValue = YES;
+		}
+	}
+}
+
 - (void)bindValues {
+	if (_bound)
+		return;
+
 	[self willChangeValueForKey:@"isEditable"];
 
 	if (_node) {
+		[self parseNameAndType];
+
 		if (_children) {
 			[_node addObserver:self forKeyPath:_name options:0 context:NULL];
 
-		} else {
-			/* Try to get the separate values of a split value attribute */
-			_splitNames = [_name componentsSeparatedByString:@","];
-			if (_splitNames.count > 1) {
-				_name = _splitNames[0];
-				_splitValue = YES;
-				_value = [NSMutableArray array];
-				/* Initialize and bind each value for the split value attribute */
-				for (int i=1; i<_splitNames.count; ++i) {
-					[_value addObject:[NSNull null]];
-					[self bind:[NSString stringWithFormat:@"value%d", i] toObject:_node withKeyPath:_splitNames[i] options:nil];
-				}
-
-			} else {
-				/* Try to get the endoced type fields of the struct */
-				NSMutableArray *tempArray = [NSMutableArray array];
-				NSInteger level = 0;
-
-				_types = [NSMutableArray array];
-
-				for (NSInteger i=0; i<_identifier.length; i++) {
-					NSString *ch = [_identifier substringWithRange:NSMakeRange(i, 1)];
-					if ([ch isEqualToString:@"{"]) {
-						level++;
-						tempArray = [NSMutableArray array];
-					} else if ([ch isEqualToString:@"="]) {
-						tempArray = [NSMutableArray array];
-					} else if ([ch isEqualToString:@"}"]) {
-						[_types addObjectsFromArray:tempArray];
-						tempArray = [NSMutableArray array];
-						level--;
-					} else {
-						[tempArray addObject:ch];
-					}
-				}
-
-				if (_types.count && level == 0) {
-					/* Compute the size of each field and data buffer to hold the struct fields */
-					_typeSizes = [NSMutableArray array];
-
-					for (int i = 0; i < _types.count; ++i) {
-						[_typeSizes addObject:@(_typeSize)];
-						NSUInteger size;
-						NSGetSizeAndAlignment([_types[i] UTF8String], &size, NULL);
-						_typeSize += size;
-					}
-
-					/* Allocate the data buffer to hold the struct fields */
-					_data = [NSMutableData dataWithLength:_typeSize];
-					_pdata = [_data mutableBytes];
-
-					_structValue = YES;
-				}
-
-				/* Bind the struct value */
-				[self bind:@"value" toObject:_node withKeyPath:_name options:nil];
+		} else if (_splitValue) {
+			/* Bind each value for the split value attribute */
+			for (int i=1; i<_splitNames.count; ++i) {
+				[self bind:AttributeValueKey(i) toObject:_node withKeyPath:_splitNames[i] options:nil];
 			}
+
+		} else {
+			/* Bind the property to the 'raw' value if there isn't an accessor */
+			[self bind:@"value" toObject:_node withKeyPath:_name options:nil];
 		}
+
+		_bound = YES;
 	}
 	
 	[self didChangeValueForKey:@"isEditable"];
 }
 
 - (void)unbindValues {
-	if (_splitValue) {
+	if (!_bound)
+		return;
+
+	if (_children) {
+		[_node removeObserver:self forKeyPath:_name];
+	} else if (_splitValue) {
 		for (int i = 1; i <= [_value count]; ++i) {
-			[self unbind:[NSString stringWithFormat:@"value%d", i]];
+			[self unbind:AttributeValueKey(i)];
 		}
 	} else {
 		[self unbind:@"value"];
 	}
+
+	_bound = NO;
 }
 
 - (void)dealloc {
-	if (_children) {
-		[_node removeObserver:self forKeyPath:_name];
-	} else {
-		[self unbindValues];
-	}
+	[self unbindValues];
 }
 
 #pragma mark Value
@@ -260,12 +416,19 @@ labels = _labels;
 	if ([value isKindOfClass:[SKShader class]]) {
 		NSArray *uniforms = [_value uniforms];
 		if (uniforms.count) {
+			/* The shaders from the registry are shared between nodes, the uniforms go in a copy */
+			value = [value copy];
 			[value setUniforms:uniforms];
 		}
 	}
 	return value;
 }
 
+- (void)postChangeOfKeyPath:(NSString *)keyPath oldValue:(id)oldValue {
+	[[NSNotificationCenter defaultCenter] postNotificationName:AttributeNodeDidChangeValueNotification object:_node
+													  userInfo:@{AttributeNodeKeyPathKey: keyPath, AttributeNodeOldValueKey: oldValue ?: [NSNull null]}];
+}
+
 - (void)setValue:(id)value {
 	/* Do nothing if the value hasn't changed */
 	if ([_value isEqual:value])
@@ -277,7 +440,9 @@ labels = _labels;
 
 	/* Update the bound object's property value */
 	@try {
+		id oldValue = [_node valueForKeyPath:_name];
 		[_node setValue:_value forKeyPath:_name];
+		[self postChangeOfKeyPath:_name oldValue:oldValue];
 	}
 	@catch (NSException *exception) {
 		NSLog(@"Couldn't change property '%@' in %@", _name, _node);
@@ -290,23 +455,21 @@ labels = _labels;
 
 - (void)setValue:(id)value forUndefinedKey:(NSString *)key {
 	/* Try to get a subindex from the key */
-	NSArray *results = [key substringsWithRegularExpressionWithPattern:@"([\\D]+)([\\d]+)" options:0 error:NULL];
-
-	NSString *baseKey = results[0];
-	NSInteger subindex = [results[1] integerValue] - 1; // 1-based subindex (label1, value1, etc.)
+	NSInteger subindex;
+	AttributeKeyKind kind = AttributeKeyKindOfKey(key, &subindex);
 
-	if ([baseKey isEqualToString:@"value"]) {
+	if (kind == AttributeKeyValue) {
 		/* Update the value component for the given subindex */
 		if (_splitValue) {
 			if (![self.value[subindex] isEqual:value]) {
 				self.value[subindex] = value;
+				id oldValue = [_node valueForKeyPath:_splitNames[subindex + 1]];
 				[_node setValue:value forKeyPath:_splitNames[subindex + 1]];
+				[self postChangeOfKeyPath:_splitNames[subindex + 1] oldValue:oldValue];
 			}
 		} else if (_structValue) {
 			[self.value getValue:_pdata];
-			int offset = [_typeSizes[subindex] intValue];
-			const char *objCType = [_types[subindex] UTF8String];
-			[(NSNumber *)value getValue:_pdata + offset withObjCType:objCType];
+			[(NSNumber *)value getValue:_pdata + [_structLayout offsetOfField:subindex] withObjCType:[_structLayout typeOfField:subindex]];
 			self.value = [NSValue value:_pdata withObjCType:_identifier.UTF8String];
 		}
 
@@ -319,24 +482,20 @@ labels = _labels;
 
 - (id)valueForUndefinedKey:(NSString *)key {
 	/* Try to get a subindex from the key */
-	NSArray *results = [key substringsWithRegularExpressionWithPattern:@"([\\D]+)([\\d]+)" options:0 error:NULL];
+	NSInteger subindex;
+	AttributeKeyKind kind = AttributeKeyKindOfKey(key, &subindex);
 
-	NSString *baseKey = results[0];
-	NSInteger subindex = [results[1] integerValue] - 1; // 1-based subindex (label1, value1, etc.)
-
-	if ([baseKey isEqualToString:@"label"]) {
+	if (kind == AttributeKeyLabel) {
 		/* The key is a subindex of label */
 		return _labels[subindex];
 
-	} else if ([baseKey isEqualToString:@"value"]) {
+	} else if (kind == AttributeKeyValue) {
 		/* The key is a subindex of value */
 		if (_splitValue) {
 			return _value[subindex];
 		} else if (_structValue) {
 			[_value getValue:_pdata];
-			int offset = [_typeSizes[subindex] intValue];
-			const char *objCType = [_types[subindex] UTF8String];
-			return [NSNumber numberWithValue:_pdata + offset objCType:objCType];
+			return [NSNumber numberWithValue:_pdata + [_structLayout offsetOfField:subindex] objCType:[_structLayout typeOfField:subindex]];
 		}
 	}
 
@@ -351,10 +510,8 @@ labels = _labels;
 	NSSet *keyPaths = [super keyPathsForValuesAffectingValueForKey:key];
 
 	/* Try to get the key without subindex */
-	NSArray *results = [key substringsWithRegularExpressionWithPattern:@"([\\D]+)([\\d]+)" options:0 error:NULL];
-	NSString *baseKey = results[0];
-
-	if ([baseKey isEqualToString:@"value"]) {
+	NSInteger subindex;
+	if (AttributeKeyKindOfKey(key, &subindex) == AttributeKeyValue) {
 		keyPaths = [keyPaths setByAddingObject:@"value"];
 	}
 
@@ -0,0 +1,56 @@
+/*
+ * AttributeSchema.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+typedef enum AttributeDescriptorKind {
+	AttributeDescriptorKindValue = 0,
+	AttributeDescriptorKindNonEditable,
+	AttributeDescriptorKindPhysicsBody,
+	AttributeDescriptorKindPhysicsWorld,
+	AttributeDescriptorKindShader
+} AttributeDescriptorKind;
+
+/* Immutable description of an inspector row, it's bound to a node when the node gets selected */
+@interface AttributeDescriptor : NSObject
+@property (readonly) AttributeDescriptorKind kind;
+@property (readonly, copy) NSString *name;
+@property (readonly, copy) NSString *identifier;
+@property (readonly) Class propertyClass;
+@property (readonly) id formatter;
+@property (readonly) id valueTransformer;
+@property (readonly) NSArray *labels;
+- (id)attributeWithNode:(id)node;
+@end
+
+/* Reflection of a class built once per class and shared by every inspector and editor view */
+@interface AttributeSchema : NSObject
++ (instancetype)schemaForClass:(Class)classType;
+@property (readonly) Class classType;
+@property (readonly) NSArray *propertyNames;
+@property (readonly) NSArray *allPropertyNames;
+@property (readonly) NSArray *attributes;
+@property (readonly) NSArray *sceneAttributes;
+@end
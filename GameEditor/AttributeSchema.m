@@ -0,0 +1,464 @@
+/*
+ * AttributeSchema.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "AttributeSchema.h"
+#import "AttributeNode.h"
+#import "ValueTransformers.h"
+#import <SpriteKit/SpriteKit.h>
+#import <objc/runtime.h>
+
+#pragma mark AttributeDescriptor
+
+@implementation AttributeDescriptor
+
+@synthesize
+kind = _kind,
+name = _name,
+identifier = _identifier,
+propertyClass = _propertyClass,
+formatter = _formatter,
+valueTransformer = _valueTransformer,
+labels = _labels;
+
+- (instancetype)initWithKind:(AttributeDescriptorKind)kind
+						name:(NSString *)name
+				  identifier:(NSString *)identifier
+				   formatter:(id)formatter
+			valueTransformer:(id)valueTransformer
+					  labels:(NSArray *)labels
+			   propertyClass:(Class)propertyClass
+{
+	if (self = [super init]) {
+		_kind = kind;
+		_name = [name copy];
+		_identifier = [identifier copy];
+		_formatter = formatter;
+		_valueTransformer = valueTransformer;
+		_labels = [labels copy];
+		_propertyClass = propertyClass;
+	}
+	return self;
+}
+
++ (instancetype)descriptorWithName:(NSString *)name identifier:(NSString *)identifier formatter:(id)formatter valueTransformer:(id)valueTransformer labels:(NSArray *)labels {
+	return [[AttributeDescriptor alloc] initWithKind:AttributeDescriptorKindValue name:name identifier:identifier formatter:formatter valueTransformer:valueTransformer labels:labels propertyClass:nil];
+}
+
++ (instancetype)descriptorWithName:(NSString *)name identifier:(NSString *)identifier {
+	return [self descriptorWithName:name identifier:identifier formatter:nil valueTransformer:nil labels:nil];
+}
+
++ (instancetype)descriptorForHighPrecisionValueWithName:(NSString *)name identifier:(NSString *)identifier labels:(NSArray *)labels {
+	return [self descriptorWithName:name identifier:identifier
+						  formatter:[NSNumberFormatter highPrecisionFormatter]
+				   valueTransformer:[PrecisionTransformer transformer]
+							 labels:labels];
+}
+
++ (instancetype)descriptorForNonEditableValue:(NSString *)name identifier:(NSString *)identifier {
+	return [[AttributeDescriptor alloc] initWithKind:AttributeDescriptorKindNonEditable name:name identifier:identifier formatter:nil valueTransformer:nil labels:nil propertyClass:nil];
+}
+
++ (instancetype)descriptorWithKind:(AttributeDescriptorKind)kind name:(NSString *)name identifier:(NSString *)identifier valueTransformer:(id)valueTransformer propertyClass:(Class)propertyClass {
+	return [[AttributeDescriptor alloc] initWithKind:kind name:name identifier:identifier formatter:nil valueTransformer:valueTransformer labels:nil propertyClass:propertyClass];
+}
+
+- (id)attributeWithNode:(id)node {
+	if (_kind == AttributeDescriptorKindNonEditable) {
+		return [AttributeNode attributeForNonEditableValue:_name identifier:_identifier];
+	}
+
+	AttributeNode *attribute = [AttributeNode attributeWithName:_name
+														   node:node
+													 identifier:_identifier
+													  formatter:_formatter
+											   valueTransformer:_valueTransformer];
+	if (_labels) {
+		attribute.labels = _labels;
+	}
+	return attribute;
+}
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"%@\n%@", _name, _identifier];
+}
+
+@end
+
+#pragma mark AttributeSchema
+
+@implementation AttributeSchema
+
+@synthesize
+classType = _classType,
+propertyNames = _propertyNames,
+allPropertyNames = _allPropertyNames,
+attributes = _attributes,
+sceneAttributes = _sceneAttributes;
+
++ (instancetype)schemaForClass:(Class)classType {
+	static NSMapTable *schemas = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		schemas = [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality
+										valueOptions:NSMapTableStrongMemory];
+	});
+
+	if (!classType)
+		return nil;
+
+	/* The inspector may be populated from a background queue */
+	@synchronized(schemas) {
+		AttributeSchema *schema = [schemas objectForKey:classType];
+		if (!schema) {
+			schema = [[AttributeSchema alloc] initWithClass:classType];
+			[schemas setObject:schema forKey:classType];
+		}
+		return schema;
+	}
+}
+
+- (instancetype)initWithClass:(Class)classType {
+	if (self = [super init]) {
+		_classType = classType;
+
+		NSMutableArray *propertyNames = [NSMutableArray array];
+		NSMutableArray *propertyAttributes = [NSMutableArray array];
+
+		unsigned int count;
+		objc_property_t *properties = class_copyPropertyList(classType, &count);
+		for (unsigned int i = 0; i < count; i++) {
+			[propertyNames addObject:[NSString stringWithUTF8String:property_getName(properties[i])]];
+			[propertyAttributes addObject:[NSString stringWithUTF8String:property_getAttributes(properties[i])+1]];
+		}
+		free(properties);
+
+		_propertyNames = propertyNames;
+
+		/* Accumulate the properties of the superclasses up to SKNode */
+		Class superclass = [classType superclass];
+		if (superclass && superclass != [SKNode superclass]) {
+			NSMutableOrderedSet *allPropertyNames = [NSMutableOrderedSet orderedSetWithArray:propertyNames];
+			[allPropertyNames addObjectsFromArray:[AttributeSchema schemaForClass:superclass].allPropertyNames];
+			_allPropertyNames = allPropertyNames.array;
+		} else {
+			_allPropertyNames = propertyNames;
+		}
+
+		_attributes = [self attributesWithPropertyNames:propertyNames propertyAttributes:propertyAttributes forScene:NO];
+		_sceneAttributes = [self attributesWithPropertyNames:propertyNames propertyAttributes:propertyAttributes forScene:YES];
+	}
+	return self;
+}
+
+- (NSArray *)attributesWithPropertyNames:(NSArray *)propertyNames propertyAttributes:(NSArray *)propertyAttributesArray forScene:(BOOL)isScene {
+	NSMutableArray *attributesArray = [NSMutableArray array];
+
+	BOOL hasZPositionRotation = NO;
+	BOOL hasSpeed = NO;
+	BOOL hasEmissionAngle = NO;
+	BOOL hasLifetime = NO;
+	BOOL hasXYAcceleration = NO;
+	BOOL hasXYScale = NO;
+	BOOL hasXYRotation = NO;
+	BOOL hasParticleZPositionRangeSpeed = NO;
+	BOOL hasParticleScaleRangeSpeed = NO;
+	BOOL hasParticleRotationRangeSpeed = NO;
+	BOOL hasParticleAlphaRangeSpeed = NO;
+	BOOL hasParticleColorBlendFactor = NO;
+	BOOL hasParticleColorRed = NO;
+	BOOL hasParticleColorGreen = NO;
+	BOOL hasParticleColorBlue = NO;
+	BOOL hasParticleColorAlpha = NO;
+
+	for (NSUInteger i = 0; i < propertyNames.count; i++) {
+		NSString *propertyAttributes = propertyAttributesArray[i];
+
+		/* Skip read-only attributes that are not class instances */
+		BOOL isReadonlyNonClass = [propertyAttributes rangeOfString:@"^[^@]*,R(,|$)" options:NSRegularExpressionSearch].location != NSNotFound;
+		if (isReadonlyNonClass)
+			continue;
+
+		NSString *propertyName = propertyNames[i];
+
+		BOOL isPrivateProperty = [propertyName rangeOfString:@"^_" options:NSRegularExpressionSearch].location != NSNotFound;
+		if (isPrivateProperty)
+			continue;
+
+		NSString *propertyType = [[propertyAttributes componentsSeparatedByString:@","] firstObject];
+
+		if (isScene
+			&& ([propertyName isEqualToString:@"position"]
+				|| [propertyName isEqualToString:@"zPosition"]
+				|| [propertyName isEqualToString:@"zRotation"]
+				|| [propertyName isEqualToString:@"xScale"]
+				|| [propertyName isEqualToString:@"yScale"]
+				|| [propertyName isEqualToString:@"visibleRect"]
+				|| [propertyName isEqualToString:@"visibleRectCenter"]
+				|| [propertyName isEqualToString:@"visibleRectSize"])) {
+			[attributesArray addObject:[AttributeDescriptor descriptorForNonEditableValue:propertyName identifier:propertyType]];
+
+		} else if ([propertyName rangeOfString:@"^z(Position|Rotation)$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasZPositionRotation) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:@"z,zPosition,zRotation"
+																		identifier:@"{dd}"
+																		 formatter:@[[NSNumberFormatter integerFormatter],
+																					 [NSNumberFormatter degreesFormatter]]
+																  valueTransformer:@[[NSNull null],
+																					 [DegreesTransformer transformer]]
+																			labels:@[@"Position", @"Rotation"]]];
+				hasZPositionRotation = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^emissionAngle(Range)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasEmissionAngle) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:@"emissionAngle,emissionAngle,emissionAngleRange"
+																		identifier:@"{dd}"
+																		 formatter:[NSNumberFormatter degreesFormatter]
+																  valueTransformer:[DegreesTransformer transformer]
+																			labels:@[@"Start", @"Range"]]];
+				hasEmissionAngle = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleColorRed(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleColorRed) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"red,particleColorRedSpeed,particleColorRedRange" identifier:@"{dd}" labels:@[@"Start", @"Range"]]];
+				hasParticleColorRed = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleColorGreen(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleColorGreen) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"green,particleColorGreenSpeed,particleColorGreenRange" identifier:@"{dd}" labels:@[@"Start", @"Range"]]];
+				hasParticleColorGreen = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleColorBlue(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleColorBlue) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"blue,particleColorBlueSpeed,particleColorBlueRange" identifier:@"{dd}" labels:@[@"Start", @"Range"]]];
+				hasParticleColorBlue = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleColorAlpha(Speed|Range)$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleColorAlpha) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"alpha,particleColorAlphaSpeed,particleColorAlphaRange" identifier:@"{dd}" labels:@[@"Start", @"Range"]]];
+				hasParticleColorAlpha = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleSpeed(Range)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasSpeed) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"speed,particleSpeed,particleSpeedRange" identifier:@"{dd}" labels:@[@"Start", @"Range"]]];
+				hasSpeed = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleLifetime(Range)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasLifetime) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"lifetime,particleLifetime,particleLifetimeRange" identifier:@"{dd}" labels:@[@"Start", @"Range"]]];
+				hasLifetime = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^(x|y)Acceleration$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasXYAcceleration) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"acceleration,xAcceleration,yAcceleration" identifier:@"{dd}" labels:@[@"X", @"Y"]]];
+				hasXYAcceleration = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^(x|y)Scale$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasXYScale) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"scale,xScale,yScale" identifier:@"{dd}" labels:@[@"X", @"Y"]]];
+				hasXYScale = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^(x|y)Rotation$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasXYRotation) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:@"rotation,xRotation,yRotation"
+																		identifier:@"{dd}"
+																		 formatter:[NSNumberFormatter degreesFormatter]
+																  valueTransformer:[DegreesTransformer transformer]
+																			labels:@[@"X", @"Y"]]];
+				hasXYRotation = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleZPosition(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleZPositionRangeSpeed) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"zPosition,particleZPosition,particleZPositionRange,particleZPositionSpeed" identifier:@"{ddd}" labels:@[@"Start", @"Range", @"Speed"]]];
+				hasParticleZPositionRangeSpeed = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleScale(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleScaleRangeSpeed) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"scale,particleScale,particleScaleRange,particleScaleSpeed" identifier:@"{ddd}" labels:@[@"Start", @"Range", @"Speed"]]];
+				hasParticleScaleRangeSpeed = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleRotation(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleRotationRangeSpeed) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"rotation,particleRotation,particleRotationRange,particleRotationSpeed" identifier:@"{ddd}" labels:@[@"Start", @"Range", @"Speed"]]];
+				hasParticleRotationRangeSpeed = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleAlpha(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleAlphaRangeSpeed) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"alpha,particleAlpha,particleAlphaRange,particleAlphaSpeed" identifier:@"{ddd}" labels:@[@"Start", @"Range", @"Speed"]]];
+				hasParticleAlphaRangeSpeed = YES;
+			}
+
+		} else if ([propertyName rangeOfString:@"^particleColorBlendFactor(Range|Speed)?$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			if (!hasParticleColorBlendFactor) {
+				[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:@"colorBlendFactor,particleColorBlendFactor,particleColorBlendFactorRange,particleColorBlendFactorSpeed" identifier:@"{ddd}" labels:@[@"Start", @"Range", @"Speed"]]];
+				hasParticleColorBlendFactor = YES;
+			}
+
+		} else if ([propertyName isEqualToString:@"bodyType"]) {
+			/* Do nothing, the body type will be added with the SKPhysicsNode property */
+
+		} else if ([propertyName rangeOfString:@"[bB]lendMode$" options:NSRegularExpressionSearch].location != NSNotFound) {
+			[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName identifier:@"blendMode"]];
+
+		} else if ([propertyName isEqualToString:@"scaleMode"]
+				   || [propertyName isEqualToString:@"lineCap"]
+				   || [propertyName isEqualToString:@"lineJoin"]
+				   || [propertyName isEqualToString:@"verticalAlignmentMode"]
+				   || [propertyName isEqualToString:@"horizontalAlignmentMode"]
+				   || [propertyName isEqualToString:@"fontName"]) {
+			[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName identifier:propertyName]];
+
+		} else {
+
+			Class propertyClass = [propertyType classType];
+
+			if ([propertyType isEqualToEncodedType:@encode(NSMutableDictionary)]) {
+				/* Do nothing, this will be added to the Identity inspector */
+
+			} else if ([propertyType isEqualToEncodedType:@encode(NSString)]) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName identifier:propertyType]];
+
+			} else if ([propertyType isEqualToEncodedType:@encode(NSColor)]) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName identifier:propertyType]];
+
+			} else if (propertyClass == [SKTexture class]) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName
+																		identifier:propertyType
+																		 formatter:nil
+																  valueTransformer:[TextureTransformer transformer]
+																			labels:nil]];
+
+			} else if (propertyClass == [SKPhysicsBody class]) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithKind:AttributeDescriptorKindPhysicsBody
+																			  name:propertyName
+																		identifier:@"expandable"
+																  valueTransformer:nil
+																	 propertyClass:propertyClass]];
+
+			} else if (propertyClass == [SKShader class]) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithKind:AttributeDescriptorKindShader
+																			  name:propertyName
+																		identifier:propertyType
+																  valueTransformer:[ShaderTransformer transformer]
+																	 propertyClass:propertyClass]];
+
+			} else if (propertyClass == [SKPhysicsWorld class]) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithKind:AttributeDescriptorKindPhysicsWorld
+																			  name:propertyName
+																		identifier:@"expandable"
+																  valueTransformer:nil
+																	 propertyClass:propertyClass]];
+
+			} else if ([propertyName rangeOfString:@"rotation" options:NSCaseInsensitiveSearch].location != NSNotFound) {
+				[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName
+																		identifier:@"d"
+																		 formatter:[NSNumberFormatter degreesFormatter]
+																  valueTransformer:[DegreesTransformer transformer]
+																			labels:nil]];
+
+			} else {
+				/* Skip remaining read-only attributes */
+				BOOL isReadOnly = [propertyAttributes rangeOfString:@",R(,|$)" options:NSRegularExpressionSearch].location != NSNotFound;
+				if (isReadOnly)
+					continue;
+
+				NSCharacterSet *nonEditableTypes = [NSCharacterSet characterSetWithCharactersInString:@"^?b:#@*v"];
+				BOOL editable = ![propertyType isEqualToString:@""] && [propertyType rangeOfCharacterFromSet:nonEditableTypes].location == NSNotFound;
+
+				if (editable) {
+					NSArray *labels = nil;
+					if ([propertyType isEqualToEncodedType:@encode(CGPoint)]
+						|| [propertyType isEqualToEncodedType:@encode(CGVector)]) {
+						labels = @[@"X", @"Y"];
+					} else if ([propertyType isEqualToEncodedType:@encode(CGSize)]) {
+						labels = @[@"W", @"H"];
+					} else if ([propertyType isEqualToEncodedType:@encode(CGRect)]) {
+						labels = @[@"X", @"Y", @"W", @"H"];
+					}
+
+					if (![propertyName containsString:@"anchorPoint"]
+						&& ![propertyName containsString:@"centerRect"]
+						&& ([propertyType isEqualToEncodedType:@encode(CGPoint)]
+							|| [propertyType isEqualToEncodedType:@encode(CGSize)]
+							|| [propertyType isEqualToEncodedType:@encode(CGRect)])) {
+						[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName
+																				identifier:propertyType
+																				 formatter:[NSNumberFormatter normalPrecisionFormatter]
+																		  valueTransformer:nil
+																					labels:labels]];
+
+					} else if ([propertyName containsString:@"colorBlendFactor"]
+							   || [propertyName containsString:@"alpha"]) {
+						[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName
+																				identifier:propertyType
+																				 formatter:[NSNumberFormatter normalizedFormatter]
+																		  valueTransformer:[PrecisionTransformer transformer]
+																					labels:labels]];
+
+					} else if ([propertyType isEqualToEncodedType:@encode(short)]
+							   || [propertyType isEqualToEncodedType:@encode(int)]
+							   || [propertyType isEqualToEncodedType:@encode(long)]
+							   || [propertyType isEqualToEncodedType:@encode(long long)]
+							   || [propertyType isEqualToEncodedType:@encode(unsigned short)]
+							   || [propertyType isEqualToEncodedType:@encode(unsigned int)]
+							   || [propertyType isEqualToEncodedType:@encode(unsigned long)]
+							   || [propertyType isEqualToEncodedType:@encode(unsigned long long)]) {
+						[attributesArray addObject:[AttributeDescriptor descriptorWithName:propertyName
+																				identifier:propertyType
+																				 formatter:[NSNumberFormatter integerFormatter]
+																		  valueTransformer:nil
+																					labels:labels]];
+
+					} else {
+						[attributesArray addObject:[AttributeDescriptor descriptorForHighPrecisionValueWithName:propertyName identifier:propertyType labels:labels]];
+					}
+				}
+#if 1// Show a dummy attribute for non-editable properties
+				else {
+					[attributesArray addObject:[AttributeDescriptor descriptorForNonEditableValue:propertyName identifier:propertyType]];
+				}
+#endif
+			}
+		}
+	}
+
+	return attributesArray;
+}
+
+@end
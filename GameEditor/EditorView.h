@@ -30,6 +30,7 @@
 
 @property (weak) SKNode *node;
 @property (weak) SKScene *scene;
+@property (readonly) NSArray *selectedNodes;
 
 @property CGPoint position;
 @property CGFloat zRotation;
@@ -38,7 +39,16 @@
 
 @property (weak) id delegate;
 
+/* Instrumentation of the selected node observation */
+@property (readonly) NSUInteger observedKeyCount;
+@property (readonly) NSUInteger observedChangeCount;
+@property (readonly) NSUInteger selectionUpdateCount;
+
 - (void)updateVisibleRect;
+- (void)updateIndexForNode:(SKNode *)node;
+- (void)removeIndexForNode:(SKNode *)node;
+- (NSArray *)nodesContainingPoint:(CGPoint)point inNode:(SKNode *)aNode;
+- (NSArray *)nodesIntersectingRect:(CGRect)rect;
 
 @end
 
@@ -24,6 +24,10 @@
  */
 
 #import "EditorView.h"
+#import "SpatialIndex.h"
+#import "NSMapTable+Subscripting.h"
+#import "AttributeNode.h"
+#import "UndoJournal.h"
 #import <GLKit/GLKit.h>
 #import <objc/runtime.h>
 
@@ -246,15 +250,48 @@ typedef enum {
 	CGPoint _handleOffset;
 	BOOL _manipulatingHandle;
 	ManipulatedHandle _manipulatedHandle;
-	NSMutableSet *_boundAttributes;
-	BOOL _registeredUndo;
-	NSMutableDictionary *_compoundUndo;
+	NSArray *_boundAttributes;
+	BOOL _observingAttributeChanges;
+	BOOL _needsSelectionUpdate;
+
+	/* Observation counters, logged for every drag event with the LogEditorObservation default */
+	NSUInteger _observedChangeCount;
+	NSUInteger _selectionUpdateCount;
+	BOOL _logsObservation;
+	NSUInteger _loggedChangeCount;
+	NSUInteger _loggedSelectionUpdateCount;
+	UndoJournal *_undoJournal;
+	BOOL _replayingUndoJournal;
 	CGPoint _viewOrigin;
 	CGFloat _viewScale;
-	NSBezierPath *_selectionPath;
+
+	/* Overlay rendering caches */
+	NSMapTable *_glyphPaths;
+	NSMutableDictionary *_glowImages;
+	CGFloat _glyphsViewScale;
+	CGRect _handlesRect;
 
 	/* Outline handle points */
 	CGPoint _handlePoints[MaxHandle];
+
+	/* Spatial index of the scene nodes used for hit-testing */
+	SpatialIndexRef _spatialIndex;
+	NSMapTable *_proxiesByNode;
+	NSMapTable *_nodesByProxy;
+
+	/* Position of every node in the scene's order, rebuilt after nodes are inserted or moved */
+	NSMapTable *_sceneOrder;
+
+	/* Multiple selection */
+	NSArray *_selectedNodes;
+	BOOL _selectingWithMarquee;
+	CGPoint _marqueeOrigin;
+	CGRect _marqueeRect;
+	BOOL _transformingSelection;
+	CGRect _selectionBounds;
+	CGPoint _transformOrigin;
+	CGFloat _selectionRotation;
+	NSArray *_transformStates;
 }
 
 @synthesize
@@ -533,7 +570,7 @@ anchorPoint = _anchorPoint;
 		}
 	}
 	
-	[self setNeedsDisplay:YES];
+	[self invalidateHandles];
 }
 
 - (void)updateVisibleRect {
@@ -557,58 +594,238 @@ anchorPoint = _anchorPoint;
 	[self updateVisibleRect];
 }
 
-- (BOOL)node:(SKNode *)node containsPoint:(CGPoint)point {
-	BOOL result = NO;
+#pragma mark Spatial index
 
-	CGMutablePathRef path = CGPathCreateMutable();
+static bool collectProxy(SpatialIndexProxy proxy, void *context) {
+	[(__bridge NSMutableData *)context appendBytes:&proxy length:sizeof(proxy)];
+	return true;
+}
 
-	/* Construct the path using the transformed frame */
-	if ([node respondsToSelector:@selector(size)]) {
-		CGPoint points[5];
-		[self getFramePoints:points forNode:node];
-		CGPathAddLines(path, NULL, &points[1], 4);
+- (CGPoint)convertPointToScene:(CGPoint)point {
+	return CGPointMake(_viewScale * (point.x - _viewOrigin.x), _viewScale * (point.y - _viewOrigin.y));
+}
+
+- (CGPoint)convertPointFromScene:(CGPoint)point {
+	return CGPointMake(point.x / _viewScale + _viewOrigin.x, point.y / _viewScale + _viewOrigin.y);
+}
+
+- (CGAffineTransform)localTransformForNode:(SKNode *)node {
+	CGAffineTransform transform = CGAffineTransformMakeScale(node.xScale, node.yScale);
+	transform = CGAffineTransformConcat(transform, CGAffineTransformMakeRotation(node.zRotation));
+	return CGAffineTransformConcat(transform, CGAffineTransformMakeTranslation(node.position.x, node.position.y));
+}
+
+- (CGAffineTransform)transformFromNode:(SKNode *)node {
+	/* Accumulate the transforms up to the scene, the same as the scene's convertPoint:fromNode: */
+	CGAffineTransform transform = CGAffineTransformIdentity;
+	while (node && node != _scene) {
+		transform = CGAffineTransformConcat(transform, [self localTransformForNode:node]);
+		node = node.parent;
+	}
+	return transform;
+}
+
+- (SpatialIndexBox)boxForNode:(SKNode *)node transform:(CGAffineTransform)transform isPoint:(BOOL *)isPoint {
+	/* Nodes without size are hit using a square of fixed size around their position */
+	if (![node respondsToSelector:@selector(size)]) {
+		*isPoint = YES;
+		return SpatialIndexBoxMakePoint(CGPointMake(transform.tx, transform.ty));
+	}
+
+	*isPoint = NO;
+
+	CGPoint anchorPoint = CGPointZero;
+	if ([node respondsToSelector:@selector(anchorPoint)]) {
+		anchorPoint = [(id)node anchorPoint];
+	}
+
+	/* The size already has the node's scale applied */
+	CGSize size = [(id)node size];
+	size.width = node.xScale != 0 ? size.width / node.xScale : 0;
+	size.height = node.yScale != 0 ? size.height / node.yScale : 0;
+
+	return SpatialIndexBoxMake(transform, size, anchorPoint);
+}
+
+- (void)indexNode:(SKNode *)node withParentTransform:(CGAffineTransform)parentTransform {
+	CGAffineTransform transform = CGAffineTransformConcat([self localTransformForNode:node], parentTransform);
+
+	BOOL isPoint;
+	SpatialIndexBox box = [self boxForNode:node transform:transform isPoint:&isPoint];
 
-		/* Construct the path using a rectangle of arbitrary size centered at the node's position */
+	[_glyphPaths removeObjectForKey:node];
+
+	NSNumber *proxy = _proxiesByNode[node];
+	if (proxy) {
+		SpatialIndexUpdate(_spatialIndex, proxy.intValue, box, isPoint);
 	} else {
-		CGPoint center = [_scene convertPoint:CGPointZero fromNode:node];
-		center.x /= _viewScale;
-		center.y /= _viewScale;
-		center.x += _viewOrigin.x;
-		center.y += _viewOrigin.y;
-		CGPoint points[4] = {
-			{center.x - kRotationHandleDistance, center.y - kRotationHandleDistance},
-			{center.x + kRotationHandleDistance, center.y - kRotationHandleDistance},
-			{center.x + kRotationHandleDistance, center.y + kRotationHandleDistance},
-			{center.x - kRotationHandleDistance, center.y + kRotationHandleDistance}
-		};
-		CGPathAddLines(path, NULL, &points[0], 4);
+		proxy = @(SpatialIndexInsert(_spatialIndex, box, isPoint));
+		_proxiesByNode[node] = proxy;
+		_nodesByProxy[proxy] = node;
+		_sceneOrder = nil;
 	}
 
-	CGPathCloseSubpath(path);
+	for (SKNode *child in node.children) {
+		[self indexNode:child withParentTransform:transform];
+	}
+}
+
+- (void)rebuildIndex {
+	_sceneOrder = nil;
 
-	if (CGPathContainsPoint(path, NULL, point, NO)) {
-		result = YES;
+	if (_spatialIndex) {
+		SpatialIndexRemoveAll(_spatialIndex);
+		[_proxiesByNode removeAllObjects];
+		[_nodesByProxy removeAllObjects];
+	} else {
+		_spatialIndex = SpatialIndexCreate();
+		_proxiesByNode = [NSMapTable mapTableWithKeyOptions:NSMapTableWeakMemory|NSMapTableObjectPointerPersonality
+											   valueOptions:NSMapTableStrongMemory];
+		_nodesByProxy = [NSMapTable strongToWeakObjectsMapTable];
 	}
 
-	CGPathRelease(path);
+	for (SKNode *child in _scene.children) {
+		[self indexNode:child withParentTransform:CGAffineTransformIdentity];
+	}
+}
 
-	return result;
+- (void)updateIndexForNode:(SKNode *)node {
+	/* Nodes are moved between parents through here, unlike the geometry changes made in the editor */
+	_sceneOrder = nil;
+	[self updateIndexForTransformedNode:node];
 }
 
-- (NSArray *)nodesContainingPoint:(CGPoint)point inNode:(SKNode *)aNode {
-	NSMutableArray *array = [NSMutableArray array];
-	for (SKNode *node in aNode.children) {
-		if ([self node:node containsPoint:point]) {
-			[array addObject:node];
+- (void)updateIndexForTransformedNode:(SKNode *)node {
+	if (!_spatialIndex || !node || node.scene != _scene)
+		return;
+
+	if (node == _scene) {
+		[self rebuildIndex];
+	} else {
+		[self indexNode:node withParentTransform:[self transformFromNode:node.parent]];
+	}
+}
+
+- (void)removeIndexForNode:(SKNode *)node {
+	if (!_spatialIndex || !node)
+		return;
+
+	NSNumber *proxy = _proxiesByNode[node];
+	if (proxy) {
+		SpatialIndexRemove(_spatialIndex, proxy.intValue);
+		[_proxiesByNode removeObjectForKey:node];
+		[_nodesByProxy removeObjectForKey:proxy];
+	}
+	[_glyphPaths removeObjectForKey:node];
+
+	for (SKNode *child in node.children) {
+		[self removeIndexForNode:child];
+	}
+}
+
+- (void)addNode:(SKNode *)node toSceneOrder:(NSUInteger *)position {
+	[_sceneOrder setObject:@((*position)++) forKey:node];
+	for (SKNode *child in node.children) {
+		[self addNode:child toSceneOrder:position];
+	}
+}
+
+- (NSMapTable *)sceneOrder {
+	if (!_sceneOrder) {
+		_sceneOrder = [NSMapTable mapTableWithKeyOptions:NSMapTableWeakMemory|NSMapTableObjectPointerPersonality
+											valueOptions:NSMapTableStrongMemory];
+		NSUInteger position = 0;
+		if (_scene) {
+			[self addNode:_scene toSceneOrder:&position];
 		}
-		if (node.children.count > 0) {
-			[array addObjectsFromArray:[self nodesContainingPoint:point inNode:node]];
+	}
+	return _sceneOrder;
+}
+
+- (NSArray *)indexedNodesWithProxies:(NSMutableData *)proxies {
+	SpatialIndexProxy *proxyList = proxies.mutableBytes;
+	NSUInteger count = proxies.length / sizeof(SpatialIndexProxy);
+
+	NSMutableArray *nodes = [NSMutableArray arrayWithCapacity:count];
+	for (NSUInteger i = 0; i < count; ++i) {
+		NSNumber *proxy = @(proxyList[i]);
+		SKNode *node = _nodesByProxy[proxy];
+		if (node && node.scene == _scene) {
+			[nodes addObject:node];
+		} else {
+			/* Nodes removed without going through removeIndexForNode: */
+			SpatialIndexRemove(_spatialIndex, proxyList[i]);
+			[_nodesByProxy removeObjectForKey:proxy];
+			if (node) {
+				[_proxiesByNode removeObjectForKey:node];
+			}
 		}
 	}
-	return array;
+	return nodes;
+}
+
+- (NSArray *)sortedNodesInSceneOrder:(NSArray *)nodes {
+	/* Report the hits in the scene's order, parents before their children, the same order clicking cycles through */
+	NSMapTable *sceneOrder = [self sceneOrder];
+	return [nodes sortedArrayUsingComparator:^NSComparisonResult(SKNode *a, SKNode *b) {
+		return [[sceneOrder objectForKey:a] compare:[sceneOrder objectForKey:b]];
+	}];
+}
+
+- (BOOL)node:(SKNode *)node containsPoint:(CGPoint)point {
+	CGPoint locationInScene = [self convertPointToScene:point];
+
+	BOOL isPoint;
+	SpatialIndexBox box = [self boxForNode:node transform:[self transformFromNode:node] isPoint:&isPoint];
+
+	if (isPoint) {
+		CGFloat radius = kRotationHandleDistance * _viewScale;
+		return fabs(locationInScene.x - box.corners[0].x) <= radius && fabs(locationInScene.y - box.corners[0].y) <= radius;
+	}
+
+	return SpatialIndexBoxContainsPoint(box, locationInScene);
+}
+
+- (NSArray *)nodesContainingPoint:(CGPoint)point inNode:(SKNode *)aNode {
+	if (!_spatialIndex)
+		return [NSArray array];
+
+	NSMutableData *proxies = [NSMutableData data];
+	SpatialIndexQueryPoint(_spatialIndex, [self convertPointToScene:point], kRotationHandleDistance * _viewScale, collectProxy, (__bridge void *)proxies);
+
+	NSArray *nodes = [self sortedNodesInSceneOrder:[self indexedNodesWithProxies:proxies]];
+
+	if (aNode != _scene) {
+		nodes = [nodes filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(SKNode *node, NSDictionary *bindings) {
+			return node != aNode && [node inParentHierarchy:aNode];
+		}]];
+	}
+
+	return nodes;
+}
+
+- (NSArray *)unsortedNodesIntersectingRect:(CGRect)rect {
+	if (!_spatialIndex)
+		return [NSArray array];
+
+	rect = CGRectStandardize(rect);
+	rect.origin = [self convertPointToScene:rect.origin];
+	rect.size.width *= _viewScale;
+	rect.size.height *= _viewScale;
+
+	NSMutableData *proxies = [NSMutableData data];
+	SpatialIndexQueryRect(_spatialIndex, rect, kRotationHandleDistance * _viewScale, collectProxy, (__bridge void *)proxies);
+
+	return [self indexedNodesWithProxies:proxies];
+}
+
+- (NSArray *)nodesIntersectingRect:(CGRect)rect {
+	return [self sortedNodesInSceneOrder:[self unsortedNodesIntersectingRect:rect]];
 }
 
 - (void)selectNodeAtPoint:(CGPoint)point {
+	_selectedNodes = nil;
+
 	NSArray *nodes = [self nodesContainingPoint:point inNode:_scene];
 	if (nodes.count) {
 		NSUInteger index = ([nodes indexOfObject:_node] + 1) % nodes.count;
@@ -618,8 +835,261 @@ anchorPoint = _anchorPoint;
 	}
 }
 
+#pragma mark Multiple selection
+
+- (NSArray *)selectedNodes {
+	if (_selectedNodes.count) {
+		return _selectedNodes;
+	} else if (_node && _node != _scene) {
+		return @[_node];
+	}
+	return @[];
+}
+
+- (void)updateMarqueeWithLocation:(CGPoint)location {
+	_marqueeRect = CGRectStandardize(CGRectMake(_marqueeOrigin.x, _marqueeOrigin.y, location.x - _marqueeOrigin.x, location.y - _marqueeOrigin.y));
+	/* The hits are only sorted in the scene's order once the marquee is released */
+	_selectedNodes = [self unsortedNodesIntersectingRect:_marqueeRect];
+	[self setNeedsDisplay:YES];
+}
+
+- (void)endMarquee {
+	_selectingWithMarquee = NO;
+
+	NSArray *nodes = [self sortedNodesInSceneOrder:_selectedNodes];
+	_selectedNodes = nodes;
+	if (nodes.count > 1) {
+		self.node = nodes.firstObject;
+	} else {
+		_selectedNodes = nil;
+		self.node = nodes.count ? nodes.firstObject : _scene;
+	}
+
+	[self setNeedsDisplay:YES];
+}
+
+- (CGRect)boundsOfSelectedNodes {
+	/* Union of the frames of the selected nodes in scene coordinates */
+	CGRect bounds = CGRectNull;
+	for (SKNode *node in _selectedNodes) {
+		NSNumber *proxy = _proxiesByNode[node];
+		if (proxy) {
+			CGRect frame = SpatialIndexBoxGetBounds(SpatialIndexGetBox(_spatialIndex, proxy.intValue));
+			if (SpatialIndexIsPoint(_spatialIndex, proxy.intValue)) {
+				frame = CGRectInset(frame, -kHandleRadius * _viewScale, -kHandleRadius * _viewScale);
+			}
+			bounds = CGRectUnion(bounds, frame);
+		}
+	}
+	return bounds;
+}
+
+- (void)updateSelectionHandles {
+	CGRect bounds = _transformingSelection ? _selectionBounds : [self boundsOfSelectedNodes];
+
+	_handlePoints[BottomLeftHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMinX(bounds), CGRectGetMinY(bounds))];
+	_handlePoints[BottomRightHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMaxX(bounds), CGRectGetMinY(bounds))];
+	_handlePoints[TopRightHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMaxX(bounds), CGRectGetMaxY(bounds))];
+	_handlePoints[TopLeftHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMinX(bounds), CGRectGetMaxY(bounds))];
+	_handlePoints[BottomMiddleHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMidX(bounds), CGRectGetMinY(bounds))];
+	_handlePoints[RightMiddleHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMaxX(bounds), CGRectGetMidY(bounds))];
+	_handlePoints[TopMiddleHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMidX(bounds), CGRectGetMaxY(bounds))];
+	_handlePoints[LeftMiddleHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMinX(bounds), CGRectGetMidY(bounds))];
+	_handlePoints[AnchorPointHandle] = [self convertPointFromScene:CGPointMake(CGRectGetMidX(bounds), CGRectGetMidY(bounds))];
+	_handlePoints[RotationHandle] = CGPointMake(_handlePoints[AnchorPointHandle].x + kRotationHandleDistance * cos(_selectionRotation),
+												_handlePoints[AnchorPointHandle].y + kRotationHandleDistance * sin(_selectionRotation));
+}
+
+- (NSDictionary *)transformStateWithNode:(SKNode *)node {
+	return @{@"node": node,
+			 @"position": [NSValue valueWithPoint:node.position],
+			 @"zRotation": @(node.zRotation),
+			 @"xScale": @(node.xScale),
+			 @"yScale": @(node.yScale)};
+}
+
+- (void)beginTransformingSelectionWithLocation:(CGPoint)location {
+	_transformingSelection = YES;
+	_selectionBounds = [self boundsOfSelectedNodes];
+	_transformOrigin = [self convertPointToScene:location];
+	_selectionRotation = 0;
+
+	/* Transform only the topmost selected nodes, the descendants follow their parents */
+	NSSet *selection = [NSSet setWithArray:_selectedNodes];
+	NSMutableArray *states = [NSMutableArray arrayWithCapacity:_selectedNodes.count];
+	for (SKNode *node in _selectedNodes) {
+		SKNode *parent = node.parent;
+		while (parent && ![selection containsObject:parent]) {
+			parent = parent.parent;
+		}
+		if (!parent) {
+			NSMutableDictionary *state = [self transformStateWithNode:node].mutableCopy;
+			CGAffineTransform transform = [self transformFromNode:node];
+			state[@"scenePosition"] = [NSValue valueWithPoint:CGPointMake(transform.tx, transform.ty)];
+			[states addObject:state];
+		}
+	}
+	_transformStates = states;
+}
+
+- (void)getZRotation:(CGFloat *)zRotation xScale:(CGFloat *)xScale yScale:(CGFloat *)yScale ofNode:(SKNode *)node state:(NSDictionary *)state
+ afterSceneTransform:(CGAffineTransform)sceneTransform {
+	/* Bring the scene transform into the parent's space, P * T * P^-1 with P going from the parent to the scene */
+	CGAffineTransform parentTransform = [self transformFromNode:node.parent];
+	parentTransform.tx = 0;
+	parentTransform.ty = 0;
+	CGAffineTransform transform = CGAffineTransformConcat(parentTransform, sceneTransform);
+	transform = CGAffineTransformConcat(transform, CGAffineTransformInvert(parentTransform));
+
+	/* Transform the node's axes, the local transform before translation */
+	CGAffineTransform localTransform = CGAffineTransformMakeScale([state[@"xScale"] doubleValue], [state[@"yScale"] doubleValue]);
+	localTransform = CGAffineTransformConcat(localTransform, CGAffineTransformMakeRotation([state[@"zRotation"] doubleValue]));
+	CGPoint xAxis = CGPointApplyAffineTransform(CGPointMake(1, 0), localTransform);
+	CGPoint newXAxis = CGPointApplyAffineTransform(xAxis, transform);
+	CGPoint newYAxis = CGPointApplyAffineTransform(CGPointApplyAffineTransform(CGPointMake(0, 1), localTransform), transform);
+
+	CGFloat length = hypot(xAxis.x, xAxis.y);
+	if (length == 0)
+		return;
+
+	/* Flip the scale rather than turning the node around when the x axis gets reversed */
+	CGFloat sign = xAxis.x * newXAxis.x + xAxis.y * newXAxis.y < 0 ? -1 : 1;
+	newXAxis = CGPointMake(sign * newXAxis.x, sign * newXAxis.y);
+
+	*zRotation += atan2(xAxis.x * newXAxis.y - xAxis.y * newXAxis.x, xAxis.x * newXAxis.x + xAxis.y * newXAxis.y);
+	*xScale *= sign * hypot(newXAxis.x, newXAxis.y) / length;
+
+	/* Shear can't be represented, only the part of the y axis perpendicular to the new x axis is kept */
+	*yScale = newYAxis.y * cos(*zRotation) - newYAxis.x * sin(*zRotation);
+}
+
+- (void)transformSelectionWithLocation:(CGPoint)location {
+	location = [self convertPointToScene:location];
+
+	CGAffineTransform transform = CGAffineTransformIdentity;
+	CGFloat rotation = 0;
+	CGFloat xScale = 1.0;
+	CGFloat yScale = 1.0;
+
+	if (_manipulatedHandle == RotationHandle) {
+		/* Rotate around the center of the selection */
+		CGPoint center = CGPointMake(CGRectGetMidX(_selectionBounds), CGRectGetMidY(_selectionBounds));
+		rotation = atan2(location.y - center.y, location.x - center.x) - atan2(_transformOrigin.y - center.y, _transformOrigin.x - center.x);
+		transform = CGAffineTransformMakeTranslation(-center.x, -center.y);
+		transform = CGAffineTransformConcat(transform, CGAffineTransformMakeRotation(rotation));
+		transform = CGAffineTransformConcat(transform, CGAffineTransformMakeTranslation(center.x, center.y));
+
+	} else if (_manipulatedHandle != AnchorPointHandle && _manipulatedHandle != MaxHandle) {
+		/* Scale keeping the side or corner opposite to the handle in place */
+		CGPoint pivot = CGPointMake(CGRectGetMidX(_selectionBounds), CGRectGetMidY(_selectionBounds));
+		BOOL scalesX = YES;
+		BOOL scalesY = YES;
+
+		switch (_manipulatedHandle) {
+			case BottomLeftHandle:
+				pivot = CGPointMake(CGRectGetMaxX(_selectionBounds), CGRectGetMaxY(_selectionBounds));
+				break;
+			case BottomRightHandle:
+				pivot = CGPointMake(CGRectGetMinX(_selectionBounds), CGRectGetMaxY(_selectionBounds));
+				break;
+			case TopRightHandle:
+				pivot = CGPointMake(CGRectGetMinX(_selectionBounds), CGRectGetMinY(_selectionBounds));
+				break;
+			case TopLeftHandle:
+				pivot = CGPointMake(CGRectGetMaxX(_selectionBounds), CGRectGetMinY(_selectionBounds));
+				break;
+			case BottomMiddleHandle:
+				pivot.y = CGRectGetMaxY(_selectionBounds);
+				scalesX = NO;
+				break;
+			case TopMiddleHandle:
+				pivot.y = CGRectGetMinY(_selectionBounds);
+				scalesX = NO;
+				break;
+			case RightMiddleHandle:
+				pivot.x = CGRectGetMinX(_selectionBounds);
+				scalesY = NO;
+				break;
+			case LeftMiddleHandle:
+				pivot.x = CGRectGetMaxX(_selectionBounds);
+				scalesY = NO;
+				break;
+			default:
+				break;
+		}
+
+		if (scalesX && _transformOrigin.x != pivot.x) {
+			xScale = (location.x - pivot.x) / (_transformOrigin.x - pivot.x);
+		}
+		if (scalesY && _transformOrigin.y != pivot.y) {
+			yScale = (location.y - pivot.y) / (_transformOrigin.y - pivot.y);
+		}
+
+		transform = CGAffineTransformMakeTranslation(-pivot.x, -pivot.y);
+		transform = CGAffineTransformConcat(transform, CGAffineTransformMakeScale(xScale, yScale));
+		transform = CGAffineTransformConcat(transform, CGAffineTransformMakeTranslation(pivot.x, pivot.y));
+
+	} else {
+		/* Move the selection */
+		transform = CGAffineTransformMakeTranslation(location.x - _transformOrigin.x, location.y - _transformOrigin.y);
+	}
+
+	_selectionRotation = rotation;
+
+	/* The rotation and scale are along the scene's axes, each node gets them in its parent's space */
+	CGAffineTransform linearTransform = transform;
+	linearTransform.tx = 0;
+	linearTransform.ty = 0;
+
+	/* Apply the same transform to all the nodes */
+	for (NSDictionary *state in _transformStates) {
+		SKNode *node = state[@"node"];
+		CGPoint scenePosition = CGPointApplyAffineTransform([state[@"scenePosition"] pointValue], transform);
+		CGPoint position = [_scene convertPoint:scenePosition toNode:node.parent];
+		CGPoint statePosition = [state[@"position"] pointValue];
+
+		CGFloat stateZRotation = [state[@"zRotation"] doubleValue];
+		CGFloat stateXScale = [state[@"xScale"] doubleValue];
+		CGFloat stateYScale = [state[@"yScale"] doubleValue];
+		CGFloat zRotation = stateZRotation;
+		CGFloat nodeXScale = stateXScale;
+		CGFloat nodeYScale = stateYScale;
+		if (!CGAffineTransformIsIdentity(linearTransform)) {
+			[self getZRotation:&zRotation xScale:&nodeXScale yScale:&nodeYScale ofNode:node state:state
+		   afterSceneTransform:linearTransform];
+		}
+
+		/* The journal merges the steps of the gesture, only the values before the first step are kept */
+		[self.undoJournal recordNode:node property:UndoJournalPropertyPosition
+							oldValue:(UndoJournalValue){statePosition.x, statePosition.y} newValue:(UndoJournalValue){position.x, position.y}];
+		[self.undoJournal recordNode:node property:UndoJournalPropertyZRotation
+							oldValue:(UndoJournalValue){stateZRotation, 0} newValue:(UndoJournalValue){zRotation, 0}];
+		[self.undoJournal recordNode:node property:UndoJournalPropertyXScale
+							oldValue:(UndoJournalValue){stateXScale, 0} newValue:(UndoJournalValue){nodeXScale, 0}];
+		[self.undoJournal recordNode:node property:UndoJournalPropertyYScale
+							oldValue:(UndoJournalValue){stateYScale, 0} newValue:(UndoJournalValue){nodeYScale, 0}];
+
+		node.position = position;
+		node.zRotation = zRotation;
+		node.xScale = nodeXScale;
+		node.yScale = nodeYScale;
+		[self updateIndexForTransformedNode:node];
+	}
+
+	[self setNeedsDisplay:YES];
+}
+
+- (void)endTransformingSelection {
+	_transformingSelection = NO;
+	_selectionRotation = 0;
+	_transformStates = nil;
+}
+
 - (void)dealloc {
 	[self unbindFromSelectedNode];
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
+	SpatialIndexRelease(_spatialIndex);
 }
 
 #pragma mark Drawing
@@ -644,144 +1114,327 @@ anchorPoint = _anchorPoint;
 
 	[path stroke];
 
-	/* Draw the scene nodes */
-	_selectionPath = nil;
-	[self drawSelectionInNode:_scene];
+	/* Draw the glyphs of the nodes that are visible and need to be redrawn */
+	[self drawGlyphsInRect:NSIntersectionRect(dirtyRect, self.visibleRect)];
 
-	/* Draw selection */
-	if (_selectionPath && !_selectionPath.isEmpty) {
-		[[NSColor colorWithRed:0.4 green:0.5 blue:1.0 alpha:1.0] setStroke];
+	if (_selectedNodes.count > 1 || _selectingWithMarquee) {
+		[self drawSelectedNodes];
+	} else if (_node && _node != _scene) {
+		[self drawHandles];
+	}
+}
 
-		/* Set the glow effect */
-		NSShadow *shadow = [[NSShadow alloc] init];
-		[shadow setShadowBlurRadius:2.0];
-		[shadow setShadowColor:[NSColor whiteColor]];
-		[shadow set];
+- (void)drawSelectedNodes {
+	NSColor *whiteColor = [NSColor whiteColor];
+	NSColor *blueColor = [NSColor colorWithCalibratedRed:0.345 green:0.337 blue:0.961 alpha:1.0];
 
-		// TODO: Avoid drawing multiple times to get the glow effect
-		for (int i = 0; i < 8; ++i) {
-			[_selectionPath stroke];
+	/* Draw the outline of every selected node in a single path */
+	NSBezierPath *outlinePath = [NSBezierPath bezierPath];
+	for (SKNode *node in _selectedNodes) {
+		NSNumber *proxy = _proxiesByNode[node];
+		if (!proxy)
+			continue;
+
+		SpatialIndexBox box = SpatialIndexGetBox(_spatialIndex, proxy.intValue);
+		if (SpatialIndexIsPoint(_spatialIndex, proxy.intValue)) {
+			CGPoint center = [self convertPointFromScene:box.corners[0]];
+			[outlinePath appendBezierPathWithRect:CGRectMake(center.x - 2 * kHandleRadius, center.y - 2 * kHandleRadius, 4 * kHandleRadius, 4 * kHandleRadius)];
+		} else {
+			CGPoint points[4];
+			for (int i = 0; i < 4; ++i) {
+				points[i] = [self convertPointFromScene:box.corners[i]];
+			}
+			[outlinePath appendBezierPathWithPoints:points count:4];
+			[outlinePath closePath];
 		}
 	}
-	if (_node && _node != _scene) {
-		[self drawHandles];
+	[blueColor setStroke];
+	[outlinePath setLineWidth:1.0];
+	[outlinePath stroke];
+
+	/* Draw the marquee */
+	if (_selectingWithMarquee) {
+		[[blueColor colorWithAlphaComponent:0.2] setFill];
+		NSRectFillUsingOperation(_marqueeRect, NSCompositeSourceOver);
+		[whiteColor setStroke];
+		[NSBezierPath strokeRect:_marqueeRect];
+		return;
 	}
-}
 
-- (void)drawSelectionInNode:(SKNode *)aNode {
+	/* Draw the handles of the selection bounds */
+	[self updateSelectionHandles];
 
-	CGContextRef ctx = [[NSGraphicsContext currentContext] graphicsPort];
-	CGContextSaveGState(ctx);
+	NSBezierPath *boundsPath = [NSBezierPath bezierPath];
+	[boundsPath appendBezierPathWithPoints:&_handlePoints[BottomLeftHandle] count:4];
+	[boundsPath closePath];
+	[whiteColor setStroke];
+	[boundsPath setLineWidth:1.0];
+	[boundsPath stroke];
 
+	const CGFloat handleLineWidth = 1.5;
 	NSBezierPath *path = [NSBezierPath bezierPath];
-	[path setLineWidth:2.0];
+	[path setLineWidth:handleLineWidth];
+	for (int i = BottomLeftHandle; i <= LeftMiddleHandle; ++i) {
+		[path appendBezierPathWithCircleWithCenter:_handlePoints[i] radius:kHandleRadius];
+	}
+	[blueColor setFill];
+	[whiteColor setStroke];
+	[path fill];
+	[path stroke];
 
-	CGPoint center = [_scene convertPoint:CGPointZero fromNode:aNode];
-	center.x /= _viewScale;
-	center.y /= _viewScale;
-	center.x += _viewOrigin.x;
-	center.y += _viewOrigin.y;
+	/* Rotation handle */
+	[NSBezierPath strokeLineFromPoint:_handlePoints[AnchorPointHandle] toPoint:_handlePoints[RotationHandle]];
+	[self drawCircleWithCenter:_handlePoints[RotationHandle] radius:4.0 fillColor:blueColor strokeColor:whiteColor lineWidth:handleLineWidth];
+}
 
-	NSColor *color = nil;
+- (NSString *)glyphNameForNode:(SKNode *)node {
+	if ([node isMemberOfClass:[SKNode class]]) {
+		return @"node";
+	} else if ([node isKindOfClass:[SKEmitterNode class]]) {
+		return @"emitter";
+	} else if ([node isKindOfClass:[SKLightNode class]]) {
+		return @"light";
+	} else if ([node isKindOfClass:[SKFieldNode class]]) {
+		return @"field";
+	}
+	return nil;
+}
 
-	if ([aNode isMemberOfClass:[SKNode class]]) {
+- (NSDictionary *)glyphs {
+	/* Glyph paths centered at the origin, they don't change with the view scale */
+	static NSDictionary *glyphs = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		NSBezierPath *path = [NSBezierPath bezierPath];
 
 		const CGFloat halfWidth = 11;
 		const CGFloat dashSize = 8;
 
-		const CGFloat leftEdge = center.x - halfWidth;
-		const CGFloat rightEdge = center.x + halfWidth;
-		const CGFloat topEdge = center.y + halfWidth;
-		const CGFloat bottomEdge = center.y - halfWidth;
-
-		[path moveToPoint:CGPointMake(leftEdge, bottomEdge + dashSize)];
-		[path lineToPoint:CGPointMake(leftEdge, bottomEdge)];
-		[path lineToPoint:CGPointMake(leftEdge + dashSize, bottomEdge)];
+		[path moveToPoint:CGPointMake(-halfWidth, -halfWidth + dashSize)];
+		[path lineToPoint:CGPointMake(-halfWidth, -halfWidth)];
+		[path lineToPoint:CGPointMake(-halfWidth + dashSize, -halfWidth)];
 
-		[path moveToPoint:CGPointMake(rightEdge - dashSize, bottomEdge)];
-		[path lineToPoint:CGPointMake(rightEdge, bottomEdge)];
-		[path lineToPoint:CGPointMake(rightEdge, bottomEdge + dashSize)];
+		[path moveToPoint:CGPointMake(halfWidth - dashSize, -halfWidth)];
+		[path lineToPoint:CGPointMake(halfWidth, -halfWidth)];
+		[path lineToPoint:CGPointMake(halfWidth, -halfWidth + dashSize)];
 
-		[path moveToPoint:CGPointMake(rightEdge, topEdge - dashSize)];
-		[path lineToPoint:CGPointMake(rightEdge, topEdge)];
-		[path lineToPoint:CGPointMake(rightEdge - dashSize, topEdge)];
+		[path moveToPoint:CGPointMake(halfWidth, halfWidth - dashSize)];
+		[path lineToPoint:CGPointMake(halfWidth, halfWidth)];
+		[path lineToPoint:CGPointMake(halfWidth - dashSize, halfWidth)];
 
-		[path moveToPoint:CGPointMake(leftEdge + dashSize, topEdge)];
-		[path lineToPoint:CGPointMake(leftEdge, topEdge)];
-		[path lineToPoint:CGPointMake(leftEdge, topEdge - dashSize)];
+		[path moveToPoint:CGPointMake(-halfWidth + dashSize, halfWidth)];
+		[path lineToPoint:CGPointMake(-halfWidth, halfWidth)];
+		[path lineToPoint:CGPointMake(-halfWidth, halfWidth - dashSize)];
 
-		color = [NSColor magentaColor];
-
-	} else if ([aNode isKindOfClass:[SKEmitterNode class]]) {
+		NSBezierPath *nodePath = path;
 
 		const CGFloat distance = 8.0;
-
-		CGFloat angles[] = {
+		CGFloat emitterAngles[] = {
 			GLKMathDegreesToRadians(30),
 			GLKMathDegreesToRadians(150),
 			GLKMathDegreesToRadians(270)
 		};
 
+		path = [NSBezierPath bezierPath];
 		for (int i = 0; i < 3; ++i) {
-			[path appendBezierPathWithCircleWithCenter:CGPointMake(center.x + distance * cos(angles[i]), center.y + distance * sin(angles[i]))
+			[path appendBezierPathWithCircleWithCenter:CGPointMake(distance * cos(emitterAngles[i]), distance * sin(emitterAngles[i]))
 												radius:kHandleRadius];
 		}
 
-		color = [NSColor magentaColor];
+		NSBezierPath *emitterPath = path;
 
-	} else if ([aNode isKindOfClass:[SKLightNode class]]) {
-
-		const CGFloat distance1 = 8.0;
-		const CGFloat distance2 = 16.0;
-
-		[path appendBezierPathWithCircleWithCenter:center radius:distance1];
-
-		CGFloat angles[] = {
+		const CGFloat lightDistance1 = 8.0;
+		const CGFloat lightDistance2 = 16.0;
+		CGFloat lightAngles[] = {
 			GLKMathDegreesToRadians(45),
 			GLKMathDegreesToRadians(135),
 			GLKMathDegreesToRadians(225),
 			GLKMathDegreesToRadians(315)
 		};
 
+		path = [NSBezierPath bezierPath];
+		[path appendBezierPathWithCircleWithCenter:CGPointZero radius:lightDistance1];
 		for (int i = 0; i < 4; ++i) {
-			CGFloat cosine = cos(angles[i]);
-			CGFloat sine = sin(angles[i]);
-			[path moveToPoint:CGPointMake(center.x + distance1 * cosine, center.y + distance1 * sine)];
-			[path lineToPoint:CGPointMake(center.x + distance2 * cosine, center.y + distance2 * sine)];
+			CGFloat cosine = cos(lightAngles[i]);
+			CGFloat sine = sin(lightAngles[i]);
+			[path moveToPoint:CGPointMake(lightDistance1 * cosine, lightDistance1 * sine)];
+			[path lineToPoint:CGPointMake(lightDistance2 * cosine, lightDistance2 * sine)];
 		}
 
-		color = [NSColor yellowColor];
+		NSBezierPath *lightPath = path;
 
-	} else if ([aNode isKindOfClass:[SKFieldNode class]]) {
+		path = [NSBezierPath bezierPath];
+		[path appendBezierPathWithCircleWithCenter:CGPointZero radius:4.25];
+		[path appendBezierPathWithCircleWithCenter:CGPointZero radius:11.25];
 
-		const CGFloat distance1 = 4.25;
-		const CGFloat distance2 = 11.25;
+		NSBezierPath *fieldPath = path;
 
-		[path appendBezierPathWithCircleWithCenter:center radius:distance1];
-		[path appendBezierPathWithCircleWithCenter:center radius:distance2];
+		glyphs = @{@"node": @{@"path": nodePath, @"color": [NSColor magentaColor]},
+				   @"emitter": @{@"path": emitterPath, @"color": [NSColor magentaColor]},
+				   @"light": @{@"path": lightPath, @"color": [NSColor yellowColor]},
+				   @"field": @{@"path": fieldPath, @"color": [NSColor cyanColor]}};
+	});
+	return glyphs;
+}
 
-		color = [NSColor cyanColor];
+- (NSBezierPath *)glyphPathForNode:(SKNode *)node name:(NSString *)name {
+	/* The cached paths are scaled to the view but not panned, start over only when the view is zoomed */
+	if (_glyphsViewScale != _viewScale) {
+		[_glyphPaths removeAllObjects];
+		_glyphsViewScale = _viewScale;
+	}
 
+	if (!_glyphPaths) {
+		_glyphPaths = [NSMapTable weakToStrongObjectsMapTable];
 	}
 
-	if (_node != _scene && _node == aNode) {
-		_selectionPath = path.copy;
-	} else {
+	NSBezierPath *path = _glyphPaths[node];
+	if (!path) {
+		NSNumber *proxy = _proxiesByNode[node];
+		CGPoint center = proxy ? SpatialIndexGetBox(_spatialIndex, proxy.intValue).corners[0] : CGPointZero;
+		center = CGPointMake(center.x / _viewScale, center.y / _viewScale);
+
+		NSAffineTransform *transform = [NSAffineTransform transform];
+		[transform translateXBy:center.x yBy:center.y];
+
+		path = [[self glyphs][name][@"path"] copy];
+		[path transformUsingAffineTransform:transform];
+
+		_glyphPaths[node] = path;
+	}
+	return path;
+}
+
+- (NSImage *)glowImageForGlyphWithName:(NSString *)name {
+	if (!_glowImages) {
+		_glowImages = [NSMutableDictionary dictionary];
+	}
+
+	NSImage *image = _glowImages[name];
+	if (!image) {
+		NSBezierPath *path = [[self glyphs][name][@"path"] copy];
+		[path setLineWidth:2.0];
+
+		/* Center the glyph leaving room for the blur around it */
+		CGRect glyphBounds = path.bounds;
+		CGFloat halfWidth = MAX(fabs(CGRectGetMinX(glyphBounds)), fabs(CGRectGetMaxX(glyphBounds))) + 8.0;
+		CGFloat halfHeight = MAX(fabs(CGRectGetMinY(glyphBounds)), fabs(CGRectGetMaxY(glyphBounds))) + 8.0;
+		CGRect bounds = CGRectMake(-halfWidth, -halfHeight, 2 * halfWidth, 2 * halfHeight);
+
+		NSAffineTransform *transform = [NSAffineTransform transform];
+		[transform translateXBy:-bounds.origin.x yBy:-bounds.origin.y];
+		[path transformUsingAffineTransform:transform];
+
+		image = [NSImage imageWithSize:bounds.size flipped:NO drawingHandler:^BOOL(NSRect dstRect) {
+			[[NSColor colorWithRed:0.4 green:0.5 blue:1.0 alpha:1.0] setStroke];
+
+			/* Set the glow effect */
+			NSShadow *shadow = [[NSShadow alloc] init];
+			[shadow setShadowBlurRadius:2.0];
+			[shadow setShadowColor:[NSColor whiteColor]];
+			[shadow set];
+
+			/* Accumulate the shadow to make the glow visible, this is done only once per glyph */
+			for (int i = 0; i < 8; ++i) {
+				[path stroke];
+			}
+			return YES;
+		}];
+
+		_glowImages[name] = image;
+	}
+	return image;
+}
+
+- (void)drawGlyphsInRect:(CGRect)rect {
+	if (CGRectIsEmpty(rect))
+		return;
+
+	/* Stroke the glyphs of the same color in a single path */
+	NSMutableDictionary *paths = [NSMutableDictionary dictionary];
+	NSString *selectionGlyphName = nil;
+
+	/* The glyphs are batched by color, they are drawn in any order */
+	for (SKNode *node in [self unsortedNodesIntersectingRect:rect]) {
+		NSString *name = [self glyphNameForNode:node];
+		if (!name)
+			continue;
+
+		if (node == _node) {
+			selectionGlyphName = name;
+			continue;
+		}
+
+		NSColor *color = [self glyphs][name][@"color"];
+		NSBezierPath *path = paths[color];
+		if (!path) {
+			path = [NSBezierPath bezierPath];
+			[path setLineWidth:2.0];
+			paths[color] = path;
+		}
+		[path appendBezierPath:[self glyphPathForNode:node name:name]];
+	}
+
+	/* Pan the cached paths to the view's origin */
+	[NSGraphicsContext saveGraphicsState];
+	NSAffineTransform *transform = [NSAffineTransform transform];
+	[transform translateXBy:_viewOrigin.x yBy:_viewOrigin.y];
+	[transform concat];
+	for (NSColor *color in paths) {
 		[color setStroke];
-		[path stroke];
+		[paths[color] stroke];
 	}
+	[NSGraphicsContext restoreGraphicsState];
 
-	CGContextRestoreGState(ctx);
+	/* Draw the selection with the cached glow */
+	if (selectionGlyphName) {
+		NSImage *image = [self glowImageForGlyphWithName:selectionGlyphName];
+		NSNumber *proxy = _proxiesByNode[_node];
+		CGPoint center = [self convertPointFromScene:SpatialIndexGetBox(_spatialIndex, proxy.intValue).corners[0]];
+
+		/* The glyph is centered in the image */
+		CGPoint origin = CGPointMake(center.x - 0.5 * image.size.width, center.y - 0.5 * image.size.height);
+		[image drawAtPoint:origin fromRect:NSZeroRect operation:NSCompositeSourceOver fraction:1.0];
+	}
+}
+
+- (CGRect)handlesRect {
+	/* Area covered by the handles, the rotation circle and the selection glyph */
+	CGRect rect = CGRectMake(_handlePoints[AnchorPointHandle].x - kRotationHandleDistance, _handlePoints[AnchorPointHandle].y - kRotationHandleDistance,
+							 2 * kRotationHandleDistance, 2 * kRotationHandleDistance);
+	for (int i = AnchorPointHandle; i < MaxHandle; ++i) {
+		rect = CGRectUnion(rect, [self handleRectFromPoint:_handlePoints[i]]);
+	}
+
+	if (_node.parent && _node.parent != _scene) {
+		CGPoint parentPosition = [self convertPointFromScene:[_scene convertPoint:CGPointZero fromNode:_node.parent]];
+		rect = CGRectUnion(rect, CGRectMake(parentPosition.x, parentPosition.y, 0, 0));
+	}
 
-	for (SKNode *node in aNode.children) {
-		[self drawSelectionInNode:node];
+	/* Room for the shadows */
+	return CGRectInset(rect, -8.0, -8.0);
+}
+
+- (void)invalidateHandles {
+	/* Redraw everything when other nodes move with the selection */
+	if (_node == _scene || _node.children.count || _selectedNodes.count || CGRectIsEmpty(_handlesRect)) {
+		[self setNeedsDisplay:YES];
+		return;
 	}
+
+	/* Otherwise redraw only the area of the handles at their old and new locations */
+	[self setNeedsDisplayInRect:_handlesRect];
+	[self updateHandles];
+	_handlesRect = [self handlesRect];
+	[self setNeedsDisplayInRect:_handlesRect];
 }
 
 - (void)drawHandles {
 
 	[self updateHandles];
 
+	_handlesRect = [self handlesRect];
+
 	NSColor *whiteColor = [NSColor whiteColor];
 	NSColor *blueColor = [NSColor colorWithCalibratedRed:0.345 green:0.337 blue:0.961 alpha:1.0];
 	NSColor *orangeColor = [NSColor colorWithRed:1.0 green:0.9 blue:0.0 alpha:1.0];
@@ -905,12 +1558,51 @@ anchorPoint = _anchorPoint;
 - (void)mouseDown:(NSEvent *)theEvent {
 	[[self window] makeFirstResponder:self];
 	_dragging = NO;
+
+	_logsObservation = [[NSUserDefaults standardUserDefaults] boolForKey:@"LogEditorObservation"];
+	_loggedChangeCount = _observedChangeCount;
+	_loggedSelectionUpdateCount = _selectionUpdateCount;
+
+	/* Everything changed until the mouse is released is undone at once */
+	[self beginUndoGroup];
 }
 
 - (void)mouseDragged:(NSEvent *)theEvent {
+	if (_logsObservation) {
+		NSLog(@"Previous drag event: %lu observed changes of %lu keys, %lu selection updates", (unsigned long)(_observedChangeCount - _loggedChangeCount),
+			  (unsigned long)_boundAttributes.count, (unsigned long)(_selectionUpdateCount - _loggedSelectionUpdateCount));
+		_loggedChangeCount = _observedChangeCount;
+		_loggedSelectionUpdateCount = _selectionUpdateCount;
+	}
+
 	if (_scene) {
 		CGPoint locationInScene = [self convertPoint:theEvent.locationInWindow fromView:nil];
 
+		if (!_dragging && _selectedNodes.count > 1) {
+			/* Transform the selected nodes when dragging the selection bounds or any of its handles */
+			[self updateSelectionHandles];
+			_manipulatedHandle = [self manipulatedHandleWithPoint:locationInScene];
+			CGRect bounds = CGRectStandardize(CGRectMake(_handlePoints[BottomLeftHandle].x, _handlePoints[BottomLeftHandle].y,
+														 _handlePoints[TopRightHandle].x - _handlePoints[BottomLeftHandle].x,
+														 _handlePoints[TopRightHandle].y - _handlePoints[BottomLeftHandle].y));
+			if (_manipulatedHandle != MaxHandle || CGRectContainsPoint(bounds, locationInScene)) {
+				[self beginTransformingSelectionWithLocation:locationInScene];
+				_dragging = YES;
+				return;
+			}
+			_selectedNodes = nil;
+		}
+
+		if (!_dragging && (theEvent.modifierFlags & NSShiftKeyMask)) {
+			/* Start a marquee selection */
+			_selectingWithMarquee = YES;
+			_marqueeOrigin = locationInScene;
+			_marqueeRect = CGRectZero;
+			_selectedNodes = nil;
+			_dragging = YES;
+			return;
+		}
+
 		if (!_dragging) {
 			/* Ensure that there is something selected */
 			if (!_node || _node == _scene) {
@@ -947,6 +1639,10 @@ anchorPoint = _anchorPoint;
 			}
 
 			_dragging = YES;
+		} else if (_selectingWithMarquee) {
+			[self updateMarqueeWithLocation:locationInScene];
+		} else if (_transformingSelection) {
+			[self transformSelectionWithLocation:locationInScene];
 		} else {
 			[self updateSelectionWithLocationInScene:locationInScene];
 		}
@@ -958,8 +1654,15 @@ anchorPoint = _anchorPoint;
 }
 
 - (void)mouseUp:(NSEvent *)theEvent {
+	if (_selectingWithMarquee) {
+		[self endMarquee];
+	} else if (_transformingSelection) {
+		[self endTransformingSelection];
+	}
+
 	_manipulatingHandle = NO;
-	_registeredUndo = NO;
+
+	[self endUndoGroup];
 
 	if (_scene && !_dragging) {
 		CGPoint locationInScene = [self convertPoint:theEvent.locationInWindow fromView:nil];
@@ -992,99 +1695,184 @@ anchorPoint = _anchorPoint;
 
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
 	if (object == _node) {
+		++_observedChangeCount;
+
+		/* Only geometry keys are observed, all of them go to the undo journal */
+		UndoJournalProperty property = (UndoJournalProperty)[UndoJournal propertyWithKey:keyPath];
+		if (!_replayingUndoJournal) {
+			/* The changes outside of a gesture are grouped until the next run loop iteration */
+			if (!self.undoJournal.isGrouping) {
+				[self beginUndoGroup];
+				[self performSelector:@selector(endUndoGroup) withObject:nil afterDelay:0];
+			}
+			[_undoJournal recordNode:object property:property
+							oldValue:[UndoJournal valueWithObject:change[NSKeyValueChangeOldKey] property:property]
+							newValue:[UndoJournal valueWithObject:change[NSKeyValueChangeNewKey] property:property]];
+		}
 
-		/* Try to register the undo operation for the observed change */
-		if (![keyPath isEqualToString:@"visibleRect"]
-			&& ![keyPath isEqualToString:@"children"]) {
+		/* Keep the selection geometry current, the drag handling reads it between changes */
+		if (object != _scene) {
+			switch (property) {
+				case UndoJournalPropertyPosition:
+					self.position = _node.position;
+					break;
+				case UndoJournalPropertyZRotation:
+					self.zRotation = _node.zRotation;
+					break;
+				case UndoJournalPropertySize:
+					self.size = [(id)_node size];
+					break;
+				case UndoJournalPropertyAnchorPoint:
+					self.anchorPoint = [(id)_node anchorPoint];
+					break;
+				default:
+					break;
+			}
 
-			id oldValue = [change objectForKey:NSKeyValueChangeOldKey];
-			id newValue = [change objectForKey:NSKeyValueChangeNewKey];
+			/* Hit-testing right after the change must find the node where it is now */
+			[self updateIndexForTransformedNode:_node];
+		}
 
-			if (!_registeredUndo && ![oldValue isEqual:newValue]) {
+		[self setNeedsSelectionUpdate];
+	} else {
+		[super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+	}
+}
 
-				if ([_compoundUndo valueForKey:keyPath]) {
-					/* Register all the stored undo operations in a single invocation by the undo manager */
-					[[[self undoManager] prepareWithInvocationTarget:self] performUndoWithInfo:_compoundUndo];
+- (void)setNeedsSelectionUpdate {
+	/* Every change in the same run loop iteration is handled by a single update */
+	if (!_needsSelectionUpdate) {
+		_needsSelectionUpdate = YES;
+		[self performSelector:@selector(updateSelection) withObject:nil afterDelay:0 inModes:@[NSRunLoopCommonModes]];
+	}
+}
 
-					_compoundUndo = nil;
-					_registeredUndo = YES;
+- (void)updateSelection {
+	if (!_needsSelectionUpdate)
+		return;
+	_needsSelectionUpdate = NO;
+	++_selectionUpdateCount;
 
-				} else {
-					/* Some undo operations are compound of several observed changes,
-					 thus store this single undo operation for later registration */
-					if (!_compoundUndo)
-						_compoundUndo = [NSMutableDictionary dictionary];
+	/* The index of the selection is updated with every change, only the editor view's visible rect is left */
+	if (!_node || _node == _scene) {
+		[self updateVisibleRect];
+	}
 
-					[_compoundUndo setObject:@{@"object": object, @"value": oldValue} forKey:keyPath];
-				}
-			}
-		}
+	[self invalidateHandles];
+}
 
-		/* Update the current selection and editor view's visible rect */
-		if (object != _scene) {
-			[self setValue:[object valueForKey:@"position"] forKey:@"position"];
-			[self setValue:[object valueForKey:@"size"] forKey:@"size"];
-			[self setValue:[object valueForKey:@"zRotation"] forKey:@"zRotation"];
-			[self setValue:[object valueForKey:@"anchorPoint"] forKey:@"anchorPoint"];
-		} else {
-			[self updateVisibleRect];
+- (void)attributeDidChangeValue:(NSNotification *)notification {
+	/* The geometry changes are journaled when observed */
+	NSString *keyPath = notification.userInfo[AttributeNodeKeyPathKey];
+	if (!notification.object || _replayingUndoJournal || [UndoJournal propertyWithKey:keyPath] != NSNotFound)
+		return;
+
+	/* The changes made in the same run loop iteration are undone at once, split values change several key paths at once */
+	if (!self.undoJournal.isGrouping) {
+		[self beginUndoGroup];
+		[self performSelector:@selector(endUndoGroup) withObject:nil afterDelay:0];
+	}
+	id object = notification.object;
+	id oldValue = notification.userInfo[AttributeNodeOldValueKey];
+	[_undoJournal recordObject:object keyPath:keyPath oldValue:oldValue == [NSNull null] ? nil : oldValue newValue:[object valueForKeyPath:keyPath]];
+}
+
+- (UndoJournal *)undoJournal {
+	if (!_undoJournal) {
+		_undoJournal = [[UndoJournal alloc] init];
+		NSUInteger memoryLimit = [[NSUserDefaults standardUserDefaults] integerForKey:@"UndoJournalMemoryLimit"];
+		if (memoryLimit > 0) {
+			_undoJournal.memoryLimit = memoryLimit;
 		}
+	}
+	return _undoJournal;
+}
 
-		dispatch_async(dispatch_get_main_queue(), ^{
-			[self setNeedsDisplay:YES];
-		});
-	} else {
-		[super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+- (void)beginUndoGroup {
+	[self.undoJournal beginGroup];
+}
+
+- (void)endUndoGroup {
+	NSInteger group = [self.undoJournal endGroup];
+	if (group != NSNotFound) {
+		[[self undoManager] registerUndoWithTarget:self selector:@selector(revertUndoGroup:) object:@(group)];
 	}
 }
 
-- (void)performUndoWithInfo:(id)info {
+- (void)revertUndoGroup:(NSNumber *)group {
+	[self replayUndoGroup:group reverting:YES];
+}
 
-	NSMutableDictionary *redoInfo = [NSMutableDictionary dictionary];
-	for (id key in info) {
-		id operation = info[key];
+- (void)reapplyUndoGroup:(NSNumber *)group {
+	[self replayUndoGroup:group reverting:NO];
+}
 
-		id object = operation[@"object"];
-		id value = operation[@"value"];
-		id redoValue = [object valueForKey:key];
+- (void)replayUndoGroup:(NSNumber *)group reverting:(BOOL)reverting {
+	/* Avoid journaling the changes being replayed */
+	_replayingUndoJournal = YES;
+	NSArray *nodes = reverting ? [_undoJournal revertGroup:group.integerValue] : [_undoJournal reapplyGroup:group.integerValue];
+	_replayingUndoJournal = NO;
 
-		redoInfo[key] = @{@"object": object, @"value": redoValue};
+	/* The group was dropped to keep the journal within its memory limit */
+	if (!nodes)
+		return;
 
-		[object setValue:value forKey:key];
-		[self setNode:object];
+	/* Key path records can belong to objects other than nodes, like physics bodies */
+	for (id node in nodes) {
+		if ([node isKindOfClass:[SKNode class]]) {
+			[self updateIndexForTransformedNode:node];
+		}
+	}
+	if (nodes.count == 1 && [nodes.firstObject isKindOfClass:[SKNode class]]) {
+		[self setNode:nodes.firstObject];
 	}
 
-	[[[self undoManager] prepareWithInvocationTarget:self] performUndoWithInfo:redoInfo];
+	[[self undoManager] registerUndoWithTarget:self selector:reverting ? @selector(reapplyUndoGroup:) : @selector(revertUndoGroup:) object:group];
 
-	_registeredUndo = NO;
-	_compoundUndo = nil;
-	
 	[self setNeedsDisplay:YES];
 }
 
 #pragma mark Bindings
 
-- (void)bindToSelectedNode {
-	/* Start observing all properties in the selected node */
-	_boundAttributes = [NSMutableSet set];
-	Class classType = [_node class];
-	do {
-		unsigned int count;
-		objc_property_t *properties = class_copyPropertyList(classType, &count);
-
-		if (count) {
-			for (unsigned int i = 0; i < count; i++) {
-				NSString *key = [NSString stringWithUTF8String:property_getName(properties[i])];
-				if (![_boundAttributes containsObject:key]) {
-					[_boundAttributes addObject:key];
-					[_node addObserver:self forKeyPath:key options:NSKeyValueObservingOptionOld|NSKeyValueObservingOptionNew context:nil];
-				}
++ (NSArray *)observedKeysForClass:(Class)classType {
+	/* The geometry keys the class implements, the list is cached per class so that selecting is constant time */
+	static NSMapTable *keysByClass = nil;
+	if (!keysByClass) {
+		keysByClass = [NSMapTable strongToStrongObjectsMapTable];
+	}
+	NSArray *keys = [keysByClass objectForKey:classType];
+	if (!keys) {
+		NSMutableArray *classKeys = [NSMutableArray array];
+		for (NSString *key in @[@"position", @"zRotation", @"xScale", @"yScale", @"size", @"anchorPoint"]) {
+			if ([classType instancesRespondToSelector:NSSelectorFromString(key)]) {
+				[classKeys addObject:key];
 			}
-			free(properties);
 		}
+		keys = classKeys;
+		[keysByClass setObject:keys forKey:classType];
+	}
+	return keys;
+}
+
+- (void)bindToSelectedNode {
+	/* The inspector reports the edits of the other properties for undo */
+	if (!_observingAttributeChanges) {
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(attributeDidChangeValue:) name:AttributeNodeDidChangeValueNotification object:nil];
+		_observingAttributeChanges = YES;
+	}
+
+	/* Start observing the geometry of the selected node, what the overlay and the undo journal need */
+	_boundAttributes = _node ? [EditorView observedKeysForClass:[_node class]] : nil;
+	for (NSString *key in _boundAttributes) {
+		[_node addObserver:self forKeyPath:key options:NSKeyValueObservingOptionOld|NSKeyValueObservingOptionNew context:nil];
+	}
 
-		classType = [classType superclass];
-	} while (classType != nil && classType != [SKNode superclass]);
+	if (_node && _node != _scene) {
+		self.position = _node.position;
+		self.zRotation = _node.zRotation;
+		self.size = [_node respondsToSelector:@selector(size)] ? [(id)_node size] : CGSizeZero;
+		self.anchorPoint = [_node respondsToSelector:@selector(anchorPoint)] ? [(id)_node anchorPoint] : CGPointZero;
+	}
 }
 
 - (void)unbindFromSelectedNode {
@@ -1136,6 +1924,9 @@ anchorPoint = _anchorPoint;
 
 	_scene = scene;
 
+	/* The journaled changes belong to the previous scene */
+	[_undoJournal removeAllGroups];
+
 	/* Set the view scale to the default value */
 	_viewScale = 1.0;
 
@@ -1144,6 +1935,9 @@ anchorPoint = _anchorPoint;
 	CGSize sceneSize = _scene.size;
 	_viewOrigin = CGPointMake(0.5 * (viewSize.width - sceneSize.width),
 							  0.5 * (viewSize.height - sceneSize.height));
+
+	/* Index the nodes for hit-testing */
+	[self rebuildIndex];
 }
 
 - (SKScene *)scene {
@@ -1159,13 +1953,28 @@ anchorPoint = _anchorPoint;
 		self.wantsLayer = YES;
 	}
 
+	/* Selecting a node outside of the multiple selection clears it */
+	if (_selectedNodes && ![_selectedNodes containsObject:node]) {
+		_selectedNodes = nil;
+		[self setNeedsDisplay:YES];
+	}
+
 	/* Clear the properties bindings */
 	[self unbindFromSelectedNode];
 
 	_node = node;
 
+	/* Redraw the old and new selections */
+	_handlesRect = CGRectNull;
+	[self setNeedsDisplay:YES];
+
 	//self.scene = _node.scene;
 
+	/* Nodes get selected when they are inserted, keep the index up to date with them */
+	if (_node != _scene) {
+		[self updateIndexForTransformedNode:_node];
+	}
+
 	/* Craete the new bindings */
 	[self bindToSelectedNode];
 
@@ -1179,4 +1988,16 @@ anchorPoint = _anchorPoint;
 	return _node;
 }
 
+- (NSUInteger)observedKeyCount {
+	return _boundAttributes.count;
+}
+
+- (NSUInteger)observedChangeCount {
+	return _observedChangeCount;
+}
+
+- (NSUInteger)selectionUpdateCount {
+	return _selectionUpdateCount;
+}
+
 @end
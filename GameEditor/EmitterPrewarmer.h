@@ -0,0 +1,46 @@
+/*
+ * EmitterPrewarmer.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <SpriteKit/SpriteKit.h>
+
+/*
+ Advances the emitters of a scene being opened so that they don't show up cold. The emitters are
+ simulated in parallel batches before the scene is presented. Sprite Kit has no way to copy the
+ particles of an emitter, so every configuration of particle parameters in an opened scene leaves
+ one emitter that is warmed in the background and kept outside of any scene: on the next open, an
+ emitter with the same particle parameters, wherever it's placed, is replaced by it instead of
+ being simulated again
+ */
+@interface EmitterPrewarmer : NSObject
+- (void)prewarmEmittersInNode:(SKNode *)node;
+- (void)waitForPendingEmitters;
+- (void)removeAllEmitters;
++ (NSData *)configurationOfEmitter:(SKEmitterNode *)emitter;
+@property (assign) NSUInteger batchSize;
+@property (assign) CGFloat lifetimeFraction;
+@property (readonly) NSUInteger simulatedEmitterCount;
+@property (readonly) NSUInteger reusedEmitterCount;
+@end
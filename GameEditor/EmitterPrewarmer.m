@@ -0,0 +1,255 @@
+/*
+ * EmitterPrewarmer.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "EmitterPrewarmer.h"
+#import "TextureRegistry.h"
+#import "AttributeSchema.h"
+
+static const NSUInteger kDefaultBatchSize = 8;
+
+/* Fraction of the particle's lifetime that looks like an emitter that has been running for a while */
+static const CGFloat kDefaultLifetimeFraction = 0.41;
+
+#pragma mark EmitterConfigurationArchiver
+
+/* Archives the particle parameters of an emitter, leaving out the rest of the scene they're connected to */
+@interface EmitterConfigurationArchiver : NSObject <NSKeyedArchiverDelegate>
+@end
+
+@implementation EmitterConfigurationArchiver
+
+- (id)archiver:(NSKeyedArchiver *)archiver willEncodeObject:(id)object {
+	/* Textures are compared by the image they were loaded from instead of by their pixels */
+	if ([object isKindOfClass:[SKTexture class]]) {
+		NSString *name = [[TextureRegistry sharedRegistry] nameOfTexture:object];
+		return name ?: [NSString stringWithFormat:@"%p", object];
+	}
+	if ([object isKindOfClass:[SKNode class]]) {
+		return nil;
+	}
+	return object;
+}
+
+@end
+
+#pragma mark EmitterPrewarmer
+
+@implementation EmitterPrewarmer {
+	/* Configuration to the warm emitter made on the last open, none of them is part of a scene */
+	NSMutableDictionary *_warmEmitters;
+	dispatch_queue_t _warmingQueue;
+	NSUInteger _generation;
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_warmEmitters = [NSMutableDictionary dictionary];
+		_warmingQueue = dispatch_queue_create("developer.GameEditor.emitters", DISPATCH_QUEUE_SERIAL);
+		_batchSize = kDefaultBatchSize;
+		_lifetimeFraction = kDefaultLifetimeFraction;
+	}
+	return self;
+}
+
+#pragma mark Configuration
+
++ (NSArray *)particleKeys {
+	/* The properties SKEmitterNode declares, the target node is never set on the emitters that are swapped */
+	static NSArray *particleKeys;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		NSMutableArray *keys = [[AttributeSchema schemaForClass:[SKEmitterNode class]].propertyNames mutableCopy];
+		[keys removeObjectsInArray:@[@"targetNode", @"hash", @"superclass", @"description", @"debugDescription"]];
+		particleKeys = keys;
+	});
+	return particleKeys;
+}
+
++ (NSArray *)nodeKeys {
+	/* The state of the node an emitter is swapped with, the particles don't depend on it */
+	return @[@"name", @"position", @"zPosition", @"zRotation", @"xScale", @"yScale",
+			 @"speed", @"alpha", @"paused", @"hidden", @"userInteractionEnabled", @"userData", @"constraints", @"reachConstraints"];
+}
+
++ (NSData *)configurationOfEmitter:(SKEmitterNode *)emitter {
+	/* Only the particle parameters, emitters named or placed differently simulate the same particles */
+	NSMutableArray *values = [NSMutableArray array];
+	for (NSString *key in [self particleKeys]) {
+		[values addObject:[emitter valueForKey:key] ?: [NSNull null]];
+	}
+
+	EmitterConfigurationArchiver *archiverDelegate = [[EmitterConfigurationArchiver alloc] init];
+	NSMutableData *data = [NSMutableData data];
+	NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+	archiver.delegate = archiverDelegate;
+	[archiver encodeObject:values forKey:NSKeyedArchiveRootObjectKey];
+	[archiver finishEncoding];
+	return data;
+}
+
++ (void)moveNodeStateFromEmitter:(SKEmitterNode *)emitter toEmitter:(SKEmitterNode *)otherEmitter {
+	for (NSString *key in [self nodeKeys]) {
+		if ([emitter respondsToSelector:NSSelectorFromString(key)]) {
+			[otherEmitter setValue:[emitter valueForKey:key] forKey:key];
+		}
+	}
+
+	/* A physics body belongs to a single node */
+	SKPhysicsBody *physicsBody = emitter.physicsBody;
+	emitter.physicsBody = nil;
+	otherEmitter.physicsBody = physicsBody;
+}
+
+#pragma mark Pre-warming
+
+- (NSArray *)emittersInNode:(SKNode *)node {
+	NSMutableArray *emitters = [NSMutableArray array];
+	NSMutableArray *stack = [NSMutableArray arrayWithObject:node];
+	while (stack.count) {
+		SKNode *current = stack.lastObject;
+		[stack removeLastObject];
+		if ([current isKindOfClass:[SKEmitterNode class]]) {
+			[emitters addObject:current];
+		}
+		[stack addObjectsFromArray:current.children];
+	}
+	return emitters;
+}
+
+- (void)performInBatchesWithCount:(NSUInteger)count block:(void (^)(NSUInteger index))block {
+	NSUInteger batchSize = MAX(_batchSize, 1);
+	NSUInteger batchCount = (count + batchSize - 1) / batchSize;
+	dispatch_apply(batchCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t batch) {
+		NSUInteger end = MIN((batch + 1) * batchSize, count);
+		for (NSUInteger i = batch * batchSize; i < end; ++i) {
+			block(i);
+		}
+	});
+}
+
+- (void)prewarmEmittersInNode:(SKNode *)node {
+	NSMutableArray *emitters = [[self emittersInNode:node] mutableCopy];
+	NSUInteger count = emitters.count;
+
+	/* Archiving an emitter costs about as much as a short simulation, so the configurations are taken in batches too */
+	NSMutableArray *configurations = [NSMutableArray arrayWithCapacity:count];
+	for (NSUInteger i = 0; i < count; ++i) {
+		[configurations addObject:[NSNull null]];
+	}
+	[self performInBatchesWithCount:count block:^(NSUInteger i) {
+		/* Emitters with children or a target node can't be swapped without touching other nodes */
+		SKEmitterNode *emitter = emitters[i];
+		if (emitter.parent && emitter.children.count == 0 && emitter.targetNode == nil) {
+			NSData *configuration = [EmitterPrewarmer configurationOfEmitter:emitter];
+			@synchronized(configurations) {
+				configurations[i] = configuration;
+			}
+		}
+	}];
+
+	/* A single emitter of every configuration is warmed for the next open */
+	NSMutableDictionary *seeds = [NSMutableDictionary dictionary];
+	NSMutableIndexSet *coldIndexes = [NSMutableIndexSet indexSet];
+	NSUInteger generation;
+	_reusedEmitterCount = 0;
+
+	@synchronized(self) {
+		generation = ++_generation;
+
+		for (NSUInteger i = 0; i < count; ++i) {
+			id configuration = configurations[i];
+			SKEmitterNode *warmEmitter = configuration != [NSNull null] ? _warmEmitters[configuration] : nil;
+			if (!warmEmitter) {
+				[coldIndexes addIndex:i];
+				continue;
+			}
+			[_warmEmitters removeObjectForKey:configuration];
+
+			/* The scene being opened isn't presented yet, the warm emitter takes the place of the cold one */
+			SKEmitterNode *emitter = emitters[i];
+			SKNode *parent = emitter.parent;
+			NSUInteger index = [parent.children indexOfObjectIdenticalTo:emitter];
+			[EmitterPrewarmer moveNodeStateFromEmitter:emitter toEmitter:warmEmitter];
+			[emitter removeFromParent];
+			[parent insertChild:warmEmitter atIndex:index];
+			emitters[i] = warmEmitter;
+
+			/* The cold emitter has the same particles, it's warmed for the next open */
+			seeds[configuration] = emitter;
+			_reusedEmitterCount++;
+		}
+
+		/* The warm emitters of configurations the scene doesn't have are dropped */
+		[_warmEmitters removeAllObjects];
+	}
+
+	/* The configurations without a seed yet get a copy of their first emitter, taken before it's advanced */
+	[coldIndexes enumerateIndexesUsingBlock:^(NSUInteger i, BOOL *stop) {
+		id configuration = configurations[i];
+		if (configuration != [NSNull null] && !seeds[configuration]) {
+			seeds[configuration] = [emitters[i] copy];
+		}
+	}];
+
+	CGFloat lifetimeFraction = _lifetimeFraction;
+	[self performInBatchesWithCount:count block:^(NSUInteger i) {
+		if ([coldIndexes containsIndex:i]) {
+			SKEmitterNode *emitter = emitters[i];
+			[emitter advanceSimulationTime:lifetimeFraction * emitter.particleLifetime];
+		}
+	}];
+
+	_simulatedEmitterCount = coldIndexes.count;
+
+	/* Warm the seeds for the next open away from the main thread, they aren't part of any scene so they stay as warm as they were made */
+	dispatch_async(_warmingQueue, ^{
+		NSArray *configurationsToWarm = seeds.allKeys;
+		[self performInBatchesWithCount:configurationsToWarm.count block:^(NSUInteger i) {
+			SKEmitterNode *seed = seeds[configurationsToWarm[i]];
+			[seed advanceSimulationTime:lifetimeFraction * seed.particleLifetime];
+		}];
+
+		@synchronized(self) {
+			/* Another scene was opened meanwhile */
+			if (generation != _generation)
+				return;
+
+			[_warmEmitters addEntriesFromDictionary:seeds];
+		}
+	});
+}
+
+- (void)waitForPendingEmitters {
+	dispatch_sync(_warmingQueue, ^{});
+}
+
+- (void)removeAllEmitters {
+	@synchronized(self) {
+		_generation++;
+		[_warmEmitters removeAllObjects];
+	}
+}
+
+@end
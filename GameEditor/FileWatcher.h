@@ -0,0 +1,48 @@
+/*
+ * FileWatcher.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+typedef enum FileWatcherBackend {
+	FileWatcherBackendFSEvents,
+	FileWatcherBackendPolling
+} FileWatcherBackend;
+
+/* Receives the full paths of the files that changed since the previous call, on the main thread */
+typedef void (^FileWatcherHandler)(NSArray *addedFiles, NSArray *removedFiles, NSArray *modifiedFiles);
+
+/*
+ Watches the files under a directory, the first call to the handler reports every file as added.
+ The paths passed to the handler have their symbolic links resolved
+ */
+@interface FileWatcher : NSObject
+- (instancetype)initWithPath:(NSString *)path backend:(FileWatcherBackend)backend handler:(FileWatcherHandler)handler;
+- (void)start;
+- (void)stop;
+- (void)rescan;
+@property (readonly) NSString *path;
+@property (readonly) FileWatcherBackend backend;
+@property (assign) NSTimeInterval latency;
+@end
@@ -0,0 +1,248 @@
+/*
+ * FileWatcher.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "FileWatcher.h"
+#import <CoreServices/CoreServices.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+@interface FileWatcher ()
+- (void)rescanDirectories:(NSArray *)directories recursive:(BOOL)recursive;
+@end
+
+/* Retained by the event stream, the events that arrive while the watcher is going away find it nil */
+@interface FileWatcherReference : NSObject
+@property (weak) FileWatcher *watcher;
+@end
+
+@implementation FileWatcherReference
+@end
+
+static void FileWatcherCallback(ConstFSEventStreamRef streamRef, void *info, size_t numEvents, void *eventPaths, const FSEventStreamEventFlags eventFlags[], const FSEventStreamEventId eventIds[]) {
+	FileWatcher *watcher = [(__bridge FileWatcherReference *)info watcher];
+	if (!watcher)
+		return;
+
+	NSArray *paths = (__bridge NSArray *)eventPaths;
+
+	/* The events name the directories whose contents changed, unless the stream lost track of them */
+	BOOL recursive = NO;
+	for (size_t i = 0; i < numEvents; ++i) {
+		if (eventFlags[i] & (kFSEventStreamEventFlagMustScanSubDirs | kFSEventStreamEventFlagRootChanged)) {
+			recursive = YES;
+		}
+	}
+	[watcher rescanDirectories:paths recursive:recursive];
+}
+
+@implementation FileWatcher {
+	FileWatcherHandler _handler;
+	dispatch_queue_t _queue;
+	FSEventStreamRef _stream;
+	dispatch_source_t _timer;
+	NSString *_resolvedPath;
+	NSMutableDictionary *_filesByDirectory;
+	NSMutableDictionary *_subdirectoriesByDirectory;
+}
+
+@synthesize
+path = _path,
+backend = _backend;
+
+- (instancetype)initWithPath:(NSString *)path backend:(FileWatcherBackend)backend handler:(FileWatcherHandler)handler {
+	if (self = [super init]) {
+		_path = path;
+		_backend = backend;
+		_handler = handler;
+		_latency = backend == FileWatcherBackendPolling ? 1.0 : 0.2;
+		_queue = dispatch_queue_create("developer.GameEditor.filewatcher", DISPATCH_QUEUE_SERIAL);
+		_filesByDirectory = [NSMutableDictionary dictionary];
+		_subdirectoriesByDirectory = [NSMutableDictionary dictionary];
+
+		/* FSEvents reports the real paths, without symbolic links */
+		char resolvedPath[PATH_MAX];
+		_resolvedPath = realpath(path.fileSystemRepresentation, resolvedPath) ? @(resolvedPath) : path;
+	}
+	return self;
+}
+
+- (void)dealloc {
+	[self stop];
+}
+
+- (void)start {
+	if (_stream || _timer)
+		return;
+
+	if (_backend == FileWatcherBackendFSEvents) {
+		/* Start listening before the first scan, the events wait in the queue until the scan finishes */
+		FileWatcherReference *reference = [[FileWatcherReference alloc] init];
+		reference.watcher = self;
+		FSEventStreamContext context = {0, (__bridge void *)reference, CFRetain, CFRelease, NULL};
+		_stream = FSEventStreamCreate(NULL, &FileWatcherCallback, &context, (__bridge CFArrayRef)@[_resolvedPath],
+									  kFSEventStreamEventIdSinceNow, _latency,
+									  kFSEventStreamCreateFlagUseCFTypes | kFSEventStreamCreateFlagWatchRoot);
+		FSEventStreamSetDispatchQueue(_stream, _queue);
+		FSEventStreamStart(_stream);
+
+	} else {
+		_timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+		dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, _latency * NSEC_PER_SEC), _latency * NSEC_PER_SEC, _latency * NSEC_PER_SEC / 10);
+		__weak FileWatcher *weakSelf = self;
+		NSString *resolvedPath = _resolvedPath;
+		dispatch_source_set_event_handler(_timer, ^{
+			[weakSelf rescanDirectories:@[resolvedPath] recursive:YES];
+		});
+		dispatch_resume(_timer);
+	}
+
+	[self rescan];
+}
+
+- (void)stop {
+	if (_stream) {
+		FSEventStreamStop(_stream);
+		FSEventStreamInvalidate(_stream);
+		FSEventStreamRelease(_stream);
+		_stream = NULL;
+	}
+	if (_timer) {
+		dispatch_source_cancel(_timer);
+		_timer = nil;
+	}
+	_handler = nil;
+}
+
+- (void)rescan {
+	dispatch_async(_queue, ^{
+		[self rescanDirectories:@[_resolvedPath] recursive:YES];
+	});
+}
+
+#pragma mark Scanning
+
+- (void)rescanDirectories:(NSArray *)directories recursive:(BOOL)recursive {
+	NSMutableArray *addedFiles = [NSMutableArray array];
+	NSMutableArray *removedFiles = [NSMutableArray array];
+	NSMutableArray *modifiedFiles = [NSMutableArray array];
+
+	for (NSString *path in directories) {
+		NSString *directory = [path hasSuffix:@"/"] && path.length > 1 ? [path substringToIndex:path.length - 1] : path;
+
+		/* A directory that isn't known yet is found by scanning its closest known ancestor */
+		while (!_filesByDirectory[directory] && ![directory isEqualToString:_resolvedPath]) {
+			if (![directory hasPrefix:_resolvedPath]) {
+				directory = nil;
+				break;
+			}
+			directory = [directory stringByDeletingLastPathComponent];
+		}
+
+		if (directory) {
+			[self scanDirectory:directory recursive:recursive added:addedFiles removed:removedFiles modified:modifiedFiles];
+		}
+	}
+
+	if (addedFiles.count || removedFiles.count || modifiedFiles.count) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (_handler) {
+				_handler(addedFiles, removedFiles, modifiedFiles);
+			}
+		});
+	}
+}
+
+- (void)scanDirectory:(NSString *)directory recursive:(BOOL)recursive added:(NSMutableArray *)addedFiles removed:(NSMutableArray *)removedFiles modified:(NSMutableArray *)modifiedFiles {
+	NSDictionary *previousFiles = _filesByDirectory[directory];
+	NSSet *previousSubdirectories = _subdirectoriesByDirectory[directory];
+	NSMutableDictionary *files = [NSMutableDictionary dictionary];
+	NSMutableSet *subdirectories = [NSMutableSet set];
+
+	DIR *dir = opendir(directory.fileSystemRepresentation);
+	if (dir) {
+		struct dirent *entry;
+		while ((entry = readdir(dir))) {
+			/* Skip hidden files, including the temporary files written while saving */
+			if (entry->d_name[0] == '.')
+				continue;
+
+			NSString *file = [directory stringByAppendingPathComponent:@(entry->d_name)];
+			struct stat fileStat;
+			if (stat(file.fileSystemRepresentation, &fileStat) != 0)
+				continue;
+
+			if (S_ISDIR(fileStat.st_mode)) {
+				[subdirectories addObject:file];
+			} else if (S_ISREG(fileStat.st_mode)) {
+				/* A file is modified when either its modification time or its size change */
+				files[file] = @[@(fileStat.st_mtimespec.tv_sec), @(fileStat.st_mtimespec.tv_nsec), @(fileStat.st_size)];
+			}
+		}
+		closedir(dir);
+
+		_filesByDirectory[directory] = files;
+		_subdirectoriesByDirectory[directory] = subdirectories;
+	} else {
+		[_filesByDirectory removeObjectForKey:directory];
+		[_subdirectoriesByDirectory removeObjectForKey:directory];
+	}
+
+	for (NSString *file in files) {
+		NSArray *previousStat = previousFiles[file];
+		if (!previousStat) {
+			[addedFiles addObject:file];
+		} else if (![previousStat isEqualToArray:files[file]]) {
+			[modifiedFiles addObject:file];
+		}
+	}
+	for (NSString *file in previousFiles) {
+		if (!files[file]) {
+			[removedFiles addObject:file];
+		}
+	}
+
+	/* New directories are always scanned entirely, the known ones only when asked to */
+	for (NSString *subdirectory in subdirectories) {
+		if (recursive || ![previousSubdirectories containsObject:subdirectory]) {
+			[self scanDirectory:subdirectory recursive:recursive added:addedFiles removed:removedFiles modified:modifiedFiles];
+		}
+	}
+	for (NSString *subdirectory in previousSubdirectories) {
+		if (![subdirectories containsObject:subdirectory]) {
+			[self forgetDirectory:subdirectory removed:removedFiles];
+		}
+	}
+}
+
+- (void)forgetDirectory:(NSString *)directory removed:(NSMutableArray *)removedFiles {
+	[removedFiles addObjectsFromArray:[_filesByDirectory[directory] allKeys]];
+	for (NSString *subdirectory in _subdirectoriesByDirectory[directory]) {
+		[self forgetDirectory:subdirectory removed:removedFiles];
+	}
+	[_filesByDirectory removeObjectForKey:directory];
+	[_subdirectoriesByDirectory removeObjectForKey:directory];
+}
+
+@end
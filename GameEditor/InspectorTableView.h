@@ -38,5 +38,6 @@ IB_DESIGNABLE
 
 @interface InspectorTableView : NSOutlineView
 - (void)setHeight:(CGFloat)height forItem:(id)item;
-- (void)setTop:(CGFloat)top forItem:(id)item;
+- (void)expandItems:(NSArray *)items collapsingItemsPassingTest:(BOOL (^)(id item))predicate;
+- (void)performOnNextPaint:(void (^)(void))handler;
 @end
@@ -27,6 +27,7 @@
 #import "StepperTextField.h"
 #import "NSView+LayoutConstraint.h"
 #import "NSMapTable+Subscripting.h"
+#import "RowHeightIndex.h"
 
 #pragma mark InspectorTableCellView
 
@@ -345,6 +346,8 @@
 
 static const CGFloat kIndentationPerLevel = 0.0;
 
+static NSString *const kRowViewIdentifier = @"InspectorTableRowView";
+
 @interface InspectorTableView () <NSOutlineViewDelegate, NSOutlineViewDataSource>
 @end
 
@@ -354,6 +357,14 @@ static const CGFloat kIndentationPerLevel = 0.0;
 	NSMutableDictionary *_prefferedSizes;
 	NSMutableArray *_editorIdentifiers;
 	NSMapTable *_itemHeights;
+	NSMutableDictionary *_editorIdentifiersByType;
+
+	/* Offsets of the rows, rebuilt when the rows change and updated in place when a row changes its height */
+	RowHeightIndex *_rowHeights;
+	BOOL _rowHeightsAreValid;
+	NSUInteger _rowBatchingLevel;
+
+	NSMutableArray *_paintHandlers;
 }
 
 - (id)initWithCoder:(NSCoder *)coder {
@@ -369,6 +380,9 @@ static const CGFloat kIndentationPerLevel = 0.0;
 		_prefferedSizes = [NSMutableDictionary dictionary];
 		_itemHeights = [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality
 											 valueOptions:NSMapTableStrongMemory];
+		_editorIdentifiersByType = [NSMutableDictionary dictionary];
+		_rowHeights = [[RowHeightIndex alloc] init];
+		_paintHandlers = [NSMutableArray array];
 
 		for (id object in objects) {
 			if ([object isKindOfClass:[NSTableCellView class]]) {
@@ -391,15 +405,125 @@ static const CGFloat kIndentationPerLevel = 0.0;
 - (void) expandItem:(id)item expandChildren:(BOOL)expandChildren {
 	[NSAnimationContext beginGrouping];
 	[[NSAnimationContext currentContext] setDuration:0.0];
+	[self invalidateRowHeights];
 	[super expandItem:item expandChildren:expandChildren];
 	[NSAnimationContext endGrouping];
+	[self invalidateRowHeights];
 }
 
 - (void)collapseItem:(id)item collapseChildren:(BOOL)collapseChildren {
 	[NSAnimationContext beginGrouping];
 	[[NSAnimationContext currentContext] setDuration:0.0];
+	[self invalidateRowHeights];
 	[super collapseItem:item collapseChildren:collapseChildren];
 	[NSAnimationContext endGrouping];
+	[self invalidateRowHeights];
+}
+
+- (void)expandItems:(NSArray *)items collapsingItemsPassingTest:(BOOL (^)(id item))predicate {
+	/* Batch the expansion so that the rows are laid out and indexed once, not after every group */
+	[self beginUpdates];
+	++_rowBatchingLevel;
+	for (id item in items) {
+		[self expandItem:item expandChildren:YES];
+		if (predicate(item)) {
+			[self collapseItem:item];
+		}
+	}
+	--_rowBatchingLevel;
+	[self invalidateRowHeights];
+	[self endUpdates];
+}
+
+#pragma mark Row layout
+
+- (void)invalidateRowHeights {
+	_rowHeightsAreValid = NO;
+}
+
+- (RowHeightIndex *)rowHeights {
+	NSInteger numberOfRows = self.numberOfRows;
+
+	/* The rows change with every item expanded in a batch, the table lays them out by itself until it ends */
+	if (_rowBatchingLevel > 0)
+		return nil;
+
+	if (!_rowHeightsAreValid || _rowHeights.count != numberOfRows) {
+		CGFloat spacing = self.intercellSpacing.height;
+		CGFloat *heights = malloc(MAX(numberOfRows, 1) * sizeof(CGFloat));
+		for (NSInteger row = 0; row < numberOfRows; ++row) {
+			heights[row] = [self outlineView:self heightOfRowByItem:[self itemAtRow:row]] + spacing;
+		}
+		[_rowHeights setHeights:heights count:numberOfRows];
+		free(heights);
+		_rowHeightsAreValid = YES;
+	}
+	return _rowHeights;
+}
+
+- (void)reloadData {
+	[self invalidateRowHeights];
+	[super reloadData];
+}
+
+- (void)reloadItem:(id)item reloadChildren:(BOOL)reloadChildren {
+	[self invalidateRowHeights];
+	[super reloadItem:item reloadChildren:reloadChildren];
+}
+
+- (void)noteNumberOfRowsChanged {
+	[self invalidateRowHeights];
+	[super noteNumberOfRowsChanged];
+}
+
+- (void)insertItemsAtIndexes:(NSIndexSet *)indexes inParent:(id)parent withAnimation:(NSTableViewAnimationOptions)animationOptions {
+	[self invalidateRowHeights];
+	[super insertItemsAtIndexes:indexes inParent:parent withAnimation:animationOptions];
+}
+
+- (void)removeItemsAtIndexes:(NSIndexSet *)indexes inParent:(id)parent withAnimation:(NSTableViewAnimationOptions)animationOptions {
+	[self invalidateRowHeights];
+	[super removeItemsAtIndexes:indexes inParent:parent withAnimation:animationOptions];
+}
+
+- (void)noteHeightOfRowsWithIndexesChanged:(NSIndexSet *)indexSet {
+	if (_rowHeightsAreValid && _rowHeights.count == self.numberOfRows) {
+		CGFloat spacing = self.intercellSpacing.height;
+		[indexSet enumerateIndexesUsingBlock:^(NSUInteger row, BOOL *stop) {
+			if (row < _rowHeights.count) {
+				[_rowHeights setHeight:[self outlineView:self heightOfRowByItem:[self itemAtRow:row]] + spacing ofRow:row];
+			}
+		}];
+	}
+	[super noteHeightOfRowsWithIndexesChanged:indexSet];
+}
+
+/* The table asks for these while tiling, answering from the index keeps the row views it makes limited to the visible rect */
+
+- (NSRect)rectOfRow:(NSInteger)row {
+	RowHeightIndex *rowHeights = [self rowHeights];
+	if (!rowHeights)
+		return [super rectOfRow:row];
+	if (row < 0 || row >= rowHeights.count)
+		return NSZeroRect;
+	return NSMakeRect(0, [rowHeights offsetOfRow:row], NSWidth(self.bounds), [rowHeights heightOfRow:row]);
+}
+
+- (NSRange)rowsInRect:(NSRect)rect {
+	RowHeightIndex *rowHeights = [self rowHeights];
+	if (!rowHeights)
+		return [super rowsInRect:rect];
+	return [rowHeights rowsFromOffset:NSMinY(rect) toOffset:NSMaxY(rect)];
+}
+
+- (NSInteger)rowAtPoint:(NSPoint)point {
+	RowHeightIndex *rowHeights = [self rowHeights];
+	if (!rowHeights)
+		return [super rowAtPoint:point];
+	if (!NSPointInRect(point, self.bounds))
+		return -1;
+	NSUInteger row = [rowHeights rowAtOffset:point.y];
+	return row == NSNotFound ? -1 : row;
 }
 
 - (NSTableViewSelectionHighlightStyle)selectionHighlightStyle {
@@ -411,18 +535,46 @@ static const CGFloat kIndentationPerLevel = 0.0;
 }
 
 - (NSTableRowView *)outlineView:(NSOutlineView *)outlineView rowViewForItem:(id)item {
-	return [[InspectorTableRowView alloc] init];
+	/* Row views scrolled out of sight are queued by the table for reuse under their identifier */
+	InspectorTableRowView *rowView = [outlineView makeViewWithIdentifier:kRowViewIdentifier owner:self];
+	if (!rowView) {
+		rowView = [[InspectorTableRowView alloc] init];
+		rowView.identifier = kRowViewIdentifier;
+	}
+	return rowView;
 }
 
 - (void)setHeight:(CGFloat)height forItem:(id)item {
+	NSNumber *itemHeightValue = _itemHeights[[item representedObject]];
+	if (itemHeightValue && [itemHeightValue floatValue] == (float)height)
+		return;
+
 	_itemHeights[[item representedObject]] = [NSNumber numberWithFloat:height];
+
+	/* Only the row itself is updated, the table moves the rows below it */
+	NSInteger row = [self rowForItem:item];
+	if (row >= 0) {
+		[NSAnimationContext beginGrouping];
+		[[NSAnimationContext currentContext] setDuration:0];
+		[self noteHeightOfRowsWithIndexesChanged:[NSIndexSet indexSetWithIndex:row]];
+		[NSAnimationContext endGrouping];
+	}
 }
 
-- (void)setTop:(CGFloat)top forItem:(id)item {
-	NSTableRowView *rowView = [self rowViewAtRow:[self rowForItem:item] makeIfNecessary:NO];
-	CGRect viewFrame = rowView.frame;
-	viewFrame.origin.y = top;
-	rowView.frame = viewFrame;
+- (NSString *)editorIdentifierForType:(NSString *)type {
+	/* Matching the editors is a regular expression search per editor, do it once per type */
+	id editorIdentifier = _editorIdentifiersByType[type];
+	if (!editorIdentifier) {
+		editorIdentifier = [NSNull null];
+		for (NSString *identifier in _editorIdentifiers) {
+			if (type.length == [type rangeOfString:identifier options:NSRegularExpressionSearch].length) {
+				editorIdentifier = identifier;
+				break;
+			}
+		}
+		_editorIdentifiersByType[type] = editorIdentifier;
+	}
+	return editorIdentifier == [NSNull null] ? nil : editorIdentifier;
 }
 
 - (CGFloat)outlineView:(NSOutlineView *)outlineView heightOfRowByItem:(id)item {
@@ -434,12 +586,11 @@ static const CGFloat kIndentationPerLevel = 0.0;
 	NSString *type = [[item representedObject] valueForKey:@"identifier"];
 
 	if (type) {
-		for (NSString *identifier in _editorIdentifiers) {
-			if (type.length == [type rangeOfString:identifier options:NSRegularExpressionSearch].length) {
-				CGFloat height = [_prefferedSizes[identifier] sizeValue].height;
-				_itemHeights[[item representedObject]] = [NSNumber numberWithFloat:height];
-				return height;
-			}
+		NSString *identifier = [self editorIdentifierForType:type];
+		if (identifier) {
+			CGFloat height = [_prefferedSizes[identifier] sizeValue].height;
+			_itemHeights[[item representedObject]] = [NSNumber numberWithFloat:height];
+			return height;
 		}
 	}
 	return 20;
@@ -461,6 +612,19 @@ static const CGFloat kIndentationPerLevel = 0.0;
 - (void)drawRect:(NSRect)dirtyRect {
 	[self.backgroundColor set];
 	NSRectFill(dirtyRect);
+
+	if (_paintHandlers.count) {
+		NSArray *paintHandlers = _paintHandlers.copy;
+		[_paintHandlers removeAllObjects];
+		for (void (^handler)(void) in paintHandlers) {
+			handler();
+		}
+	}
+}
+
+- (void)performOnNextPaint:(void (^)(void))handler {
+	[_paintHandlers addObject:[handler copy]];
+	[self setNeedsDisplay:YES];
 }
 
 - (NSView *)outlineView:(NSOutlineView *)outlineView viewForTableColumn:(NSTableColumn *)tableColumn item:(id)item {
@@ -470,10 +634,9 @@ static const CGFloat kIndentationPerLevel = 0.0;
 	} else if ([[tableColumn identifier] isEqualToString:@"key"]) {
 		return [outlineView makeViewWithIdentifier:@"attribute" owner:self];
 	} else {
-		for (NSString *editorIdentifier in _editorIdentifiers) {
-			if (type.length == [type rangeOfString:editorIdentifier options:NSRegularExpressionSearch].length) {
-				return [outlineView makeViewWithIdentifier:editorIdentifier owner:self];
-			}
+		NSString *editorIdentifier = type ? [self editorIdentifierForType:type] : nil;
+		if (editorIdentifier) {
+			return [outlineView makeViewWithIdentifier:editorIdentifier owner:self];
 		}
 		return [outlineView makeViewWithIdentifier:@"generic attribute" owner:self];
 	}
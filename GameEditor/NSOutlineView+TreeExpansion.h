@@ -28,5 +28,6 @@
 @interface NSOutlineView (TreeExpansion)
 - (NSMutableArray *)expansionInfoWithNode:(NSTreeNode *)aNode;
 - (void)expandNode:(NSTreeNode *)aNode withInfo:(NSMutableArray *)array;
+- (void)expandChildrenOfNode:(NSTreeNode *)aNode toDepth:(NSUInteger)depth;
 @end
 
@@ -34,19 +34,41 @@
 }
 
 - (void)getExpandedNodesInfo:(NSMutableArray *)array forNode:(NSTreeNode *)aNode {
-	[array addObject:[NSNumber numberWithBool:[self isItemExpanded:aNode]]];
-	for (NSTreeNode *node in aNode.childNodes) {
-		[self getExpandedNodesInfo:array forNode:node];
+	BOOL expanded = [self isItemExpanded:aNode];
+	[array addObject:[NSNumber numberWithBool:expanded]];
+
+	/* The children of collapsed nodes aren't visited, so they don't have to be loaded */
+	if (expanded) {
+		for (NSTreeNode *node in aNode.childNodes) {
+			[self getExpandedNodesInfo:array forNode:node];
+		}
 	}
 }
 
 - (void)expandNode:(NSTreeNode *)aNode withInfo:(NSMutableArray *)array {
-	if ([[array firstObject] boolValue]) {
+	if (array.count == 0)
+		return;
+
+	BOOL expanded = [[array firstObject] boolValue];
+	[array removeObjectAtIndex:0];
+
+	if (expanded) {
 		[self expandItem:aNode];
+		for (NSTreeNode *node in aNode.childNodes) {
+			[self expandNode:node withInfo:array];
+		}
 	}
-	[array removeObjectAtIndex:0];
+}
+
+- (void)expandChildrenOfNode:(NSTreeNode *)aNode toDepth:(NSUInteger)depth {
+	if (depth == 0)
+		return;
+
 	for (NSTreeNode *node in aNode.childNodes) {
-		[self expandNode:node withInfo:array];
+		if (![node isLeaf]) {
+			[self expandItem:node];
+			[self expandChildrenOfNode:node toDepth:depth - 1];
+		}
 	}
 }
 
@@ -28,7 +28,10 @@
 
 @interface NavigationNode : NSObject <NSCoding>
 + (instancetype)navigationNodeWithNode:(id)node;
++ (instancetype)navigationNodeForNode:(SKNode *)node;
 @property SKNode *node;
+@property (weak, readonly) NavigationNode *parent;
 @property NSString *name;
 @property NSMutableArray *children;
+- (NSUInteger)indexOfChild:(NavigationNode *)child;
 @end
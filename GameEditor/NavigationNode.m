@@ -24,6 +24,8 @@
  */
 
 #import "NavigationNode.h"
+#import "AttributeNode.h"
+#import "NavigationSearchIndex.h"
 #import <AppKit/AppKit.h>
 #import <SpriteKit/SpriteKit.h>
 
@@ -31,12 +33,42 @@
 
 @implementation NavigationNode {
 	NSPredicate *_filterPredicate;
+	__weak NavigationNode *_parent;
+	NavigationSearchIndex *_searchIndex;
+	NSMutableArray *_filteredChildren;
+	NSUInteger _filteredGeneration;
+	NSUInteger _indexHint;
 }
 
 @synthesize
 node = _node,
 name = _name,
-children = _childrenNavigationNodes;
+children = _childrenNavigationNodes,
+parent = _parent;
+
++ (NSMapTable *)navigationNodesByNode {
+	/* Weak map of the scene nodes to the navigation node that represents them */
+	static NSMapTable *navigationNodesByNode = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		navigationNodesByNode = [NSMapTable mapTableWithKeyOptions:NSMapTableWeakMemory|NSMapTableObjectPointerPersonality
+													 valueOptions:NSMapTableWeakMemory];
+	});
+	return navigationNodesByNode;
+}
+
++ (instancetype)navigationNodeForNode:(SKNode *)node {
+	if (!node)
+		return nil;
+
+	NavigationNode *navigationNode = [[self navigationNodesByNode] objectForKey:node];
+	if (!navigationNode && node.parent) {
+		/* Load the siblings of the node, the ancestors are loaded first if needed */
+		[[self navigationNodeForNode:node.parent] loadChildren];
+		navigationNode = [[self navigationNodesByNode] objectForKey:node];
+	}
+	return navigationNode;
+}
 
 + (instancetype)navigationNodeWithNode:(id)node {
 	if (node) {
@@ -53,6 +85,17 @@ children = _childrenNavigationNodes;
 		_name = [aDecoder decodeObjectForKey:@"name"];
 		_childrenNavigationNodes = [aDecoder decodeObjectForKey:@"children"];
 
+		_searchIndex = [[NavigationSearchIndex alloc] initWithRootNode:_node];
+
+		for (NavigationNode *child in _childrenNavigationNodes) {
+			child->_parent = self;
+			[child setSearchIndex:_searchIndex];
+		}
+
+		if (_node) {
+			[[NavigationNode navigationNodesByNode] setObject:self forKey:_node];
+		}
+
 		[_node addObserver:self forKeyPath:@"name" options:0 context:NULL];
 	}
 	return self;
@@ -61,21 +104,31 @@ children = _childrenNavigationNodes;
 - (void)encodeWithCoder:(NSCoder *)aCoder {
 	[aCoder encodeObject:_node forKey:@"node"];
 	[aCoder encodeObject:_name forKey:@"name"];
-	[aCoder encodeObject:_childrenNavigationNodes forKey:@"children"];
+	[aCoder encodeObject:[self loadChildren] forKey:@"children"];
 }
 
 - (void)setNode:(id)node {
-	_childrenNavigationNodes = [NSMutableArray array];
-
-	for (id child in [node children]) {
-		NavigationNode *childNavigationNode = [NavigationNode navigationNodeWithNode:child];
-		[_childrenNavigationNodes addObject:childNavigationNode];
-	}
+	/* The navigation nodes of the children are created when they are first requested */
+	_childrenNavigationNodes = nil;
 
 	[_node removeObserver:self forKeyPath:@"name"];
 
+	NSMapTable *navigationNodesByNode = [NavigationNode navigationNodesByNode];
+	if (_node && [navigationNodesByNode objectForKey:_node] == self) {
+		[navigationNodesByNode removeObjectForKey:_node];
+	}
+
 	_node = node;
 
+	if (_node) {
+		[navigationNodesByNode setObject:self forKey:_node];
+	}
+
+	/* The children share the search index of the root */
+	if (!_searchIndex) {
+		_searchIndex = [[NavigationSearchIndex alloc] initWithRootNode:_node];
+	}
+
 	[_node addObserver:self forKeyPath:@"name" options:0 context:NULL];
 }
 
@@ -83,21 +136,243 @@ children = _childrenNavigationNodes;
 	return _node;
 }
 
+- (NSMutableArray *)loadChildren {
+	if (!_childrenNavigationNodes) {
+		_childrenNavigationNodes = [NSMutableArray array];
+
+		for (id child in [_node children]) {
+			NavigationNode *childNavigationNode = [[NavigationNode alloc] init];
+			childNavigationNode->_parent = self;
+			childNavigationNode->_searchIndex = _searchIndex;
+			childNavigationNode->_filterPredicate = _filterPredicate;
+			childNavigationNode.node = child;
+			childNavigationNode->_indexHint = _childrenNavigationNodes.count;
+			[_childrenNavigationNodes addObject:childNavigationNode];
+		}
+	}
+	return _childrenNavigationNodes;
+}
+
 - (void)setChildren:(NSMutableArray *)children {
-	/* Clean up all the children before adding the new ones */
-	[_node removeAllChildren];
+	[self loadChildren];
+
+	NSMapTable *newIndexes = [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality valueOptions:NSMapTableStrongMemory];
+	[children enumerateObjectsUsingBlock:^(NavigationNode *child, NSUInteger index, BOOL *stop) {
+		[newIndexes setObject:@(index) forKey:child];
+	}];
+
+	/* Detach the children that were removed */
+	NSMutableArray *keptChildren = [NSMutableArray arrayWithCapacity:_childrenNavigationNodes.count];
+	for (NavigationNode *child in _childrenNavigationNodes) {
+		if ([newIndexes objectForKey:child]) {
+			[keptChildren addObject:child];
+		} else {
+			if (child.node.parent == _node) {
+				[child.node removeFromParent];
+			}
+			if (child->_parent == self) {
+				child->_parent = nil;
+			}
+		}
+	}
+
+	/* The longest run of kept children already in the new order stays in the node, the other ones are moved */
+	NSUInteger keptCount = keptChildren.count;
+	NSUInteger *positions = malloc(MAX(keptCount, 1) * sizeof(NSUInteger));
+	NSUInteger *tails = malloc(MAX(keptCount, 1) * sizeof(NSUInteger));
+	NSUInteger *previous = malloc(MAX(keptCount, 1) * sizeof(NSUInteger));
+	NSUInteger length = 0;
+	for (NSUInteger i = 0; i < keptCount; ++i) {
+		positions[i] = [[newIndexes objectForKey:keptChildren[i]] unsignedIntegerValue];
+		NSUInteger low = 0, high = length;
+		while (low < high) {
+			NSUInteger middle = (low + high) / 2;
+			if (positions[tails[middle]] < positions[i]) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		previous[i] = low > 0 ? tails[low - 1] : NSNotFound;
+		tails[low] = i;
+		if (low == length) {
+			length++;
+		}
+	}
+	NSHashTable *stayingChildren = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+	for (NSUInteger i = length ? tails[length - 1] : NSNotFound; i != NSNotFound; i = previous[i]) {
+		[stayingChildren addObject:keptChildren[i]];
+	}
+	free(positions);
+	free(tails);
+	free(previous);
 
-	/* Add the new children */
-	for (NavigationNode *child in children) {
-		[_node addChild:child.node];
+	for (NavigationNode *child in keptChildren) {
+		if (![stayingChildren containsObject:child]) {
+			[child.node removeFromParent];
+		}
+	}
+
+	/* Insert the added and moved children, the ones before them in the node are already in order */
+	for (NSUInteger index = 0; index < children.count; ++index) {
+		NavigationNode *child = children[index];
+		if ([stayingChildren containsObject:child])
+			continue;
+
+		[child.node removeFromParent];
+		[_node insertChild:child.node atIndex:index];
 		[child setFilterPredicate:_filterPredicate];
+		child->_parent = self;
+
+		/* Index the nodes that come from outside of the tree */
+		if (child->_searchIndex != _searchIndex) {
+			[child setSearchIndex:_searchIndex];
+			[_searchIndex addNode:child.node];
+		}
 	}
 
 	_childrenNavigationNodes = children;
+	_filteredChildren = nil;
+
+	[_searchIndex invalidate];
+}
+
+#pragma mark Children mutation
+
+/* Indexed accessors used by the tree controller, only the inserted and removed children change in the node */
+
+- (NSUInteger)indexOfChildAtVisibleIndex:(NSUInteger)index {
+	/* While filtering, the indexes refer to the visible children */
+	NSArray *visibleChildren = [self children];
+	if (visibleChildren == _childrenNavigationNodes)
+		return index;
+	if (index < visibleChildren.count)
+		return [_childrenNavigationNodes indexOfObjectIdenticalTo:visibleChildren[index]];
+	return _childrenNavigationNodes.count;
+}
+
+- (void)insertObject:(NavigationNode *)child inChildrenAtIndex:(NSUInteger)index {
+	[self insertChildren:@[child] atIndexes:[NSIndexSet indexSetWithIndex:index]];
+}
+
+- (void)insertChildren:(NSArray *)children atIndexes:(NSIndexSet *)indexes {
+	[self loadChildren];
+
+	/* Resolve all the indexes against the visible children before any of them is inserted */
+	[_searchIndex invalidate];
+	NSArray *visibleChildren = [self children];
+	NSMapTable *childIndexes = nil;
+	if (visibleChildren != _childrenNavigationNodes) {
+		childIndexes = [NSMapTable mapTableWithKeyOptions:NSMapTableObjectPointerPersonality valueOptions:NSMapTableStrongMemory];
+		[_childrenNavigationNodes enumerateObjectsUsingBlock:^(NavigationNode *child, NSUInteger index, BOOL *stop) {
+			[childIndexes setObject:@(index) forKey:child];
+		}];
+	}
+
+	/* Every child goes before the visible child whose place it takes, or after all of them */
+	NSMutableIndexSet *insertionIndexes = [NSMutableIndexSet indexSet];
+	__block NSUInteger position = 0;
+	[indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+		NSUInteger visibleIndex = index - position;
+		NSUInteger childIndex = visibleIndex;
+		if (childIndexes) {
+			childIndex = visibleIndex < visibleChildren.count ? [[childIndexes objectForKey:visibleChildren[visibleIndex]] unsignedIntegerValue] : _childrenNavigationNodes.count;
+		}
+		[insertionIndexes addIndex:childIndex + position++];
+	}];
+
+	[_childrenNavigationNodes insertObjects:children atIndexes:insertionIndexes];
+
+	position = 0;
+	[insertionIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+		NavigationNode *child = children[position++];
+
+		[child.node removeFromParent];
+		[_node insertChild:child.node atIndex:index];
+		[child setFilterPredicate:_filterPredicate];
+		child->_parent = self;
+
+		/* Index the nodes that come from outside of the tree */
+		if (child->_searchIndex != _searchIndex) {
+			[child setSearchIndex:_searchIndex];
+			[_searchIndex addNode:child.node];
+		}
+	}];
+	_filteredChildren = nil;
+
+	[_searchIndex invalidate];
+}
+
+- (void)removeObjectFromChildrenAtIndex:(NSUInteger)index {
+	[self removeChildrenAtIndexes:[NSIndexSet indexSetWithIndex:index]];
+}
+
+- (void)removeChildrenAtIndexes:(NSIndexSet *)indexes {
+	[self loadChildren];
+
+	NSMutableIndexSet *childIndexes = [NSMutableIndexSet indexSet];
+	[indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+		[childIndexes addIndex:[self indexOfChildAtVisibleIndex:index]];
+	}];
+
+	/* Detach the children that were removed */
+	[childIndexes enumerateIndexesWithOptions:NSEnumerationReverse usingBlock:^(NSUInteger index, BOOL *stop) {
+		NavigationNode *child = _childrenNavigationNodes[index];
+		if (child.node.parent == _node) {
+			[child.node removeFromParent];
+		}
+		if (child->_parent == self) {
+			child->_parent = nil;
+		}
+	}];
+	[_childrenNavigationNodes removeObjectsAtIndexes:childIndexes];
+	_filteredChildren = nil;
+
+	[_searchIndex invalidate];
+}
+
+- (void)replaceObjectInChildrenAtIndex:(NSUInteger)index withObject:(NavigationNode *)child {
+	[self removeObjectFromChildrenAtIndex:index];
+	[self insertObject:child inChildrenAtIndex:index];
+}
+
+- (void)setSearchIndex:(NavigationSearchIndex *)searchIndex {
+	_searchIndex = searchIndex;
+	for (NavigationNode *child in _childrenNavigationNodes) {
+		[child setSearchIndex:searchIndex];
+	}
+}
+
+- (NSUInteger)indexOfChild:(NavigationNode *)child {
+	/* The index where the child was last found, checked before searching the siblings again */
+	NSArray *children = [self children];
+	NSUInteger index = child->_indexHint;
+	if (index >= children.count || children[index] != child) {
+		index = [children indexOfObjectIdenticalTo:child];
+		if (index != NSNotFound) {
+			child->_indexHint = index;
+		}
+	}
+	return index;
 }
 
 - (NSMutableArray *)children {
+	[self loadChildren];
 	if (_filterPredicate) {
+		/* Keep the children that match the search or have a descendant that does */
+		NSHashTable *visibleNodes = [_searchIndex visibleNodesWithSearchString:[NavigationSearchIndex searchStringWithPredicate:_filterPredicate]];
+		if (visibleNodes) {
+			if (!_filteredChildren || _filteredGeneration != _searchIndex.generation) {
+				_filteredChildren = [NSMutableArray array];
+				for (NavigationNode *child in _childrenNavigationNodes) {
+					if ([visibleNodes containsObject:child.node]) {
+						[_filteredChildren addObject:child];
+					}
+				}
+				_filteredGeneration = _searchIndex.generation;
+			}
+			return _filteredChildren;
+		}
 		return (NSMutableArray *)[_childrenNavigationNodes filteredArrayUsingPredicate:_filterPredicate];
 	}
 	return _childrenNavigationNodes;
@@ -105,7 +380,12 @@ children = _childrenNavigationNodes;
 
 - (void)setName:(NSString *)name {
 	if (![_node.name isEqualToString:name]) {
+		NSString *oldName = [_node name];
 		[(SKNode *)self.node setName:name];
+
+		/* Renaming in the navigator is undone like the edits made in the inspector */
+		[[NSNotificationCenter defaultCenter] postNotificationName:AttributeNodeDidChangeValueNotification object:_node
+														  userInfo:@{AttributeNodeKeyPathKey: @"name", AttributeNodeOldValueKey: oldName ?: [NSNull null]}];
 	}
 }
 
@@ -119,7 +399,10 @@ children = _childrenNavigationNodes;
 }
 
 - (BOOL)isLeaf {
-	return [_childrenNavigationNodes count] == 0;
+	if (_childrenNavigationNodes) {
+		return [_childrenNavigationNodes count] == 0;
+	}
+	return [[_node children] count] == 0;
 }
 
 - (BOOL)isEditable {
@@ -151,6 +434,16 @@ children = _childrenNavigationNodes;
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
 	if ([keyPath isEqualToString:@"name"]) {
 		self.name = [_node valueForKey:@"name"];
+
+		/* The renamed node may show up or disappear from the filtered tree */
+		[_searchIndex updateNode:_node];
+		if (_filterPredicate) {
+			NavigationNode *root = self;
+			while (root.parent) {
+				root = root.parent;
+			}
+			[root reloadFilteredChildren];
+		}
 	} else {
 		[super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
 	}
@@ -160,7 +453,23 @@ children = _childrenNavigationNodes;
 	if (_filterPredicate != newFilterPredicate) {
 		[self willChangeValueForKey:@"children"];
 		_filterPredicate = newFilterPredicate;
+		_filteredChildren = nil;
 		[self didChangeValueForKey:@"children"];
+
+		/* Only the loaded children need the new predicate, the rest inherit it when loaded */
+		for (NavigationNode *child in _childrenNavigationNodes) {
+			[child setFilterPredicate:newFilterPredicate];
+		}
+	}
+}
+
+- (void)reloadFilteredChildren {
+	[self willChangeValueForKey:@"children"];
+	_filteredChildren = nil;
+	[self didChangeValueForKey:@"children"];
+
+	for (NavigationNode *child in _childrenNavigationNodes) {
+		[child reloadFilteredChildren];
 	}
 }
 
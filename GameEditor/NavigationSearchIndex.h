@@ -0,0 +1,39 @@
+/*
+ * NavigationSearchIndex.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <SpriteKit/SpriteKit.h>
+
+/* Trigram index over the names of the nodes in a scene as the navigator shows them, used to filter it */
+@interface NavigationSearchIndex : NSObject
++ (NSString *)searchStringWithPredicate:(NSPredicate *)predicate;
+- (instancetype)initWithRootNode:(SKNode *)rootNode;
+- (void)addNode:(SKNode *)node;
+- (void)updateNode:(SKNode *)node;
+- (void)invalidate;
+- (NSHashTable *)visibleNodesWithSearchString:(NSString *)searchString;
+@property (readonly) SKNode *rootNode;
+@property (readonly) NSUInteger generation;
+@end
@@ -0,0 +1,225 @@
+/*
+ * NavigationSearchIndex.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "NavigationSearchIndex.h"
+
+static const NSUInteger kGramLength = 3;
+
+@implementation NavigationSearchIndex {
+	NSMutableDictionary *_nodesByGram;
+	NSMapTable *_termsByNode;
+	BOOL _built;
+	NSString *_cachedSearchString;
+	NSUInteger _cachedGeneration;
+	NSHashTable *_cachedVisibleNodes;
+}
+
+@synthesize
+rootNode = _rootNode,
+generation = _generation;
+
++ (NSString *)searchStringWithPredicate:(NSPredicate *)predicate {
+	/* Only the predicate used by the navigator's search field is supported, name contains[c] */
+	if ([predicate isKindOfClass:[NSComparisonPredicate class]]) {
+		NSComparisonPredicate *comparison = (NSComparisonPredicate *)predicate;
+		if (comparison.predicateOperatorType == NSContainsPredicateOperatorType
+			&& comparison.options == NSCaseInsensitivePredicateOption
+			&& comparison.leftExpression.expressionType == NSKeyPathExpressionType
+			&& [comparison.leftExpression.keyPath isEqualToString:@"name"]
+			&& comparison.rightExpression.expressionType == NSConstantValueExpressionType
+			&& [comparison.rightExpression.constantValue isKindOfClass:[NSString class]]) {
+			return comparison.rightExpression.constantValue;
+		}
+	}
+	return nil;
+}
+
+- (instancetype)initWithRootNode:(SKNode *)rootNode {
+	if (self = [super init]) {
+		_rootNode = rootNode;
+	}
+	return self;
+}
+
+#pragma mark Indexing
+
+- (NSArray *)termsOfNode:(SKNode *)node {
+	/* The name shown in the navigator, the nodes without name show their class name */
+	NSString *name = node.name.length ? node.name : [NSString stringWithFormat:@"<%@>", [node className]];
+	return @[[name lowercaseString]];
+}
+
+- (void)enumerateGramsOfTerms:(NSArray *)terms usingBlock:(void (^)(NSString *gram))block {
+	for (NSString *term in terms) {
+		for (NSUInteger i = 0; i + kGramLength <= term.length; ++i) {
+			block([term substringWithRange:NSMakeRange(i, kGramLength)]);
+		}
+	}
+}
+
+- (void)indexNode:(SKNode *)node {
+	NSArray *terms = [self termsOfNode:node];
+	[_termsByNode setObject:terms forKey:node];
+	[self enumerateGramsOfTerms:terms usingBlock:^(NSString *gram) {
+		NSHashTable *nodes = _nodesByGram[gram];
+		if (!nodes) {
+			nodes = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory|NSPointerFunctionsObjectPointerPersonality];
+			_nodesByGram[gram] = nodes;
+		}
+		[nodes addObject:node];
+	}];
+}
+
+- (void)unindexNode:(SKNode *)node {
+	NSArray *terms = [_termsByNode objectForKey:node];
+	if (terms) {
+		[self enumerateGramsOfTerms:terms usingBlock:^(NSString *gram) {
+			[_nodesByGram[gram] removeObject:node];
+		}];
+		[_termsByNode removeObjectForKey:node];
+	}
+}
+
+- (void)indexNodeRecursively:(SKNode *)node {
+	[self indexNode:node];
+	for (SKNode *child in node.children) {
+		[self indexNodeRecursively:child];
+	}
+}
+
+- (void)build {
+	if (_built)
+		return;
+
+	_nodesByGram = [NSMutableDictionary dictionary];
+	_termsByNode = [NSMapTable mapTableWithKeyOptions:NSMapTableWeakMemory|NSMapTableObjectPointerPersonality
+										 valueOptions:NSMapTableStrongMemory];
+	if (_rootNode) {
+		[self indexNodeRecursively:_rootNode];
+	}
+	_built = YES;
+}
+
+- (void)addNode:(SKNode *)node {
+	/* Nothing to do until the index is used for the first time */
+	if (_built && node) {
+		[self indexNodeRecursively:node];
+	}
+	_generation++;
+}
+
+- (void)updateNode:(SKNode *)node {
+	if (_built && node) {
+		[self unindexNode:node];
+		[self indexNode:node];
+	}
+	_generation++;
+}
+
+- (void)invalidate {
+	_generation++;
+}
+
+#pragma mark Search
+
+- (BOOL)node:(SKNode *)node matchesSearchString:(NSString *)searchString {
+	for (NSString *term in [_termsByNode objectForKey:node]) {
+		if ([term rangeOfString:searchString].location != NSNotFound)
+			return YES;
+	}
+	return NO;
+}
+
+- (NSArray *)nodesMatchingSearchString:(NSString *)searchString {
+	id<NSFastEnumeration> candidates = nil;
+
+	if (searchString.length >= kGramLength) {
+		/* Start with the smallest list of nodes that share a gram with the search string */
+		NSMutableArray *postings = [NSMutableArray array];
+		for (NSUInteger i = 0; i + kGramLength <= searchString.length; ++i) {
+			NSHashTable *nodes = _nodesByGram[[searchString substringWithRange:NSMakeRange(i, kGramLength)]];
+			if (nodes.count == 0)
+				return @[];
+			[postings addObject:nodes];
+		}
+		[postings sortUsingComparator:^NSComparisonResult(NSHashTable *a, NSHashTable *b) {
+			return a.count < b.count ? NSOrderedAscending : a.count > b.count ? NSOrderedDescending : NSOrderedSame;
+		}];
+		candidates = postings.firstObject;
+
+	} else {
+		/* Short search strings don't have grams, check every node */
+		candidates = [_termsByNode keyEnumerator];
+	}
+
+	NSMutableArray *matches = [NSMutableArray array];
+	for (SKNode *node in candidates) {
+		if ([self node:node matchesSearchString:searchString]) {
+			[matches addObject:node];
+		}
+	}
+	return matches;
+}
+
+- (NSHashTable *)visibleNodesWithSearchString:(NSString *)searchString {
+	searchString = [searchString lowercaseString];
+
+	if (searchString.length == 0)
+		return nil;
+
+	if (_cachedVisibleNodes && _cachedGeneration == _generation && [_cachedSearchString isEqualToString:searchString])
+		return _cachedVisibleNodes;
+
+	[self build];
+
+	/* Add the matching nodes and their ancestors in one pass, skipping the nodes that aren't in the scene anymore */
+	NSHashTable *visibleNodes = [NSHashTable hashTableWithOptions:NSPointerFunctionsWeakMemory|NSPointerFunctionsObjectPointerPersonality];
+	if (_rootNode) {
+		[visibleNodes addObject:_rootNode];
+	}
+
+	NSMutableArray *chain = [NSMutableArray array];
+	for (SKNode *match in [self nodesMatchingSearchString:searchString]) {
+		[chain removeAllObjects];
+		SKNode *node = match;
+		while (node && ![visibleNodes containsObject:node]) {
+			[chain addObject:node];
+			node = node.parent;
+		}
+		if (node) {
+			for (SKNode *ancestor in chain) {
+				[visibleNodes addObject:ancestor];
+			}
+		}
+	}
+
+	_cachedSearchString = searchString;
+	_cachedGeneration = _generation;
+	_cachedVisibleNodes = visibleNodes;
+
+	return _cachedVisibleNodes;
+}
+
+@end
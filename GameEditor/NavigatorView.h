@@ -32,4 +32,5 @@
 
 @protocol NavigatorViewDelegate
 - (void)navigatorView:(NavigatorView *)navigatorView didSelectObject:(id)object;
+- (void)navigatorView:(NavigatorView *)navigatorView didMoveObject:(id)object;
 @end
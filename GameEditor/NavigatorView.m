@@ -58,7 +58,7 @@
 @implementation NavigatorView {
 	__weak id _actualDelegate;
 	__weak id _actualDataSource;
-	NSIndexPath *_fromIndexPath;
+	NSArray *_fromIndexPaths;
 	NSIndexPath *_toIndexPath;
 	__weak NavigationTreeController *_treeController;
 }
@@ -87,18 +87,34 @@
 
 - (NSDragOperation)outlineView:(NSOutlineView *)outlineView validateDrop:(id <NSDraggingInfo>)info proposedItem:(id)item proposedChildIndex:(NSInteger)index {
 	if (item && !_treeController.filterPredicate) {
-		NSPasteboard *pasteBoard = [info draggingPasteboard];
-		_fromIndexPath = [NSKeyedUnarchiver unarchiveObjectWithData:[pasteBoard dataForType:@"public.binary"]];
+		/* Every dragged row has its own pasteboard item */
+		NSMutableArray *fromIndexPaths = [NSMutableArray array];
+		for (NSPasteboardItem *pboardItem in [[info draggingPasteboard] pasteboardItems]) {
+			NSData *pboardData = [pboardItem dataForType:@"public.binary"];
+			id indexPath = pboardData ? [NSKeyedUnarchiver unarchiveObjectWithData:pboardData] : nil;
+			if ([indexPath isKindOfClass:[NSIndexPath class]]) {
+				[fromIndexPaths addObject:indexPath];
+			}
+		}
+		if (!fromIndexPaths.count)
+			return NSDragOperationNone;
+
+		_fromIndexPaths = [self topmostIndexPaths:fromIndexPaths];
 		_toIndexPath = [[item indexPath] indexPathByAddingIndex:MAX(0, index)];
 
-		if (_fromIndexPath.length < _toIndexPath.length) {
-			/* Can't drop the item on itself nor one of its children */
-			for (NSUInteger position = 0; position < _fromIndexPath.length; ++position) {
-				if ([_fromIndexPath indexAtPosition:position] != [_toIndexPath indexAtPosition:position]) {
-					return NSDragOperationMove;
+		for (NSIndexPath *fromIndexPath in _fromIndexPaths) {
+			if (fromIndexPath.length < _toIndexPath.length) {
+				/* Can't drop the item on itself nor one of its children */
+				BOOL isDescendant = YES;
+				for (NSUInteger position = 0; position < fromIndexPath.length; ++position) {
+					if ([fromIndexPath indexAtPosition:position] != [_toIndexPath indexAtPosition:position]) {
+						isDescendant = NO;
+						break;
+					}
 				}
+				if (isDescendant)
+					return NSDragOperationNone;
 			}
-			return NSDragOperationNone;
 		}
 
 		return NSDragOperationMove;
@@ -108,7 +124,7 @@
 
 - (BOOL)outlineView:(NSOutlineView *)outlineView acceptDrop:(id <NSDraggingInfo>)info item:(id)item childIndex:(NSInteger)index {
 	if ([self outlineView:outlineView validateDrop:info proposedItem:item proposedChildIndex:index] == NSDragOperationMove) {
-		[self moveNodeFromIndexPath:_fromIndexPath toIndexPath:_toIndexPath];
+		[self moveNodesFromIndexPaths:_fromIndexPaths toIndexPath:_toIndexPath];
 		return YES;
 	}
 	return NO;
@@ -116,49 +132,111 @@
 
 #pragma mark Drag & Drop helper methods
 
-- (void)moveNodeFromIndexPath:(NSIndexPath *)fromIndexPath toIndexPath:(NSIndexPath *)toIndexPath {
+- (NSArray *)topmostIndexPaths:(NSArray *)indexPaths {
+	/* Sorted index paths without the ones inside others, the descendants move with their ancestors */
+	NSArray *sortedIndexPaths = [indexPaths sortedArrayUsingSelector:@selector(compare:)];
+	NSMutableArray *topmostIndexPaths = [NSMutableArray arrayWithCapacity:sortedIndexPaths.count];
+	for (NSIndexPath *indexPath in sortedIndexPaths) {
+		NSIndexPath *ancestor = topmostIndexPaths.lastObject;
+		BOOL isDescendant = ancestor && ancestor.length < indexPath.length;
+		for (NSUInteger position = 0; isDescendant && position < ancestor.length; ++position) {
+			isDescendant = [ancestor indexAtPosition:position] == [indexPath indexAtPosition:position];
+		}
+		if (!isDescendant && ![indexPath isEqual:ancestor]) {
+			[topmostIndexPaths addObject:indexPath];
+		}
+	}
+	return topmostIndexPaths;
+}
 
-	/* Register undo operation */
-	[[self.undoManager prepareWithInvocationTarget:self] moveNodeFromIndexPath:toIndexPath toIndexPath:fromIndexPath];
+- (void)moveNodesFromIndexPaths:(NSArray *)fromIndexPaths toIndexPath:(NSIndexPath *)toIndexPath {
+	fromIndexPaths = [self topmostIndexPaths:fromIndexPaths];
 
-	/* Move the node to its new location */
+	/* The destination shifts by the moved nodes that come before it in each level of the tree */
+	NSIndexPath *indexPath = [[NSIndexPath alloc] init];
+	for (NSUInteger position = 0; position < toIndexPath.length; ++position) {
+		NSUInteger toIndex = [toIndexPath indexAtPosition:position];
+		NSUInteger index = toIndex;
+		for (NSIndexPath *fromIndexPath in fromIndexPaths) {
+			if (fromIndexPath.length != position + 1 || [fromIndexPath indexAtPosition:position] >= toIndex)
+				continue;
+			BOOL isSibling = YES;
+			for (NSUInteger level = 0; isSibling && level < position; ++level) {
+				isSibling = [fromIndexPath indexAtPosition:level] == [toIndexPath indexAtPosition:level];
+			}
+			if (isSibling) {
+				--index;
+			}
+		}
+		indexPath = [indexPath indexPathByAddingIndex:index];
+	}
+
+	/* The moved nodes end up next to each other in their original order */
+	NSIndexPath *parentIndexPath = [indexPath indexPathByRemovingLastIndex];
+	NSUInteger index = [indexPath indexAtPosition:indexPath.length - 1];
+	NSMutableArray *toIndexPaths = [NSMutableArray arrayWithCapacity:fromIndexPaths.count];
+	for (NSUInteger i = 0; i < fromIndexPaths.count; ++i) {
+		[toIndexPaths addObject:[parentIndexPath indexPathByAddingIndex:index + i]];
+	}
+
+	[self moveNodesAtIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths];
+}
+
+- (void)moveNodesAtIndexPaths:(NSArray *)fromIndexPaths toIndexPaths:(NSArray *)toIndexPaths {
+	/* The node at each index path ends at the index path in the same position of the other array */
+	NSUInteger count = fromIndexPaths.count;
 	NSTreeNode *rootNode = [_treeController arrangedObjects];
-	NSTreeNode *selectedNode = [rootNode descendantNodeAtIndexPath:fromIndexPath];
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:count];
+	NSMutableArray *expansionInfos = [NSMutableArray arrayWithCapacity:count];
+	for (NSIndexPath *fromIndexPath in fromIndexPaths) {
+		NSTreeNode *treeNode = [rootNode descendantNodeAtIndexPath:fromIndexPath];
+		[objects addObject:[treeNode representedObject]];
+
+		/* Save the state of node to be moved */
+		[expansionInfos addObject:[self expansionInfoWithNode:treeNode]];
+	}
 
-	/* Save the state of node to be moved */
-	NSMutableArray *expansionInfo = [self expansionInfoWithNode:selectedNode];
+	/* A single undo operation for all the nodes */
+	[[self.undoManager prepareWithInvocationTarget:self] moveNodesAtIndexPaths:toIndexPaths toIndexPaths:fromIndexPaths];
 
-	/* Move the node to its new location */
-#if 1// remove and insert instead of moving the node
-	[_treeController removeObjectAtArrangedObjectIndexPath:fromIndexPath];
-	NSIndexPath *indexPath = [[NSIndexPath alloc] init];
-	for (NSInteger position = 0; position < toIndexPath.length; ++position) {
-		NSInteger fromIndex = [fromIndexPath indexAtPosition:position];
-		NSInteger toIndex = [toIndexPath indexAtPosition:position];
-		if (fromIndex == toIndex) {
-			indexPath = [indexPath indexPathByAddingIndex:fromIndex];
-		} else if (fromIndexPath.length - 1 == position && fromIndex < toIndex) {
-			indexPath = [indexPath indexPathByAddingIndex:toIndex - 1];
-		} else {
-			indexPath = [indexPath indexPathByAddingIndex:toIndex];
-		}
+	/* The tree controller takes the index paths in ascending order, the insertion order must follow the destinations */
+	NSMutableArray *order = [NSMutableArray arrayWithCapacity:count];
+	for (NSUInteger i = 0; i < count; ++i) {
+		[order addObject:@(i)];
+	}
+	[order sortUsingComparator:^NSComparisonResult(NSNumber *a, NSNumber *b) {
+		return [toIndexPaths[a.unsignedIntegerValue] compare:toIndexPaths[b.unsignedIntegerValue]];
+	}];
+	NSMutableArray *sortedObjects = [NSMutableArray arrayWithCapacity:count];
+	NSMutableArray *sortedToIndexPaths = [NSMutableArray arrayWithCapacity:count];
+	for (NSNumber *i in order) {
+		[sortedObjects addObject:objects[i.unsignedIntegerValue]];
+		[sortedToIndexPaths addObject:toIndexPaths[i.unsignedIntegerValue]];
 	}
-	[_treeController insertObject:[selectedNode representedObject] atArrangedObjectIndexPath:indexPath];
-#else
-	[_treeController moveNode:selectedNode toIndexPath:toIndexPath];
-#endif
 
-	/* Retrieve the selected node at its new location */
-	selectedNode = [rootNode descendantNodeAtIndexPath:toIndexPath];
+	/* Only the moved nodes are detached and attached again in the scene */
+	[_treeController removeObjectsAtArrangedObjectIndexPaths:[fromIndexPaths sortedArrayUsingSelector:@selector(compare:)]];
+	[_treeController insertObjects:sortedObjects atArrangedObjectIndexPaths:sortedToIndexPaths];
+
+	NSMutableIndexSet *rows = [NSMutableIndexSet indexSet];
+	for (NSUInteger i = 0; i < count; ++i) {
+		/* Retrieve the node at its new location */
+		NSTreeNode *movedNode = [rootNode descendantNodeAtIndexPath:toIndexPaths[i]];
 
-	/* Expand the new parent node */
-	[self expandItem:selectedNode.parentNode];
+		/* Expand the new parent node and the moved node */
+		[self expandItem:movedNode.parentNode];
+		[self expandNode:movedNode withInfo:expansionInfos[i]];
 
-	/* Expand the moved node */
-	[self expandNode:selectedNode withInfo:expansionInfo];
+		[rows addIndex:[self rowForItem:movedNode]];
+	}
+
+	/* Select the nodes at their new location */
+	[self selectRowIndexes:rows byExtendingSelection:NO];
 
-	/* Select the node at it's new location */
-	[self selectRowIndexes:[NSIndexSet indexSetWithIndex:[self rowForItem:selectedNode]] byExtendingSelection:NO];
+	/* Nofify the delegate */
+	for (id object in objects) {
+		[_actualDelegate navigatorView:self didMoveObject:object];
+	}
 }
 
 #pragma mark Delegate methods interception
@@ -0,0 +1,40 @@
+/*
+ * NodeClipboard.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <SpriteKit/SpriteKit.h>
+
+/* Pasteboard type of the copied node subtrees */
+extern NSString *const NodeClipboardType;
+
+/*
+ Flat clipboard format for node subtrees: the nodes are stored without their children in pre-order
+ along with the index of their parents. Textures and shaders from the registries are stored by name
+ and shared again with the pasted nodes
+ */
+@interface NodeClipboard : NSObject
++ (NSData *)dataWithNode:(SKNode *)node expansionInfo:(id)expansionInfo;
++ (NSArray *)nodesWithData:(NSData *)data count:(NSUInteger)count expansionInfo:(id __autoreleasing *)expansionInfo error:(NSError * __autoreleasing *)error;
+@end
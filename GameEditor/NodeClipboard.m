@@ -0,0 +1,230 @@
+/*
+ * NodeClipboard.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "NodeClipboard.h"
+#import "TextureRegistry.h"
+#import "ShaderRegistry.h"
+
+NSString *const NodeClipboardType = @"developer.GameEditor.nodes";
+
+static const char NodeClipboardMagic[4] = {'G', 'E', 'N', 'C'};
+static const uint32_t NodeClipboardVersion = 1;
+static const uint32_t NodeClipboardNoParent = UINT32_MAX;
+
+typedef struct NodeClipboardHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t nodeCount;
+} NodeClipboardHeader;
+
+#pragma mark NodeClipboardReference
+
+/* Stands for a registry texture or shader in the archive, it's replaced by the registry object when decoded */
+@interface NodeClipboardReference : NSObject <NSCoding>
+@property (copy) NSString *kind;
+@property (copy) NSString *name;
+@end
+
+@implementation NodeClipboardReference
+
+- (id)initWithCoder:(NSCoder *)aDecoder {
+	if (self = [super init]) {
+		_kind = [aDecoder decodeObjectForKey:@"kind"];
+		_name = [aDecoder decodeObjectForKey:@"name"];
+	}
+	return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+	[aCoder encodeObject:_kind forKey:@"kind"];
+	[aCoder encodeObject:_name forKey:@"name"];
+}
+
+- (id)awakeAfterUsingCoder:(NSCoder *)aDecoder {
+	if ([_kind isEqualToString:@"texture"]) {
+		return [[TextureRegistry sharedRegistry] textureNamed:_name];
+	} else if ([_kind isEqualToString:@"shader"]) {
+		return [[ShaderRegistry sharedRegistry] shaderNamed:_name];
+	}
+	return nil;
+}
+
+@end
+
+#pragma mark NodeClipboard
+
+@interface NodeClipboard () <NSKeyedArchiverDelegate>
+@property (strong) NSArray *nodes;
+@property (strong) NSHashTable *nodeSet;
+@end
+
+@implementation NodeClipboard
+
+- (id)archiver:(NSKeyedArchiver *)archiver willEncodeObject:(id)object {
+	/* The nodes are archived without their children, the parent indices link them again */
+	if ([object isKindOfClass:[NSArray class]] && object != _nodes) {
+		id firstObject = [object firstObject];
+		if ([firstObject isKindOfClass:[SKNode class]] && [_nodeSet containsObject:firstObject] && [object isEqualToArray:[firstObject parent].children]) {
+			return @[];
+		}
+		return object;
+	}
+
+	/* Only the instances shared through the registries are stored by name, the rest are archived as usual */
+	NodeClipboardReference *reference = nil;
+	if ([object isKindOfClass:[SKTexture class]]) {
+		TextureRegistry *registry = [TextureRegistry sharedRegistry];
+		NSString *name = [registry nameOfTexture:object];
+		if (name && [registry textureNamed:name] == object) {
+			reference = [[NodeClipboardReference alloc] init];
+			reference.kind = @"texture";
+			reference.name = name;
+		}
+	} else if ([object isKindOfClass:[SKShader class]]) {
+		ShaderRegistry *registry = [ShaderRegistry sharedRegistry];
+		NSString *name = [registry nameOfShader:object];
+		if (name && [registry shaderNamed:name] == object) {
+			reference = [[NodeClipboardReference alloc] init];
+			reference.kind = @"shader";
+			reference.name = name;
+		}
+	}
+	return reference ?: object;
+}
+
++ (NSData *)dataWithNode:(SKNode *)node expansionInfo:(id)expansionInfo {
+	if (!node)
+		return nil;
+
+	/* Flatten the subtree in place, the archiver delegate leaves the children out of every node */
+	NSMutableArray *nodes = [NSMutableArray array];
+	NSHashTable *nodeSet = [NSHashTable hashTableWithOptions:NSPointerFunctionsStrongMemory|NSPointerFunctionsObjectPointerPersonality];
+	NSMutableData *parents = [NSMutableData data];
+	NSMutableArray *stack = [NSMutableArray arrayWithObject:node];
+	NSMutableData *stackParents = [NSMutableData dataWithBytes:&NodeClipboardNoParent length:sizeof(uint32_t)];
+
+	while (stack.count) {
+		SKNode *current = stack.lastObject;
+		[stack removeLastObject];
+		uint32_t parent = ((uint32_t *)stackParents.mutableBytes)[stack.count];
+		stackParents.length = stack.count * sizeof(uint32_t);
+
+		uint32_t index = (uint32_t)nodes.count;
+		[nodes addObject:current];
+		[nodeSet addObject:current];
+		[parents appendBytes:&parent length:sizeof(uint32_t)];
+
+		/* Push the children in reverse so that they come out in order */
+		for (SKNode *child in current.children.reverseObjectEnumerator) {
+			[stack addObject:child];
+			[stackParents appendBytes:&index length:sizeof(uint32_t)];
+		}
+	}
+
+	NodeClipboardHeader header;
+	memcpy(header.magic, NodeClipboardMagic, sizeof(header.magic));
+	header.version = NodeClipboardVersion;
+	header.nodeCount = (uint32_t)nodes.count;
+
+	NSMutableData *data = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+	[data appendData:parents];
+
+	NSMutableData *archivedData = [NSMutableData data];
+	NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:archivedData];
+	NodeClipboard *delegate = [[NodeClipboard alloc] init];
+	delegate.nodes = nodes;
+	delegate.nodeSet = nodeSet;
+	archiver.delegate = delegate;
+	[archiver encodeObject:nodes forKey:@"nodes"];
+	if (expansionInfo) {
+		[archiver encodeObject:expansionInfo forKey:@"expansionInfo"];
+	}
+	[archiver finishEncoding];
+	[data appendData:archivedData];
+
+	return data;
+}
+
++ (NSArray *)nodesWithData:(NSData *)data count:(NSUInteger)count expansionInfo:(id __autoreleasing *)expansionInfo error:(NSError * __autoreleasing *)error {
+	NodeClipboardHeader header;
+	if (data.length < sizeof(header))
+		return [self corruptDataWithError:error];
+
+	[data getBytes:&header length:sizeof(header)];
+	NSUInteger parentsLength = header.nodeCount * sizeof(uint32_t);
+	if (memcmp(header.magic, NodeClipboardMagic, sizeof(header.magic)) != 0
+		|| header.version != NodeClipboardVersion
+		|| header.nodeCount == 0
+		|| data.length < sizeof(header) + parentsLength)
+		return [self corruptDataWithError:error];
+
+	const uint32_t *parents = (const uint32_t *)((const char *)data.bytes + sizeof(header));
+	if (parents[0] != NodeClipboardNoParent)
+		return [self corruptDataWithError:error];
+	for (uint32_t i = 1; i < header.nodeCount; ++i) {
+		if (parents[i] >= i)
+			return [self corruptDataWithError:error];
+	}
+
+	/* Every copy is decoded on its own, copying the nodes would give them their own textures and shaders */
+	NSData *archivedData = [data subdataWithRange:NSMakeRange(sizeof(header) + parentsLength, data.length - sizeof(header) - parentsLength)];
+	NSMutableArray *roots = [NSMutableArray arrayWithCapacity:count];
+	for (NSUInteger copyIndex = 0; copyIndex < MAX(count, 1); ++copyIndex) {
+		NSArray *nodes = nil;
+		@try {
+			NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:archivedData];
+			nodes = [unarchiver decodeObjectForKey:@"nodes"];
+			if (copyIndex == 0 && expansionInfo) {
+				*expansionInfo = [unarchiver decodeObjectForKey:@"expansionInfo"];
+			}
+			[unarchiver finishDecoding];
+		}
+		@catch (NSException *exception) {
+			return [self corruptDataWithError:error];
+		}
+
+		if (nodes.count != header.nodeCount)
+			return [self corruptDataWithError:error];
+
+		/* Parents always come before their children, the tree is linked in a single pass */
+		for (uint32_t i = 1; i < header.nodeCount; ++i) {
+			[nodes[parents[i]] addChild:nodes[i]];
+		}
+		[roots addObject:nodes[0]];
+	}
+
+	return roots;
+}
+
++ (id)corruptDataWithError:(NSError * __autoreleasing *)error {
+	if (error) {
+		*error = [NSError errorWithDomain:NSCocoaErrorDomain
+									 code:NSPropertyListReadCorruptError
+								 userInfo:@{NSLocalizedDescriptionKey: @"The clipboard doesn't contain nodes that can be pasted."}];
+	}
+	return nil;
+}
+
+@end
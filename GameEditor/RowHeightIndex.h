@@ -0,0 +1,43 @@
+/*
+ * RowHeightIndex.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/*
+ Keeps the heights of the rows of a table in a binary indexed tree, so that the offset of a row,
+ the row at an offset and updating the height of a single row are all O(log n) instead of
+ walking every row above it
+ */
+@interface RowHeightIndex : NSObject
+- (void)setHeights:(const CGFloat *)heights count:(NSUInteger)count;
+- (void)setHeight:(CGFloat)height ofRow:(NSUInteger)row;
+- (CGFloat)heightOfRow:(NSUInteger)row;
+- (CGFloat)offsetOfRow:(NSUInteger)row;
+- (NSUInteger)rowAtOffset:(CGFloat)offset;
+- (NSRange)rowsFromOffset:(CGFloat)minOffset toOffset:(CGFloat)maxOffset;
+- (void)removeAllRows;
+@property (readonly) NSUInteger count;
+@property (readonly) CGFloat totalHeight;
+@end
@@ -0,0 +1,147 @@
+/*
+ * RowHeightIndex.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "RowHeightIndex.h"
+
+@implementation RowHeightIndex {
+	/* The heights of the rows and the tree of partial sums, the tree is 1-based */
+	NSMutableData *_heights;
+	NSMutableData *_tree;
+	NSUInteger _count;
+	NSUInteger _highestBit;
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_heights = [NSMutableData data];
+		_tree = [NSMutableData data];
+	}
+	return self;
+}
+
+- (void)setHeights:(const CGFloat *)heights count:(NSUInteger)count {
+	_count = count;
+	_heights.length = count * sizeof(CGFloat);
+	_tree.length = (count + 1) * sizeof(CGFloat);
+
+	CGFloat *rowHeights = _heights.mutableBytes;
+	CGFloat *tree = _tree.mutableBytes;
+
+	if (count)
+		memcpy(rowHeights, heights, count * sizeof(CGFloat));
+
+	/* Build the tree in linear time by pushing every partial sum up to its parent once */
+	tree[0] = 0;
+	memcpy(tree + 1, rowHeights, count * sizeof(CGFloat));
+	for (NSUInteger i = 1; i <= count; ++i) {
+		NSUInteger parent = i + (i & -i);
+		if (parent <= count) {
+			tree[parent] += tree[i];
+		}
+	}
+
+	_highestBit = 1;
+	while (_highestBit * 2 <= count) {
+		_highestBit *= 2;
+	}
+}
+
+- (void)setHeight:(CGFloat)height ofRow:(NSUInteger)row {
+	NSAssert(row < _count, @"Row %lu out of bounds", (unsigned long)row);
+
+	CGFloat *rowHeights = _heights.mutableBytes;
+	CGFloat delta = height - rowHeights[row];
+	if (delta == 0)
+		return;
+
+	rowHeights[row] = height;
+
+	CGFloat *tree = _tree.mutableBytes;
+	for (NSUInteger i = row + 1; i <= _count; i += i & -i) {
+		tree[i] += delta;
+	}
+}
+
+- (CGFloat)heightOfRow:(NSUInteger)row {
+	NSAssert(row < _count, @"Row %lu out of bounds", (unsigned long)row);
+	return ((const CGFloat *)_heights.bytes)[row];
+}
+
+- (CGFloat)offsetOfRow:(NSUInteger)row {
+	/* Sum of the heights of the rows above the given one */
+	const CGFloat *tree = _tree.bytes;
+	CGFloat offset = 0;
+	for (NSUInteger i = MIN(row, _count); i > 0; i -= i & -i) {
+		offset += tree[i];
+	}
+	return offset;
+}
+
+- (NSUInteger)rowAtOffset:(CGFloat)offset {
+	if (offset < 0 || _count == 0)
+		return NSNotFound;
+
+	/* Descend the tree looking for the last row whose top is at or above the offset */
+	const CGFloat *tree = _tree.bytes;
+	NSUInteger position = 0;
+	for (NSUInteger step = _highestBit; step > 0; step /= 2) {
+		NSUInteger next = position + step;
+		if (next <= _count && tree[next] <= offset) {
+			position = next;
+			offset -= tree[next];
+		}
+	}
+	return position < _count ? position : NSNotFound;
+}
+
+- (NSRange)rowsFromOffset:(CGFloat)minOffset toOffset:(CGFloat)maxOffset {
+	if (_count == 0 || maxOffset <= 0 || minOffset >= self.totalHeight || maxOffset <= minOffset)
+		return NSMakeRange(0, 0);
+
+	NSUInteger first = [self rowAtOffset:MAX(0, minOffset)];
+	NSUInteger last = [self rowAtOffset:maxOffset];
+
+	/* A row starting right at the end of the range isn't part of it */
+	if (last == NSNotFound) {
+		last = _count - 1;
+	} else if (last > first && [self offsetOfRow:last] >= maxOffset) {
+		last--;
+	}
+	return NSMakeRange(first, last - first + 1);
+}
+
+- (void)removeAllRows {
+	[self setHeights:NULL count:0];
+}
+
+- (NSUInteger)count {
+	return _count;
+}
+
+- (CGFloat)totalHeight {
+	return [self offsetOfRow:_count];
+}
+
+@end
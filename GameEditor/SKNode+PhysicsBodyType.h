@@ -25,8 +25,18 @@
 
 #import <SpriteKit/SpriteKit.h>
 
+/*
+ The body types are the ones listed by the inspector: 1 none, 2 bounding rectangle, 3 bounding circle,
+ 4 alpha mask, 5 path and 6 edges, 0 is a body that wasn't made through the body type.
+ Shapes made from a size are cached per texture, size, anchor point and body type and every node
+ that asks for the same shape gets a copy. Alpha masks are traced in the background, the node gets
+ its body once the shape is ready and reports the requested body type meanwhile
+ */
 @interface SKNode (PhysicsBodyType)
 
 @property (assign) NSUInteger bodyType;
 
++ (NSUInteger)pendingPhysicsBodyCount;
++ (void)removeAllCachedPhysicsBodies;
+
 @end
@@ -24,80 +24,230 @@
  */
 
 #import "SKNode+PhysicsBodyType.h"
+#import <objc/runtime.h>
+
+static const void *kBodyTypeKey = &kBodyTypeKey;
+static const void *kPendingShapeKey = &kPendingShapeKey;
+
+enum {
+	PhysicsBodyTypeOther = 0,
+	PhysicsBodyTypeNone = 1,
+	PhysicsBodyTypeRectangle = 2,
+	PhysicsBodyTypeCircle = 3,
+	PhysicsBodyTypeAlphaMask = 4,
+	PhysicsBodyTypePath = 5,
+	PhysicsBodyTypeEdges = 6
+};
+
+/* Sets the node's body remembering which body type it was made for */
+static void SetPhysicsBody(SKNode *node, SKPhysicsBody *physicsBody, NSUInteger bodyType) {
+	if (physicsBody) {
+		if (bodyType != PhysicsBodyTypeEdges)
+			physicsBody.dynamic = NO;
+		objc_setAssociatedObject(physicsBody, kBodyTypeKey, @(bodyType), OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+	node.physicsBody = physicsBody;
+}
+
+#pragma mark PhysicsShapeCache
+
+/* The shapes made so far, and the nodes waiting for the alpha masks being traced */
+@interface PhysicsShapeCache : NSObject
++ (instancetype)sharedCache;
+@end
+
+@implementation PhysicsShapeCache {
+	/* Texture to a dictionary of shapes by key, the shapes of a texture go away with it */
+	NSMapTable *_shapesByTexture;
+	NSMutableDictionary *_untexturedShapes;
+
+	/* Shape key to the nodes waiting for it */
+	NSMutableDictionary *_waitingNodes;
+	dispatch_queue_t _queue;
+}
+
++ (instancetype)sharedCache {
+	static PhysicsShapeCache *sharedCache = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sharedCache = [[PhysicsShapeCache alloc] init];
+	});
+	return sharedCache;
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_shapesByTexture = [NSMapTable weakToStrongObjectsMapTable];
+		_untexturedShapes = [NSMutableDictionary dictionary];
+		_waitingNodes = [NSMutableDictionary dictionary];
+		_queue = dispatch_queue_create("developer.GameEditor.physics-shapes", DISPATCH_QUEUE_CONCURRENT);
+	}
+	return self;
+}
+
+- (NSMutableDictionary *)shapesOfTexture:(SKTexture *)texture {
+	if (!texture)
+		return _untexturedShapes;
+
+	NSMutableDictionary *shapes = [_shapesByTexture objectForKey:texture];
+	if (!shapes) {
+		shapes = [NSMutableDictionary dictionary];
+		[_shapesByTexture setObject:shapes forKey:texture];
+	}
+	return shapes;
+}
+
++ (NSString *)keyWithBodyType:(NSUInteger)bodyType size:(CGSize)size anchorPoint:(CGPoint)anchorPoint {
+	return [NSString stringWithFormat:@"%lu %g %g %g %g", (unsigned long)bodyType, size.width, size.height, anchorPoint.x, anchorPoint.y];
+}
+
+- (SKPhysicsBody *)shapeWithKey:(NSString *)key texture:(SKTexture *)texture {
+	return [self shapesOfTexture:texture][key];
+}
+
+- (void)setShape:(SKPhysicsBody *)shape withKey:(NSString *)key texture:(SKTexture *)texture {
+	[self shapesOfTexture:texture][key] = shape;
+}
+
+- (void)traceAlphaMaskOfTexture:(SKTexture *)texture size:(CGSize)size key:(NSString *)key forNode:(SKNode *)node {
+	/* The node owns a reference to the pending request, replacing the body type drops it */
+	id pendingShape = @[key, texture];
+	objc_setAssociatedObject(node, kPendingShapeKey, pendingShape, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+
+	/* Nodes sharing the texture wait for the same trace */
+	NSString *waitingKey = [NSString stringWithFormat:@"%p %@", texture, key];
+	NSHashTable *nodes = _waitingNodes[waitingKey];
+	if (nodes) {
+		[nodes addObject:node];
+		return;
+	}
+
+	nodes = [NSHashTable weakObjectsHashTable];
+	[nodes addObject:node];
+	_waitingNodes[waitingKey] = nodes;
+
+	dispatch_async(_queue, ^{
+		SKPhysicsBody *shape = [SKPhysicsBody bodyWithTexture:texture size:size];
+		shape.dynamic = NO;
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self setShape:shape withKey:key texture:texture];
+
+			NSHashTable *waitingNodes = _waitingNodes[waitingKey];
+			[_waitingNodes removeObjectForKey:waitingKey];
+
+			for (SKNode *waitingNode in waitingNodes) {
+				/* Skip the nodes whose body type changed while the shape was traced */
+				id pending = objc_getAssociatedObject(waitingNode, kPendingShapeKey);
+				if (![pending isEqual:pendingShape])
+					continue;
+				objc_setAssociatedObject(waitingNode, kPendingShapeKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+				SetPhysicsBody(waitingNode, [shape copy], PhysicsBodyTypeAlphaMask);
+			}
+		});
+	});
+}
+
+- (NSUInteger)pendingCount {
+	NSUInteger count = 0;
+	for (NSHashTable *nodes in _waitingNodes.allValues) {
+		count += nodes.count;
+	}
+	return count;
+}
+
+- (void)removeAllShapes {
+	[_shapesByTexture removeAllObjects];
+	[_untexturedShapes removeAllObjects];
+}
+
+@end
+
+#pragma mark SKNode (PhysicsBodyType)
 
 @implementation SKNode (PhysicsBodyType)
 
+- (SKPhysicsBody *)cachedShapeWithBodyType:(NSUInteger)bodyType texture:(SKTexture *)texture size:(CGSize)size anchorPoint:(CGPoint)anchorPoint {
+	PhysicsShapeCache *cache = [PhysicsShapeCache sharedCache];
+	NSString *key = [PhysicsShapeCache keyWithBodyType:bodyType size:size anchorPoint:anchorPoint];
+	SKPhysicsBody *shape = [cache shapeWithKey:key texture:texture];
+
+	if (!shape) {
+		CGPoint center = CGPointMake(size.width * (0.5 - anchorPoint.x), size.height * (0.5 - anchorPoint.y));
+
+		if (bodyType == PhysicsBodyTypeRectangle) {
+			shape = [SKPhysicsBody bodyWithRectangleOfSize:size center:center];
+		} else {
+			/* Find the a minimum radius that resembles the one shown on Xcode */
+			CGFloat minDimension = MIN(size.width, size.height);
+			CGFloat maxDimension = MAX(size.width, size.height);
+			CGFloat radius = 0.5 * MAX(minDimension, M_SQRT1_2 * maxDimension);
+			shape = [SKPhysicsBody bodyWithCircleOfRadius:radius center:center];
+		}
+		[cache setShape:shape withKey:key texture:texture];
+	}
+
+	/* Bodies can't be shared between nodes, each one gets its own copy of the shape */
+	return [shape copy];
+}
+
 - (void)setBodyType:(NSUInteger)bodyType {
+	/* Any alpha mask still being traced for the node is no longer wanted */
+	objc_setAssociatedObject(self, kPendingShapeKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+
+	BOOL hasSize = [self respondsToSelector:@selector(size)];
+	CGSize size = hasSize ? [(id)self size] : CGSizeZero;
+	CGPoint anchorPoint = [self respondsToSelector:@selector(anchorPoint)] ? [(id)self anchorPoint] : CGPointMake(0.5, 0.5);
+	SKTexture *texture = [self respondsToSelector:@selector(texture)] ? [(id)self texture] : nil;
+
 	switch (bodyType) {
 			/* None */
-		case 1:
+		case PhysicsBodyTypeNone:
 			self.physicsBody = nil;
 			break;
 
 			/* Bounding Rectangle */
-		case 2:
-			if ([self respondsToSelector:@selector(size)]) {
-				CGSize size = [(id)self size];
-				if ([self respondsToSelector:@selector(anchorPoint)]) {
-					CGPoint anchorPoint = [(id)self anchorPoint];
-					CGPoint center = CGPointMake(size.width * (0.5 - anchorPoint.x), size.height * (0.5 - anchorPoint.y));
-					self.physicsBody = [SKPhysicsBody bodyWithRectangleOfSize:size center:center];
-				} else {
-					self.physicsBody = [SKPhysicsBody bodyWithRectangleOfSize:[(id)self size]];
-				}
-			} else {
-				self.physicsBody = nil;
-			}
-			self.physicsBody.dynamic = NO;
-			break;
-
 			/* Bounding Circle */
-		case 3:
-			if ([self respondsToSelector:@selector(size)]) {
-				CGSize size = [(id)self size];
-
-				/* Find the a minimum radius that resembles the one shown on Xcode */
-				CGFloat minDimension = MIN(size.width, size.height);
-				CGFloat maxDimension = MAX(size.width, size.height);
-				CGFloat radius = 0.5 * MAX(minDimension, M_SQRT1_2 * maxDimension);
-
-				if ([self respondsToSelector:@selector(anchorPoint)]) {
-					CGPoint anchorPoint = [(id)self anchorPoint];
-					CGPoint center = CGPointMake(size.width * (0.5 - anchorPoint.x), size.height * (0.5 - anchorPoint.y));
-					self.physicsBody = [SKPhysicsBody bodyWithCircleOfRadius:radius center:center];
-				} else {
-					self.physicsBody = [SKPhysicsBody bodyWithCircleOfRadius:radius];
-				}
+		case PhysicsBodyTypeRectangle:
+		case PhysicsBodyTypeCircle:
+			if (hasSize) {
+				SetPhysicsBody(self, [self cachedShapeWithBodyType:bodyType texture:texture size:size anchorPoint:anchorPoint], bodyType);
 			} else {
 				self.physicsBody = nil;
 			}
-			self.physicsBody.dynamic = NO;
 			break;
 
 			/* Alpha mask */
-		case 4:
-			if ([self respondsToSelector:@selector(texture)] && [self respondsToSelector:@selector(size)]) {
-				self.physicsBody = [SKPhysicsBody bodyWithTexture:(SKTexture *)[(id)self texture] size:[(id)self size]];
+		case PhysicsBodyTypeAlphaMask:
+			if (texture && hasSize) {
+				PhysicsShapeCache *cache = [PhysicsShapeCache sharedCache];
+				/* The traced outline is centered on the node whatever its anchor point, so it's shared across anchor points */
+				NSString *key = [PhysicsShapeCache keyWithBodyType:bodyType size:size anchorPoint:CGPointZero];
+				SKPhysicsBody *shape = [cache shapeWithKey:key texture:texture];
+				if (shape) {
+					SetPhysicsBody(self, [shape copy], bodyType);
+				} else {
+					/* Tracing the texture's pixels is slow, the body is set once it's done */
+					[cache traceAlphaMaskOfTexture:texture size:size key:key forNode:self];
+				}
 			} else {
 				self.physicsBody = nil;
 			}
-			self.physicsBody.dynamic = NO;
 			break;
 
 			/* Path */
-		case 5:
+		case PhysicsBodyTypePath:
 			if ([self respondsToSelector:@selector(path)]) {
-				self.physicsBody = [SKPhysicsBody bodyWithPolygonFromPath:[(SKShapeNode *)self path]];
+				SetPhysicsBody(self, [SKPhysicsBody bodyWithPolygonFromPath:[(SKShapeNode *)self path]], bodyType);
 			}
-			self.physicsBody.dynamic = NO;
 			break;
 
 			/* Edges */
-		case 6:
+		case PhysicsBodyTypeEdges:
 			if ([self respondsToSelector:@selector(path)]) {
-				self.physicsBody = [SKPhysicsBody bodyWithEdgeLoopFromPath:[(SKShapeNode *)self path]];
+				SetPhysicsBody(self, [SKPhysicsBody bodyWithEdgeLoopFromPath:[(SKShapeNode *)self path]], bodyType);
 			} else {
-				self.physicsBody = [SKPhysicsBody bodyWithEdgeLoopFromRect:self.frame];
+				SetPhysicsBody(self, [SKPhysicsBody bodyWithEdgeLoopFromRect:self.frame], bodyType);
 			}
 			break;
 
@@ -108,7 +258,23 @@
 }
 
 - (NSUInteger)bodyType {
-	return self.physicsBody == nil ? 1 : 0;
+	/* An alpha mask being traced is reported as the body type the node is going to have */
+	if (objc_getAssociatedObject(self, kPendingShapeKey))
+		return PhysicsBodyTypeAlphaMask;
+
+	if (self.physicsBody == nil)
+		return PhysicsBodyTypeNone;
+
+	NSNumber *bodyType = objc_getAssociatedObject(self.physicsBody, kBodyTypeKey);
+	return bodyType ? [bodyType unsignedIntegerValue] : PhysicsBodyTypeOther;
+}
+
++ (NSUInteger)pendingPhysicsBodyCount {
+	return [[PhysicsShapeCache sharedCache] pendingCount];
+}
+
++ (void)removeAllCachedPhysicsBodies {
+	[[PhysicsShapeCache sharedCache] removeAllShapes];
 }
 
 @end
@@ -0,0 +1,46 @@
+/*
+ * SceneArchive.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/* Keys of the timings reported by the scene archive, in seconds */
+extern NSString *const SceneArchiveMapTimingKey;
+extern NSString *const SceneArchiveSniffTimingKey;
+extern NSString *const SceneArchiveDecodeTimingKey;
+extern NSString *const SceneArchiveTotalTimingKey;
+
+@interface SceneArchive : NSObject
++ (NSPropertyListFormat)formatOfData:(NSData *)data;
++ (id)rootObjectWithContentsOfFile:(NSString *)file
+						   classes:(NSDictionary *)classes
+							format:(NSPropertyListFormat *)format
+						   timings:(NSDictionary * __autoreleasing *)timings
+							 error:(NSError * __autoreleasing *)error;
++ (NSData *)archivedDataWithRootObject:(id)rootObject format:(NSPropertyListFormat)format;
++ (NSProgress *)writeRootObject:(id)rootObject
+						 toFile:(NSString *)file
+						 format:(NSPropertyListFormat)format
+			  completionHandler:(void (^)(NSError *error))completionHandler;
+@end
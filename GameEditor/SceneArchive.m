@@ -0,0 +1,221 @@
+/*
+ * SceneArchive.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "SceneArchive.h"
+
+NSString *const SceneArchiveMapTimingKey = @"map";
+NSString *const SceneArchiveSniffTimingKey = @"sniff";
+NSString *const SceneArchiveDecodeTimingKey = @"decode";
+NSString *const SceneArchiveTotalTimingKey = @"total";
+
+/* Format returned when the header doesn't belong to a property list */
+static const NSPropertyListFormat SceneArchiveUnknownFormat = 0;
+
+/* Size of the pieces written to disk between progress updates */
+static const NSUInteger SceneArchiveChunkSize = 256 * 1024;
+
+@implementation SceneArchive
+
++ (NSPropertyListFormat)formatOfData:(NSData *)data {
+	const char *bytes = data.bytes;
+	NSUInteger length = data.length;
+
+	/* Binary property lists start with a magic number and a version */
+	if (length >= 8 && memcmp(bytes, "bplist0", 7) == 0) {
+		return NSPropertyListBinaryFormat_v1_0;
+	}
+
+	/* Skip the byte order mark and white space before the XML declaration */
+	NSUInteger i = 0;
+	if (length >= 3 && memcmp(bytes, "\xEF\xBB\xBF", 3) == 0) {
+		i = 3;
+	}
+	while (i < length && (bytes[i] == ' ' || bytes[i] == '\t' || bytes[i] == '\r' || bytes[i] == '\n')) {
+		i++;
+	}
+
+	if ((length - i >= 5 && memcmp(bytes + i, "<?xml", 5) == 0)
+		|| (length - i >= 9 && memcmp(bytes + i, "<!DOCTYPE", 9) == 0)
+		|| (length - i >= 6 && memcmp(bytes + i, "<plist", 6) == 0)) {
+		return NSPropertyListXMLFormat_v1_0;
+	}
+
+	return SceneArchiveUnknownFormat;
+}
+
++ (id)rootObjectWithContentsOfFile:(NSString *)file
+						   classes:(NSDictionary *)classes
+							format:(NSPropertyListFormat *)format
+						   timings:(NSDictionary * __autoreleasing *)timings
+							 error:(NSError * __autoreleasing *)error {
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+	/* Map the file instead of copying it, the pages are read as the unarchiver touches them */
+	NSData *data = [NSData dataWithContentsOfFile:file options:NSDataReadingMappedIfSafe error:error];
+	if (!data)
+		return nil;
+
+	CFAbsoluteTime mapTime = CFAbsoluteTimeGetCurrent();
+
+	/* Only the header is needed to tell the format */
+	NSPropertyListFormat dataFormat = [self formatOfData:data];
+
+	CFAbsoluteTime sniffTime = CFAbsoluteTimeGetCurrent();
+
+	if (dataFormat == SceneArchiveUnknownFormat) {
+		if (error) {
+			*error = [NSError errorWithDomain:NSCocoaErrorDomain
+										 code:NSFileReadCorruptFileError
+									 userInfo:@{NSFilePathErrorKey: file,
+												NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The file \"%@\" isn't a scene archive.", file.lastPathComponent]}];
+		}
+		return nil;
+	}
+
+	/* The unarchiver reads both binary and XML archives, so the XML doesn't need to be converted to binary first */
+	id rootObject = nil;
+	@try {
+		NSKeyedUnarchiver *arch = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+		for (NSString *className in classes) {
+			[arch setClass:classes[className] forClassName:className];
+		}
+		rootObject = [arch decodeObjectForKey:NSKeyedArchiveRootObjectKey];
+		[arch finishDecoding];
+	}
+	@catch (NSException *exception) {
+		if (error) {
+			*error = [NSError errorWithDomain:NSCocoaErrorDomain
+										 code:NSFileReadCorruptFileError
+									 userInfo:@{NSFilePathErrorKey: file,
+												NSLocalizedDescriptionKey: [NSString stringWithFormat:@"The file \"%@\" couldn't be opened.", file.lastPathComponent],
+												NSLocalizedFailureReasonErrorKey: exception.reason ?: @""}];
+		}
+		return nil;
+	}
+
+	CFAbsoluteTime decodeTime = CFAbsoluteTimeGetCurrent();
+
+	if (format) {
+		*format = dataFormat;
+	}
+
+	if (timings) {
+		*timings = @{SceneArchiveMapTimingKey: @(mapTime - startTime),
+					 SceneArchiveSniffTimingKey: @(sniffTime - mapTime),
+					 SceneArchiveDecodeTimingKey: @(decodeTime - sniffTime),
+					 SceneArchiveTotalTimingKey: @(decodeTime - startTime)};
+	}
+
+	return rootObject;
+}
+
+#pragma mark Saving
+
++ (NSData *)archivedDataWithRootObject:(id)rootObject format:(NSPropertyListFormat)format {
+	NSMutableData *data = [NSMutableData data];
+	NSKeyedArchiver *arch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+	[arch setOutputFormat:format];
+	[arch encodeObject:rootObject forKey:NSKeyedArchiveRootObjectKey];
+	[arch finishEncoding];
+	return data;
+}
+
++ (dispatch_queue_t)savingQueue {
+	static dispatch_queue_t savingQueue;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		savingQueue = dispatch_queue_create("developer.GameEditor.saving", DISPATCH_QUEUE_SERIAL);
+	});
+	return savingQueue;
+}
+
++ (NSProgress *)writeRootObject:(id)rootObject
+						 toFile:(NSString *)file
+						 format:(NSPropertyListFormat)format
+			  completionHandler:(void (^)(NSError *error))completionHandler {
+	/* Take the snapshot of the scene in the calling thread, the binary archive is the cheapest form of it.
+	   Copying the nodes instead would unshare their textures and shaders, and change the bytes written */
+	NSData *snapshot = [self archivedDataWithRootObject:rootObject format:NSPropertyListBinaryFormat_v1_0];
+
+	NSProgress *progress = [NSProgress progressWithTotalUnitCount:-1];
+
+	dispatch_async([self savingQueue], ^{
+		NSError *error = nil;
+		NSData *data = snapshot;
+
+		if (format != NSPropertyListBinaryFormat_v1_0) {
+			/* Converting the archive gives the same property list, and therefore the same bytes, the archiver would have written */
+			id plist = [NSPropertyListSerialization propertyListWithData:snapshot options:NSPropertyListImmutable format:NULL error:&error];
+			data = plist ? [NSPropertyListSerialization dataWithPropertyList:plist format:format options:0 error:&error] : nil;
+		}
+
+		if (data) {
+			progress.totalUnitCount = data.length;
+
+			/* Write next to the destination so the file can be moved into place atomically */
+			NSString *temporaryFile = [[file stringByDeletingLastPathComponent] stringByAppendingPathComponent:
+									   [NSString stringWithFormat:@".%@.%@", file.lastPathComponent, [NSUUID UUID].UUIDString]];
+
+			if ([[NSFileManager defaultManager] createFileAtPath:temporaryFile contents:nil attributes:nil]) {
+				NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:temporaryFile];
+				@try {
+					for (NSUInteger offset = 0; offset < data.length; offset += SceneArchiveChunkSize) {
+						NSRange range = NSMakeRange(offset, MIN(SceneArchiveChunkSize, data.length - offset));
+						[fileHandle writeData:[data subdataWithRange:range]];
+						progress.completedUnitCount = NSMaxRange(range);
+					}
+					[fileHandle synchronizeFile];
+				}
+				@catch (NSException *exception) {
+					error = [NSError errorWithDomain:NSCocoaErrorDomain
+												code:NSFileWriteUnknownError
+											userInfo:@{NSFilePathErrorKey: file,
+													   NSLocalizedFailureReasonErrorKey: exception.reason ?: @""}];
+				}
+				[fileHandle closeFile];
+
+				if (!error && rename(temporaryFile.fileSystemRepresentation, file.fileSystemRepresentation) != 0) {
+					error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: file}];
+				}
+				if (error) {
+					[[NSFileManager defaultManager] removeItemAtPath:temporaryFile error:NULL];
+				}
+
+			} else {
+				error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteNoPermissionError userInfo:@{NSFilePathErrorKey: file}];
+			}
+		}
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (completionHandler) {
+				completionHandler(error);
+			}
+		});
+	});
+
+	return progress;
+}
+
+@end
@@ -0,0 +1,40 @@
+/*
+ * ScriptContextPool.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "LuaContext.h"
+
+/* Library scripts parsed ahead of time, each one with a few contexts ready to create nodes */
+@interface ScriptContextPool : NSObject
++ (NSArray *)createNodesAtPositions:(NSArray *)positions name:(NSString *)name inContext:(LuaContext *)context error:(NSError * __autoreleasing *)error;
+- (instancetype)initWithGlobals:(NSDictionary *)globals;
+- (void)prewarmScript:(NSString *)script forKey:(id<NSCopying>)key;
+- (LuaContext *)dequeueContextForKey:(id<NSCopying>)key script:(NSString *)script error:(NSError * __autoreleasing *)error;
+- (void)enqueueContext:(LuaContext *)context forKey:(id<NSCopying>)key;
+- (void)removeAllContexts;
+- (void)performWhenPrewarmed:(dispatch_block_t)block;
+@property (readonly) NSDictionary *globals;
+@property (assign) NSUInteger warmContextCount;
+@end
@@ -0,0 +1,227 @@
+/*
+ * ScriptContextPool.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "ScriptContextPool.h"
+#import "ScriptExporter.h"
+#import <objc/runtime.h>
+
+/* Creates several nodes in one call from Objective-C, unless the library script has its own version */
+static NSString *const ScriptContextPoolBatchScript = LUA_STRING
+(
+ if createNodesAtPositions == nil then
+	function createNodesAtPositions(positions, name)
+		local nodes = {}
+		for i, position in ipairs(positions) do
+			nodes[i] = createNodeAtPosition(position, name)
+		end
+		return nodes
+	end
+ end
+ );
+
+/* The script a context was prepared with */
+static char ScriptContextPoolScriptKey;
+
+@implementation ScriptContextPool {
+	dispatch_queue_t _prewarmQueue;
+	NSMutableDictionary *_idleContexts;
+	NSMutableDictionary *_scripts;
+	NSUInteger _generation;
+	NSArray *_exportedClasses;
+}
+
+@synthesize globals = _globals;
+
++ (NSArray *)createNodesAtPositions:(NSArray *)positions name:(NSString *)name inContext:(LuaContext *)context error:(NSError * __autoreleasing *)error {
+	id result = [context call:@"createNodesAtPositions" with:@[positions, name] error:error];
+
+	/* Lua tables come back either as arrays or as dictionaries keyed by their index */
+	if ([result isKindOfClass:[NSDictionary class]]) {
+		NSArray *keys = [[result allKeys] sortedArrayUsingSelector:@selector(compare:)];
+		return [result objectsForKeys:keys notFoundMarker:[NSNull null]];
+	}
+	if ([result isKindOfClass:[NSArray class]]) {
+		return result;
+	}
+	return result ? @[result] : @[];
+}
+
+- (instancetype)initWithGlobals:(NSDictionary *)globals {
+	if (self = [super init]) {
+		_globals = [globals copy];
+
+		NSMutableArray *exportedClasses = [NSMutableArray array];
+		for (id global in _globals.allValues) {
+			if (class_isMetaClass(object_getClass(global))) {
+				[exportedClasses addObject:global];
+			}
+		}
+		_exportedClasses = exportedClasses;
+		_warmContextCount = 1;
+		_prewarmQueue = dispatch_queue_create("developer.GameEditor.scripting", DISPATCH_QUEUE_SERIAL);
+		_idleContexts = [NSMutableDictionary dictionary];
+		_scripts = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
+- (LuaContext *)newContextWithScript:(NSString *)script error:(NSError * __autoreleasing *)error {
+	/* The classes are exported the first time a context uses them */
+	ScriptExporter *exporter = [ScriptExporter sharedExporter];
+	[exporter exportClasses:_exportedClasses];
+	[exporter saveMetadata];
+
+	/* Every context gets its own virtual machine, so it can be prepared away from the one used in the main thread */
+	LuaContext *context = [LuaContext new];
+	for (NSString *name in _globals) {
+		context[name] = _globals[name];
+	}
+
+	objc_setAssociatedObject(context, &ScriptContextPoolScriptKey, script, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+
+	if (![script isKindOfClass:[NSString class]])
+		return context;
+
+	NSError *parseError = nil;
+	[context parse:script error:&parseError];
+	if (!parseError) {
+		[context parse:ScriptContextPoolBatchScript error:&parseError];
+	}
+	if (parseError) {
+		if (error) {
+			*error = parseError;
+		}
+		return nil;
+	}
+
+	return context;
+}
+
+- (void)fillPoolForKey:(id<NSCopying>)key {
+	NSUInteger generation;
+	NSString *script;
+	NSUInteger missingCount;
+	@synchronized(self) {
+		generation = _generation;
+		script = _scripts[key];
+		missingCount = _warmContextCount > [_idleContexts[key] count] ? _warmContextCount - [_idleContexts[key] count] : 0;
+	}
+
+	if (!script || missingCount == 0)
+		return;
+
+	dispatch_async(_prewarmQueue, ^{
+		for (NSUInteger i = 0; i < missingCount; ++i) {
+			LuaContext *context = [self newContextWithScript:script error:NULL];
+			if (!context)
+				return;
+
+			@synchronized(self) {
+				/* The contexts of a pool that was emptied or given another script meanwhile are dropped */
+				if (generation != _generation || ![_scripts[key] isEqual:script])
+					return;
+
+				NSMutableArray *contexts = _idleContexts[key];
+				if (!contexts) {
+					contexts = [NSMutableArray array];
+					_idleContexts[key] = contexts;
+				}
+				if (contexts.count >= _warmContextCount)
+					return;
+				[contexts addObject:context];
+			}
+		}
+	});
+}
+
+- (void)prewarmScript:(NSString *)script forKey:(id<NSCopying>)key {
+	@synchronized(self) {
+		_scripts[key] = script;
+	}
+	[self fillPoolForKey:key];
+}
+
+- (LuaContext *)dequeueContextForKey:(id<NSCopying>)key script:(NSString *)script error:(NSError * __autoreleasing *)error {
+	LuaContext *context = nil;
+	@synchronized(self) {
+		if (![_scripts[key] isEqual:script]) {
+			_scripts[key] = script;
+			[_idleContexts removeObjectForKey:key];
+			_generation++;
+		}
+		NSMutableArray *contexts = _idleContexts[key];
+		context = contexts.lastObject;
+		if (context) {
+			[contexts removeLastObject];
+		}
+	}
+
+	/* Prepare the context right away if the pool ran out of them */
+	if (!context) {
+		context = [self newContextWithScript:script error:error];
+	}
+
+	[self fillPoolForKey:key];
+
+	return context;
+}
+
+- (void)enqueueContext:(LuaContext *)context forKey:(id<NSCopying>)key {
+	if (!context)
+		return;
+
+	@synchronized(self) {
+		/* A context of a script that was replaced while it was in use isn't reused */
+		NSString *script = objc_getAssociatedObject(context, &ScriptContextPoolScriptKey);
+		if (_scripts[key] != script && ![_scripts[key] isEqual:script])
+			return;
+
+		NSMutableArray *contexts = _idleContexts[key];
+		if (!contexts) {
+			contexts = [NSMutableArray array];
+			_idleContexts[key] = contexts;
+		}
+		if (contexts.count < _warmContextCount) {
+			[contexts addObject:context];
+		}
+	}
+}
+
+- (void)removeAllContexts {
+	@synchronized(self) {
+		_generation++;
+		[_idleContexts removeAllObjects];
+		[_scripts removeAllObjects];
+	}
+}
+
+- (void)performWhenPrewarmed:(dispatch_block_t)block {
+	/* The block runs in the main thread after the contexts queued so far are prepared */
+	dispatch_async(_prewarmQueue, ^{
+		dispatch_async(dispatch_get_main_queue(), block);
+	});
+}
+
+@end
@@ -0,0 +1,48 @@
+/*
+ * ScriptExporter.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/* Keys of the export metadata of a class */
+extern NSString *const ScriptExporterInstanceMethodsKey;
+extern NSString *const ScriptExporterClassMethodsKey;
+extern NSString *const ScriptExporterPropertiesKey;
+
+/*
+ Exposes classes to Lua by adding them a protocol with their methods and properties. The classes are
+ exported the first time a script context needs them, and their metadata is kept between launches
+ */
+@interface ScriptExporter : NSObject
++ (instancetype)sharedExporter;
+- (instancetype)initWithCacheFile:(NSString *)cacheFile;
+- (NSDictionary *)metadataForClass:(Class)classType;
+- (void)exportClass:(Class)classType;
+- (void)exportClasses:(NSArray *)classes;
+- (BOOL)isClassExported:(Class)classType;
+- (BOOL)saveMetadata;
+@property (readonly) NSString *cacheFile;
+@property (readonly) NSUInteger exportedClassCount;
+@property (readonly) NSTimeInterval exportDuration;
+@end
@@ -0,0 +1,237 @@
+/*
+ * ScriptExporter.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "ScriptExporter.h"
+#import "LuaExport.h"
+#import <objc/runtime.h>
+
+NSString *const ScriptExporterInstanceMethodsKey = @"instanceMethods";
+NSString *const ScriptExporterClassMethodsKey = @"classMethods";
+NSString *const ScriptExporterPropertiesKey = @"properties";
+
+/* Key of the version of the framework the metadata was read from */
+static NSString *const ScriptExporterVersionKey = @"version";
+
+@implementation ScriptExporter {
+	NSMutableDictionary *_metadata;
+	NSMutableSet *_exportedClasses;
+	NSMutableDictionary *_imageVersions;
+	BOOL _metadataChanged;
+}
+
+@synthesize
+cacheFile = _cacheFile,
+exportDuration = _exportDuration;
+
++ (instancetype)sharedExporter {
+	static ScriptExporter *sharedExporter;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+		NSString *cacheFile = [[cachesPath stringByAppendingPathComponent:[[NSBundle mainBundle] bundleIdentifier]] stringByAppendingPathComponent:@"LuaExports.plist"];
+		sharedExporter = [[ScriptExporter alloc] initWithCacheFile:cacheFile];
+	});
+	return sharedExporter;
+}
+
+- (instancetype)initWithCacheFile:(NSString *)cacheFile {
+	if (self = [super init]) {
+		_cacheFile = cacheFile;
+		_exportedClasses = [NSMutableSet set];
+		_imageVersions = [NSMutableDictionary dictionary];
+		_metadata = [NSMutableDictionary dictionary];
+
+		NSDictionary *cachedMetadata = cacheFile ? [NSDictionary dictionaryWithContentsOfFile:cacheFile] : nil;
+		if (cachedMetadata) {
+			[_metadata addEntriesFromDictionary:cachedMetadata];
+		}
+	}
+	return self;
+}
+
+#pragma mark Metadata
+
+- (NSString *)versionOfClass:(Class)classType {
+	const char *imageName = class_getImageName(classType);
+	NSString *imagePath = imageName ? @(imageName) : @"";
+
+	@synchronized(self) {
+		NSString *version = _imageVersions[imagePath];
+		if (!version) {
+			/*
+			 The metadata is read again when the system or the binary the class lives in are updated. The
+			 application classes change with every build, even when the bundle version stays the same
+			 */
+			NSDictionary *info = [[NSBundle bundleForClass:classType] infoDictionary];
+			NSDate *imageDate = [[NSFileManager defaultManager] attributesOfItemAtPath:imagePath error:NULL].fileModificationDate;
+			version = [NSString stringWithFormat:@"%@ %@ %@ %.0f", info[@"CFBundleVersion"] ?: @"", [[NSProcessInfo processInfo] operatingSystemVersionString], imagePath, imageDate.timeIntervalSinceReferenceDate];
+			_imageVersions[imagePath] = version;
+		}
+		return version;
+	}
+}
+
+- (NSArray *)methodsOfClass:(Class)classType {
+	NSMutableArray *result = [NSMutableArray array];
+	unsigned int methodCount;
+	Method *methods = class_copyMethodList(classType, &methodCount);
+	for (unsigned int methodIndex = 0; methodIndex < methodCount; ++methodIndex) {
+		Method method = methods[methodIndex];
+		const char *types = method_getTypeEncoding(method);
+		if (types) {
+			[result addObject:@[NSStringFromSelector(method_getName(method)), @(types)]];
+		}
+	}
+	free(methods);
+	return result;
+}
+
+- (NSArray *)propertiesOfClass:(Class)classType {
+	NSMutableArray *result = [NSMutableArray array];
+	unsigned int propertyCount;
+	objc_property_t *properties = class_copyPropertyList(classType, &propertyCount);
+	for (unsigned int propertyIndex = 0; propertyIndex < propertyCount; ++propertyIndex) {
+		objc_property_t property = properties[propertyIndex];
+
+		unsigned int attributeCount;
+		objc_property_attribute_t *attributes = property_copyAttributeList(property, &attributeCount);
+		NSMutableArray *attributeList = [NSMutableArray arrayWithCapacity:attributeCount];
+		for (unsigned int attributeIndex = 0; attributeIndex < attributeCount; ++attributeIndex) {
+			[attributeList addObject:@[@(attributes[attributeIndex].name), @(attributes[attributeIndex].value)]];
+		}
+		free(attributes);
+
+		[result addObject:@[@(property_getName(property)), attributeList]];
+	}
+	free(properties);
+	return result;
+}
+
+- (NSDictionary *)metadataForClass:(Class)classType {
+	NSString *className = NSStringFromClass(classType);
+	NSString *version = [self versionOfClass:classType];
+
+	@synchronized(self) {
+		NSDictionary *metadata = _metadata[className];
+		if (![metadata[ScriptExporterVersionKey] isEqualToString:version]) {
+			metadata = @{ScriptExporterVersionKey: version,
+						 ScriptExporterInstanceMethodsKey: [self methodsOfClass:classType],
+						 ScriptExporterClassMethodsKey: [self methodsOfClass:object_getClass(classType)],
+						 ScriptExporterPropertiesKey: [self propertiesOfClass:classType]};
+			_metadata[className] = metadata;
+			_metadataChanged = YES;
+		}
+		return metadata;
+	}
+}
+
+- (BOOL)saveMetadata {
+	NSDictionary *metadata;
+	@synchronized(self) {
+		if (!_metadataChanged || !_cacheFile)
+			return NO;
+		metadata = [_metadata copy];
+		_metadataChanged = NO;
+	}
+
+	[[NSFileManager defaultManager] createDirectoryAtPath:[_cacheFile stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:NULL];
+	return [metadata writeToFile:_cacheFile atomically:YES];
+}
+
+#pragma mark Exporting
+
+- (void)exportClass:(Class)classType {
+	if (!classType)
+		return;
+
+	@synchronized(self) {
+		if ([_exportedClasses containsObject:classType])
+			return;
+
+		CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+		/* Create a protocol that inherits from LuaExport and with all the methods and properties of the class */
+		const char *protocolName = [NSString stringWithFormat:@"%sLuaExports", class_getName(classType)].UTF8String;
+		Protocol *protocol = objc_getProtocol(protocolName);
+		if (!protocol) {
+			protocol = objc_allocateProtocol(protocolName);
+
+			protocol_addProtocol(protocol, @protocol(LuaExport));
+
+			NSDictionary *metadata = [self metadataForClass:classType];
+
+			for (NSArray *method in metadata[ScriptExporterInstanceMethodsKey]) {
+				protocol_addMethodDescription(protocol, NSSelectorFromString(method[0]), [method[1] UTF8String], YES, YES);
+			}
+
+			for (NSArray *method in metadata[ScriptExporterClassMethodsKey]) {
+				protocol_addMethodDescription(protocol, NSSelectorFromString(method[0]), [method[1] UTF8String], YES, NO);
+			}
+
+			for (NSArray *property in metadata[ScriptExporterPropertiesKey]) {
+				NSArray *attributeList = property[1];
+				objc_property_attribute_t *attributes = calloc(MAX(1, attributeList.count), sizeof(objc_property_attribute_t));
+				for (NSUInteger attributeIndex = 0; attributeIndex < attributeList.count; ++attributeIndex) {
+					attributes[attributeIndex].name = [attributeList[attributeIndex][0] UTF8String];
+					attributes[attributeIndex].value = [attributeList[attributeIndex][1] UTF8String];
+				}
+				protocol_addProperty(protocol, [property[0] UTF8String], attributes, (unsigned int)attributeList.count, YES, YES);
+				free(attributes);
+			}
+
+			objc_registerProtocol(protocol);
+		}
+		class_addProtocol(classType, protocol);
+
+		[_exportedClasses addObject:classType];
+		_exportDuration += CFAbsoluteTimeGetCurrent() - startTime;
+	}
+}
+
+- (void)exportClasses:(NSArray *)classes {
+	for (Class classType in classes) {
+		/* Methods inherited from the superclasses are looked up in their own protocols */
+		for (Class superclass = class_getSuperclass(classType); superclass; superclass = class_getSuperclass(superclass)) {
+			if ([classes containsObject:superclass]) {
+				[self exportClass:superclass];
+			}
+		}
+		[self exportClass:classType];
+	}
+}
+
+- (BOOL)isClassExported:(Class)classType {
+	@synchronized(self) {
+		return [_exportedClasses containsObject:classType];
+	}
+}
+
+- (NSUInteger)exportedClassCount {
+	@synchronized(self) {
+		return _exportedClasses.count;
+	}
+}
+
+@end
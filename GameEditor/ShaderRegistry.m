@@ -0,0 +1,204 @@
+/*
+ * ShaderRegistry.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "ShaderRegistry.h"
+#import <CommonCrypto/CommonDigest.h>
+
+@implementation ShaderRegistry {
+	NSMutableDictionary *_sourcesByName;
+	NSMutableDictionary *_namesByDigest;
+	NSMutableDictionary *_pathsByName;
+	NSMutableDictionary *_shadersByDigest;
+	NSMapTable *_namesByShader;
+	NSHashTable *_sharedShaders;
+}
+
++ (instancetype)sharedRegistry {
+	static ShaderRegistry *sharedRegistry;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sharedRegistry = [ShaderRegistry new];
+	});
+	return sharedRegistry;
+}
+
++ (NSString *)digestOfSource:(NSString *)source {
+	NSData *data = [source dataUsingEncoding:NSUTF8StringEncoding];
+
+	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+	CC_SHA1(data.bytes, (CC_LONG)data.length, digest);
+
+	NSMutableString *result = [NSMutableString stringWithCapacity:2 * CC_SHA1_DIGEST_LENGTH];
+	for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; ++i) {
+		[result appendFormat:@"%02x", digest[i]];
+	}
+	return result;
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_sourcesByName = [NSMutableDictionary dictionary];
+		_namesByDigest = [NSMutableDictionary dictionary];
+		_pathsByName = [NSMutableDictionary dictionary];
+		_shadersByDigest = [NSMutableDictionary dictionary];
+		_namesByShader = [NSMapTable weakToStrongObjectsMapTable];
+		_sharedShaders = [NSHashTable weakObjectsHashTable];
+	}
+	return self;
+}
+
+#pragma mark Loading
+
+- (void)addShaderWithContentsOfFile:(NSString *)path {
+	NSString *source = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
+	if (!source)
+		return;
+
+	NSString *name = path.lastPathComponent;
+	[self removeShaderNamed:name];
+
+	NSString *digest = [ShaderRegistry digestOfSource:source];
+	_sourcesByName[name] = source;
+	_pathsByName[name] = path;
+
+	/* Shaders with the same source are shown with the name that was loaded first */
+	if (!_namesByDigest[digest]) {
+		_namesByDigest[digest] = name;
+	}
+}
+
+- (void)removeShaderNamed:(NSString *)name {
+	NSString *source = _sourcesByName[name];
+	if (!source)
+		return;
+
+	NSString *digest = [ShaderRegistry digestOfSource:source];
+	if ([_namesByDigest[digest] isEqualToString:name]) {
+		[_namesByDigest removeObjectForKey:digest];
+
+		/* Another file with the same source keeps the digest */
+		for (NSString *otherName in _sourcesByName) {
+			if (![otherName isEqualToString:name] && [_sourcesByName[otherName] isEqualToString:source]) {
+				_namesByDigest[digest] = otherName;
+				break;
+			}
+		}
+	}
+
+	[_sourcesByName removeObjectForKey:name];
+	[_pathsByName removeObjectForKey:name];
+
+	/* The shaders seen so far may have been named after the old source */
+	[_namesByShader removeAllObjects];
+}
+
+- (void)loadShadersWithPaths:(NSArray *)paths {
+	@synchronized(self) {
+		for (NSString *path in paths) {
+			if (![_pathsByName[path.lastPathComponent] isEqualToString:path]) {
+				[self addShaderWithContentsOfFile:path];
+			}
+		}
+	}
+}
+
+- (void)updateWithAddedFiles:(NSArray *)addedFiles removedFiles:(NSArray *)removedFiles modifiedFiles:(NSArray *)modifiedFiles {
+	@synchronized(self) {
+		for (NSString *path in removedFiles) {
+			if ([path.pathExtension isEqualToString:@"fsh"] && [_pathsByName[path.lastPathComponent] isEqualToString:path]) {
+				[self removeShaderNamed:path.lastPathComponent];
+			}
+		}
+		for (NSString *path in [addedFiles arrayByAddingObjectsFromArray:modifiedFiles]) {
+			if ([path.pathExtension isEqualToString:@"fsh"]) {
+				[self addShaderWithContentsOfFile:path];
+			}
+		}
+	}
+}
+
+- (void)removeAllShaders {
+	@synchronized(self) {
+		[_sourcesByName removeAllObjects];
+		[_namesByDigest removeAllObjects];
+		[_pathsByName removeAllObjects];
+		[_shadersByDigest removeAllObjects];
+		[_namesByShader removeAllObjects];
+	}
+}
+
+#pragma mark Lookup
+
+- (SKShader *)shaderNamed:(NSString *)name {
+	@synchronized(self) {
+		NSString *source = _sourcesByName[name];
+		if (!source)
+			return nil;
+
+		/* The nodes using the same source share the shader, and Sprite Kit compiles it once */
+		NSString *digest = [ShaderRegistry digestOfSource:source];
+		SKShader *shader = _shadersByDigest[digest];
+		if (!shader) {
+			shader = [SKShader shaderWithSource:source];
+			_shadersByDigest[digest] = shader;
+			[_sharedShaders addObject:shader];
+		}
+		[_namesByShader setObject:name forKey:shader];
+		return shader;
+	}
+}
+
+- (NSString *)nameOfShader:(SKShader *)shader {
+	if (!shader)
+		return nil;
+
+	@synchronized(self) {
+		/* Shaders already seen don't need their source hashed again */
+		NSString *name = [_namesByShader objectForKey:shader];
+		if (name)
+			return name;
+
+		name = _namesByDigest[[ShaderRegistry digestOfSource:shader.source]];
+		if (name) {
+			[_namesByShader setObject:name forKey:shader];
+		}
+		return name;
+	}
+}
+
+- (BOOL)isSharedShader:(SKShader *)shader {
+	/* The shaders handed out stay shared while any node uses them, even after their source is gone from the registry */
+	@synchronized(self) {
+		return shader && [_sharedShaders containsObject:shader];
+	}
+}
+
+- (NSArray *)shaderNames {
+	@synchronized(self) {
+		return [_sourcesByName.allKeys sortedArrayUsingSelector:@selector(localizedStandardCompare:)];
+	}
+}
+
+@end
@@ -0,0 +1,551 @@
+/*
+ * SpatialIndex.c
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SpatialIndex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SpatialIndexNullNode (-1)
+
+/* Leaves are fattened so that small edits don't restructure the tree */
+static const CGFloat kSpatialIndexMargin = 4.0;
+static const CGFloat kSpatialIndexMarginFactor = 0.1;
+
+typedef struct {
+	CGFloat minX, minY, maxX, maxY;
+} SpatialIndexAABB;
+
+typedef struct {
+	SpatialIndexAABB aabb;
+	SpatialIndexBox box;
+	int parent; // next free node when the node is in the free list
+	int child1;
+	int child2;
+	int height; // -1 for free nodes, 0 for leaves
+	bool isPoint;
+} SpatialIndexNode;
+
+struct SpatialIndex {
+	SpatialIndexNode *nodes;
+	int capacity;
+	int freeList;
+	int root;
+	size_t count;
+	int *stack;
+	int stackCapacity;
+};
+
+#pragma mark AABB
+
+static inline SpatialIndexAABB SpatialIndexAABBUnion(SpatialIndexAABB a, SpatialIndexAABB b) {
+	SpatialIndexAABB result = {fmin(a.minX, b.minX), fmin(a.minY, b.minY), fmax(a.maxX, b.maxX), fmax(a.maxY, b.maxY)};
+	return result;
+}
+
+static inline CGFloat SpatialIndexAABBPerimeter(SpatialIndexAABB a) {
+	return 2.0 * ((a.maxX - a.minX) + (a.maxY - a.minY));
+}
+
+static inline bool SpatialIndexAABBContains(SpatialIndexAABB a, SpatialIndexAABB b) {
+	return a.minX <= b.minX && a.minY <= b.minY && b.maxX <= a.maxX && b.maxY <= a.maxY;
+}
+
+static inline bool SpatialIndexAABBOverlaps(SpatialIndexAABB a, SpatialIndexAABB b) {
+	return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+static inline SpatialIndexAABB SpatialIndexAABBWithBox(SpatialIndexBox box) {
+	SpatialIndexAABB result = {box.corners[0].x, box.corners[0].y, box.corners[0].x, box.corners[0].y};
+	for (int i = 1; i < 4; ++i) {
+		result.minX = fmin(result.minX, box.corners[i].x);
+		result.minY = fmin(result.minY, box.corners[i].y);
+		result.maxX = fmax(result.maxX, box.corners[i].x);
+		result.maxY = fmax(result.maxY, box.corners[i].y);
+	}
+	return result;
+}
+
+static inline SpatialIndexAABB SpatialIndexAABBInset(SpatialIndexAABB a, CGFloat inset) {
+	SpatialIndexAABB result = {a.minX + inset, a.minY + inset, a.maxX - inset, a.maxY - inset};
+	return result;
+}
+
+static inline SpatialIndexAABB SpatialIndexAABBFattened(SpatialIndexAABB a) {
+	CGFloat margin = kSpatialIndexMargin + kSpatialIndexMarginFactor * fmax(a.maxX - a.minX, a.maxY - a.minY);
+	return SpatialIndexAABBInset(a, -margin);
+}
+
+#pragma mark Geometry
+
+SpatialIndexBox SpatialIndexBoxMake(CGAffineTransform t, CGSize size, CGPoint anchorPoint) {
+	const CGFloat left = -size.width * anchorPoint.x;
+	const CGFloat right = size.width * (1.0 - anchorPoint.x);
+	const CGFloat bottom = -size.height * anchorPoint.y;
+	const CGFloat top = size.height * (1.0 - anchorPoint.y);
+
+	const CGFloat xs[4] = {left, right, right, left};
+	const CGFloat ys[4] = {bottom, bottom, top, top};
+
+	SpatialIndexBox box;
+	for (int i = 0; i < 4; ++i) {
+		box.corners[i].x = t.a * xs[i] + t.c * ys[i] + t.tx;
+		box.corners[i].y = t.b * xs[i] + t.d * ys[i] + t.ty;
+	}
+	return box;
+}
+
+SpatialIndexBox SpatialIndexBoxMakePoint(CGPoint point) {
+	SpatialIndexBox box = {{point, point, point, point}};
+	return box;
+}
+
+CGRect SpatialIndexBoxGetBounds(SpatialIndexBox box) {
+	SpatialIndexAABB aabb = SpatialIndexAABBWithBox(box);
+	return CGRectMake(aabb.minX, aabb.minY, aabb.maxX - aabb.minX, aabb.maxY - aabb.minY);
+}
+
+bool SpatialIndexBoxContainsPoint(SpatialIndexBox box, CGPoint point) {
+	/* The point is inside when it's on the same side of every edge, the winding of the box is irrelevant */
+	bool hasPositive = false;
+	bool hasNegative = false;
+	for (int i = 0; i < 4; ++i) {
+		CGPoint a = box.corners[i];
+		CGPoint b = box.corners[(i + 1) & 3];
+		CGFloat cross = (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+		if (cross > 0) {
+			hasPositive = true;
+		} else if (cross < 0) {
+			hasNegative = true;
+		}
+	}
+	/* A box with no area doesn't contain any point */
+	return hasPositive != hasNegative;
+}
+
+static inline void SpatialIndexProject(const CGPoint *points, int count, CGFloat axisX, CGFloat axisY, CGFloat *min, CGFloat *max) {
+	*min = *max = points[0].x * axisX + points[0].y * axisY;
+	for (int i = 1; i < count; ++i) {
+		CGFloat projection = points[i].x * axisX + points[i].y * axisY;
+		*min = fmin(*min, projection);
+		*max = fmax(*max, projection);
+	}
+}
+
+bool SpatialIndexBoxIntersectsRect(SpatialIndexBox box, CGRect rect) {
+	rect = CGRectStandardize(rect);
+	SpatialIndexAABB aabb = {rect.origin.x, rect.origin.y, rect.origin.x + rect.size.width, rect.origin.y + rect.size.height};
+
+	/* Separating axes of the rect */
+	if (!SpatialIndexAABBOverlaps(SpatialIndexAABBWithBox(box), aabb)) {
+		return false;
+	}
+
+	/* Separating axes of the box, its opposite edges are parallel so two of them are enough */
+	const CGPoint rectCorners[4] = {{aabb.minX, aabb.minY}, {aabb.maxX, aabb.minY}, {aabb.maxX, aabb.maxY}, {aabb.minX, aabb.maxY}};
+	for (int i = 0; i < 2; ++i) {
+		CGFloat axisX = box.corners[i].y - box.corners[i + 1].y;
+		CGFloat axisY = box.corners[i + 1].x - box.corners[i].x;
+		if (axisX == 0 && axisY == 0) {
+			continue;
+		}
+
+		CGFloat boxMin, boxMax, rectMin, rectMax;
+		SpatialIndexProject(box.corners, 4, axisX, axisY, &boxMin, &boxMax);
+		SpatialIndexProject(rectCorners, 4, axisX, axisY, &rectMin, &rectMax);
+		if (boxMax < rectMin || rectMax < boxMin) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#pragma mark Nodes
+
+static int SpatialIndexAllocateNode(SpatialIndexRef index) {
+	if (index->freeList == SpatialIndexNullNode) {
+		int capacity = index->capacity ? 2 * index->capacity : 64;
+		index->nodes = realloc(index->nodes, capacity * sizeof(SpatialIndexNode));
+		for (int i = index->capacity; i < capacity; ++i) {
+			index->nodes[i].parent = i + 1 < capacity ? i + 1 : SpatialIndexNullNode;
+			index->nodes[i].height = -1;
+		}
+		index->freeList = index->capacity;
+		index->capacity = capacity;
+	}
+
+	int nodeId = index->freeList;
+	SpatialIndexNode *node = &index->nodes[nodeId];
+	index->freeList = node->parent;
+	node->parent = SpatialIndexNullNode;
+	node->child1 = SpatialIndexNullNode;
+	node->child2 = SpatialIndexNullNode;
+	node->height = 0;
+	node->isPoint = false;
+	return nodeId;
+}
+
+static void SpatialIndexFreeNode(SpatialIndexRef index, int nodeId) {
+	index->nodes[nodeId].parent = index->freeList;
+	index->nodes[nodeId].height = -1;
+	index->freeList = nodeId;
+}
+
+static inline bool SpatialIndexIsLeaf(const SpatialIndexNode *node) {
+	return node->child1 == SpatialIndexNullNode;
+}
+
+static void SpatialIndexReplaceChild(SpatialIndexRef index, int parent, int oldChild, int newChild) {
+	if (parent == SpatialIndexNullNode) {
+		index->root = newChild;
+	} else if (index->nodes[parent].child1 == oldChild) {
+		index->nodes[parent].child1 = newChild;
+	} else {
+		index->nodes[parent].child2 = newChild;
+	}
+}
+
+/* Perform a left or right rotation if the node A is imbalanced, return the new root of the subtree */
+static int SpatialIndexBalance(SpatialIndexRef index, int iA) {
+	SpatialIndexNode *nodes = index->nodes;
+	SpatialIndexNode *A = &nodes[iA];
+	if (SpatialIndexIsLeaf(A) || A->height < 2) {
+		return iA;
+	}
+
+	int iB = A->child1;
+	int iC = A->child2;
+	SpatialIndexNode *B = &nodes[iB];
+	SpatialIndexNode *C = &nodes[iC];
+
+	int balance = C->height - B->height;
+
+	/* Rotate C up */
+	if (balance > 1) {
+		int iF = C->child1;
+		int iG = C->child2;
+		SpatialIndexNode *F = &nodes[iF];
+		SpatialIndexNode *G = &nodes[iG];
+
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+		SpatialIndexReplaceChild(index, C->parent, iA, iC);
+
+		if (F->height > G->height) {
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->aabb = SpatialIndexAABBUnion(B->aabb, G->aabb);
+			C->aabb = SpatialIndexAABBUnion(A->aabb, F->aabb);
+			A->height = 1 + (B->height > G->height ? B->height : G->height);
+			C->height = 1 + (A->height > F->height ? A->height : F->height);
+		} else {
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->aabb = SpatialIndexAABBUnion(B->aabb, F->aabb);
+			C->aabb = SpatialIndexAABBUnion(A->aabb, G->aabb);
+			A->height = 1 + (B->height > F->height ? B->height : F->height);
+			C->height = 1 + (A->height > G->height ? A->height : G->height);
+		}
+		return iC;
+	}
+
+	/* Rotate B up */
+	if (balance < -1) {
+		int iD = B->child1;
+		int iE = B->child2;
+		SpatialIndexNode *D = &nodes[iD];
+		SpatialIndexNode *E = &nodes[iE];
+
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+		SpatialIndexReplaceChild(index, B->parent, iA, iB);
+
+		if (D->height > E->height) {
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->aabb = SpatialIndexAABBUnion(C->aabb, E->aabb);
+			B->aabb = SpatialIndexAABBUnion(A->aabb, D->aabb);
+			A->height = 1 + (C->height > E->height ? C->height : E->height);
+			B->height = 1 + (A->height > D->height ? A->height : D->height);
+		} else {
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->aabb = SpatialIndexAABBUnion(C->aabb, D->aabb);
+			B->aabb = SpatialIndexAABBUnion(A->aabb, E->aabb);
+			A->height = 1 + (C->height > D->height ? C->height : D->height);
+			B->height = 1 + (A->height > E->height ? A->height : E->height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+static void SpatialIndexRefit(SpatialIndexRef index, int nodeId) {
+	while (nodeId != SpatialIndexNullNode) {
+		nodeId = SpatialIndexBalance(index, nodeId);
+
+		SpatialIndexNode *node = &index->nodes[nodeId];
+		const SpatialIndexNode *child1 = &index->nodes[node->child1];
+		const SpatialIndexNode *child2 = &index->nodes[node->child2];
+		node->height = 1 + (child1->height > child2->height ? child1->height : child2->height);
+		node->aabb = SpatialIndexAABBUnion(child1->aabb, child2->aabb);
+
+		nodeId = node->parent;
+	}
+}
+
+static void SpatialIndexInsertLeaf(SpatialIndexRef index, int leaf) {
+	if (index->root == SpatialIndexNullNode) {
+		index->root = leaf;
+		index->nodes[leaf].parent = SpatialIndexNullNode;
+		return;
+	}
+
+	/* Find the best sibling for the leaf using the surface area heuristic */
+	SpatialIndexAABB leafAABB = index->nodes[leaf].aabb;
+	int nodeId = index->root;
+	while (!SpatialIndexIsLeaf(&index->nodes[nodeId])) {
+		const SpatialIndexNode *node = &index->nodes[nodeId];
+		const SpatialIndexNode *child1 = &index->nodes[node->child1];
+		const SpatialIndexNode *child2 = &index->nodes[node->child2];
+
+		CGFloat area = SpatialIndexAABBPerimeter(node->aabb);
+		CGFloat combinedArea = SpatialIndexAABBPerimeter(SpatialIndexAABBUnion(node->aabb, leafAABB));
+
+		/* Cost of creating a new parent for this node and the new leaf */
+		CGFloat cost = 2.0 * combinedArea;
+
+		/* Minimum cost of pushing the leaf further down the tree */
+		CGFloat inheritanceCost = 2.0 * (combinedArea - area);
+
+		CGFloat cost1 = SpatialIndexAABBPerimeter(SpatialIndexAABBUnion(leafAABB, child1->aabb)) + inheritanceCost;
+		if (!SpatialIndexIsLeaf(child1)) {
+			cost1 -= SpatialIndexAABBPerimeter(child1->aabb);
+		}
+
+		CGFloat cost2 = SpatialIndexAABBPerimeter(SpatialIndexAABBUnion(leafAABB, child2->aabb)) + inheritanceCost;
+		if (!SpatialIndexIsLeaf(child2)) {
+			cost2 -= SpatialIndexAABBPerimeter(child2->aabb);
+		}
+
+		if (cost < cost1 && cost < cost2) {
+			break;
+		}
+
+		nodeId = cost1 < cost2 ? node->child1 : node->child2;
+	}
+
+	/* Create a new parent for the sibling and the leaf */
+	int sibling = nodeId;
+	int newParent = SpatialIndexAllocateNode(index);
+	int oldParent = index->nodes[sibling].parent;
+
+	SpatialIndexNode *parentNode = &index->nodes[newParent];
+	parentNode->parent = oldParent;
+	parentNode->aabb = SpatialIndexAABBUnion(leafAABB, index->nodes[sibling].aabb);
+	parentNode->height = index->nodes[sibling].height + 1;
+	parentNode->child1 = sibling;
+	parentNode->child2 = leaf;
+
+	SpatialIndexReplaceChild(index, oldParent, sibling, newParent);
+	index->nodes[sibling].parent = newParent;
+	index->nodes[leaf].parent = newParent;
+
+	/* Walk back up the tree fixing heights and bounding boxes */
+	SpatialIndexRefit(index, index->nodes[leaf].parent);
+}
+
+static void SpatialIndexRemoveLeaf(SpatialIndexRef index, int leaf) {
+	if (leaf == index->root) {
+		index->root = SpatialIndexNullNode;
+		return;
+	}
+
+	int parent = index->nodes[leaf].parent;
+	int grandParent = index->nodes[parent].parent;
+	int sibling = index->nodes[parent].child1 == leaf ? index->nodes[parent].child2 : index->nodes[parent].child1;
+
+	/* Replace the parent with the sibling */
+	SpatialIndexReplaceChild(index, grandParent, parent, sibling);
+	index->nodes[sibling].parent = grandParent;
+	SpatialIndexFreeNode(index, parent);
+
+	SpatialIndexRefit(index, grandParent);
+}
+
+#pragma mark Index
+
+SpatialIndexRef SpatialIndexCreate(void) {
+	SpatialIndexRef index = calloc(1, sizeof(struct SpatialIndex));
+	index->freeList = SpatialIndexNullNode;
+	index->root = SpatialIndexNullNode;
+	return index;
+}
+
+void SpatialIndexRelease(SpatialIndexRef index) {
+	if (index) {
+		free(index->nodes);
+		free(index->stack);
+		free(index);
+	}
+}
+
+void SpatialIndexRemoveAll(SpatialIndexRef index) {
+	index->root = SpatialIndexNullNode;
+	index->count = 0;
+	index->freeList = index->capacity ? 0 : SpatialIndexNullNode;
+	for (int i = 0; i < index->capacity; ++i) {
+		index->nodes[i].parent = i + 1 < index->capacity ? i + 1 : SpatialIndexNullNode;
+		index->nodes[i].height = -1;
+	}
+}
+
+size_t SpatialIndexGetCount(SpatialIndexRef index) {
+	return index->count;
+}
+
+SpatialIndexProxy SpatialIndexInsert(SpatialIndexRef index, SpatialIndexBox box, bool isPoint) {
+	int leaf = SpatialIndexAllocateNode(index);
+	SpatialIndexNode *node = &index->nodes[leaf];
+	node->box = box;
+	node->isPoint = isPoint;
+	node->aabb = SpatialIndexAABBFattened(SpatialIndexAABBWithBox(box));
+	SpatialIndexInsertLeaf(index, leaf);
+	index->count++;
+	return leaf;
+}
+
+void SpatialIndexUpdate(SpatialIndexRef index, SpatialIndexProxy proxy, SpatialIndexBox box, bool isPoint) {
+	SpatialIndexNode *node = &index->nodes[proxy];
+	SpatialIndexAABB aabb = SpatialIndexAABBWithBox(box);
+
+	node->box = box;
+	node->isPoint = isPoint;
+
+	/* Nothing to restructure while the leaf stays inside its fattened bounds */
+	if (SpatialIndexAABBContains(node->aabb, aabb)) {
+		return;
+	}
+
+	SpatialIndexRemoveLeaf(index, proxy);
+	index->nodes[proxy].aabb = SpatialIndexAABBFattened(aabb);
+	SpatialIndexInsertLeaf(index, proxy);
+}
+
+void SpatialIndexRemove(SpatialIndexRef index, SpatialIndexProxy proxy) {
+	SpatialIndexRemoveLeaf(index, proxy);
+	SpatialIndexFreeNode(index, proxy);
+	index->count--;
+}
+
+SpatialIndexBox SpatialIndexGetBox(SpatialIndexRef index, SpatialIndexProxy proxy) {
+	return index->nodes[proxy].box;
+}
+
+bool SpatialIndexIsPoint(SpatialIndexRef index, SpatialIndexProxy proxy) {
+	return index->nodes[proxy].isPoint;
+}
+
+#pragma mark Queries
+
+typedef bool (*SpatialIndexLeafTest)(const SpatialIndexNode *leaf, SpatialIndexAABB query, CGFloat pointRadius, const void *data);
+
+static size_t SpatialIndexQuery(SpatialIndexRef index, SpatialIndexAABB query, CGFloat pointRadius, SpatialIndexLeafTest test, const void *data, SpatialIndexQueryCallback callback, void *context) {
+	if (index->root == SpatialIndexNullNode) {
+		return 0;
+	}
+
+	size_t hits = 0;
+	int count = 0;
+
+	if (!index->stack) {
+		index->stackCapacity = 64;
+		index->stack = malloc(index->stackCapacity * sizeof(int));
+	}
+	index->stack[count++] = index->root;
+
+	while (count > 0) {
+		int nodeId = index->stack[--count];
+		const SpatialIndexNode *node = &index->nodes[nodeId];
+
+		if (!SpatialIndexAABBOverlaps(node->aabb, query)) {
+			continue;
+		}
+
+		if (SpatialIndexIsLeaf(node)) {
+			if (test(node, query, pointRadius, data)) {
+				hits++;
+				if (callback && !callback(nodeId, context)) {
+					break;
+				}
+			}
+		} else {
+			if (count + 2 > index->stackCapacity) {
+				index->stackCapacity *= 2;
+				index->stack = realloc(index->stack, index->stackCapacity * sizeof(int));
+			}
+			index->stack[count++] = node->child1;
+			index->stack[count++] = node->child2;
+		}
+	}
+
+	return hits;
+}
+
+static bool SpatialIndexLeafContainsPoint(const SpatialIndexNode *leaf, SpatialIndexAABB query, CGFloat pointRadius, const void *data) {
+	const CGPoint *point = data;
+	if (leaf->isPoint) {
+		CGPoint center = leaf->box.corners[0];
+		return fabs(point->x - center.x) <= pointRadius && fabs(point->y - center.y) <= pointRadius;
+	}
+	return SpatialIndexBoxContainsPoint(leaf->box, *point);
+}
+
+static bool SpatialIndexLeafIntersectsRect(const SpatialIndexNode *leaf, SpatialIndexAABB query, CGFloat pointRadius, const void *data) {
+	/* The query is the rect grown by the point radius */
+	if (leaf->isPoint) {
+		return SpatialIndexAABBOverlaps(SpatialIndexAABBWithBox(leaf->box), query);
+	}
+	return SpatialIndexBoxIntersectsRect(leaf->box, *(const CGRect *)data);
+}
+
+size_t SpatialIndexQueryPoint(SpatialIndexRef index, CGPoint point, CGFloat pointRadius, SpatialIndexQueryCallback callback, void *context) {
+	SpatialIndexAABB query = {point.x - pointRadius, point.y - pointRadius, point.x + pointRadius, point.y + pointRadius};
+	return SpatialIndexQuery(index, query, pointRadius, SpatialIndexLeafContainsPoint, &point, callback, context);
+}
+
+size_t SpatialIndexQueryRect(SpatialIndexRef index, CGRect rect, CGFloat pointRadius, SpatialIndexQueryCallback callback, void *context) {
+	rect = CGRectStandardize(rect);
+	SpatialIndexAABB aabb = {rect.origin.x, rect.origin.y, rect.origin.x + rect.size.width, rect.origin.y + rect.size.height};
+	return SpatialIndexQuery(index, SpatialIndexAABBInset(aabb, -pointRadius), pointRadius, SpatialIndexLeafIntersectsRect, &rect, callback, context);
+}
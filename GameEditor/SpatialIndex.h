@@ -0,0 +1,85 @@
+/*
+ * SpatialIndex.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef GameEditor_SpatialIndex_h
+#define GameEditor_SpatialIndex_h
+
+#include <CoreGraphics/CGGeometry.h>
+#include <CoreGraphics/CGAffineTransform.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ Dynamic bounding volume hierarchy over the oriented frames of the scene nodes.
+
+ Each entry (proxy) stores the four corners of a node's frame in scene coordinates,
+ the leaves are kept in a balanced AABB tree so that point and rect queries visit
+ O(log n) tree nodes, and the final hit test is done with plain arithmetic.
+
+ Entries without a size (plain SKNode, emitters, lights, ...) are stored as points,
+ they are hit when a query falls within `pointRadius` of them, which mimics the
+ fixed size square the editor draws around those nodes.
+ */
+
+typedef struct SpatialIndex *SpatialIndexRef;
+
+typedef int SpatialIndexProxy;
+
+enum {
+	SpatialIndexNullProxy = -1
+};
+
+typedef struct {
+	CGPoint corners[4]; // bottom-left, bottom-right, top-right, top-left
+} SpatialIndexBox;
+
+/* Return false from the callback to stop the query */
+typedef bool (*SpatialIndexQueryCallback)(SpatialIndexProxy proxy, void *context);
+
+SpatialIndexRef SpatialIndexCreate(void);
+void SpatialIndexRelease(SpatialIndexRef index);
+void SpatialIndexRemoveAll(SpatialIndexRef index);
+size_t SpatialIndexGetCount(SpatialIndexRef index);
+
+SpatialIndexProxy SpatialIndexInsert(SpatialIndexRef index, SpatialIndexBox box, bool isPoint);
+void SpatialIndexUpdate(SpatialIndexRef index, SpatialIndexProxy proxy, SpatialIndexBox box, bool isPoint);
+void SpatialIndexRemove(SpatialIndexRef index, SpatialIndexProxy proxy);
+SpatialIndexBox SpatialIndexGetBox(SpatialIndexRef index, SpatialIndexProxy proxy);
+bool SpatialIndexIsPoint(SpatialIndexRef index, SpatialIndexProxy proxy);
+
+/* Report the entries whose frame contains the point */
+size_t SpatialIndexQueryPoint(SpatialIndexRef index, CGPoint point, CGFloat pointRadius, SpatialIndexQueryCallback callback, void *context);
+
+/* Report the entries whose frame intersects the rect */
+size_t SpatialIndexQueryRect(SpatialIndexRef index, CGRect rect, CGFloat pointRadius, SpatialIndexQueryCallback callback, void *context);
+
+/* Geometry helpers */
+SpatialIndexBox SpatialIndexBoxMake(CGAffineTransform transform, CGSize size, CGPoint anchorPoint);
+SpatialIndexBox SpatialIndexBoxMakePoint(CGPoint point);
+CGRect SpatialIndexBoxGetBounds(SpatialIndexBox box);
+bool SpatialIndexBoxContainsPoint(SpatialIndexBox box, CGPoint point);
+bool SpatialIndexBoxIntersectsRect(SpatialIndexBox box, CGRect rect);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ * TextureRegistry.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "TextureRegistry.h"
+
+/* Textures are counted as 32 bit per pixel when estimating their memory */
+static const NSUInteger TextureRegistryBytesPerPixel = 4;
+
+@implementation TextureRegistry {
+	NSMapTable *_texturesByName;
+	NSMapTable *_namesByTexture;
+	NSMutableDictionary *_preloadedTextures;
+	NSUInteger _generation;
+}
+
++ (instancetype)sharedRegistry {
+	static TextureRegistry *sharedRegistry;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sharedRegistry = [TextureRegistry new];
+	});
+	return sharedRegistry;
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		/* The registry doesn't keep the textures alive, only the nodes using them and the preloaded ones do */
+		_texturesByName = [NSMapTable strongToWeakObjectsMapTable];
+		_namesByTexture = [NSMapTable weakToStrongObjectsMapTable];
+		_preloadedTextures = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
+#pragma mark Naming
+
+- (void)registerTexture:(SKTexture *)texture withName:(NSString *)name {
+	if (!texture || !name)
+		return;
+
+	@synchronized(self) {
+		[_namesByTexture setObject:name forKey:texture];
+		if (![_texturesByName objectForKey:name]) {
+			[_texturesByName setObject:texture forKey:name];
+		}
+	}
+}
+
+- (SKTexture *)textureNamed:(NSString *)name {
+	if (!name)
+		return nil;
+
+	@synchronized(self) {
+		SKTexture *texture = [_texturesByName objectForKey:name];
+		if (!texture) {
+			texture = [SKTexture textureWithImageNamed:name];
+			[self registerTexture:texture withName:name];
+		}
+		return texture;
+	}
+}
+
+- (NSString *)nameOfTexture:(SKTexture *)texture {
+	if (!texture)
+		return nil;
+
+	@synchronized(self) {
+		NSString *name = [_namesByTexture objectForKey:texture];
+		if (!name) {
+			/* Textures decoded from a scene only carry their name in the description, it's parsed once */
+			NSString *description = [texture description];
+			NSRange range = [description rangeOfString:@"(?<=\').*(?=\')" options:NSRegularExpressionSearch];
+			if (range.location != NSNotFound) {
+				name = [[description substringWithRange:range] stringByDeletingPathExtension];
+				[_namesByTexture setObject:name forKey:texture];
+			}
+		}
+		return name;
+	}
+}
+
+#pragma mark Sharing
+
+- (SKTexture *)sharedTextureForTexture:(SKTexture *)texture {
+	/* Only whole images are shared, and only when they are filtered the same way */
+	if (!texture || !CGRectEqualToRect(texture.textureRect, CGRectMake(0, 0, 1, 1)))
+		return texture;
+
+	NSString *name = [self nameOfTexture:texture];
+	if (!name)
+		return texture;
+
+	@synchronized(self) {
+		/* The preloaded textures come from the packed atlas when there is one, they are the ones worth sharing */
+		SKTexture *sharedTexture = _preloadedTextures[name] ?: [_texturesByName objectForKey:name];
+		if (!sharedTexture) {
+			[_texturesByName setObject:texture forKey:name];
+			return texture;
+		}
+		return sharedTexture.filteringMode == texture.filteringMode ? sharedTexture : texture;
+	}
+}
+
+- (void)shareTexturesInNode:(SKNode *)node {
+	NSMutableArray *nodes = [NSMutableArray arrayWithObject:node];
+	while (nodes.count) {
+		node = nodes.lastObject;
+		[nodes removeLastObject];
+		[nodes addObjectsFromArray:node.children];
+
+		if ([node isKindOfClass:[SKSpriteNode class]]) {
+			SKSpriteNode *sprite = (SKSpriteNode *)node;
+			sprite.texture = [self sharedTextureForTexture:sprite.texture];
+			sprite.normalTexture = [self sharedTextureForTexture:sprite.normalTexture];
+		} else if ([node isKindOfClass:[SKEmitterNode class]]) {
+			SKEmitterNode *emitter = (SKEmitterNode *)node;
+			emitter.particleTexture = [self sharedTextureForTexture:emitter.particleTexture];
+		} else if ([node isKindOfClass:[SKShapeNode class]]) {
+			SKShapeNode *shape = (SKShapeNode *)node;
+			shape.fillTexture = [self sharedTextureForTexture:shape.fillTexture];
+			shape.strokeTexture = [self sharedTextureForTexture:shape.strokeTexture];
+		}
+	}
+}
+
+- (SKTexture *)reloadTextureNamed:(NSString *)name withContentsOfFile:(NSString *)file {
+	/* Sprite Kit keeps returning its cached texture for the name, so the new one is made from the image */
+	NSImage *image = [[NSImage alloc] initWithContentsOfFile:file];
+	if (!image)
+		return nil;
+
+	SKTexture *texture = [SKTexture textureWithImage:image];
+
+	@synchronized(self) {
+		/* The new image is filtered the same way as the one it replaces */
+		SKTexture *oldTexture = [_texturesByName objectForKey:name] ?: _preloadedTextures[name];
+		if (oldTexture) {
+			texture.filteringMode = oldTexture.filteringMode;
+		}
+
+		[_namesByTexture setObject:name forKey:texture];
+		[_texturesByName setObject:texture forKey:name];
+		if (_preloadedTextures[name]) {
+			_preloadedTextures[name] = texture;
+		}
+	}
+
+	return texture;
+}
+
+#pragma mark Preloading
+
+- (void)preloadTexturesWithFiles:(NSDictionary *)filesByName packIntoAtlas:(BOOL)packIntoAtlas completionHandler:(void (^)(void))completionHandler {
+	NSUInteger generation;
+	@synchronized(self) {
+		generation = _generation;
+	}
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+		NSMutableDictionary *textures = [NSMutableDictionary dictionary];
+
+		if (packIntoAtlas) {
+			/* Sprite Kit packs the images into as few textures as it can */
+			NSMutableDictionary *images = [NSMutableDictionary dictionary];
+			for (NSString *name in filesByName) {
+				NSImage *image = [[NSImage alloc] initWithContentsOfFile:filesByName[name]];
+				if (image) {
+					images[name] = image;
+				}
+			}
+			SKTextureAtlas *atlas = [SKTextureAtlas atlasWithDictionary:images];
+			for (NSString *name in images) {
+				textures[name] = [atlas textureNamed:name];
+			}
+		} else {
+			for (NSString *name in filesByName) {
+				textures[name] = [SKTexture textureWithImageNamed:name];
+			}
+		}
+
+		[SKTexture preloadTextures:textures.allValues withCompletionHandler:^{
+			@synchronized(self) {
+				/* The textures of a preload outliving a reset belong to the previous bundle */
+				if (generation != _generation) {
+					[textures removeAllObjects];
+				}
+
+				for (NSString *name in textures) {
+					/* The preloaded textures are shared from now on, the nodes already using the old ones keep them */
+					SKTexture *texture = textures[name];
+					SKTexture *oldTexture = [_texturesByName objectForKey:name];
+					if (oldTexture) {
+						texture.filteringMode = oldTexture.filteringMode;
+					}
+					[_namesByTexture setObject:name forKey:texture];
+					[_texturesByName setObject:texture forKey:name];
+					_preloadedTextures[name] = texture;
+				}
+			}
+
+			dispatch_async(dispatch_get_main_queue(), ^{
+				if (completionHandler) {
+					completionHandler();
+				}
+			});
+		}];
+	});
+}
+
+- (void)removeAllTextures {
+	@synchronized(self) {
+		[_texturesByName removeAllObjects];
+		[_preloadedTextures removeAllObjects];
+		_generation++;
+	}
+}
+
+#pragma mark Statistics
+
+- (NSUInteger)residentTextureCount {
+	@synchronized(self) {
+		return [[_texturesByName objectEnumerator] allObjects].count;
+	}
+}
+
+- (NSUInteger)residentTextureBytes {
+	@synchronized(self) {
+		NSUInteger bytes = 0;
+		for (SKTexture *texture in [_texturesByName objectEnumerator]) {
+			CGSize size = texture.size;
+			bytes += (NSUInteger)(size.width * size.height) * TextureRegistryBytesPerPixel;
+		}
+		return bytes;
+	}
+}
+
+@end
@@ -0,0 +1,42 @@
+/*
+ * ThumbnailService.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/* Decodes the thumbnails of the media library in a pool of worker threads and keeps them cached on disk */
+@interface ThumbnailService : NSObject
++ (BOOL)isImageFile:(NSString *)file;
++ (NSString *)libraryNameOfFile:(NSString *)file;
+- (instancetype)initWithCacheDirectory:(NSString *)cacheDirectory thumbnailSize:(CGFloat)thumbnailSize;
+- (NSImage *)thumbnailOfFile:(NSString *)file;
+- (void)loadThumbnailsOfFiles:(NSArray *)files
+				resultHandler:(void (^)(NSUInteger index, NSImage *thumbnail))resultHandler
+			completionHandler:(void (^)(void))completionHandler;
+- (void)cancelAllLoads;
+- (void)removeCachedThumbnails;
+@property (readonly) NSString *cacheDirectory;
+@property (readonly) CGFloat thumbnailSize;
+@property (assign) NSUInteger maxConcurrentDecodes;
+@end
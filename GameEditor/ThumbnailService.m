@@ -0,0 +1,227 @@
+/*
+ * ThumbnailService.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "ThumbnailService.h"
+#import <CommonCrypto/CommonDigest.h>
+#include <sys/stat.h>
+
+/* Thumbnails are decoded for retina screens and drawn at half their pixel size */
+static const CGFloat ThumbnailServiceBackingScale = 2.0;
+
+@implementation ThumbnailService {
+	NSOperationQueue *_decodingQueue;
+	NSCache *_thumbnails;
+	NSUInteger _generation;
+}
+
+@synthesize
+cacheDirectory = _cacheDirectory,
+thumbnailSize = _thumbnailSize;
+
++ (BOOL)isImageFile:(NSString *)file {
+	CFStringRef fileExtension = (__bridge CFStringRef)[file pathExtension];
+	CFStringRef fileUTI = UTTypeCreatePreferredIdentifierForTag(kUTTagClassFilenameExtension, fileExtension, NULL);
+	if (!fileUTI)
+		return NO;
+	BOOL isImage = UTTypeConformsTo(fileUTI, kUTTypeImage);
+	CFRelease(fileUTI);
+	return isImage;
+}
+
++ (NSString *)libraryNameOfFile:(NSString *)file {
+	/* Images with different idioms share the name in the library */
+	NSString *filename = [file lastPathComponent];
+	NSRange range = [filename rangeOfString:@"~[^~\\.]*\\." options:NSRegularExpressionSearch];
+	if (range.location != NSNotFound)
+		filename = [filename stringByReplacingCharactersInRange:range withString:@"."];
+	return [filename stringByDeletingPathExtension];
+}
+
+- (instancetype)initWithCacheDirectory:(NSString *)cacheDirectory thumbnailSize:(CGFloat)thumbnailSize {
+	if (self = [super init]) {
+		_cacheDirectory = cacheDirectory;
+		_thumbnailSize = thumbnailSize;
+		_thumbnails = [NSCache new];
+		_decodingQueue = [NSOperationQueue new];
+		_decodingQueue.name = @"developer.GameEditor.thumbnails";
+		_decodingQueue.maxConcurrentOperationCount = [[NSProcessInfo processInfo] activeProcessorCount];
+		[[NSFileManager defaultManager] createDirectoryAtPath:cacheDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+	}
+	return self;
+}
+
+- (NSUInteger)maxConcurrentDecodes {
+	return _decodingQueue.maxConcurrentOperationCount;
+}
+
+- (void)setMaxConcurrentDecodes:(NSUInteger)maxConcurrentDecodes {
+	_decodingQueue.maxConcurrentOperationCount = MAX(1, maxConcurrentDecodes);
+}
+
+#pragma mark Thumbnails
+
+- (NSString *)cacheKeyOfFile:(NSString *)file {
+	struct stat fileStat;
+	if (stat(file.fileSystemRepresentation, &fileStat) != 0)
+		return nil;
+
+	/* A thumbnail is valid as long as the file keeps its path, modification time and size */
+	NSString *identity = [NSString stringWithFormat:@"%@\n%ld.%09ld\n%lld\n%g", file,
+						  (long)fileStat.st_mtimespec.tv_sec, (long)fileStat.st_mtimespec.tv_nsec,
+						  (long long)fileStat.st_size, _thumbnailSize];
+	const char *identityString = identity.UTF8String;
+
+	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+	CC_SHA1(identityString, (CC_LONG)strlen(identityString), digest);
+
+	NSMutableString *key = [NSMutableString stringWithCapacity:2 * CC_SHA1_DIGEST_LENGTH];
+	for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; ++i) {
+		[key appendFormat:@"%02x", digest[i]];
+	}
+	return key;
+}
+
+- (NSImage *)imageWithThumbnail:(CGImageRef)thumbnail {
+	/* The thumbnail keeps the aspect ratio, small images aren't scaled up */
+	CGFloat width = CGImageGetWidth(thumbnail);
+	CGFloat height = CGImageGetHeight(thumbnail);
+	CGFloat scale = MIN(1.0, _thumbnailSize / MAX(width, height));
+	return [[NSImage alloc] initWithCGImage:thumbnail size:NSMakeSize(width * scale, height * scale)];
+}
+
+- (CGImageRef)newThumbnailWithContentsOfFile:(NSString *)file {
+	CGImageSourceRef imageSource = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath:file], NULL);
+	if (!imageSource)
+		return NULL;
+
+	/* Let Image I/O decode a downscaled image instead of the full resolution one */
+	NSDictionary *options = @{(NSString *)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+							  (NSString *)kCGImageSourceCreateThumbnailWithTransform: @YES,
+							  (NSString *)kCGImageSourceShouldCacheImmediately: @YES,
+							  (NSString *)kCGImageSourceThumbnailMaxPixelSize: @(_thumbnailSize * ThumbnailServiceBackingScale)};
+	CGImageRef thumbnail = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, (CFDictionaryRef)options);
+	CFRelease(imageSource);
+
+	return thumbnail;
+}
+
+- (void)writeThumbnail:(CGImageRef)thumbnail toFile:(NSString *)file {
+	/* Workers may write the same thumbnail at once, each one writes its own file and moves it into place */
+	NSString *temporaryFile = [file stringByAppendingFormat:@".%@", [NSUUID UUID].UUIDString];
+	CGImageDestinationRef destination = CGImageDestinationCreateWithURL((CFURLRef)[NSURL fileURLWithPath:temporaryFile], kUTTypePNG, 1, NULL);
+	if (!destination)
+		return;
+
+	CGImageDestinationAddImage(destination, thumbnail, NULL);
+	BOOL written = CGImageDestinationFinalize(destination);
+	CFRelease(destination);
+
+	if (!written || rename(temporaryFile.fileSystemRepresentation, file.fileSystemRepresentation) != 0) {
+		unlink(temporaryFile.fileSystemRepresentation);
+	}
+}
+
+- (NSImage *)thumbnailOfFile:(NSString *)file {
+	NSString *key = [self cacheKeyOfFile:file];
+	if (!key)
+		return nil;
+
+	NSImage *image = [_thumbnails objectForKey:key];
+	if (image)
+		return image;
+
+	/* Reading the cached thumbnail is much cheaper than decoding the image */
+	NSString *cachedFile = [_cacheDirectory stringByAppendingPathComponent:[key stringByAppendingPathExtension:@"png"]];
+	CGImageRef thumbnail = NULL;
+	CGImageSourceRef cachedSource = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath:cachedFile], NULL);
+	if (cachedSource) {
+		thumbnail = CGImageSourceCreateImageAtIndex(cachedSource, 0, NULL);
+		CFRelease(cachedSource);
+	}
+
+	if (!thumbnail) {
+		thumbnail = [self newThumbnailWithContentsOfFile:file];
+		if (!thumbnail)
+			return nil;
+		[self writeThumbnail:thumbnail toFile:cachedFile];
+	}
+
+	image = [self imageWithThumbnail:thumbnail];
+	CGImageRelease(thumbnail);
+
+	[_thumbnails setObject:image forKey:key];
+
+	return image;
+}
+
+- (void)loadThumbnailsOfFiles:(NSArray *)files
+				resultHandler:(void (^)(NSUInteger index, NSImage *thumbnail))resultHandler
+			completionHandler:(void (^)(void))completionHandler {
+	NSUInteger generation = _generation;
+
+	NSBlockOperation *completionOperation = [NSBlockOperation blockOperationWithBlock:^{
+		dispatch_async(dispatch_get_main_queue(), ^{
+			/* Loads that were cancelled don't complete */
+			if (generation == _generation && completionHandler) {
+				completionHandler();
+			}
+		});
+	}];
+
+	[files enumerateObjectsUsingBlock:^(NSString *file, NSUInteger index, BOOL *stop) {
+		NSBlockOperation *operation = [NSBlockOperation new];
+		__weak NSBlockOperation *weakOperation = operation;
+		[operation addExecutionBlock:^{
+			if (weakOperation.isCancelled)
+				return;
+
+			NSImage *thumbnail = [self thumbnailOfFile:file];
+
+			/* Deliver each thumbnail as soon as it is ready */
+			dispatch_async(dispatch_get_main_queue(), ^{
+				if (generation == _generation && resultHandler) {
+					resultHandler(index, thumbnail);
+				}
+			});
+		}];
+		[completionOperation addDependency:operation];
+		[_decodingQueue addOperation:operation];
+	}];
+
+	[_decodingQueue addOperation:completionOperation];
+}
+
+- (void)cancelAllLoads {
+	_generation++;
+	[_decodingQueue cancelAllOperations];
+}
+
+- (void)removeCachedThumbnails {
+	[_thumbnails removeAllObjects];
+	[[NSFileManager defaultManager] removeItemAtPath:_cacheDirectory error:NULL];
+	[[NSFileManager defaultManager] createDirectoryAtPath:_cacheDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+@end
@@ -0,0 +1,69 @@
+/*
+ * UndoJournal.h
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <SpriteKit/SpriteKit.h>
+
+typedef enum UndoJournalProperty {
+	UndoJournalPropertyPosition,
+	UndoJournalPropertyZRotation,
+	UndoJournalPropertySize,
+	UndoJournalPropertyAnchorPoint,
+	UndoJournalPropertyXScale,
+	UndoJournalPropertyYScale,
+	UndoJournalPropertyKeyPath
+} UndoJournalProperty;
+
+/* Raw value of a journaled property, scalars only use the first component */
+typedef struct UndoJournalValue {
+	CGFloat x;
+	CGFloat y;
+} UndoJournalValue;
+
+/*
+ Stores the geometry changes of the edited nodes as packed records instead of boxed values,
+ the changes of any other key path keep their values as objects. Records are grouped, a group
+ is what gets undone or redone at once and changing the same property of a node again while
+ its group is open only updates the recorded new value. Groups are identified by increasing
+ numbers, the oldest groups are dropped when the journal grows over its memory limit. The
+ edited objects are referenced weakly, the records of the ones that went away are skipped
+ */
+@interface UndoJournal : NSObject
++ (NSInteger)propertyWithKey:(NSString *)key;
++ (UndoJournalValue)valueWithObject:(id)object property:(UndoJournalProperty)property;
++ (UndoJournalValue)valueOfProperty:(UndoJournalProperty)property ofNode:(SKNode *)node;
+- (void)beginGroup;
+- (NSInteger)endGroup;
+- (void)recordNode:(SKNode *)node property:(UndoJournalProperty)property oldValue:(UndoJournalValue)oldValue newValue:(UndoJournalValue)newValue;
+- (void)recordObject:(id)object keyPath:(NSString *)keyPath oldValue:(id)oldValue newValue:(id)newValue;
+- (NSArray *)revertGroup:(NSInteger)group;
+- (NSArray *)reapplyGroup:(NSInteger)group;
+- (void)removeAllGroups;
+@property (readonly) BOOL isGrouping;
+@property (readonly) NSUInteger groupCount;
+@property (readonly) NSUInteger recordCount;
+@property (readonly) NSUInteger memoryUsage;
+@property (assign, nonatomic) NSUInteger memoryLimit;
+@end
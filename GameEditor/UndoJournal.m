@@ -0,0 +1,444 @@
+/*
+ * UndoJournal.m
+ * GameEditor
+ *
+ * Copyright (c) 2015 Rhody Lugo.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#import "UndoJournal.h"
+
+typedef struct UndoJournalRecord {
+	uint32_t node;
+	uint32_t property;
+	UndoJournalValue oldValue;
+	UndoJournalValue newValue;
+} UndoJournalRecord;
+
+static const NSUInteger kDefaultMemoryLimit = 8 * 1024 * 1024;
+
+@implementation UndoJournal {
+	NSMutableData *_records;
+	NSUInteger _recordCount;
+
+	/* Index of the first record of every closed group, the first one is the group numbered _firstGroup */
+	NSMutableData *_groupStarts;
+	NSInteger _firstGroup;
+
+	/* The open group is always at the end of the records */
+	NSUInteger _groupingLevel;
+	NSUInteger _openGroupStart;
+	NSMapTable *_openGroupRecords;
+	NSMutableDictionary *_openGroupKeyPathRecords;
+
+	/* Nodes are referenced by index from the records */
+	NSPointerArray *_nodes;
+	NSMapTable *_nodeIndexes;
+
+	/* Key path records keep the index of their key path and values in the value components, the first one is numbered _firstObjectValue */
+	NSMutableArray *_objectValues;
+	NSUInteger _firstObjectValue;
+}
+
++ (NSInteger)propertyWithKey:(NSString *)key {
+	static NSDictionary *properties = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		properties = @{@"position": @(UndoJournalPropertyPosition),
+					   @"zRotation": @(UndoJournalPropertyZRotation),
+					   @"size": @(UndoJournalPropertySize),
+					   @"anchorPoint": @(UndoJournalPropertyAnchorPoint),
+					   @"xScale": @(UndoJournalPropertyXScale),
+					   @"yScale": @(UndoJournalPropertyYScale)};
+	});
+	NSNumber *property = properties[key];
+	return property ? property.integerValue : NSNotFound;
+}
+
++ (UndoJournalValue)valueWithObject:(id)object property:(UndoJournalProperty)property {
+	switch (property) {
+		case UndoJournalPropertyPosition:
+		case UndoJournalPropertyAnchorPoint: {
+			NSPoint point = [object pointValue];
+			return (UndoJournalValue){point.x, point.y};
+		}
+		case UndoJournalPropertySize: {
+			NSSize size = [object sizeValue];
+			return (UndoJournalValue){size.width, size.height};
+		}
+		default:
+			return (UndoJournalValue){[object doubleValue], 0};
+	}
+}
+
++ (UndoJournalValue)valueOfProperty:(UndoJournalProperty)property ofNode:(SKNode *)node {
+	switch (property) {
+		case UndoJournalPropertyPosition:
+			return (UndoJournalValue){node.position.x, node.position.y};
+		case UndoJournalPropertyZRotation:
+			return (UndoJournalValue){node.zRotation, 0};
+		case UndoJournalPropertySize: {
+			CGSize size = [node respondsToSelector:@selector(size)] ? [(id)node size] : CGSizeZero;
+			return (UndoJournalValue){size.width, size.height};
+		}
+		case UndoJournalPropertyAnchorPoint: {
+			CGPoint anchorPoint = [node respondsToSelector:@selector(anchorPoint)] ? [(id)node anchorPoint] : CGPointZero;
+			return (UndoJournalValue){anchorPoint.x, anchorPoint.y};
+		}
+		case UndoJournalPropertyXScale:
+			return (UndoJournalValue){node.xScale, 0};
+		case UndoJournalPropertyYScale:
+			return (UndoJournalValue){node.yScale, 0};
+		case UndoJournalPropertyKeyPath:
+			break;
+	}
+	return (UndoJournalValue){0, 0};
+}
+
+static void UndoJournalApplyValue(SKNode *node, UndoJournalProperty property, UndoJournalValue value) {
+	switch (property) {
+		case UndoJournalPropertyPosition:
+			node.position = CGPointMake(value.x, value.y);
+			break;
+		case UndoJournalPropertyZRotation:
+			node.zRotation = value.x;
+			break;
+		case UndoJournalPropertySize:
+			if ([node respondsToSelector:@selector(setSize:)])
+				[(id)node setSize:CGSizeMake(value.x, value.y)];
+			break;
+		case UndoJournalPropertyAnchorPoint:
+			if ([node respondsToSelector:@selector(setAnchorPoint:)])
+				[(id)node setAnchorPoint:CGPointMake(value.x, value.y)];
+			break;
+		case UndoJournalPropertyXScale:
+			node.xScale = value.x;
+			break;
+		case UndoJournalPropertyYScale:
+			node.yScale = value.x;
+			break;
+		case UndoJournalPropertyKeyPath:
+			break;
+	}
+}
+
++ (NSMapTable *)nodeIndexTable {
+	return [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory|NSPointerFunctionsObjectPointerPersonality
+								 valueOptions:NSPointerFunctionsOpaqueMemory|NSPointerFunctionsIntegerPersonality];
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_records = [NSMutableData data];
+		_groupStarts = [NSMutableData data];
+		_openGroupStart = NSNotFound;
+		_openGroupRecords = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory|NSPointerFunctionsIntegerPersonality
+												  valueOptions:NSPointerFunctionsOpaqueMemory|NSPointerFunctionsIntegerPersonality];
+		_openGroupKeyPathRecords = [NSMutableDictionary dictionary];
+		_nodes = [NSPointerArray weakObjectsPointerArray];
+		_nodeIndexes = [UndoJournal nodeIndexTable];
+		_objectValues = [NSMutableArray array];
+		_memoryLimit = kDefaultMemoryLimit;
+	}
+	return self;
+}
+
+#pragma mark Recording
+
+- (void)beginGroup {
+	if (_groupingLevel++ == 0) {
+		_openGroupStart = _recordCount;
+	}
+}
+
+- (NSInteger)endGroup {
+	if (_groupingLevel == 0 || --_groupingLevel > 0)
+		return NSNotFound;
+
+	NSUInteger start = _openGroupStart;
+	_openGroupStart = NSNotFound;
+	NSResetMapTable(_openGroupRecords);
+	[_openGroupKeyPathRecords removeAllObjects];
+
+	/* Drop the properties that ended the group with the value they had when it began */
+	UndoJournalRecord *records = _records.mutableBytes;
+	NSUInteger count = start;
+	for (NSUInteger i = start; i < _recordCount; ++i) {
+		BOOL changed;
+		if (records[i].property == UndoJournalPropertyKeyPath) {
+			NSArray *values = _objectValues[(NSUInteger)records[i].oldValue.x - _firstObjectValue];
+			changed = ![values[1] isEqual:values[2]];
+		} else {
+			changed = records[i].oldValue.x != records[i].newValue.x || records[i].oldValue.y != records[i].newValue.y;
+		}
+		if (changed) {
+			records[count++] = records[i];
+		}
+	}
+	_recordCount = count;
+	_records.length = _recordCount * sizeof(UndoJournalRecord);
+
+	if (_recordCount == start)
+		return NSNotFound;
+
+	[_groupStarts appendBytes:&start length:sizeof(NSUInteger)];
+	NSInteger group = _firstGroup + self.groupCount - 1;
+
+	if (self.memoryUsage > _memoryLimit) {
+		[self trimToSize:_memoryLimit * 3 / 4];
+	}
+
+	return group;
+}
+
+- (void)recordNode:(SKNode *)node property:(UndoJournalProperty)property oldValue:(UndoJournalValue)oldValue newValue:(UndoJournalValue)newValue {
+	/* Changes outside of a group form a group by themselves */
+	BOOL implicitGroup = _groupingLevel == 0;
+	if (implicitGroup) {
+		[self beginGroup];
+	}
+
+	NSUInteger nodeIndex = [self indexOfNode:node];
+
+	/* Keys and values are offset by one, zero means not found */
+	uintptr_t key = ((uintptr_t)(nodeIndex - 1) << 3 | property) + 1;
+	NSUInteger recordIndex = (NSUInteger)NSMapGet(_openGroupRecords, (void *)key);
+	if (recordIndex) {
+		/* Merge with the previous change of the property in the group */
+		UndoJournalRecord *records = _records.mutableBytes;
+		records[recordIndex - 1].newValue = newValue;
+	} else {
+		UndoJournalRecord record = {(uint32_t)(nodeIndex - 1), property, oldValue, newValue};
+		[_records appendBytes:&record length:sizeof(UndoJournalRecord)];
+		NSMapInsert(_openGroupRecords, (void *)key, (void *)++_recordCount);
+	}
+
+	if (implicitGroup) {
+		[self endGroup];
+	}
+}
+
+- (void)recordObject:(id)object keyPath:(NSString *)keyPath oldValue:(id)oldValue newValue:(id)newValue {
+	BOOL implicitGroup = _groupingLevel == 0;
+	if (implicitGroup) {
+		[self beginGroup];
+	}
+
+	NSUInteger nodeIndex = [self indexOfNode:object];
+	NSArray *key = @[@(nodeIndex), keyPath];
+	NSNumber *recordIndex = _openGroupKeyPathRecords[key];
+	if (recordIndex) {
+		/* Merge with the previous change of the key path in the group */
+		const UndoJournalRecord *records = _records.bytes;
+		NSUInteger valueIndex = (NSUInteger)records[recordIndex.unsignedIntegerValue].oldValue.x - _firstObjectValue;
+		NSArray *values = _objectValues[valueIndex];
+		_objectValues[valueIndex] = @[keyPath, values[1], newValue ?: [NSNull null]];
+	} else {
+		CGFloat valueIndex = _firstObjectValue + _objectValues.count;
+		[_objectValues addObject:@[keyPath, oldValue ?: [NSNull null], newValue ?: [NSNull null]]];
+		UndoJournalRecord record = {(uint32_t)(nodeIndex - 1), UndoJournalPropertyKeyPath, {valueIndex, 0}, {valueIndex, 0}};
+		[_records appendBytes:&record length:sizeof(UndoJournalRecord)];
+		_openGroupKeyPathRecords[key] = @(_recordCount++);
+	}
+
+	if (implicitGroup) {
+		[self endGroup];
+	}
+}
+
+- (NSUInteger)indexOfNode:(id)node {
+	/* Indexes are offset by one, zero means not found */
+	NSUInteger nodeIndex = (NSUInteger)NSMapGet(_nodeIndexes, (__bridge void *)node);
+	if (nodeIndex == 0) {
+		[_nodes addPointer:(__bridge void *)node];
+		nodeIndex = _nodes.count;
+		NSMapInsert(_nodeIndexes, (__bridge void *)node, (void *)nodeIndex);
+	}
+	return nodeIndex;
+}
+
+- (void)applyRecord:(const UndoJournalRecord *)record reverting:(BOOL)reverting toNodes:(NSMutableOrderedSet *)nodes {
+	id node = (__bridge id)[_nodes pointerAtIndex:record->node];
+	if (!node)
+		return;
+
+	if (record->property == UndoJournalPropertyKeyPath) {
+		NSArray *values = _objectValues[(NSUInteger)record->oldValue.x - _firstObjectValue];
+		id value = reverting ? values[1] : values[2];
+		[node setValue:value == [NSNull null] ? nil : value forKeyPath:values[0]];
+	} else {
+		UndoJournalApplyValue(node, record->property, reverting ? record->oldValue : record->newValue);
+	}
+	[nodes addObject:node];
+}
+
+#pragma mark Replaying
+
+- (NSRange)rangeOfGroup:(NSInteger)group {
+	NSUInteger groupCount = self.groupCount;
+	if (group < _firstGroup || group >= _firstGroup + (NSInteger)groupCount)
+		return NSMakeRange(NSNotFound, 0);
+
+	const NSUInteger *starts = _groupStarts.bytes;
+	NSUInteger index = group - _firstGroup;
+	NSUInteger end = index + 1 < groupCount ? starts[index + 1] : (_openGroupStart != NSNotFound ? _openGroupStart : _recordCount);
+	return NSMakeRange(starts[index], end - starts[index]);
+}
+
+- (NSArray *)revertGroup:(NSInteger)group {
+	NSRange range = [self rangeOfGroup:group];
+	if (range.location == NSNotFound)
+		return nil;
+
+	/* Revert in reverse order so that the oldest value of every property is the one that stays */
+	NSMutableOrderedSet *nodes = [NSMutableOrderedSet orderedSet];
+	const UndoJournalRecord *records = _records.bytes;
+	for (NSUInteger i = NSMaxRange(range); i-- > range.location;) {
+		[self applyRecord:&records[i] reverting:YES toNodes:nodes];
+	}
+	return nodes.array;
+}
+
+- (NSArray *)reapplyGroup:(NSInteger)group {
+	NSRange range = [self rangeOfGroup:group];
+	if (range.location == NSNotFound)
+		return nil;
+
+	NSMutableOrderedSet *nodes = [NSMutableOrderedSet orderedSet];
+	const UndoJournalRecord *records = _records.bytes;
+	for (NSUInteger i = range.location; i < NSMaxRange(range); ++i) {
+		[self applyRecord:&records[i] reverting:NO toNodes:nodes];
+	}
+	return nodes.array;
+}
+
+#pragma mark Memory
+
+- (void)trimToSize:(NSUInteger)size {
+	/* Drop whole groups from the front, the open group is never dropped. The node table is counted
+	   as if every remaining record had a node of its own, it is compacted to the referenced nodes afterwards */
+	NSUInteger groupCount = self.groupCount;
+	const NSUInteger *starts = _groupStarts.bytes;
+	NSUInteger droppedGroups = 0;
+	NSUInteger droppedRecords = 0;
+	NSUInteger usage = self.memoryUsage - _nodes.count * 2 * sizeof(void *);
+	while (droppedGroups < groupCount && usage + MIN(_nodes.count, _recordCount - droppedRecords) * 2 * sizeof(void *) > size) {
+		NSUInteger end = droppedGroups + 1 < groupCount ? starts[droppedGroups + 1] : (_openGroupStart != NSNotFound ? _openGroupStart : _recordCount);
+		usage -= (end - starts[droppedGroups]) * sizeof(UndoJournalRecord) + sizeof(NSUInteger);
+		droppedRecords = end;
+		++droppedGroups;
+	}
+	if (droppedGroups == 0)
+		return;
+
+	[_records replaceBytesInRange:NSMakeRange(0, droppedRecords * sizeof(UndoJournalRecord)) withBytes:NULL length:0];
+	[_groupStarts replaceBytesInRange:NSMakeRange(0, droppedGroups * sizeof(NSUInteger)) withBytes:NULL length:0];
+	_recordCount -= droppedRecords;
+	_firstGroup += droppedGroups;
+	[self compactNodes];
+
+	NSUInteger *remainingStarts = _groupStarts.mutableBytes;
+	for (NSUInteger i = 0; i < groupCount - droppedGroups; ++i) {
+		remainingStarts[i] -= droppedRecords;
+	}
+	if (_openGroupStart != NSNotFound) {
+		_openGroupStart -= droppedRecords;
+		NSResetMapTable(_openGroupRecords);
+		[_openGroupKeyPathRecords removeAllObjects];
+		const UndoJournalRecord *records = _records.bytes;
+		for (NSUInteger i = _openGroupStart; i < _recordCount; ++i) {
+			if (records[i].property == UndoJournalPropertyKeyPath) {
+				NSArray *values = _objectValues[(NSUInteger)records[i].oldValue.x - _firstObjectValue];
+				_openGroupKeyPathRecords[@[@(records[i].node + 1), values[0]]] = @(i);
+			} else {
+				uintptr_t key = ((uintptr_t)records[i].node << 3 | records[i].property) + 1;
+				NSMapInsert(_openGroupRecords, (void *)key, (void *)(i + 1));
+			}
+		}
+	}
+
+	/* Release the values of the dropped key path records, they were added in the same order as the records */
+	NSUInteger firstObjectValue = _firstObjectValue + _objectValues.count;
+	const UndoJournalRecord *records = _records.bytes;
+	for (NSUInteger i = 0; i < _recordCount; ++i) {
+		if (records[i].property == UndoJournalPropertyKeyPath) {
+			firstObjectValue = (NSUInteger)records[i].oldValue.x;
+			break;
+		}
+	}
+	[_objectValues removeObjectsInRange:NSMakeRange(0, firstObjectValue - _firstObjectValue)];
+	_firstObjectValue = firstObjectValue;
+}
+
+- (void)compactNodes {
+	/* Keep the nodes the remaining records reference, numbered in the order they are first referenced */
+	uint32_t *nodeIndexes = calloc(MAX(_nodes.count, 1), sizeof(uint32_t));
+	NSPointerArray *nodes = [NSPointerArray weakObjectsPointerArray];
+	NSMapTable *indexesByNode = [UndoJournal nodeIndexTable];
+
+	UndoJournalRecord *records = _records.mutableBytes;
+	for (NSUInteger i = 0; i < _recordCount; ++i) {
+		uint32_t nodeIndex = records[i].node;
+		if (nodeIndexes[nodeIndex] == 0) {
+			void *node = [_nodes pointerAtIndex:nodeIndex];
+			[nodes addPointer:node];
+			nodeIndexes[nodeIndex] = (uint32_t)nodes.count;
+			if (node) {
+				NSMapInsert(indexesByNode, node, (void *)(NSUInteger)nodes.count);
+			}
+		}
+		records[i].node = nodeIndexes[nodeIndex] - 1;
+	}
+	free(nodeIndexes);
+
+	_nodes = nodes;
+	_nodeIndexes = indexesByNode;
+}
+
+- (void)removeAllGroups {
+	[self trimToSize:0];
+}
+
+- (void)setMemoryLimit:(NSUInteger)memoryLimit {
+	_memoryLimit = memoryLimit;
+	if (self.memoryUsage > _memoryLimit) {
+		[self trimToSize:_memoryLimit * 3 / 4];
+	}
+}
+
+#pragma mark Accessors
+
+- (BOOL)isGrouping {
+	return _groupingLevel > 0;
+}
+
+- (NSUInteger)groupCount {
+	return _groupStarts.length / sizeof(NSUInteger);
+}
+
+- (NSUInteger)recordCount {
+	return _recordCount;
+}
+
+- (NSUInteger)memoryUsage {
+	return _records.length + _groupStarts.length + _nodes.count * 2 * sizeof(void *) + _objectValues.count * 4 * sizeof(void *);
+}
+
+@end
@@ -29,7 +29,7 @@
 
 @interface UserDataUniformsArray : NSMutableArray
 
-+ (NSArrayController *)controllerWithShader:(SKShader *)shader;
++ (NSArrayController *)controllerWithShader:(SKShader *)shader node:(SKNode *)node key:(NSString *)key;
 
 @end
 
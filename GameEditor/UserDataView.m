@@ -25,7 +25,7 @@
 
 #import "UserDataView.h"
 #import "InspectorTableView.h"
-#import "NSView+LayoutConstraint.h"
+#import "ShaderRegistry.h"
 
 #pragma mark SKUniform
 
@@ -125,16 +125,20 @@
 
 @implementation UserDataUniformsArray {
 	__weak SKShader *_shader;
+	__weak SKNode *_node;
+	NSString *_key;
 }
 
-+ (NSArrayController *)controllerWithShader:(SKShader *)shader {
-	return [[NSArrayController alloc] initWithContent:[[UserDataUniformsArray alloc] initWithShader:shader]];
++ (NSArrayController *)controllerWithShader:(SKShader *)shader node:(SKNode *)node key:(NSString *)key {
+	return [[NSArrayController alloc] initWithContent:[[UserDataUniformsArray alloc] initWithShader:shader node:node key:key]];
 }
 
-- (instancetype)initWithShader:(SKShader *)shader {
+- (instancetype)initWithShader:(SKShader *)shader node:(SKNode *)node key:(NSString *)key {
 	if (self = [super init]) {
 		_shader = shader;
-		if (_shader.uniforms.count == 0) {
+		_node = node;
+		_key = key;
+		if (_shader.uniforms.count == 0 && ![[ShaderRegistry sharedRegistry] isSharedShader:_shader]) {
 			_shader.uniforms = nil;
 		}
 	}
@@ -180,6 +184,13 @@
 }
 
 - (void)updateUniforms:(NSArray *)uniforms {
+	/* The shaders from the registry are shared between nodes, the node gets its own copy before the first edit */
+	if ([[ShaderRegistry sharedRegistry] isSharedShader:_shader]) {
+		SKShader *shader = [_shader copy];
+		[_node setValue:shader forKey:_key];
+		_shader = shader;
+	}
+
 	if (uniforms.count) {
 		_shader.uniforms = uniforms;
 	} else {
@@ -342,16 +353,22 @@
 
 - (void)didAddRowView:(NSTableRowView *)rowView forRow:(NSInteger)row {
 	[super didAddRowView:rowView forRow:row];
-	[self updateTableHeight];
+	[self setNeedsTableHeightUpdate];
 	[self updateBackgroundStyle];
 }
 
 - (void)didRemoveRowView:(NSTableRowView *)rowView forRow:(NSInteger)row {
 	[super didRemoveRowView:rowView forRow:row];
-	[self updateTableHeight];
+	[self setNeedsTableHeightUpdate];
 	[self updateBackgroundStyle];
 }
 
+- (void)setNeedsTableHeightUpdate {
+	/* Adding or removing several rows only resizes the inspector row once, the pending request keeps the table alive until then */
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(updateTableHeight) object:nil];
+	[self performSelector:@selector(updateTableHeight) withObject:nil afterDelay:0 inModes:@[NSRunLoopCommonModes]];
+}
+
 - (void)updateTableHeight {
 	/* Register to receive a notification when the table row containing the user data table is added to the inspector */
 	if (!_inspectorTableRowView && [self.enclosingScrollView.superview.superview isKindOfClass:[InspectorTableRowView class]]) {
@@ -359,12 +376,6 @@
 		[_inspectorTableRowView addObserver:self forKeyPath:@"superview" options:0 context: NULL];
 	}
 
-	const CGFloat newHeight = MAX([self heightForRows:3], [self heightForRows:self.numberOfRows]);
-
-	CGRect frame = _inspectorTableRowView.frame;
-	frame.size.height = newHeight;
-	_inspectorTableRowView.frame = frame;
-
 	InspectorTableView *inspectorTableView = (InspectorTableView *)_inspectorTableRowView.superview;
 
 	if (!inspectorTableView)
@@ -372,25 +383,12 @@
 
 	NSInteger tableRow = [inspectorTableView rowForView:_inspectorTableRowView];
 
-	[_inspectorTableRowView setConstraintConstant:newHeight - 2 forAttribute:NSLayoutAttributeHeight];
-	[inspectorTableView setHeight:newHeight - 2 forItem:[inspectorTableView itemAtRow:tableRow]];
+	if (tableRow < 0)
+		return;
 
-	/* Update the user data table's row height */
-	[NSAnimationContext beginGrouping];
-	[[NSAnimationContext currentContext] setDuration:0];
-	[inspectorTableView noteHeightOfRowsWithIndexesChanged:[NSIndexSet indexSetWithIndex:tableRow]];
-	[NSAnimationContext endGrouping];
-
-	/* Update the position for the rows below the user data table */
-	CGFloat bottom = NSMaxY(_inspectorTableRowView.frame);
-	for (NSInteger row=tableRow + 1; row < inspectorTableView.numberOfRows; ++row) {
-		InspectorTableRowView *tableRowView = (InspectorTableRowView *)[inspectorTableView rowViewAtRow:row makeIfNecessary:NO];
-		if (!tableRowView)
-			break;
-		[tableRowView setConstraintConstant:bottom forAttribute:NSLayoutAttributeTop];
-		[inspectorTableView setTop:bottom forItem:[inspectorTableView itemAtRow:[inspectorTableView rowForView:tableRowView]]];
-		bottom = NSMaxY(tableRowView.frame);
-	}
+	/* The inspector only updates the offsets of the rows below, and moves the ones that are visible */
+	const CGFloat newHeight = MAX([self heightForRows:3], [self heightForRows:self.numberOfRows]);
+	[inspectorTableView setHeight:newHeight - 2 forItem:[inspectorTableView itemAtRow:tableRow]];
 }
 
 - (CGFloat)heightForRows:(NSInteger)rows {
@@ -27,6 +27,8 @@
 #import <SpriteKit/SpriteKit.h>
 #import <AppKit/AppKit.h>
 #import <objc/runtime.h>
+#import "ShaderRegistry.h"
+#import "TextureRegistry.h"
 
 #pragma mark NSBundle
 
@@ -35,7 +37,7 @@
 - (NSArray *) pathsForResourcesOfType:(NSString *)ext {
 	NSMutableArray *result = [NSMutableArray array];
 	NSString *mainbundleResourcesPath = [[[NSBundle mainBundle] resourcePath] stringByAppendingString:@"/"];
-	for (NSString *path in [[NSBundle mainBundle] pathsForResourcesOfType:@"fsh" inDirectory:nil]) {
+	for (NSString *path in [[NSBundle mainBundle] pathsForResourcesOfType:ext inDirectory:nil]) {
 		if (![path hasPrefix:mainbundleResourcesPath]) {
 			[result addObject:path];
 		}
@@ -485,16 +487,11 @@ static BOOL isNumber(id value) {
 	[self initializeWithTransformedValueClass:[SKTexture class]
 				  allowsReverseTransformation:YES
 						transformedValueBlock:^id(SKTexture *value){
-							NSString *description = [value description];
-							NSRange range = [description  rangeOfString:@"(?<=\').*(?=\')" options:NSRegularExpressionSearch];
-							if (range.location != NSNotFound) {
-								return [[description substringWithRange:range] stringByDeletingPathExtension];
-							}
-							return nil;
+							return [[TextureRegistry sharedRegistry] nameOfTexture:value];
 						}
 				 reverseTransformedValueBlock:^id(NSString *value){
 					 if (value) {
-						 return [SKTexture textureWithImageNamed:value];
+						 return [[TextureRegistry sharedRegistry] textureNamed:value];
 					 }
 					 return nil;
 				 }];
@@ -508,23 +505,11 @@ static BOOL isNumber(id value) {
 	[self initializeWithTransformedValueClass:[SKShader class]
 				  allowsReverseTransformation:YES
 						transformedValueBlock:^id(SKShader *value){
-							for (NSString *path in [[NSBundle mainBundle] pathsForResourcesOfType:@"fsh"]) {
-								NSString *source = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
-								if ([[value source] hash] == [source hash]) {
-									return path.lastPathComponent;
-								}
-							}
-							return nil;
+							return [[ShaderRegistry sharedRegistry] nameOfShader:value];
 						}
 				 reverseTransformedValueBlock:^id(NSString *value){
 					 if (value) {
-						 for (NSString *path in [[NSBundle mainBundle] pathsForResourcesOfType:@"fsh"]) {
-							 if ([[path lastPathComponent] isEqualToString:value]) {
-								 NSString *source = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
-								 return [SKShader shaderWithSource:source];
-							 }
-						 }
-						 return nil;
+						 return [[ShaderRegistry sharedRegistry] shaderNamed:value];
 					 }
 					 return nil;
 				 }];
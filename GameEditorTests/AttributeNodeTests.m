@@ -0,0 +1,85 @@
+//
+//  AttributeNodeTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "AttributeNode.h"
+
+static const NSUInteger kAccessCount = 100000;
+
+@interface AttributeNodeTests : XCTestCase
+
+@end
+
+@implementation AttributeNodeTests {
+	SKSpriteNode *_node;
+}
+
+- (void)setUp {
+	[super setUp];
+	_node = [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(10, 20)];
+	_node.position = CGPointMake(1.5, 2.5);
+}
+
+#pragma mark Tests
+
+- (void)testStructFieldsAreAccessedBySubindex {
+	AttributeNode *attribute = [AttributeNode attributeWithName:@"position" node:_node identifier:@(@encode(CGPoint))];
+	XCTAssertEqualObjects([attribute valueForKey:@"value1"], @1.5);
+	XCTAssertEqualObjects([attribute valueForKey:@"value2"], @2.5);
+
+	[attribute setValue:@4.0 forKey:@"value2"];
+	XCTAssertTrue(CGPointEqualToPoint(_node.position, CGPointMake(1.5, 4.0)));
+}
+
+- (void)testNestedStructFieldsAreFlattened {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(100, 100)];
+	AttributeNode *attribute = [AttributeNode attributeWithName:@"frame" node:scene identifier:@(@encode(CGRect))];
+	CGRect frame = scene.frame;
+	XCTAssertEqualObjects([attribute valueForKey:@"value3"], @(frame.size.width));
+	XCTAssertEqualObjects([attribute valueForKey:@"value4"], @(frame.size.height));
+}
+
+- (void)testSplitValuesAndLabelsAreAccessedBySubindex {
+	AttributeNode *attribute = [AttributeNode attributeWithName:@"scale,xScale,yScale" node:_node identifier:@"d"];
+	attribute.labels = @[@"X", @"Y"];
+	XCTAssertEqualObjects([attribute valueForKey:@"label2"], @"Y");
+	XCTAssertEqualObjects([attribute valueForKey:@"value1"], @1.0);
+
+	[attribute setValue:@3.0 forKey:@"value2"];
+	XCTAssertEqual(_node.yScale, 3.0);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceStructFieldAccess {
+	AttributeNode *attribute = [AttributeNode attributeWithName:@"position" node:_node identifier:@(@encode(CGPoint))];
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < kAccessCount; ++i) {
+			[attribute valueForKey:i & 1 ? @"value2" : @"value1"];
+		}
+	}];
+}
+
+- (void)testPerformanceRegularExpressionKeyParsing {
+	/* What every access cost before the dispatch table, for comparison with the benchmark above */
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < kAccessCount; ++i) {
+			NSArray *results = [(i & 1 ? @"value2" : @"value1") substringsWithRegularExpressionWithPattern:@"([\\D]+)([\\d]+)" options:0 error:NULL];
+			(void)[results[1] integerValue];
+		}
+	}];
+}
+
+- (void)testPerformanceAttributeCreation {
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < kAccessCount / 10; ++i) {
+			(void)[AttributeNode attributeWithName:@"position" node:_node identifier:@(@encode(CGPoint))];
+		}
+	}];
+}
+
+@end
@@ -0,0 +1,117 @@
+//
+//  AttributeSchemaTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "AttributeSchema.h"
+#import "AttributeNode.h"
+#import "AppDelegate.h"
+
+/* The inspector's builder, the snapshot is taken in the main thread and the attributes are built from it in the background */
+@interface AppDelegate (AttributeSchemaTests)
+- (NSDictionary *)attributeSnapshotWithNode:(id)node class:(Class)classType;
+- (NSMutableArray *)attributesForAllClassesWithNode:(id)node snapshot:(NSDictionary *)snapshot;
+- (void)bindAttributes:(NSArray *)attributes;
+@end
+
+@interface AttributeSchemaTests : XCTestCase
+
+@end
+
+@implementation AttributeSchemaTests
+
+- (NSArray *)namesOfDescriptors:(NSArray *)descriptors {
+	return [descriptors valueForKey:@"name"];
+}
+
+- (void)testSchemaIsBuiltOncePerClass {
+	AttributeSchema *schema = [AttributeSchema schemaForClass:[SKSpriteNode class]];
+	XCTAssertEqual(schema, [AttributeSchema schemaForClass:[SKSpriteNode class]]);
+	XCTAssertNotEqual(schema, [AttributeSchema schemaForClass:[SKNode class]]);
+	XCTAssertNil([AttributeSchema schemaForClass:Nil]);
+}
+
+- (void)testMergedAttributes {
+	NSArray *names = [self namesOfDescriptors:[AttributeSchema schemaForClass:[SKNode class]].attributes];
+	XCTAssertTrue([names containsObject:@"z,zPosition,zRotation"]);
+	XCTAssertTrue([names containsObject:@"scale,xScale,yScale"]);
+	XCTAssertFalse([names containsObject:@"zPosition"]);
+	XCTAssertFalse([names containsObject:@"xScale"]);
+}
+
+- (void)testSceneAttributesAreNotEditable {
+	NSArray *descriptors = [AttributeSchema schemaForClass:[SKNode class]].sceneAttributes;
+	for (AttributeDescriptor *descriptor in descriptors) {
+		if ([descriptor.name isEqualToString:@"position"] || [descriptor.name isEqualToString:@"zPosition"]) {
+			XCTAssertEqual(descriptor.kind, AttributeDescriptorKindNonEditable);
+		}
+	}
+	XCTAssertFalse([[self namesOfDescriptors:descriptors] containsObject:@"z,zPosition,zRotation"]);
+}
+
+- (void)testAllPropertyNamesIncludeSuperclasses {
+	NSArray *names = [AttributeSchema schemaForClass:[SKSpriteNode class]].allPropertyNames;
+	XCTAssertTrue([names containsObject:@"texture"]);
+	XCTAssertTrue([names containsObject:@"position"]);
+	XCTAssertEqual(names.count, [NSSet setWithArray:names].count);
+}
+
+- (void)testAttributesBuiltInBackgroundAreBoundInMainThread {
+	SKNode *node = [SKNode node];
+	node.name = @"before";
+
+	__block AttributeNode *attribute = nil;
+	dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		attribute = [AttributeNode attributeWithName:@"name" node:node identifier:@"@\"NSString\""];
+	});
+
+	/* Changes made before binding are picked up by the binding */
+	node.name = @"after";
+	XCTAssertNil([attribute valueForKey:@"value"]);
+
+	[attribute bindValues];
+	XCTAssertEqualObjects([attribute valueForKey:@"value"], @"after");
+
+	node.name = @"bound";
+	XCTAssertEqualObjects([attribute valueForKey:@"value"], @"bound");
+}
+
+- (NSDictionary *)rowWithName:(NSString *)name inAttributes:(NSArray *)attributes {
+	for (id attribute in attributes) {
+		if ([attribute isKindOfClass:[NSDictionary class]]) {
+			if ([attribute[@"name"] isEqualToString:name])
+				return attribute;
+			NSDictionary *row = [self rowWithName:name inAttributes:attribute[@"children"]];
+			if (row)
+				return row;
+		}
+	}
+	return nil;
+}
+
+- (void)testBackgroundBuildLeavesTheShaderUntouched {
+	AppDelegate *appDelegate = [NSApp delegate];
+	SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(10, 10)];
+	sprite.shader = [SKShader shader];
+
+	NSDictionary *snapshot = [appDelegate attributeSnapshotWithNode:sprite class:[sprite class]];
+	__block NSMutableArray *attributes = nil;
+	dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		attributes = [appDelegate attributesForAllClassesWithNode:sprite snapshot:snapshot];
+	});
+
+	/* The uniforms controller writes to the shader, it's only created when binding in the main thread */
+	NSDictionary *row = [self rowWithName:@"uniforms" inAttributes:attributes];
+	XCTAssertNotNil(row);
+	XCTAssertNil(row[@"content"]);
+	XCTAssertEqual(row[@"shader"], sprite.shader);
+
+	[appDelegate bindAttributes:attributes];
+	XCTAssertNotNil(row[@"content"]);
+	XCTAssertNil(row[@"shader"]);
+}
+
+@end
@@ -0,0 +1,367 @@
+//
+//  BenchmarkSuiteTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "AppDelegate.h"
+#import "EditorView.h"
+#import "NavigationNode.h"
+#import "NodeClipboard.h"
+#import "SceneArchive.h"
+#import "SyntheticSceneGenerator.h"
+
+/*
+ Benchmarks of the editor's main code paths over a synthetic scene. The median of every benchmark is
+ written to a JSON file along with its baseline, the file is started over on every run. A benchmark fails
+ when its median is slower than the baseline by more than the threshold, benchmarks without a baseline
+ measured over the same scene are only reported. The scene and the files are set through the environment:
+ BENCHMARK_NODE_COUNT, BENCHMARK_MAXIMUM_DEPTH, BENCHMARK_TEXTURE_COUNT and BENCHMARK_SEED build the scene,
+ BENCHMARK_RESULTS_PATH locates the results and BENCHMARK_BASELINES_PATH the baselines, which otherwise come
+ from the test bundle. BENCHMARK_RECORD_BASELINES=1 stores the results as the new baselines instead of comparing
+ against them, into BENCHMARK_BASELINES_PATH or next to the results when it is not set
+ */
+
+static NSString *const kResultsFileName = @"GameEditorBenchmarkResults.json";
+static NSString *const kBaselinesFileName = @"BenchmarkBaselines.json";
+static NSString *const kRecordedBaselinesFileName = @"GameEditorBenchmarkBaselines.json";
+static const double kDefaultThreshold = 0.25;
+
+/* The app delegate's code paths being measured */
+@interface AppDelegate (BenchmarkSuite)
+- (SKScene *)unarchiveFromFile:(NSString *)file error:(NSError * __autoreleasing *)error;
+- (void)archiveScene:(SKScene *)scene toFile:(NSString *)file completionHandler:(void (^)(NSError *error))completionHandler;
+- (NSDictionary *)attributeSnapshotWithNode:(id)node class:(Class)classType;
+- (NSMutableArray *)attributesForAllClassesWithNode:(id)node snapshot:(NSDictionary *)snapshot;
+- (void)useSceneBundle:(NSBundle *)bundle;
+- (BOOL)isMediaLibraryLoaded;
+- (void)useScene:(SKScene *)scene;
+- (void)updateSelectionWithNode:(id)node;
+@end
+
+@interface BenchmarkSuiteTests : XCTestCase
+
+@end
+
+@implementation BenchmarkSuiteTests {
+	AppDelegate *_appDelegate;
+	SyntheticSceneGenerator *_generator;
+	SKScene *_scene;
+	NSString *_sceneFile;
+}
+
++ (void)setUp {
+	[super setUp];
+
+	/* The results only ever hold the benchmarks of this run */
+	[[NSFileManager defaultManager] removeItemAtPath:[self resultsPath] error:NULL];
+}
+
+- (void)setUp {
+	[super setUp];
+	_appDelegate = [NSApp delegate];
+
+	NSDictionary *environment = [[NSProcessInfo processInfo] environment];
+	_generator = [[SyntheticSceneGenerator alloc] init];
+	_generator.nodeCount = environment[@"BENCHMARK_NODE_COUNT"] ? [environment[@"BENCHMARK_NODE_COUNT"] integerValue] : 5000;
+	_generator.maximumDepth = environment[@"BENCHMARK_MAXIMUM_DEPTH"] ? [environment[@"BENCHMARK_MAXIMUM_DEPTH"] integerValue] : 6;
+	_generator.textureCount = environment[@"BENCHMARK_TEXTURE_COUNT"] ? [environment[@"BENCHMARK_TEXTURE_COUNT"] integerValue] : 16;
+	_generator.seed = environment[@"BENCHMARK_SEED"] ? (uint32_t)[environment[@"BENCHMARK_SEED"] longLongValue] : 1;
+	_scene = [_generator scene];
+
+	_sceneFile = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"Benchmark-%@.sks", [[NSUUID UUID] UUIDString]]];
+	[[SceneArchive archivedDataWithRootObject:_scene format:NSPropertyListBinaryFormat_v1_0] writeToFile:_sceneFile atomically:YES];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:_sceneFile error:NULL];
+	[super tearDown];
+}
+
+#pragma mark Results
+
++ (NSString *)resultsPath {
+	NSString *path = [[NSProcessInfo processInfo] environment][@"BENCHMARK_RESULTS_PATH"];
+	return path ?: [NSTemporaryDirectory() stringByAppendingPathComponent:kResultsFileName];
+}
+
++ (NSString *)baselinesPath {
+	NSString *path = [[NSProcessInfo processInfo] environment][@"BENCHMARK_BASELINES_PATH"];
+	return path ?: [[NSBundle bundleForClass:self] pathForResource:[kBaselinesFileName stringByDeletingPathExtension] ofType:[kBaselinesFileName pathExtension]];
+}
+
++ (NSString *)recordedBaselinesPath {
+	/* The bundled copy is never written to, the recorded baselines are checked in by hand */
+	NSString *path = [[NSProcessInfo processInfo] environment][@"BENCHMARK_BASELINES_PATH"];
+	return path ?: [[[self resultsPath] stringByDeletingLastPathComponent] stringByAppendingPathComponent:kRecordedBaselinesFileName];
+}
+
++ (NSMutableDictionary *)JSONObjectWithContentsOfFile:(NSString *)path {
+	NSData *data = [NSData dataWithContentsOfFile:path];
+	id object = data ? [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingMutableContainers error:NULL] : nil;
+	return [object isKindOfClass:[NSMutableDictionary class]] ? object : [NSMutableDictionary dictionary];
+}
+
++ (void)writeJSONObject:(id)object toFile:(NSString *)path {
+	NSData *data = [NSJSONSerialization dataWithJSONObject:object options:NSJSONWritingPrettyPrinted error:NULL];
+	[data writeToFile:path atomically:YES];
+}
+
+- (NSDictionary *)settings {
+	return @{@"nodeCount": @(_generator.nodeCount),
+			 @"maximumDepth": @(_generator.maximumDepth),
+			 @"textureCount": @(_generator.textureCount),
+			 @"seed": @(_generator.seed)};
+}
+
+- (void)recordBenchmark:(NSString *)name durations:(NSArray *)durations {
+	NSArray *sorted = [durations sortedArrayUsingSelector:@selector(compare:)];
+	double median = [sorted[sorted.count / 2] doubleValue];
+
+	NSMutableDictionary *result = [@{@"median": @(median),
+									 @"minimum": sorted.firstObject,
+									 @"maximum": sorted.lastObject,
+									 @"iterations": @(sorted.count)} mutableCopy];
+
+	BOOL isRecording = [[[NSProcessInfo processInfo] environment][@"BENCHMARK_RECORD_BASELINES"] boolValue];
+	NSString *baselinesPath = isRecording ? [[self class] recordedBaselinesPath] : [[self class] baselinesPath];
+	NSMutableDictionary *baselines = [[self class] JSONObjectWithContentsOfFile:baselinesPath];
+	NSMutableDictionary *baselineBenchmarks = baselines[@"benchmarks"] ?: [NSMutableDictionary dictionary];
+	double threshold = baselines[@"threshold"] ? [baselines[@"threshold"] doubleValue] : kDefaultThreshold;
+
+	/* Baselines are only comparable when they were measured over the same scene */
+	NSDictionary *baseline = baselineBenchmarks[name];
+	BOOL isComparable = baseline && [baselines[@"settings"] isEqual:[self settings]];
+
+	if (isRecording) {
+		baselineBenchmarks[name] = @{@"median": @(median)};
+		baselines[@"benchmarks"] = baselineBenchmarks;
+		baselines[@"settings"] = [self settings];
+		baselines[@"threshold"] = @(threshold);
+		[[self class] writeJSONObject:baselines toFile:baselinesPath];
+
+	} else if (isComparable) {
+		double baselineMedian = [baseline[@"median"] doubleValue];
+		double change = baselineMedian > 0 ? median / baselineMedian - 1 : 0;
+		BOOL regressed = change > threshold;
+
+		result[@"baseline"] = @(baselineMedian);
+		result[@"change"] = @(change);
+		result[@"regressed"] = @(regressed);
+
+		if (regressed) {
+			XCTFail(@"%@ regressed by %.0f%%: %.2f ms against a baseline of %.2f ms", name, change * 100, median * 1000, baselineMedian * 1000);
+		}
+
+	} else {
+		/* Nothing to compare with yet, machines differ too much to ship one set of baselines */
+		result[@"regressed"] = @NO;
+		NSLog(@"%@ has no baseline measured over %@ in %@, record one with BENCHMARK_RECORD_BASELINES=1", name, [self settings], baselinesPath);
+	}
+
+	/* Every benchmark adds its entry, the file ends up with the results of the whole run */
+	NSString *resultsPath = [[self class] resultsPath];
+	NSMutableDictionary *results = [[self class] JSONObjectWithContentsOfFile:resultsPath];
+	NSMutableDictionary *benchmarks = results[@"benchmarks"] ?: [NSMutableDictionary dictionary];
+	benchmarks[name] = result;
+	results[@"benchmarks"] = benchmarks;
+	results[@"settings"] = [self settings];
+	results[@"threshold"] = @(threshold);
+	results[@"date"] = [[NSDate date] description];
+	[[self class] writeJSONObject:results toFile:resultsPath];
+
+	NSLog(@"%@: %.2f ms", name, median * 1000);
+}
+
+- (void)measureBenchmark:(NSString *)name block:(void (^)(void))block {
+	[self measureBenchmark:name setUp:nil block:block];
+}
+
+- (void)measureBenchmark:(NSString *)name setUp:(void (^)(void))setUpBlock block:(void (^)(void))block {
+	/* Only the block is measured, the set up runs before every iteration */
+	NSMutableArray *durations = [NSMutableArray array];
+	[self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+		if (setUpBlock) {
+			setUpBlock();
+		}
+
+		[self startMeasuring];
+		CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+		block();
+		[durations addObject:@(CFAbsoluteTimeGetCurrent() - startTime)];
+		[self stopMeasuring];
+	}];
+	[self recordBenchmark:name durations:durations];
+}
+
+#pragma mark Helpers
+
+- (NSArray *)nodesOfClass:(Class)nodeClass {
+	NSMutableArray *nodes = [NSMutableArray array];
+	[_scene enumerateChildNodesWithName:@"//*" usingBlock:^(SKNode *node, BOOL *stop) {
+		if ([node isMemberOfClass:nodeClass]) {
+			[nodes addObject:node];
+		}
+	}];
+	return nodes;
+}
+
+- (NSUInteger)countNavigationNodes:(NavigationNode *)navigationNode {
+	NSUInteger count = 1;
+	for (NavigationNode *child in navigationNode.children) {
+		count += [self countNavigationNodes:child];
+	}
+	return count;
+}
+
+- (BOOL)waitForSelectionPaint {
+	NSTimeInterval previousDuration = _appDelegate.selectionPaintDuration;
+	NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:5];
+	while (_appDelegate.selectionPaintDuration == previousDuration && [timeout timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.001]];
+	}
+	return _appDelegate.selectionPaintDuration != previousDuration;
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceUnarchiveScene {
+	__block NSUInteger nodeCount = 0;
+	[self measureBenchmark:@"unarchiveScene" block:^{
+		SKScene *scene = [_appDelegate unarchiveFromFile:_sceneFile error:NULL];
+		nodeCount = [scene objectForKeyedSubscript:@"//*"].count;
+	}];
+	XCTAssertEqual(nodeCount, _generator.nodeCount);
+}
+
+- (void)testPerformanceArchiveScene {
+	NSString *file = [_sceneFile stringByAppendingString:@".saved"];
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+
+	[self measureBenchmark:@"archiveScene" block:^{
+		[fileManager removeItemAtPath:file error:NULL];
+
+		/* The result comes once the background writing is done */
+		__block BOOL finished = NO;
+		[_appDelegate archiveScene:_scene toFile:file completionHandler:^(NSError *error) {
+			XCTAssertNil(error);
+			finished = YES;
+		}];
+		NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:30];
+		while (!finished && [timeout timeIntervalSinceNow] > 0) {
+			[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.001]];
+		}
+		XCTAssertTrue(finished);
+	}];
+
+	XCTAssertTrue([fileManager fileExistsAtPath:file]);
+	[fileManager removeItemAtPath:file error:NULL];
+}
+
+- (void)testPerformanceInspectorAttributes {
+	/* One node of each class, the way selecting them in turn builds the inspector */
+	NSMutableArray *nodes = [NSMutableArray array];
+	for (Class nodeClass in _generator.nodeClasses) {
+		SKNode *node = [self nodesOfClass:nodeClass].firstObject;
+		if (node) {
+			[nodes addObject:node];
+		}
+	}
+
+	[self measureBenchmark:@"inspectorAttributes" block:^{
+		for (SKNode *node in nodes) {
+			NSDictionary *snapshot = [_appDelegate attributeSnapshotWithNode:node class:[node class]];
+			[_appDelegate attributesForAllClassesWithNode:node snapshot:snapshot];
+		}
+	}];
+}
+
+- (void)testPerformanceHitTesting {
+	EditorView *editorView = [[EditorView alloc] initWithFrame:NSMakeRect(0, 0, 1024, 768)];
+	editorView.scene = _scene;
+
+	[self measureBenchmark:@"hitTesting" block:^{
+		for (NSUInteger y = 0; y < 16; ++y) {
+			for (NSUInteger x = 0; x < 16; ++x) {
+				CGPoint point = CGPointMake((x + 0.5) * _scene.size.width / 16, (y + 0.5) * _scene.size.height / 16);
+				[editorView nodesContainingPoint:point inNode:_scene];
+			}
+		}
+	}];
+
+	editorView.scene = nil;
+}
+
+- (void)testPerformanceNavigationTree {
+	__block NSUInteger count = 0;
+	[self measureBenchmark:@"navigationTree" block:^{
+		count = [self countNavigationNodes:[NavigationNode navigationNodeWithNode:_scene]];
+	}];
+	XCTAssertEqual(count, _generator.nodeCount + 1);
+}
+
+- (void)testPerformanceCopyPaste {
+	/* The largest branch of the scene, copied and pasted back */
+	SKNode *subtree = nil;
+	NSUInteger subtreeCount = 0;
+	for (SKNode *child in _scene.children) {
+		NSUInteger count = [child objectForKeyedSubscript:@"//*"].count;
+		if (!subtree || count > subtreeCount) {
+			subtree = child;
+			subtreeCount = count;
+		}
+	}
+
+	__block NSArray *pasted = nil;
+	[self measureBenchmark:@"copyPaste" block:^{
+		NSData *data = [NodeClipboard dataWithNode:subtree expansionInfo:nil];
+		pasted = [NodeClipboard nodesWithData:data count:1 expansionInfo:NULL error:NULL];
+	}];
+	XCTAssertEqual(pasted.count, 1);
+}
+
+- (void)testPerformanceEmitterSelectionToFirstPaint {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	SKEmitterNode *emitter = [SKEmitterNode node];
+	[scene addChild:emitter];
+
+	/* Load the scene the way opening a document does */
+	[_appDelegate useScene:scene];
+
+	/* Only the time from selecting the emitter to painting its inspector is recorded */
+	NSMutableArray *durations = [NSMutableArray array];
+	[self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+		[_appDelegate updateSelectionWithNode:scene];
+		[self waitForSelectionPaint];
+
+		[self startMeasuring];
+		[_appDelegate updateSelectionWithNode:emitter];
+		XCTAssertTrue([self waitForSelectionPaint]);
+		[self stopMeasuring];
+		[durations addObject:@(_appDelegate.selectionPaintDuration)];
+	}];
+	[self recordBenchmark:@"emitterSelectionToFirstPaint" durations:durations];
+}
+
+- (void)testPerformancePopulateMediaLibrary {
+	/* The library is only rebuilt when the scene bundle changes, so every iteration starts from a closed scene */
+	NSBundle *bundle = [NSBundle mainBundle];
+	[self measureBenchmark:@"populateMediaLibrary" setUp:^{
+		[_appDelegate useSceneBundle:nil];
+	} block:^{
+		/* The bundle is listed and the thumbnails decoded in the background, after the first run they come from the cache */
+		[_appDelegate useSceneBundle:bundle];
+		NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:30];
+		while (![_appDelegate isMediaLibraryLoaded] && [timeout timeIntervalSinceNow] > 0) {
+			[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.001]];
+		}
+		XCTAssertTrue([_appDelegate isMediaLibraryLoaded]);
+	}];
+
+	/* Stop watching the bundle and drop its textures and thumbnails, the way closing the scene does */
+	[_appDelegate useSceneBundle:nil];
+}
+
+@end
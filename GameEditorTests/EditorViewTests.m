@@ -0,0 +1,213 @@
+//
+//  EditorViewTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "EditorView.h"
+#import "AttributeSchema.h"
+#import "NavigationNode.h"
+#import "UndoJournal.h"
+
+@interface EditorView (EditorViewTests)
+- (UndoJournal *)undoJournal;
+@end
+
+@interface EditorViewTests : XCTestCase
+
+@end
+
+@implementation EditorViewTests {
+	EditorView *_editorView;
+	SKScene *_scene;
+	SKEmitterNode *_emitter;
+}
+
+- (void)setUp {
+	[super setUp];
+	_scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	_emitter = [SKEmitterNode node];
+	[_scene addChild:_emitter];
+
+	_editorView = [[EditorView alloc] initWithFrame:NSMakeRect(0, 0, 1024, 768)];
+	_editorView.scene = _scene;
+	_editorView.node = _emitter;
+}
+
+- (void)tearDown {
+	_editorView.node = nil;
+	_editorView = nil;
+	[super tearDown];
+}
+
+- (void)spinRunLoop {
+	[[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+}
+
+- (NSEvent *)mouseEventWithType:(NSEventType)type location:(CGPoint)location modifierFlags:(NSEventModifierFlags)flags {
+	return [NSEvent mouseEventWithType:type location:location modifierFlags:flags timestamp:0 windowNumber:0 context:nil eventNumber:0 clickCount:1 pressure:1];
+}
+
+- (void)dragFrom:(CGPoint)from to:(CGPoint)to modifierFlags:(NSEventModifierFlags)flags {
+	/* The scene has the size of the view, view and scene coordinates are the same */
+	[_editorView mouseDown:[self mouseEventWithType:NSLeftMouseDown location:from modifierFlags:flags]];
+	[_editorView mouseDragged:[self mouseEventWithType:NSLeftMouseDragged location:from modifierFlags:flags]];
+	[_editorView mouseDragged:[self mouseEventWithType:NSLeftMouseDragged location:to modifierFlags:flags]];
+	[_editorView mouseUp:[self mouseEventWithType:NSLeftMouseUp location:to modifierFlags:flags]];
+}
+
+#pragma mark Tests
+
+- (void)testSelectionObservesOnlyGeometry {
+	NSUInteger allKeyCount = [AttributeSchema schemaForClass:[SKEmitterNode class]].allPropertyNames.count;
+	NSLog(@"Observing %lu keys instead of %lu", (unsigned long)_editorView.observedKeyCount, (unsigned long)allKeyCount);
+
+	XCTAssertGreaterThan(_editorView.observedKeyCount, 0);
+	XCTAssertLessThan(_editorView.observedKeyCount, allKeyCount);
+
+	/* Changing a property outside of the geometry isn't observed */
+	NSUInteger changeCount = _editorView.observedChangeCount;
+	_emitter.particleBirthRate = 100;
+	XCTAssertEqual(_editorView.observedChangeCount, changeCount);
+
+	_emitter.position = CGPointMake(10, 20);
+	XCTAssertEqual(_editorView.observedChangeCount, changeCount + 1);
+}
+
+- (void)testChangesAreCoalescedIntoOneUpdate {
+	[self spinRunLoop];
+	NSUInteger changeCount = _editorView.observedChangeCount;
+	NSUInteger updateCount = _editorView.selectionUpdateCount;
+
+	/* What a drag event does to the selected node */
+	for (NSUInteger i = 1; i <= 10; ++i) {
+		_emitter.position = CGPointMake(i, i);
+		_emitter.zRotation = 0.1 * i;
+	}
+	XCTAssertTrue(CGPointEqualToPoint(_editorView.position, CGPointMake(10, 10)));
+	[self spinRunLoop];
+
+	XCTAssertEqual(_editorView.observedChangeCount - changeCount, 20);
+	XCTAssertEqual(_editorView.selectionUpdateCount - updateCount, 1);
+}
+
+- (void)testRenamingInTheNavigatorIsJournaled {
+	_emitter.name = @"Before";
+	NavigationNode *navigationNode = [NavigationNode navigationNodeWithNode:_emitter];
+	navigationNode.name = @"After";
+	[self spinRunLoop];
+
+	UndoJournal *journal = [_editorView undoJournal];
+	XCTAssertEqual(journal.groupCount, 1);
+	[journal revertGroup:journal.groupCount - 1];
+	XCTAssertEqualObjects(_emitter.name, @"Before");
+}
+
+- (void)testMovedSelectionIsHitRightAway {
+	_emitter.position = CGPointMake(500, 500);
+
+	/* No run loop iteration between the change and the click */
+	XCTAssertTrue([[_editorView nodesContainingPoint:CGPointMake(500, 500) inNode:_scene] containsObject:_emitter]);
+	XCTAssertFalse([[_editorView nodesContainingPoint:CGPointZero inNode:_scene] containsObject:_emitter]);
+}
+
+- (void)testHitsAreInSceneOrder {
+	/* Added so that the proxies are created in the reverse of the scene's order */
+	SKSpriteNode *back = [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(4096, 4096)];
+	SKSpriteNode *front = [SKSpriteNode spriteNodeWithColor:[NSColor blueColor] size:CGSizeMake(4096, 4096)];
+	SKSpriteNode *child = [SKSpriteNode spriteNodeWithColor:[NSColor greenColor] size:CGSizeMake(4096, 4096)];
+	[_scene addChild:front];
+	[_editorView updateIndexForNode:front];
+	[front addChild:child];
+	[_editorView updateIndexForNode:child];
+	[_scene insertChild:back atIndex:0];
+	[_editorView updateIndexForNode:back];
+
+	NSArray *sprites = @[back, front, child];
+	NSArray *hits = [[_editorView nodesContainingPoint:NSMakePoint(512, 384) inNode:_scene] filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF IN %@", sprites]];
+	XCTAssertEqualObjects(hits, sprites);
+
+	/* Removed nodes are no longer hit, their children neither */
+	[_editorView removeIndexForNode:front];
+	[front removeFromParent];
+	hits = [[_editorView nodesContainingPoint:NSMakePoint(512, 384) inNode:_scene] filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF IN %@", sprites]];
+	XCTAssertEqualObjects(hits, @[back]);
+}
+
+- (void)testScalingRotatedNodesScalesAlongTheSceneAxes {
+	/* The children of a parent turned a quarter, their x axis goes up in the scene */
+	SKNode *parent = [SKNode node];
+	parent.position = CGPointMake(100, 100);
+	parent.zRotation = M_PI_2;
+	[_scene addChild:parent];
+	SKSpriteNode *first = [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(40, 20)];
+	first.position = CGPointMake(300, -300);
+	[parent addChild:first];
+	SKSpriteNode *second = [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(40, 20)];
+	second.position = CGPointMake(300, -500);
+	[parent addChild:second];
+	[_editorView updateIndexForNode:parent];
+
+	[self dragFrom:CGPointMake(350, 350) to:CGPointMake(650, 450) modifierFlags:NSShiftKeyMask];
+	XCTAssertEqual(_editorView.selectedNodes.count, 2);
+
+	/* Drag the right handle of the selection, from 390...610 to 390...830 */
+	[self dragFrom:CGPointMake(610, 400) to:CGPointMake(830, 400) modifierFlags:0];
+
+	for (SKSpriteNode *node in @[first, second]) {
+		XCTAssertEqualWithAccuracy(node.zRotation, 0, 1e-6);
+		XCTAssertEqualWithAccuracy(node.xScale, 1, 1e-6);
+		XCTAssertEqualWithAccuracy(node.yScale, 2, 1e-6);
+	}
+	CGPoint position = [_scene convertPoint:CGPointZero fromNode:second];
+	XCTAssertEqualWithAccuracy(position.x, 810, 1e-3);
+	XCTAssertEqualWithAccuracy(position.y, 400, 1e-3);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceMarqueeSelectionIn50kNodes {
+	/* Small sprites all over the scene, a few thousands of them under the marquee at the end of the drag */
+	srand48(1);
+	for (NSUInteger i = 0; i < 50000; ++i) {
+		SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(4, 4)];
+		sprite.position = CGPointMake(drand48() * _scene.size.width, drand48() * _scene.size.height);
+		[_scene addChild:sprite];
+	}
+	[_editorView updateIndexForNode:_scene];
+
+	/* The drag events and the release, which sorts the selected nodes in the scene's order */
+	[self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+		[_editorView mouseDown:[self mouseEventWithType:NSLeftMouseDown location:CGPointMake(10, 10) modifierFlags:NSShiftKeyMask]];
+		[_editorView mouseDragged:[self mouseEventWithType:NSLeftMouseDragged location:CGPointMake(10, 10) modifierFlags:NSShiftKeyMask]];
+
+		[self startMeasuring];
+		for (NSUInteger i = 1; i <= 100; ++i) {
+			[_editorView mouseDragged:[self mouseEventWithType:NSLeftMouseDragged location:CGPointMake(10 + 2 * i, 10 + 2 * i) modifierFlags:NSShiftKeyMask]];
+		}
+		[_editorView mouseUp:[self mouseEventWithType:NSLeftMouseUp location:CGPointMake(210, 210) modifierFlags:NSShiftKeyMask]];
+		[self stopMeasuring];
+
+		XCTAssertGreaterThan(_editorView.selectedNodes.count, 1);
+		_editorView.node = _scene;
+	}];
+}
+
+- (void)testPerformanceSelectionSwitch {
+	NSMutableArray *emitters = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 1000; ++i) {
+		SKEmitterNode *emitter = [SKEmitterNode node];
+		[_scene addChild:emitter];
+		[emitters addObject:emitter];
+	}
+
+	[self measureBlock:^{
+		for (SKNode *emitter in emitters) {
+			_editorView.node = emitter;
+		}
+	}];
+}
+
+@end
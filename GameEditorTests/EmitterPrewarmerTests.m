@@ -0,0 +1,163 @@
+//
+//  EmitterPrewarmerTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "EmitterPrewarmer.h"
+
+static const NSUInteger kEmitterCount = 200;
+
+@interface EmitterPrewarmerTests : XCTestCase
+
+@end
+
+@implementation EmitterPrewarmerTests
+
+#pragma mark Helpers
+
+- (SKScene *)sceneWithEmitterCount:(NSUInteger)count {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	for (NSUInteger i = 0; i < count; ++i) {
+		SKEmitterNode *emitter = [[SKEmitterNode alloc] init];
+		emitter.name = [NSString stringWithFormat:@"emitter %lu", (unsigned long)i];
+		emitter.particleBirthRate = 200;
+		emitter.particleLifetime = 4;
+		emitter.particleSpeed = 50 + i;
+		emitter.position = CGPointMake(i % 32 * 32, i / 32 * 32);
+		[scene addChild:emitter];
+	}
+	return scene;
+}
+
+#pragma mark Tests
+
+- (void)testConfigurationFollowsTheParameters {
+	SKEmitterNode *emitter = [[self sceneWithEmitterCount:1].children firstObject];
+	SKEmitterNode *other = [[self sceneWithEmitterCount:1].children firstObject];
+
+	XCTAssertEqualObjects([EmitterPrewarmer configurationOfEmitter:emitter], [EmitterPrewarmer configurationOfEmitter:other]);
+
+	/* Where the emitter is and how it's named don't change its particles */
+	other.name = @"other";
+	other.position = CGPointMake(100, 200);
+	other.zRotation = 1;
+	XCTAssertEqualObjects([EmitterPrewarmer configurationOfEmitter:emitter], [EmitterPrewarmer configurationOfEmitter:other]);
+
+	other.particleBirthRate = 10;
+	XCTAssertNotEqualObjects([EmitterPrewarmer configurationOfEmitter:emitter], [EmitterPrewarmer configurationOfEmitter:other]);
+}
+
+- (void)testReopenedEmittersAreNotSimulatedAgain {
+	EmitterPrewarmer *prewarmer = [[EmitterPrewarmer alloc] init];
+
+	SKScene *scene = [self sceneWithEmitterCount:10];
+	NSArray *emitters = scene.children;
+	[prewarmer prewarmEmittersInNode:scene];
+	XCTAssertEqual(prewarmer.simulatedEmitterCount, 10);
+	XCTAssertEqual(prewarmer.reusedEmitterCount, 0);
+	[prewarmer waitForPendingEmitters];
+
+	/* One of the emitters was changed in the file since the last open */
+	SKScene *reopenedScene = [self sceneWithEmitterCount:10];
+	[reopenedScene.children[3] setParticleBirthRate:10];
+	NSArray *names = [reopenedScene.children valueForKey:@"name"];
+
+	[prewarmer prewarmEmittersInNode:reopenedScene];
+	XCTAssertEqual(prewarmer.simulatedEmitterCount, 1);
+	XCTAssertEqual(prewarmer.reusedEmitterCount, 9);
+
+	/* The warm emitters take the place of the opened ones, the scene opened before is left alone */
+	XCTAssertEqualObjects([reopenedScene.children valueForKey:@"name"], names);
+	XCTAssertEqual([reopenedScene.children[3] particleBirthRate], 10);
+	XCTAssertEqualObjects(scene.children, emitters);
+	for (SKEmitterNode *emitter in reopenedScene.children) {
+		XCTAssertFalse([emitters containsObject:emitter]);
+	}
+}
+
+- (void)testEditsAfterOpeningDontReachTheWarmEmitters {
+	EmitterPrewarmer *prewarmer = [[EmitterPrewarmer alloc] init];
+
+	SKScene *scene = [self sceneWithEmitterCount:2];
+	[prewarmer prewarmEmittersInNode:scene];
+	[prewarmer waitForPendingEmitters];
+
+	/* Edited in the editor after the scene was opened, the file still has the old parameters */
+	[scene.children[0] setParticleSpeed:500];
+
+	SKScene *reopenedScene = [self sceneWithEmitterCount:2];
+	[prewarmer prewarmEmittersInNode:reopenedScene];
+	XCTAssertEqual(prewarmer.simulatedEmitterCount, 0);
+	XCTAssertEqual(prewarmer.reusedEmitterCount, 2);
+	XCTAssertEqual([reopenedScene.children[0] particleSpeed], 50);
+}
+
+- (void)testIdenticalEmittersShareTheirWarmEmitter {
+	EmitterPrewarmer *prewarmer = [[EmitterPrewarmer alloc] init];
+
+	/* The same emitter placed four times is warmed once for the next open */
+	SKScene *scene = [self sceneWithEmitterCount:4];
+	for (SKEmitterNode *emitter in scene.children) {
+		emitter.particleSpeed = 50;
+	}
+	[prewarmer prewarmEmittersInNode:scene];
+	[prewarmer waitForPendingEmitters];
+
+	/* Reopened somewhere else, the warm emitter takes the name and the place of the opened one */
+	SKScene *reopenedScene = [self sceneWithEmitterCount:1];
+	SKEmitterNode *emitter = reopenedScene.children.firstObject;
+	emitter.particleSpeed = 50;
+	emitter.name = @"moved";
+	emitter.position = CGPointMake(300, 400);
+
+	[prewarmer prewarmEmittersInNode:reopenedScene];
+	XCTAssertEqual(prewarmer.simulatedEmitterCount, 0);
+	XCTAssertEqual(prewarmer.reusedEmitterCount, 1);
+
+	SKEmitterNode *warmEmitter = reopenedScene.children.firstObject;
+	XCTAssertNotEqual(warmEmitter, emitter);
+	XCTAssertEqualObjects(warmEmitter.name, @"moved");
+	XCTAssertTrue(CGPointEqualToPoint(warmEmitter.position, CGPointMake(300, 400)));
+}
+
+- (void)testRemovedEmittersAreNotReused {
+	EmitterPrewarmer *prewarmer = [[EmitterPrewarmer alloc] init];
+	[prewarmer prewarmEmittersInNode:[self sceneWithEmitterCount:4]];
+	[prewarmer removeAllEmitters];
+	[prewarmer waitForPendingEmitters];
+
+	[prewarmer prewarmEmittersInNode:[self sceneWithEmitterCount:4]];
+	XCTAssertEqual(prewarmer.simulatedEmitterCount, 4);
+	XCTAssertEqual(prewarmer.reusedEmitterCount, 0);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformancePrewarm {
+	[self measureBlock:^{
+		EmitterPrewarmer *prewarmer = [[EmitterPrewarmer alloc] init];
+		[prewarmer prewarmEmittersInNode:[self sceneWithEmitterCount:kEmitterCount]];
+	}];
+}
+
+- (void)testPerformanceReopen {
+	EmitterPrewarmer *prewarmer = [[EmitterPrewarmer alloc] init];
+	[prewarmer prewarmEmittersInNode:[self sceneWithEmitterCount:kEmitterCount]];
+
+	/* Only the open is measured, the emitters for the next one are warmed in the background */
+	[self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+		[prewarmer waitForPendingEmitters];
+		SKScene *scene = [self sceneWithEmitterCount:kEmitterCount];
+
+		[self startMeasuring];
+		[prewarmer prewarmEmittersInNode:scene];
+		[self stopMeasuring];
+
+		XCTAssertEqual(prewarmer.reusedEmitterCount, kEmitterCount);
+	}];
+}
+
+@end
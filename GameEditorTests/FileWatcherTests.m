@@ -0,0 +1,137 @@
+//
+//  FileWatcherTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import "FileWatcher.h"
+
+@interface FileWatcherTests : XCTestCase
+
+@end
+
+@implementation FileWatcherTests {
+	NSString *_temporaryDirectory;
+	NSMutableArray *_changes;
+	FileWatcher *_watcher;
+}
+
+- (void)setUp {
+	[super setUp];
+	_temporaryDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+	[[NSFileManager defaultManager] createDirectoryAtPath:_temporaryDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+	_changes = [NSMutableArray array];
+}
+
+- (void)tearDown {
+	[_watcher stop];
+	[[NSFileManager defaultManager] removeItemAtPath:_temporaryDirectory error:NULL];
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (void)writeFile:(NSString *)name contents:(NSString *)contents {
+	NSString *file = [_temporaryDirectory stringByAppendingPathComponent:name];
+	[[NSFileManager defaultManager] createDirectoryAtPath:[file stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:NULL];
+	[[contents dataUsingEncoding:NSUTF8StringEncoding] writeToFile:file atomically:NO];
+}
+
+- (void)startWatcherWithBackend:(FileWatcherBackend)backend {
+	__weak NSMutableArray *changes = _changes;
+	_watcher = [[FileWatcher alloc] initWithPath:_temporaryDirectory backend:backend handler:^(NSArray *addedFiles, NSArray *removedFiles, NSArray *modifiedFiles) {
+		[changes addObject:@[[addedFiles valueForKey:@"lastPathComponent"],
+							 [removedFiles valueForKey:@"lastPathComponent"],
+							 [modifiedFiles valueForKey:@"lastPathComponent"]]];
+	}];
+	_watcher.latency = 0.1;
+	[_watcher start];
+}
+
+- (NSArray *)nextChange {
+	/* The changes are delivered on the main thread */
+	NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+	while (_changes.count == 0 && [timeout timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+	}
+	XCTAssertGreaterThan(_changes.count, 0);
+	if (_changes.count == 0)
+		return @[@[], @[], @[]];
+
+	NSArray *change = _changes.firstObject;
+	[_changes removeObjectAtIndex:0];
+	return @[[NSSet setWithArray:change[0]], [NSSet setWithArray:change[1]], [NSSet setWithArray:change[2]]];
+}
+
+#pragma mark Tests
+
+- (void)testInitialScanReportsEveryFile {
+	[self writeFile:@"a.png" contents:@"a"];
+	[self writeFile:@"Textures/b.png" contents:@"b"];
+	[self writeFile:@".hidden" contents:@"c"];
+
+	[self startWatcherWithBackend:FileWatcherBackendPolling];
+
+	NSArray *change = [self nextChange];
+	XCTAssertEqualObjects(change[0], ([NSSet setWithObjects:@"a.png", @"b.png", nil]));
+	XCTAssertEqual([change[1] count], 0);
+	XCTAssertEqual([change[2] count], 0);
+}
+
+- (void)testPollingReportsDeltas {
+	[self writeFile:@"a.png" contents:@"a"];
+	[self writeFile:@"b.png" contents:@"b"];
+	[self startWatcherWithBackend:FileWatcherBackendPolling];
+	[self nextChange];
+
+	[self writeFile:@"c.png" contents:@"c"];
+	[self writeFile:@"a.png" contents:@"aa"];
+	[[NSFileManager defaultManager] removeItemAtPath:[_temporaryDirectory stringByAppendingPathComponent:@"b.png"] error:NULL];
+
+	NSArray *change = [self nextChange];
+	XCTAssertEqualObjects(change[0], [NSSet setWithObject:@"c.png"]);
+	XCTAssertEqualObjects(change[1], [NSSet setWithObject:@"b.png"]);
+	XCTAssertEqualObjects(change[2], [NSSet setWithObject:@"a.png"]);
+}
+
+- (void)testRemovingADirectoryRemovesItsFiles {
+	[self writeFile:@"Textures/a.png" contents:@"a"];
+	[self writeFile:@"Textures/More/b.png" contents:@"b"];
+	[self startWatcherWithBackend:FileWatcherBackendPolling];
+	[self nextChange];
+
+	[[NSFileManager defaultManager] removeItemAtPath:[_temporaryDirectory stringByAppendingPathComponent:@"Textures"] error:NULL];
+
+	NSArray *change = [self nextChange];
+	XCTAssertEqualObjects(change[1], ([NSSet setWithObjects:@"a.png", @"b.png", nil]));
+}
+
+- (void)testFSEventsReportsNewFiles {
+	[self writeFile:@"a.png" contents:@"a"];
+	[self startWatcherWithBackend:FileWatcherBackendFSEvents];
+	[self nextChange];
+
+	[self writeFile:@"Textures/b.png" contents:@"b"];
+
+	NSArray *change = [self nextChange];
+	XCTAssertEqualObjects(change[0], [NSSet setWithObject:@"b.png"]);
+}
+
+- (void)testFSEventsWatcherGoesAwayWithEventsPending {
+	[self startWatcherWithBackend:FileWatcherBackendFSEvents];
+	[self nextChange];
+
+	/* Release the watcher without stopping it while the stream has events to deliver */
+	for (NSUInteger i = 0; i < 20; ++i) {
+		[self writeFile:[NSString stringWithFormat:@"%lu.png", (unsigned long)i] contents:@"a"];
+	}
+	__weak FileWatcher *weakWatcher = _watcher;
+	_watcher = nil;
+
+	[[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+	XCTAssertNil(weakWatcher);
+	XCTAssertEqual(_changes.count, 0);
+}
+
+@end
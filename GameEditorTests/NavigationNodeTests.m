@@ -0,0 +1,314 @@
+//
+//  NavigationNodeTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "NavigationNode.h"
+
+@interface NavigationNodeTests : XCTestCase
+
+@end
+
+@implementation NavigationNodeTests {
+	uint32_t _seed;
+}
+
+- (NSUInteger)randomIndex:(NSUInteger)count {
+	/* Deterministic LCG so that every run exercises the same moves */
+	_seed = _seed * 1664525 + 1013904223;
+	return (_seed >> 8) % count;
+}
+
+- (SKScene *)sceneWithNodeCount:(NSUInteger)nodeCount {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	NSMutableArray *nodes = [NSMutableArray arrayWithObject:scene];
+	while (nodes.count < nodeCount) {
+		SKNode *node = [SKNode node];
+		node.name = [NSString stringWithFormat:@"node%lu", (unsigned long)nodes.count];
+		[nodes[[self randomIndex:nodes.count]] addChild:node];
+		[nodes addObject:node];
+	}
+	return scene;
+}
+
+- (void)collectNavigationNodes:(NSMutableArray *)array parents:(NSMutableArray *)parents inNavigationNode:(NavigationNode *)navigationNode parent:(id)parent {
+	[array addObject:navigationNode];
+	[parents addObject:parent];
+	for (NavigationNode *child in navigationNode.children) {
+		[self collectNavigationNodes:array parents:parents inNavigationNode:child parent:navigationNode];
+	}
+}
+
+- (void)verifyMapWithRoot:(NavigationNode *)root {
+	NSMutableArray *navigationNodes = [NSMutableArray array];
+	NSMutableArray *parents = [NSMutableArray array];
+	[self collectNavigationNodes:navigationNodes parents:parents inNavigationNode:root parent:[NSNull null]];
+
+	for (NSUInteger i = 0; i < navigationNodes.count; ++i) {
+		NavigationNode *navigationNode = navigationNodes[i];
+		XCTAssertEqual([NavigationNode navigationNodeForNode:navigationNode.node], navigationNode);
+		XCTAssertEqual(navigationNode.parent ?: (id)[NSNull null], parents[i]);
+		XCTAssertEqual(navigationNode.node.parent, navigationNode.parent.node);
+	}
+}
+
+- (BOOL)navigationNode:(NavigationNode *)navigationNode isDescendantOf:(NavigationNode *)ancestor {
+	for (; navigationNode; navigationNode = navigationNode.parent) {
+		if (navigationNode == ancestor)
+			return YES;
+	}
+	return NO;
+}
+
+- (void)testRandomReparentingMatchesFullScan {
+	_seed = 1;
+	SKScene *scene = [self sceneWithNodeCount:2000];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+
+	[self verifyMapWithRoot:root];
+
+	NSMutableArray *navigationNodes = [NSMutableArray array];
+	[self collectNavigationNodes:navigationNodes parents:[NSMutableArray array] inNavigationNode:root parent:[NSNull null]];
+
+	for (NSUInteger i = 0; i < 2000; ++i) {
+		NavigationNode *navigationNode = navigationNodes[1 + [self randomIndex:navigationNodes.count - 1]];
+		NavigationNode *newParent = navigationNodes[[self randomIndex:navigationNodes.count]];
+		if ([self navigationNode:newParent isDescendantOf:navigationNode])
+			continue;
+
+		/* Move the node the same way the tree controller does it, through the children collection */
+		NavigationNode *oldParent = navigationNode.parent;
+		[[oldParent mutableArrayValueForKey:@"children"] removeObjectIdenticalTo:navigationNode];
+		XCTAssertNil(navigationNode.parent);
+
+		NSMutableArray *children = [newParent mutableArrayValueForKey:@"children"];
+		[children insertObject:navigationNode atIndex:[self randomIndex:children.count + 1]];
+		XCTAssertEqual(navigationNode.parent, newParent);
+
+		if (i % 100 == 0) {
+			[self verifyMapWithRoot:root];
+		}
+	}
+
+	[self verifyMapWithRoot:root];
+}
+
+- (void)testLookupLoadsTheAncestorsOnDemand {
+	_seed = 3;
+	SKScene *scene = [self sceneWithNodeCount:2000];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+
+	/* Find the deepest node of the scene */
+	__block SKNode *deepestNode = scene;
+	__block NSUInteger maxDepth = 0;
+	[scene enumerateChildNodesWithName:@"//*" usingBlock:^(SKNode *node, BOOL *stop) {
+		NSUInteger depth = 0;
+		for (SKNode *parent = node.parent; parent; parent = parent.parent) {
+			depth++;
+		}
+		if (depth > maxDepth) {
+			maxDepth = depth;
+			deepestNode = node;
+		}
+	}];
+	XCTAssertGreaterThan(maxDepth, (NSUInteger)2);
+
+	NavigationNode *navigationNode = [NavigationNode navigationNodeForNode:deepestNode];
+	XCTAssertEqual(navigationNode.node, deepestNode);
+
+	/* The parent links lead to the root through the ancestors of the node */
+	SKNode *node = deepestNode;
+	for (; navigationNode.parent; navigationNode = navigationNode.parent) {
+		XCTAssertEqual(navigationNode.node, node);
+		XCTAssertTrue([navigationNode.parent.children containsObject:navigationNode]);
+		node = node.parent;
+	}
+	XCTAssertEqual(navigationNode, root);
+
+	[self verifyMapWithRoot:root];
+}
+
+- (NSSet *)visibleNodesInNavigationNode:(NavigationNode *)navigationNode {
+	NSMutableSet *nodes = [NSMutableSet setWithObject:[NSValue valueWithNonretainedObject:navigationNode.node]];
+	for (NavigationNode *child in navigationNode.children) {
+		[nodes unionSet:[self visibleNodesInNavigationNode:child]];
+	}
+	return nodes;
+}
+
+- (NSSet *)bruteForceVisibleNodesInScene:(SKScene *)scene searchString:(NSString *)searchString {
+	NSMutableSet *nodes = [NSMutableSet setWithObject:[NSValue valueWithNonretainedObject:scene]];
+	[scene enumerateChildNodesWithName:@"//*" usingBlock:^(SKNode *node, BOOL *stop) {
+		/* The name shown in the navigator, the class name only shows for the nodes without name */
+		NSString *name = node.name.length ? node.name : [NSString stringWithFormat:@"<%@>", node.className];
+		if ([name rangeOfString:searchString options:NSCaseInsensitiveSearch].location != NSNotFound) {
+			for (; node; node = node.parent) {
+				[nodes addObject:[NSValue valueWithNonretainedObject:node]];
+			}
+		}
+	}];
+	return nodes;
+}
+
+- (void)testFilterMatchesFullScan {
+	_seed = 4;
+	SKScene *scene = [self sceneWithNodeCount:2000];
+	for (NSUInteger i = 0; i < 20; ++i) {
+		[[scene childNodeWithName:[NSString stringWithFormat:@"//node%lu", (unsigned long)(i * 97 + 1)]] addChild:[SKSpriteNode node]];
+	}
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+
+	for (NSString *searchString in @[@"node12", @"NODE7", @"7", @"de19", @"sknode", @"<skspr", @"zzz"]) {
+		[root setFilterPredicate:[NSPredicate predicateWithFormat:@"name contains[c] %@", searchString]];
+		XCTAssertEqualObjects([self visibleNodesInNavigationNode:root], [self bruteForceVisibleNodesInScene:scene searchString:searchString], @"%@", searchString);
+	}
+
+	/* Case sensitive searches aren't indexed, they still go through the predicate */
+	[root setFilterPredicate:[NSPredicate predicateWithFormat:@"name contains %@", @"NODE7"]];
+	XCTAssertEqual([self visibleNodesInNavigationNode:root].count, (NSUInteger)1);
+
+	/* Renaming a node updates the filtered tree */
+	[root setFilterPredicate:[NSPredicate predicateWithFormat:@"name contains[c] %@", @"renamed"]];
+	XCTAssertEqual([self visibleNodesInNavigationNode:root].count, (NSUInteger)1);
+
+	SKNode *node = [scene childNodeWithName:@"//node1999"];
+	[NavigationNode navigationNodeForNode:node];
+	node.name = @"renamed";
+	XCTAssertEqualObjects([self visibleNodesInNavigationNode:root], [self bruteForceVisibleNodesInScene:scene searchString:@"renamed"]);
+
+	node.name = @"node1999";
+	XCTAssertEqual([self visibleNodesInNavigationNode:root].count, (NSUInteger)1);
+
+	[root setFilterPredicate:nil];
+	XCTAssertEqual([self visibleNodesInNavigationNode:root].count, (NSUInteger)2020);
+}
+
+- (void)testRemovedNodesAreDetached {
+	_seed = 2;
+	SKScene *scene = [self sceneWithNodeCount:100];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+
+	NavigationNode *child = root.children.firstObject;
+	[[root mutableArrayValueForKey:@"children"] removeObjectIdenticalTo:child];
+
+	XCTAssertNil(child.parent);
+	XCTAssertNil(child.node.parent);
+	XCTAssertEqual([NavigationNode navigationNodeForNode:child.node], child);
+	XCTAssertFalse([self navigationNode:child isDescendantOf:root]);
+}
+
+- (SKScene *)sceneWithChildCount:(NSUInteger)childCount {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	for (NSUInteger i = 0; i < childCount; ++i) {
+		SKNode *node = [SKNode node];
+		node.name = [NSString stringWithFormat:@"node%lu", (unsigned long)i];
+		[scene addChild:node];
+	}
+	return scene;
+}
+
+- (void)testIndexedMutationsKeepTheSceneInOrder {
+	SKScene *scene = [self sceneWithChildCount:10];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+	NSMutableArray *children = [root mutableArrayValueForKey:@"children"];
+
+	NavigationNode *inserted = [NavigationNode navigationNodeWithNode:[SKNode node]];
+	[children insertObject:inserted atIndex:3];
+	[children removeObjectAtIndex:7];
+	[children exchangeObjectAtIndex:0 withObjectAtIndex:9];
+	[children replaceObjectAtIndex:5 withObject:[NavigationNode navigationNodeWithNode:[SKNode node]]];
+
+	XCTAssertEqual(scene.children.count, 10);
+	for (NSUInteger i = 0; i < 10; ++i) {
+		XCTAssertEqual(scene.children[i], [root.children[i] node]);
+	}
+	XCTAssertEqual(inserted.parent, root);
+	[self verifyMapWithRoot:root];
+}
+
+- (void)testChildIndexesFollowTheMutations {
+	SKScene *scene = [self sceneWithChildCount:10];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+	NSMutableArray *children = [root mutableArrayValueForKey:@"children"];
+	for (NSUInteger i = 0; i < 10; ++i) {
+		XCTAssertEqual([root indexOfChild:root.children[i]], i);
+	}
+
+	/* The indexes found before the mutations are stale now */
+	NavigationNode *removed = root.children[2];
+	[children insertObject:[NavigationNode navigationNodeWithNode:[SKNode node]] atIndex:0];
+	[children removeObjectIdenticalTo:removed];
+	[children exchangeObjectAtIndex:1 withObjectAtIndex:8];
+
+	for (NSUInteger i = 0; i < 10; ++i) {
+		XCTAssertEqual([root indexOfChild:root.children[i]], i);
+	}
+	XCTAssertEqual([root indexOfChild:removed], NSNotFound);
+}
+
+- (void)testBatchInsertionWhileFilteringUsesTheVisibleIndexes {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	for (NSUInteger i = 0; i < 10; ++i) {
+		SKNode *node = [SKNode node];
+		node.name = [NSString stringWithFormat:@"%@%lu", i % 2 ? @"b" : @"a", (unsigned long)i];
+		[scene addChild:node];
+	}
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+	[root setFilterPredicate:[NSPredicate predicateWithFormat:@"name contains[c] %@", @"a"]];
+
+	NSMutableArray *inserted = [NSMutableArray array];
+	for (NSString *name in @[@"aX", @"aY"]) {
+		SKNode *node = [SKNode node];
+		node.name = name;
+		[inserted addObject:[NavigationNode navigationNodeWithNode:node]];
+	}
+	NSMutableIndexSet *indexes = [NSMutableIndexSet indexSetWithIndex:1];
+	[indexes addIndex:3];
+	[[root mutableArrayValueForKey:@"children"] insertObjects:inserted atIndexes:indexes];
+
+	XCTAssertEqualObjects([root.children valueForKeyPath:@"node.name"], (@[@"a0", @"aX", @"a2", @"aY", @"a4", @"a6", @"a8"]));
+	XCTAssertEqualObjects([scene.children valueForKey:@"name"], (@[@"a0", @"b1", @"aX", @"a2", @"b3", @"aY", @"a4", @"b5", @"a6", @"b7", @"a8", @"b9"]));
+	[root setFilterPredicate:nil];
+	[self verifyMapWithRoot:root];
+}
+
+- (void)testSettingTheChildrenOnlyMovesTheChangedNodes {
+	SKScene *scene = [self sceneWithChildCount:5];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+	NSArray *oldChildren = [root.children copy];
+	NavigationNode *added = [NavigationNode navigationNodeWithNode:[SKNode node]];
+
+	/* The first child moves to the end, the third one is replaced */
+	root.children = [@[oldChildren[1], added, oldChildren[3], oldChildren[4], oldChildren[0]] mutableCopy];
+
+	XCTAssertEqual(scene.children.count, 5);
+	for (NSUInteger i = 0; i < 5; ++i) {
+		XCTAssertEqual(scene.children[i], [root.children[i] node]);
+	}
+	XCTAssertNil([oldChildren[2] parent]);
+	XCTAssertNil([oldChildren[2] node].parent);
+	[self verifyMapWithRoot:root];
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceEditUnderManySiblings {
+	/* Inserting and removing a node shouldn't touch its 10k siblings */
+	SKScene *scene = [self sceneWithChildCount:10000];
+	NavigationNode *root = [NavigationNode navigationNodeWithNode:scene];
+	NSMutableArray *children = [root mutableArrayValueForKey:@"children"];
+	NavigationNode *navigationNode = [NavigationNode navigationNodeWithNode:[SKNode node]];
+
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < 100; ++i) {
+			[children insertObject:navigationNode atIndex:5000];
+			[children removeObjectAtIndex:5000];
+		}
+	}];
+	XCTAssertEqual(scene.children.count, 10000);
+}
+
+@end
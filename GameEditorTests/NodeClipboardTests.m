@@ -0,0 +1,121 @@
+//
+//  NodeClipboardTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "NodeClipboard.h"
+#import "TextureRegistry.h"
+
+static NSString *const kTextureName = @"NodeClipboardTestsTexture";
+
+@interface NodeClipboardTests : XCTestCase
+
+@end
+
+@implementation NodeClipboardTests {
+	SKTexture *_texture;
+}
+
+- (void)setUp {
+	[super setUp];
+	NSImage *image = [[NSImage alloc] initWithSize:NSMakeSize(16, 16)];
+	[image lockFocus];
+	[[NSColor redColor] set];
+	NSRectFill(NSMakeRect(0, 0, 16, 16));
+	[image unlockFocus];
+	_texture = [SKTexture textureWithImage:image];
+	[[TextureRegistry sharedRegistry] registerTexture:_texture withName:kTextureName];
+}
+
+#pragma mark Synthetic subtrees
+
+- (SKNode *)subtreeWithNodeCount:(NSUInteger)nodeCount {
+	/* Groups of eight sprites sharing the registered texture */
+	SKNode *root = [SKNode node];
+	root.name = @"root";
+	NSUInteger count = 1;
+	while (count < nodeCount) {
+		SKNode *group = [SKNode node];
+		group.name = [NSString stringWithFormat:@"group%lu", (unsigned long)count];
+		group.position = CGPointMake(count, 2 * count);
+		[root addChild:group];
+		++count;
+		for (NSUInteger i = 0; i < 8 && count < nodeCount; ++i, ++count) {
+			SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithTexture:_texture];
+			sprite.name = [NSString stringWithFormat:@"sprite%lu", (unsigned long)count];
+			sprite.zRotation = 0.01 * count;
+			[group addChild:sprite];
+		}
+	}
+	return root;
+}
+
+- (void)assertNode:(SKNode *)node equalsNode:(SKNode *)expectedNode {
+	XCTAssertEqualObjects(node.name, expectedNode.name);
+	XCTAssertEqual([node class], [expectedNode class]);
+	XCTAssertTrue(CGPointEqualToPoint(node.position, expectedNode.position));
+	XCTAssertEqual(node.zRotation, expectedNode.zRotation);
+	XCTAssertEqual(node.children.count, expectedNode.children.count);
+	for (NSUInteger i = 0; i < node.children.count; ++i) {
+		[self assertNode:node.children[i] equalsNode:expectedNode.children[i]];
+	}
+}
+
+#pragma mark Tests
+
+- (void)testRoundTrip {
+	SKNode *subtree = [self subtreeWithNodeCount:100];
+	NSData *data = [NodeClipboard dataWithNode:subtree expansionInfo:@[@YES, @[@NO]]];
+
+	id expansionInfo = nil;
+	NSArray *nodes = [NodeClipboard nodesWithData:data count:1 expansionInfo:&expansionInfo error:NULL];
+	XCTAssertEqual(nodes.count, 1);
+	[self assertNode:nodes[0] equalsNode:subtree];
+	XCTAssertEqualObjects(expansionInfo, (@[@YES, @[@NO]]));
+
+	/* The copied subtree is left untouched */
+	XCTAssertEqual(subtree.children.count, 11);
+}
+
+- (void)testTexturesAreSharedByReference {
+	SKNode *subtree = [self subtreeWithNodeCount:10];
+	SKNode *pasted = [NodeClipboard nodesWithData:[NodeClipboard dataWithNode:subtree expansionInfo:nil] count:1 expansionInfo:NULL error:NULL].firstObject;
+
+	SKSpriteNode *sprite = [[pasted.children[0] children] firstObject];
+	XCTAssertEqual(sprite.texture, _texture);
+}
+
+- (void)testPasteSeveralTimes {
+	SKNode *subtree = [self subtreeWithNodeCount:20];
+	NSArray *nodes = [NodeClipboard nodesWithData:[NodeClipboard dataWithNode:subtree expansionInfo:nil] count:3 expansionInfo:NULL error:NULL];
+	XCTAssertEqual(nodes.count, 3);
+	XCTAssertNotEqual(nodes[0], nodes[1]);
+	for (SKNode *node in nodes) {
+		[self assertNode:node equalsNode:subtree];
+
+		/* Every copy shares the registered texture */
+		SKSpriteNode *sprite = [[node.children[0] children] firstObject];
+		XCTAssertEqual(sprite.texture, _texture);
+	}
+}
+
+- (void)testCorruptDataIsRejected {
+	NSError *error = nil;
+	XCTAssertNil([NodeClipboard nodesWithData:[@"not nodes" dataUsingEncoding:NSUTF8StringEncoding] count:1 expansionInfo:NULL error:&error]);
+	XCTAssertNotNil(error);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceClipboardRoundTrip {
+	SKNode *subtree = [self subtreeWithNodeCount:5000];
+	[self measureBlock:^{
+		NSData *data = [NodeClipboard dataWithNode:subtree expansionInfo:nil];
+		[NodeClipboard nodesWithData:data count:1 expansionInfo:NULL error:NULL];
+	}];
+}
+
+@end
@@ -0,0 +1,126 @@
+//
+//  PhysicsBodyTypeTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "SKNode+PhysicsBodyType.h"
+
+static const NSUInteger kSpriteCount = 500;
+
+@interface PhysicsBodyTypeTests : XCTestCase
+
+@end
+
+@implementation PhysicsBodyTypeTests {
+	SKTexture *_texture;
+	NSArray *_sprites;
+}
+
+- (void)setUp {
+	[super setUp];
+	[SKNode removeAllCachedPhysicsBodies];
+
+	NSImage *image = [[NSBundle mainBundle] imageForResource:@"Spaceship"];
+	_texture = [SKTexture textureWithImage:image];
+
+	NSMutableArray *sprites = [NSMutableArray array];
+	for (NSUInteger i = 0; i < kSpriteCount; ++i) {
+		SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithTexture:_texture];
+		sprite.size = CGSizeMake(128, 128);
+		[sprites addObject:sprite];
+	}
+	_sprites = sprites;
+}
+
+#pragma mark Helpers
+
+- (BOOL)waitForPendingPhysicsBodies {
+	NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10];
+	while ([SKNode pendingPhysicsBodyCount] && [timeout timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.001]];
+	}
+	return [SKNode pendingPhysicsBodyCount] == 0;
+}
+
+#pragma mark Tests
+
+- (void)testBodyTypeIsReported {
+	SKSpriteNode *sprite = _sprites[0];
+	XCTAssertEqual(sprite.bodyType, 1);
+
+	for (NSUInteger bodyType = 1; bodyType <= 3; ++bodyType) {
+		sprite.bodyType = bodyType;
+		XCTAssertEqual(sprite.bodyType, bodyType);
+	}
+
+	/* A body set by hand isn't one of the listed types */
+	sprite.physicsBody = [SKPhysicsBody bodyWithCircleOfRadius:4];
+	XCTAssertEqual(sprite.bodyType, 0);
+}
+
+- (void)testAlphaMaskIsTracedInTheBackground {
+	SKSpriteNode *sprite = _sprites[0];
+	sprite.bodyType = 4;
+
+	/* The requested type is reported before the body is ready */
+	XCTAssertEqual(sprite.bodyType, 4);
+	XCTAssertTrue([self waitForPendingPhysicsBodies]);
+	XCTAssertNotNil(sprite.physicsBody);
+	XCTAssertEqual(sprite.bodyType, 4);
+
+	/* Once traced, the shape is reused right away */
+	SKSpriteNode *other = _sprites[1];
+	other.bodyType = 4;
+	XCTAssertEqual([SKNode pendingPhysicsBodyCount], 0);
+	XCTAssertNotNil(other.physicsBody);
+	XCTAssertNotEqual(other.physicsBody, sprite.physicsBody);
+}
+
+- (void)testChangingTheTypeWhileTracingKeepsTheLatest {
+	SKSpriteNode *sprite = _sprites[0];
+	sprite.bodyType = 4;
+	sprite.bodyType = 2;
+	XCTAssertTrue([self waitForPendingPhysicsBodies]);
+	XCTAssertEqual(sprite.bodyType, 2);
+}
+
+- (void)testSharedTextureIsTracedOnce {
+	for (SKSpriteNode *sprite in _sprites) {
+		sprite.bodyType = 4;
+	}
+	XCTAssertEqual([SKNode pendingPhysicsBodyCount], kSpriteCount);
+	XCTAssertTrue([self waitForPendingPhysicsBodies]);
+
+	for (SKSpriteNode *sprite in _sprites) {
+		XCTAssertNotNil(sprite.physicsBody);
+		XCTAssertEqual(sprite.bodyType, 4);
+	}
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceBulkAlphaMask {
+	/* Setting the body type on every selected sprite, until the last one has its body */
+	[self measureBlock:^{
+		[SKNode removeAllCachedPhysicsBodies];
+		for (SKSpriteNode *sprite in _sprites) {
+			sprite.bodyType = 1;
+			sprite.bodyType = 4;
+		}
+		[self waitForPendingPhysicsBodies];
+	}];
+}
+
+- (void)testPerformanceBulkRectangle {
+	[self measureBlock:^{
+		for (SKSpriteNode *sprite in _sprites) {
+			sprite.bodyType = 1;
+			sprite.bodyType = 2;
+		}
+	}];
+}
+
+@end
@@ -0,0 +1,108 @@
+//
+//  RowHeightIndexTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import "RowHeightIndex.h"
+
+static const NSUInteger kRowCount = 10000;
+
+@interface RowHeightIndexTests : XCTestCase
+
+@end
+
+@implementation RowHeightIndexTests {
+	CGFloat *_heights;
+}
+
+- (void)setUp {
+	[super setUp];
+	_heights = malloc(kRowCount * sizeof(CGFloat));
+	for (NSUInteger row = 0; row < kRowCount; ++row) {
+		_heights[row] = 17 + (row * 7) % 40;
+	}
+}
+
+- (void)tearDown {
+	free(_heights);
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (CGFloat)offsetOfRow:(NSUInteger)row {
+	CGFloat offset = 0;
+	for (NSUInteger i = 0; i < row; ++i) {
+		offset += _heights[i];
+	}
+	return offset;
+}
+
+#pragma mark Tests
+
+- (void)testOffsetsMatchTheRowHeights {
+	RowHeightIndex *index = [[RowHeightIndex alloc] init];
+	[index setHeights:_heights count:kRowCount];
+
+	XCTAssertEqual(index.count, kRowCount);
+	XCTAssertEqual(index.totalHeight, [self offsetOfRow:kRowCount]);
+
+	for (NSUInteger row = 0; row < kRowCount; row += 97) {
+		CGFloat offset = [self offsetOfRow:row];
+		XCTAssertEqual([index offsetOfRow:row], offset);
+		XCTAssertEqual([index rowAtOffset:offset], row);
+		XCTAssertEqual([index rowAtOffset:offset + _heights[row] - 1], row);
+	}
+
+	XCTAssertEqual([index rowAtOffset:-1], NSNotFound);
+	XCTAssertEqual([index rowAtOffset:index.totalHeight], NSNotFound);
+}
+
+- (void)testChangingAHeightMovesTheRowsBelow {
+	RowHeightIndex *index = [[RowHeightIndex alloc] init];
+	[index setHeights:_heights count:kRowCount];
+
+	/* What adding rows to the user data table does to its inspector row */
+	_heights[10] = 400;
+	[index setHeight:400 ofRow:10];
+
+	XCTAssertEqual([index heightOfRow:10], 400);
+	XCTAssertEqual([index offsetOfRow:10], [self offsetOfRow:10]);
+	XCTAssertEqual([index offsetOfRow:11], [self offsetOfRow:11]);
+	XCTAssertEqual([index offsetOfRow:kRowCount - 1], [self offsetOfRow:kRowCount - 1]);
+	XCTAssertEqual([index rowAtOffset:[self offsetOfRow:10] + 399], 10);
+}
+
+- (void)testRowsInRange {
+	CGFloat heights[] = {20, 20, 100, 20};
+	RowHeightIndex *index = [[RowHeightIndex alloc] init];
+	[index setHeights:heights count:4];
+
+	XCTAssertTrue(NSEqualRanges([index rowsFromOffset:0 toOffset:40], NSMakeRange(0, 2)));
+	XCTAssertTrue(NSEqualRanges([index rowsFromOffset:30 toOffset:41], NSMakeRange(1, 2)));
+	XCTAssertTrue(NSEqualRanges([index rowsFromOffset:50 toOffset:500], NSMakeRange(2, 2)));
+	XCTAssertTrue(NSEqualRanges([index rowsFromOffset:160 toOffset:200], NSMakeRange(0, 0)));
+
+	[index removeAllRows];
+	XCTAssertEqual(index.count, 0);
+	XCTAssertEqual([index rowAtOffset:0], NSNotFound);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceHeightChanges {
+	RowHeightIndex *index = [[RowHeightIndex alloc] init];
+	[index setHeights:_heights count:kRowCount];
+
+	/* A row near the top growing and the table asking where the visible rows are */
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < 100000; ++i) {
+			[index setHeight:20 + i % 300 ofRow:i % 16];
+			[index rowsFromOffset:i % 5000 toOffset:i % 5000 + 800];
+		}
+	}];
+}
+
+@end
@@ -0,0 +1,226 @@
+//
+//  SceneArchiveTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "SceneArchive.h"
+
+@interface SceneArchiveTests : XCTestCase
+
+@end
+
+@implementation SceneArchiveTests {
+	NSMutableArray *_temporaryFiles;
+}
+
+- (void)setUp {
+	[super setUp];
+	_temporaryFiles = [NSMutableArray array];
+}
+
+- (void)tearDown {
+	for (NSString *file in _temporaryFiles) {
+		[[NSFileManager defaultManager] removeItemAtPath:file error:NULL];
+	}
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (SKScene *)sceneWithNodeCount:(NSUInteger)nodeCount {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	SKNode *layer = nil;
+	for (NSUInteger i = 0; i < nodeCount; ++i) {
+		if (i % 100 == 0) {
+			layer = [SKNode node];
+			layer.name = [NSString stringWithFormat:@"layer%lu", (unsigned long)i / 100];
+			[scene addChild:layer];
+		}
+		SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithColor:[SKColor redColor] size:CGSizeMake(32, 32)];
+		sprite.name = [NSString stringWithFormat:@"sprite%lu", (unsigned long)i];
+		sprite.position = CGPointMake(i % 1024, i / 1024);
+		sprite.zRotation = i * 0.01;
+		[layer addChild:sprite];
+	}
+	return scene;
+}
+
+- (NSString *)fileWithScene:(SKScene *)scene format:(NSPropertyListFormat)format {
+	NSMutableData *data = [NSMutableData data];
+	NSKeyedArchiver *arch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+	[arch setOutputFormat:format];
+	[arch encodeObject:scene forKey:NSKeyedArchiveRootObjectKey];
+	[arch finishEncoding];
+
+	NSString *file = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"sks"]];
+	[data writeToFile:file atomically:YES];
+	[_temporaryFiles addObject:file];
+	return file;
+}
+
+- (NSString *)bundledSceneNamed:(NSString *)name {
+	NSString *file = [[NSBundle bundleForClass:NSClassFromString(@"AppDelegate")] pathForResource:name ofType:@"sks"];
+	XCTAssertNotNil(file);
+	return file;
+}
+
+- (NSUInteger)countOfNodesInNode:(SKNode *)node {
+	NSUInteger count = 1;
+	for (SKNode *child in node.children) {
+		count += [self countOfNodesInNode:child];
+	}
+	return count;
+}
+
+- (void)measureLoadingFile:(NSString *)file {
+	[self measureBlock:^{
+		NSError *error = nil;
+		id scene = [SceneArchive rootObjectWithContentsOfFile:file classes:nil format:NULL timings:NULL error:&error];
+		XCTAssertNotNil(scene);
+		XCTAssertNil(error);
+	}];
+}
+
+#pragma mark Tests
+
+- (void)testFormatSniffing {
+	XCTAssertEqual([SceneArchive formatOfData:[@"bplist00abc" dataUsingEncoding:NSUTF8StringEncoding]], NSPropertyListBinaryFormat_v1_0);
+	XCTAssertEqual([SceneArchive formatOfData:[@"<?xml version=\"1.0\"?>" dataUsingEncoding:NSUTF8StringEncoding]], NSPropertyListXMLFormat_v1_0);
+	const char xmlWithByteOrderMark[] = "\xEF\xBB\xBF\n <plist>";
+	XCTAssertEqual([SceneArchive formatOfData:[NSData dataWithBytes:xmlWithByteOrderMark length:sizeof(xmlWithByteOrderMark) - 1]], NSPropertyListXMLFormat_v1_0);
+	XCTAssertEqual([SceneArchive formatOfData:[@"bplist" dataUsingEncoding:NSUTF8StringEncoding]], (NSPropertyListFormat)0);
+	XCTAssertEqual([SceneArchive formatOfData:[NSData data]], (NSPropertyListFormat)0);
+}
+
+- (void)testBinaryAndXMLArchivesLoadTheSameScene {
+	SKScene *scene = [self sceneWithNodeCount:1000];
+
+	for (NSNumber *format in @[@(NSPropertyListBinaryFormat_v1_0), @(NSPropertyListXMLFormat_v1_0)]) {
+		NSString *file = [self fileWithScene:scene format:format.unsignedIntegerValue];
+
+		NSPropertyListFormat loadedFormat = 0;
+		NSDictionary *timings = nil;
+		NSError *error = nil;
+		SKScene *loadedScene = [SceneArchive rootObjectWithContentsOfFile:file classes:nil format:&loadedFormat timings:&timings error:&error];
+
+		XCTAssertNil(error);
+		XCTAssertEqual(loadedFormat, format.unsignedIntegerValue);
+		XCTAssertEqual([self countOfNodesInNode:loadedScene], [self countOfNodesInNode:scene]);
+		XCTAssertEqualObjects([loadedScene childNodeWithName:@"//sprite999"].name, @"sprite999");
+		XCTAssertNotNil(timings[SceneArchiveMapTimingKey]);
+		XCTAssertNotNil(timings[SceneArchiveSniffTimingKey]);
+		XCTAssertNotNil(timings[SceneArchiveDecodeTimingKey]);
+		XCTAssertGreaterThanOrEqual([timings[SceneArchiveTotalTimingKey] doubleValue], [timings[SceneArchiveDecodeTimingKey] doubleValue]);
+	}
+}
+
+- (void)testCorruptFileReportsAnError {
+	NSString *file = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"sks"]];
+	[[@"not a scene" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:file atomically:YES];
+	[_temporaryFiles addObject:file];
+
+	NSError *error = nil;
+	XCTAssertNil([SceneArchive rootObjectWithContentsOfFile:file classes:nil format:NULL timings:NULL error:&error]);
+	XCTAssertNotNil(error);
+}
+
+- (NSString *)writeScene:(SKScene *)scene format:(NSPropertyListFormat)format {
+	NSString *file = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"sks"]];
+	[_temporaryFiles addObject:file];
+
+	XCTestExpectation *expectation = [self expectationWithDescription:@"save"];
+	NSProgress *progress = [SceneArchive writeRootObject:scene toFile:file format:format completionHandler:^(NSError *error) {
+		XCTAssertNil(error);
+		[expectation fulfill];
+	}];
+	[self waitForExpectationsWithTimeout:60 handler:nil];
+
+	XCTAssertEqual(progress.completedUnitCount, progress.totalUnitCount);
+	return file;
+}
+
+- (void)testBackgroundSaveIsByteCompatible {
+	SKScene *scene = [self sceneWithNodeCount:5000];
+
+	/* Textures and shaders shared between nodes are archived once and referenced from every node */
+	SKTexture *texture = [SKTexture textureWithImageNamed:@"Spaceship"];
+	SKShader *shader = [SKShader shaderWithSource:@"void main() { gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0); }"];
+	for (NSUInteger i = 0; i < 10; ++i) {
+		SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithTexture:texture];
+		sprite.shader = shader;
+		[scene addChild:sprite];
+	}
+
+	for (NSNumber *format in @[@(NSPropertyListBinaryFormat_v1_0), @(NSPropertyListXMLFormat_v1_0)]) {
+		NSString *file = [self writeScene:scene format:format.unsignedIntegerValue];
+
+		/* The file must be identical to the one written by archiving the scene directly */
+		NSData *expectedData = [SceneArchive archivedDataWithRootObject:scene format:format.unsignedIntegerValue];
+		XCTAssertEqualObjects([NSData dataWithContentsOfFile:file], expectedData);
+
+		/* And load back the same scene */
+		NSPropertyListFormat loadedFormat = 0;
+		SKScene *loadedScene = [SceneArchive rootObjectWithContentsOfFile:file classes:nil format:&loadedFormat timings:NULL error:NULL];
+		XCTAssertEqual(loadedFormat, format.unsignedIntegerValue);
+		XCTAssertEqual([self countOfNodesInNode:loadedScene], [self countOfNodesInNode:scene]);
+	}
+
+	/* No temporary files are left behind */
+	for (NSString *entry in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:NSTemporaryDirectory() error:NULL]) {
+		for (NSString *file in _temporaryFiles) {
+			XCTAssertFalse([entry hasPrefix:[NSString stringWithFormat:@".%@.", file.lastPathComponent]]);
+		}
+	}
+}
+
+- (void)testEditsAfterSavingAreNotWritten {
+	SKScene *scene = [self sceneWithNodeCount:1000];
+	NSData *expectedData = [SceneArchive archivedDataWithRootObject:scene format:NSPropertyListBinaryFormat_v1_0];
+
+	NSString *file = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"sks"]];
+	[_temporaryFiles addObject:file];
+
+	XCTestExpectation *expectation = [self expectationWithDescription:@"save"];
+	[SceneArchive writeRootObject:scene toFile:file format:NSPropertyListBinaryFormat_v1_0 completionHandler:^(NSError *error) {
+		XCTAssertNil(error);
+		[expectation fulfill];
+	}];
+
+	/* The editor keeps changing the scene while it's encoded in the background */
+	[scene childNodeWithName:@"//sprite999"].name = @"renamed";
+	[scene removeAllChildren];
+
+	[self waitForExpectationsWithTimeout:60 handler:nil];
+	XCTAssertEqualObjects([NSData dataWithContentsOfFile:file], expectedData);
+}
+
+#pragma mark Benchmarks
+
+- (void)testLoadGameScene {
+	[self measureLoadingFile:[self bundledSceneNamed:@"GameScene"]];
+}
+
+- (void)testLoadParticles {
+	[self measureLoadingFile:[self bundledSceneNamed:@"Particles"]];
+}
+
+- (void)testLoadLargeBinaryScene {
+	[self measureLoadingFile:[self fileWithScene:[self sceneWithNodeCount:20000] format:NSPropertyListBinaryFormat_v1_0]];
+}
+
+- (void)testLoadLargeXMLScene {
+	[self measureLoadingFile:[self fileWithScene:[self sceneWithNodeCount:20000] format:NSPropertyListXMLFormat_v1_0]];
+}
+
+- (void)testSnapshotLargeScene {
+	/* Time spent in the main thread when saving, archiving the scene that is written in the background */
+	SKScene *scene = [self sceneWithNodeCount:20000];
+	[self measureBlock:^{
+		XCTAssertGreaterThan([SceneArchive archivedDataWithRootObject:scene format:NSPropertyListBinaryFormat_v1_0].length, 0);
+	}];
+}
+
+@end
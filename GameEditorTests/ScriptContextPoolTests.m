@@ -0,0 +1,131 @@
+//
+//  ScriptContextPoolTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "ScriptContextPool.h"
+
+static const NSUInteger kNodeCount = 500;
+
+@interface ScriptContextPoolTests : XCTestCase
+
+@end
+
+@implementation ScriptContextPoolTests {
+	ScriptContextPool *_pool;
+	NSString *_script;
+	NSArray *_positions;
+}
+
+- (void)setUp {
+	[super setUp];
+
+	/* The classes are exported to Lua when the host application launches */
+	_pool = [[ScriptContextPool alloc] initWithGlobals:@{@"SKNode": [SKNode class], @"SKSpriteNode": [SKSpriteNode class]}];
+	_script = LUA_STRING
+	(
+	 function createNodeAtPosition(position, name)
+	 local node = SKNode.node()
+	 node.position = position
+	 return node
+	 end
+	 );
+
+	NSMutableArray *positions = [NSMutableArray array];
+	for (NSUInteger i = 0; i < kNodeCount; ++i) {
+		[positions addObject:[NSValue valueWithPoint:NSMakePoint(i % 32 * 16, i / 32 * 16)]];
+	}
+	_positions = positions;
+}
+
+#pragma mark Helpers
+
+- (LuaContext *)warmContextForKey:(NSString *)key {
+	[_pool prewarmScript:_script forKey:key];
+
+	/* Wait for the background queue to parse the script */
+	NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+	LuaContext *context = nil;
+	while (!context && [timeout timeIntervalSinceNow] > 0) {
+		[NSThread sleepForTimeInterval:0.01];
+		@synchronized(_pool) {
+			context = [[_pool valueForKey:@"idleContexts"][key] lastObject];
+		}
+	}
+	XCTAssertNotNil(context);
+	return [_pool dequeueContextForKey:key script:_script error:NULL];
+}
+
+#pragma mark Tests
+
+- (void)testPrewarmedContextsAreReused {
+	LuaContext *context = [self warmContextForKey:@"object.0"];
+	XCTAssertNotNil(context);
+
+	[_pool enqueueContext:context forKey:@"object.0"];
+	XCTAssertEqual([_pool dequeueContextForKey:@"object.0" script:_script error:NULL], context);
+
+	/* A different script doesn't get the contexts of the old one */
+	NSString *otherScript = [_script stringByAppendingString:@" "];
+	[_pool enqueueContext:context forKey:@"object.0"];
+	XCTAssertNotEqual([_pool dequeueContextForKey:@"object.0" script:otherScript error:NULL], context);
+}
+
+- (void)testContextsOfAReplacedScriptAreNotReused {
+	LuaContext *context = [self warmContextForKey:@"object.0"];
+
+	/* The script changes while the old context is still in use */
+	NSString *otherScript = [_script stringByAppendingString:@" "];
+	LuaContext *otherContext = [_pool dequeueContextForKey:@"object.0" script:otherScript error:NULL];
+	XCTAssertNotNil(otherContext);
+
+	[_pool enqueueContext:context forKey:@"object.0"];
+	XCTAssertNotEqual([_pool dequeueContextForKey:@"object.0" script:otherScript error:NULL], context);
+}
+
+- (void)testScriptErrorsAreReported {
+	NSError *error = nil;
+	XCTAssertNil([_pool dequeueContextForKey:@"broken" script:@"function (" error:&error]);
+	XCTAssertNotNil(error);
+}
+
+- (void)testBatchCreatesOneNodePerPosition {
+	LuaContext *context = [self warmContextForKey:@"object.0"];
+
+	NSError *error = nil;
+	NSArray *nodes = [ScriptContextPool createNodesAtPositions:_positions name:@"Node" inContext:context error:&error];
+	XCTAssertNil(error);
+	XCTAssertEqual(nodes.count, kNodeCount);
+	XCTAssertTrue(CGPointEqualToPoint([nodes.lastObject position], [_positions.lastObject pointValue]));
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceSingleCreation {
+	LuaContext *context = [self warmContextForKey:@"object.0"];
+
+	[self measureBlock:^{
+		CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+		for (NSValue *position in _positions) {
+			NSError *error = nil;
+			XCTAssertNotNil([context call:@"createNodeAtPosition" with:@[position, @"Node"] error:&error]);
+		}
+		NSLog(@"Single creation: %.2f us per node", (CFAbsoluteTimeGetCurrent() - startTime) * 1e6 / kNodeCount);
+	}];
+}
+
+- (void)testPerformanceBatchCreation {
+	LuaContext *context = [self warmContextForKey:@"object.0"];
+
+	[self measureBlock:^{
+		CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+		NSArray *nodes = [ScriptContextPool createNodesAtPositions:_positions name:@"Node" inContext:context error:NULL];
+		XCTAssertEqual(nodes.count, kNodeCount);
+		NSLog(@"Batch creation: %.2f us per node", (CFAbsoluteTimeGetCurrent() - startTime) * 1e6 / kNodeCount);
+	}];
+}
+
+@end
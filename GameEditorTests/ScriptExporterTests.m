@@ -0,0 +1,133 @@
+//
+//  ScriptExporterTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import <objc/runtime.h>
+#import "ScriptExporter.h"
+#import "LuaExport.h"
+
+@interface ScriptExporterTestNode : SKNode
+@property (assign) CGFloat speedFactor;
+- (void)jump;
+@end
+
+@implementation ScriptExporterTestNode
+- (void)jump {}
+@end
+
+@interface ScriptExporterTests : XCTestCase
+
+@end
+
+@implementation ScriptExporterTests {
+	NSString *_cacheFile;
+}
+
+- (void)setUp {
+	[super setUp];
+	_cacheFile = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"plist"]];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:_cacheFile error:NULL];
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (NSArray *)spriteKitClasses {
+	/* Every public class of the framework, the set the scripts are expected to grow into */
+	NSMutableArray *classes = [NSMutableArray array];
+	unsigned int classCount;
+	const char **classNames = objc_copyClassNamesForImage(class_getImageName([SKNode class]), &classCount);
+	for (unsigned int i = 0; i < classCount; ++i) {
+		if (strncmp(classNames[i], "SK", 2) == 0) {
+			[classes addObject:objc_getClass(classNames[i])];
+		}
+	}
+	free(classNames);
+	return classes;
+}
+
+#pragma mark Tests
+
+- (void)testExportedClassConformsToItsProtocol {
+	ScriptExporter *exporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+	XCTAssertFalse([exporter isClassExported:[ScriptExporterTestNode class]]);
+
+	[exporter exportClass:[ScriptExporterTestNode class]];
+
+	XCTAssertTrue([exporter isClassExported:[ScriptExporterTestNode class]]);
+	Protocol *protocol = objc_getProtocol("ScriptExporterTestNodeLuaExports");
+	XCTAssertNotNil(protocol);
+	XCTAssertTrue(class_conformsToProtocol([ScriptExporterTestNode class], protocol));
+	XCTAssertTrue(protocol_conformsToProtocol(protocol, @protocol(LuaExport)));
+	XCTAssertTrue(protocol_getMethodDescription(protocol, @selector(jump), YES, YES).name != NULL);
+	XCTAssertTrue(protocol_getProperty(protocol, "speedFactor", YES, YES) != NULL);
+}
+
+- (void)testMetadataPersistsBetweenLaunches {
+	ScriptExporter *exporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+	NSDictionary *metadata = [exporter metadataForClass:[SKSpriteNode class]];
+	XCTAssertGreaterThan([metadata[ScriptExporterInstanceMethodsKey] count], 0);
+	XCTAssertTrue([exporter saveMetadata]);
+	XCTAssertFalse([exporter saveMetadata]);
+
+	ScriptExporter *relaunchedExporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+	XCTAssertEqualObjects([relaunchedExporter metadataForClass:[SKSpriteNode class]], metadata);
+	XCTAssertFalse([relaunchedExporter saveMetadata]);
+}
+
+- (void)testMetadataOfRebuiltClassesIsReadAgain {
+	ScriptExporter *exporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+	[exporter metadataForClass:[ScriptExporterTestNode class]];
+	XCTAssertTrue([exporter saveMetadata]);
+
+	/* Rebuilding the application keeps its bundle version but updates its binary */
+	NSString *imagePath = @(class_getImageName([ScriptExporterTestNode class]));
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+	NSDate *imageDate = [fileManager attributesOfItemAtPath:imagePath error:NULL].fileModificationDate;
+	XCTAssertTrue([fileManager setAttributes:@{NSFileModificationDate: [imageDate dateByAddingTimeInterval:60]} ofItemAtPath:imagePath error:NULL]);
+
+	ScriptExporter *relaunchedExporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+	[relaunchedExporter metadataForClass:[ScriptExporterTestNode class]];
+	XCTAssertTrue([relaunchedExporter saveMetadata]);
+
+	[fileManager setAttributes:@{NSFileModificationDate: imageDate} ofItemAtPath:imagePath error:NULL];
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceMetadataFromRuntime {
+	NSArray *classes = [self spriteKitClasses];
+	NSLog(@"Measuring %lu classes", (unsigned long)classes.count);
+
+	[self measureBlock:^{
+		ScriptExporter *exporter = [[ScriptExporter alloc] initWithCacheFile:nil];
+		for (Class classType in classes) {
+			[exporter metadataForClass:classType];
+		}
+	}];
+}
+
+- (void)testPerformanceMetadataFromCache {
+	NSArray *classes = [self spriteKitClasses];
+	ScriptExporter *exporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+	for (Class classType in classes) {
+		[exporter metadataForClass:classType];
+	}
+	[exporter saveMetadata];
+
+	[self measureBlock:^{
+		ScriptExporter *relaunchedExporter = [[ScriptExporter alloc] initWithCacheFile:_cacheFile];
+		for (Class classType in classes) {
+			[relaunchedExporter metadataForClass:classType];
+		}
+	}];
+}
+
+@end
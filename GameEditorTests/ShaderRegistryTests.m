@@ -0,0 +1,147 @@
+//
+//  ShaderRegistryTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "ShaderRegistry.h"
+#import "UserDataView.h"
+#import "ValueTransformers.h"
+
+@interface ShaderRegistryTests : XCTestCase
+
+@end
+
+@implementation ShaderRegistryTests {
+	NSString *_temporaryDirectory;
+	ShaderRegistry *_registry;
+}
+
+- (void)setUp {
+	[super setUp];
+	_temporaryDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+	[[NSFileManager defaultManager] createDirectoryAtPath:_temporaryDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+	_registry = [ShaderRegistry new];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:_temporaryDirectory error:NULL];
+	[[ShaderRegistry sharedRegistry] removeAllShaders];
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (NSString *)writeShaderNamed:(NSString *)name source:(NSString *)source {
+	NSString *file = [_temporaryDirectory stringByAppendingPathComponent:name];
+	[source writeToFile:file atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+	return file;
+}
+
+- (NSString *)sourceWithColor:(NSString *)color {
+	return [NSString stringWithFormat:@"void main() {\n    gl_FragColor = vec4(%@);\n}\n", color];
+}
+
+#pragma mark Tests
+
+- (void)testShadersAreLookedUpByNameAndSource {
+	NSString *red = [self writeShaderNamed:@"Red.fsh" source:[self sourceWithColor:@"1.0, 0.0, 0.0, 1.0"]];
+	NSString *green = [self writeShaderNamed:@"Green.fsh" source:[self sourceWithColor:@"0.0, 1.0, 0.0, 1.0"]];
+	[_registry loadShadersWithPaths:@[red, green]];
+
+	XCTAssertEqualObjects(_registry.shaderNames, (@[@"Green.fsh", @"Red.fsh"]));
+
+	/* Shaders decoded from a scene are recognized by their source */
+	SKShader *decoded = [SKShader shaderWithSource:[self sourceWithColor:@"0.0, 1.0, 0.0, 1.0"]];
+	XCTAssertEqualObjects([_registry nameOfShader:decoded], @"Green.fsh");
+	XCTAssertNil([_registry nameOfShader:[SKShader shaderWithSource:[self sourceWithColor:@"0.0"]]]);
+}
+
+- (void)testNodesShareTheShaderInstance {
+	NSString *red = [self writeShaderNamed:@"Red.fsh" source:[self sourceWithColor:@"1.0, 0.0, 0.0, 1.0"]];
+	NSString *copy = [self writeShaderNamed:@"RedCopy.fsh" source:[self sourceWithColor:@"1.0, 0.0, 0.0, 1.0"]];
+	[_registry loadShadersWithPaths:@[red, copy]];
+
+	SKShader *shader = [_registry shaderNamed:@"Red.fsh"];
+	XCTAssertNotNil(shader);
+	XCTAssertEqual([_registry shaderNamed:@"Red.fsh"], shader);
+	XCTAssertEqual([_registry shaderNamed:@"RedCopy.fsh"], shader);
+	XCTAssertNil([_registry shaderNamed:@"Missing.fsh"]);
+}
+
+- (void)testChangesToTheFilesUpdateTheRegistry {
+	NSString *red = [self writeShaderNamed:@"Red.fsh" source:[self sourceWithColor:@"1.0, 0.0, 0.0, 1.0"]];
+	[_registry loadShadersWithPaths:@[red]];
+	SKShader *oldShader = [_registry shaderNamed:@"Red.fsh"];
+
+	[self writeShaderNamed:@"Red.fsh" source:[self sourceWithColor:@"0.5, 0.0, 0.0, 1.0"]];
+	NSString *blue = [self writeShaderNamed:@"Blue.fsh" source:[self sourceWithColor:@"0.0, 0.0, 1.0, 1.0"]];
+	[_registry updateWithAddedFiles:@[blue, [_temporaryDirectory stringByAppendingPathComponent:@"Spaceship.png"]] removedFiles:@[] modifiedFiles:@[red]];
+
+	XCTAssertEqualObjects(_registry.shaderNames, (@[@"Blue.fsh", @"Red.fsh"]));
+	XCTAssertNotEqual([_registry shaderNamed:@"Red.fsh"], oldShader);
+	XCTAssertNil([_registry nameOfShader:oldShader]);
+
+	[_registry updateWithAddedFiles:@[] removedFiles:@[red] modifiedFiles:@[]];
+	XCTAssertEqualObjects(_registry.shaderNames, @[@"Blue.fsh"]);
+}
+
+- (void)testTransformerUsesTheSharedRegistry {
+	NSString *red = [self writeShaderNamed:@"Red.fsh" source:[self sourceWithColor:@"1.0, 0.0, 0.0, 1.0"]];
+	[[ShaderRegistry sharedRegistry] loadShadersWithPaths:@[red]];
+
+	NSValueTransformer *transformer = [ShaderTransformer transformer];
+	SKShader *shader = [transformer reverseTransformedValue:@"Red.fsh"];
+	XCTAssertEqual(shader, [[ShaderRegistry sharedRegistry] shaderNamed:@"Red.fsh"]);
+	XCTAssertEqualObjects([transformer transformedValue:shader], @"Red.fsh");
+}
+
+- (void)testUniformEditsDontReachTheSharedShader {
+	NSString *red = [self writeShaderNamed:@"Red.fsh" source:[self sourceWithColor:@"1.0, 0.0, 0.0, 1.0"]];
+	ShaderRegistry *registry = [ShaderRegistry sharedRegistry];
+	[registry loadShadersWithPaths:@[red]];
+
+	SKShader *shader = [registry shaderNamed:@"Red.fsh"];
+	SKSpriteNode *edited = [SKSpriteNode node];
+	edited.shader = shader;
+	SKSpriteNode *other = [SKSpriteNode node];
+	other.shader = shader;
+
+	/* The first edit gives the node its own copy of the shader */
+	NSArrayController *controller = [UserDataUniformsArray controllerWithShader:shader node:edited key:@"shader"];
+	[controller addObject:[SKUniform uniformWithName:@"u_amount" float:1.0]];
+
+	XCTAssertNotEqual(edited.shader, shader);
+	XCTAssertEqual(edited.shader.uniforms.count, (NSUInteger)1);
+	XCTAssertFalse([registry isSharedShader:edited.shader]);
+	XCTAssertEqual(other.shader, shader);
+	XCTAssertEqual(shader.uniforms.count, (NSUInteger)0);
+	XCTAssertEqual([registry shaderNamed:@"Red.fsh"], shader);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceNameLookup {
+	NSMutableArray *paths = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 50; ++i) {
+		NSString *color = [NSString stringWithFormat:@"%lu.0, 0.0, 0.0, 1.0", (unsigned long)i];
+		[paths addObject:[self writeShaderNamed:[NSString stringWithFormat:@"Shader%lu.fsh", (unsigned long)i] source:[self sourceWithColor:color]]];
+	}
+	[_registry loadShadersWithPaths:paths];
+
+	NSMutableArray *shaders = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 1000; ++i) {
+		NSString *color = [NSString stringWithFormat:@"%lu.0, 0.0, 0.0, 1.0", (unsigned long)i % 50];
+		[shaders addObject:[SKShader shaderWithSource:[self sourceWithColor:color]]];
+	}
+
+	[self measureBlock:^{
+		for (SKShader *shader in shaders) {
+			XCTAssertNotNil([_registry nameOfShader:shader]);
+		}
+	}];
+}
+
+@end
@@ -0,0 +1,264 @@
+//
+//  SpatialIndexTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import "SpatialIndex.h"
+
+static const CGFloat kSceneSize = 4096.0;
+static const CGFloat kPointRadius = 25.0;
+
+@interface SpatialIndexTests : XCTestCase
+
+@end
+
+@implementation SpatialIndexTests {
+	SpatialIndexRef _index;
+	SpatialIndexBox *_boxes;
+	bool *_isPoint;
+	SpatialIndexProxy *_proxies;
+	NSUInteger _count;
+	NSUInteger _capacity;
+	uint32_t _seed;
+}
+
+#pragma mark Synthetic scene
+
+- (CGFloat)randomBetween:(CGFloat)min and:(CGFloat)max {
+	/* Deterministic LCG so that every run exercises the same scene */
+	_seed = _seed * 1664525 + 1013904223;
+	return min + (max - min) * (_seed >> 8) / (CGFloat)(1 << 24);
+}
+
+- (void)addNodesWithParentTransform:(CGAffineTransform)parentTransform depth:(NSUInteger)depth {
+	NSUInteger childCount = depth == 0 ? 64 : 8;
+	for (NSUInteger i = 0; i < childCount && _count < _capacity; ++i) {
+		CGFloat spread = depth == 0 ? kSceneSize : 200.0;
+
+		CGAffineTransform transform = CGAffineTransformMakeScale([self randomBetween:0.5 and:1.5], [self randomBetween:0.5 and:1.5]);
+		transform = CGAffineTransformConcat(transform, CGAffineTransformMakeRotation([self randomBetween:0 and:2 * M_PI]));
+		transform = CGAffineTransformConcat(transform, CGAffineTransformMakeTranslation([self randomBetween:0 and:spread], [self randomBetween:0 and:spread]));
+		transform = CGAffineTransformConcat(transform, parentTransform);
+
+		NSUInteger n = _count++;
+		_isPoint[n] = [self randomBetween:0 and:1] < 0.2;
+		if (_isPoint[n]) {
+			_boxes[n] = SpatialIndexBoxMakePoint(CGPointMake(transform.tx, transform.ty));
+		} else {
+			CGSize size = CGSizeMake([self randomBetween:8 and:128], [self randomBetween:8 and:128]);
+			_boxes[n] = SpatialIndexBoxMake(transform, size, CGPointMake([self randomBetween:0 and:1], [self randomBetween:0 and:1]));
+		}
+		_proxies[n] = SpatialIndexInsert(_index, _boxes[n], _isPoint[n]);
+
+		if (depth < 4) {
+			[self addNodesWithParentTransform:transform depth:depth + 1];
+		}
+	}
+}
+
+- (void)buildSceneWithNodeCount:(NSUInteger)nodeCount {
+	_seed = 1;
+	_count = 0;
+	_capacity = nodeCount;
+	_boxes = malloc(nodeCount * sizeof(SpatialIndexBox));
+	_isPoint = malloc(nodeCount * sizeof(bool));
+	_proxies = malloc(nodeCount * sizeof(SpatialIndexProxy));
+	_index = SpatialIndexCreate();
+
+	while (_count < nodeCount) {
+		[self addNodesWithParentTransform:CGAffineTransformIdentity depth:0];
+	}
+}
+
+- (void)tearDown {
+	SpatialIndexRelease(_index);
+	free(_boxes);
+	free(_isPoint);
+	free(_proxies);
+	_index = NULL;
+	_boxes = NULL;
+	_isPoint = NULL;
+	_proxies = NULL;
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+static bool collectProxy(SpatialIndexProxy proxy, void *context) {
+	[(__bridge NSMutableIndexSet *)context addIndex:proxy];
+	return true;
+}
+
+- (NSIndexSet *)bruteForceProxiesContainingPoint:(CGPoint)point {
+	NSMutableIndexSet *proxies = [NSMutableIndexSet indexSet];
+	for (NSUInteger i = 0; i < _count; ++i) {
+		if (_proxies[i] == SpatialIndexNullProxy)
+			continue;
+
+		BOOL hit;
+		if (_isPoint[i]) {
+			hit = fabs(point.x - _boxes[i].corners[0].x) <= kPointRadius && fabs(point.y - _boxes[i].corners[0].y) <= kPointRadius;
+		} else {
+			hit = SpatialIndexBoxContainsPoint(_boxes[i], point);
+		}
+		if (hit) {
+			[proxies addIndex:_proxies[i]];
+		}
+	}
+	return proxies;
+}
+
+static BOOL segmentsIntersect(CGPoint a, CGPoint b, CGPoint c, CGPoint d) {
+	CGFloat d1 = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	CGFloat d2 = (b.x - a.x) * (d.y - a.y) - (b.y - a.y) * (d.x - a.x);
+	CGFloat d3 = (d.x - c.x) * (a.y - c.y) - (d.y - c.y) * (a.x - c.x);
+	CGFloat d4 = (d.x - c.x) * (b.y - c.y) - (d.y - c.y) * (b.x - c.x);
+	return (d1 > 0) != (d2 > 0) && (d3 > 0) != (d4 > 0);
+}
+
+- (NSIndexSet *)bruteForceProxiesIntersectingRect:(CGRect)rect {
+	CGPoint rectCorners[4] = {
+		{CGRectGetMinX(rect), CGRectGetMinY(rect)},
+		{CGRectGetMaxX(rect), CGRectGetMinY(rect)},
+		{CGRectGetMaxX(rect), CGRectGetMaxY(rect)},
+		{CGRectGetMinX(rect), CGRectGetMaxY(rect)}
+	};
+
+	NSMutableIndexSet *proxies = [NSMutableIndexSet indexSet];
+	for (NSUInteger i = 0; i < _count; ++i) {
+		BOOL hit = NO;
+		if (_isPoint[i]) {
+			hit = CGRectContainsPoint(CGRectInset(rect, -kPointRadius, -kPointRadius), _boxes[i].corners[0]);
+		} else {
+			/* Either polygon has a corner inside the other or their edges cross */
+			CGMutablePathRef path = CGPathCreateMutable();
+			CGPathAddLines(path, NULL, _boxes[i].corners, 4);
+			CGPathCloseSubpath(path);
+			for (int j = 0; j < 4 && !hit; ++j) {
+				hit = CGRectContainsPoint(rect, _boxes[i].corners[j]) || CGPathContainsPoint(path, NULL, rectCorners[j], NO);
+				for (int k = 0; k < 4 && !hit; ++k) {
+					hit = segmentsIntersect(_boxes[i].corners[j], _boxes[i].corners[(j + 1) % 4], rectCorners[k], rectCorners[(k + 1) % 4]);
+				}
+			}
+			CGPathRelease(path);
+		}
+		if (hit) {
+			[proxies addIndex:_proxies[i]];
+		}
+	}
+	return proxies;
+}
+
+- (CGRect)randomMarquee {
+	return CGRectMake([self randomBetween:0 and:kSceneSize], [self randomBetween:0 and:kSceneSize],
+					  [self randomBetween:1 and:400], [self randomBetween:1 and:400]);
+}
+
+- (CGPoint)randomClick {
+	return CGPointMake([self randomBetween:0 and:kSceneSize], [self randomBetween:0 and:kSceneSize]);
+}
+
+#pragma mark Tests
+
+- (void)testBoxContainsPoint {
+	CGAffineTransform transform = CGAffineTransformConcat(CGAffineTransformMakeRotation(M_PI_4), CGAffineTransformMakeTranslation(100, 100));
+	SpatialIndexBox box = SpatialIndexBoxMake(transform, CGSizeMake(20, 20), CGPointMake(0.5, 0.5));
+
+	XCTAssertTrue(SpatialIndexBoxContainsPoint(box, CGPointMake(100, 100)));
+	XCTAssertTrue(SpatialIndexBoxContainsPoint(box, CGPointMake(100, 113)));
+	XCTAssertFalse(SpatialIndexBoxContainsPoint(box, CGPointMake(109, 109)));
+
+	/* Mirrored frames have the opposite winding */
+	box = SpatialIndexBoxMake(CGAffineTransformMakeScale(-1, 1), CGSizeMake(20, 20), CGPointZero);
+	XCTAssertTrue(SpatialIndexBoxContainsPoint(box, CGPointMake(-10, 10)));
+	XCTAssertFalse(SpatialIndexBoxContainsPoint(box, CGPointMake(10, 10)));
+
+	/* Frames without area contain nothing */
+	box = SpatialIndexBoxMake(CGAffineTransformIdentity, CGSizeMake(0, 20), CGPointZero);
+	XCTAssertFalse(SpatialIndexBoxContainsPoint(box, CGPointMake(0, 10)));
+}
+
+- (void)testPointQueriesMatchBruteForce {
+	[self buildSceneWithNodeCount:10000];
+
+	/* Move and remove some of the nodes to exercise the incremental updates */
+	for (NSUInteger i = 0; i < _count; i += 3) {
+		if (i % 2) {
+			SpatialIndexRemove(_index, _proxies[i]);
+			_proxies[i] = SpatialIndexNullProxy;
+		} else {
+			CGFloat dx = [self randomBetween:-100 and:100];
+			CGFloat dy = [self randomBetween:-100 and:100];
+			for (int c = 0; c < 4; ++c) {
+				_boxes[i].corners[c].x += dx;
+				_boxes[i].corners[c].y += dy;
+			}
+			SpatialIndexUpdate(_index, _proxies[i], _boxes[i], _isPoint[i]);
+		}
+	}
+
+	for (NSUInteger i = 0; i < 1000; ++i) {
+		CGPoint point = [self randomClick];
+		NSMutableIndexSet *proxies = [NSMutableIndexSet indexSet];
+		SpatialIndexQueryPoint(_index, point, kPointRadius, collectProxy, (__bridge void *)proxies);
+		XCTAssertEqualObjects(proxies, [self bruteForceProxiesContainingPoint:point]);
+	}
+}
+
+- (void)testBoxIntersectsRect {
+	CGAffineTransform transform = CGAffineTransformConcat(CGAffineTransformMakeRotation(M_PI_4), CGAffineTransformMakeTranslation(100, 100));
+	SpatialIndexBox box = SpatialIndexBoxMake(transform, CGSizeMake(20, 20), CGPointMake(0.5, 0.5));
+
+	/* The bounding boxes overlap but the rotated frame doesn't reach the corner of the rect */
+	XCTAssertFalse(SpatialIndexBoxIntersectsRect(box, CGRectMake(108, 108, 10, 10)));
+	XCTAssertTrue(SpatialIndexBoxIntersectsRect(box, CGRectMake(104, 104, 10, 10)));
+	XCTAssertTrue(SpatialIndexBoxIntersectsRect(box, CGRectMake(0, 0, 200, 200)));
+	XCTAssertTrue(SpatialIndexBoxIntersectsRect(box, CGRectMake(99, 99, 2, 2)));
+}
+
+- (void)testRectQueriesMatchBruteForce {
+	[self buildSceneWithNodeCount:50000];
+
+	for (NSUInteger i = 0; i < 100; ++i) {
+		CGRect rect = [self randomMarquee];
+		NSMutableIndexSet *proxies = [NSMutableIndexSet indexSet];
+		SpatialIndexQueryRect(_index, rect, kPointRadius, collectProxy, (__bridge void *)proxies);
+		XCTAssertEqualObjects(proxies, [self bruteForceProxiesIntersectingRect:rect]);
+	}
+}
+
+- (void)testMarqueeDragsIn50kNodes {
+	[self buildSceneWithNodeCount:50000];
+
+	/* Every mouse-drag event grows the marquee and queries the whole rect again */
+	[self measureBlock:^{
+		NSUInteger hits = 0;
+		for (NSUInteger i = 0; i < 100; ++i) {
+			hits += SpatialIndexQueryRect(_index, CGRectMake(0, 0, i * kSceneSize / 100, i * kSceneSize / 100), kPointRadius, NULL, NULL);
+		}
+		XCTAssertGreaterThan(hits, (NSUInteger)0);
+	}];
+}
+
+- (void)measureRandomClicksWithNodeCount:(NSUInteger)nodeCount {
+	[self buildSceneWithNodeCount:nodeCount];
+	[self measureBlock:^{
+		NSUInteger hits = 0;
+		for (NSUInteger i = 0; i < 10000; ++i) {
+			hits += SpatialIndexQueryPoint(_index, [self randomClick], kPointRadius, NULL, NULL);
+		}
+		XCTAssertGreaterThan(hits, (NSUInteger)0);
+	}];
+}
+
+- (void)testRandomClicksIn10kNodes {
+	[self measureRandomClicksWithNodeCount:10000];
+}
+
+- (void)testRandomClicksIn100kNodes {
+	[self measureRandomClicksWithNodeCount:100000];
+}
+
+@end
@@ -0,0 +1,23 @@
+//
+//  SyntheticSceneGenerator.h
+//  GameEditorTests
+//
+
+#import <Foundation/Foundation.h>
+#import <SpriteKit/SpriteKit.h>
+
+/*
+ Builds scenes for the benchmarks. The same settings always build the same scene, the nodes are
+ spread over the tree up to the maximum depth and pick their class from the node classes. Textured
+ nodes share textureCount textures, which are registered in the texture registry under their name
+ */
+@interface SyntheticSceneGenerator : NSObject
+- (SKScene *)scene;
+- (NSString *)nameOfTextureAtIndex:(NSUInteger)index;
+@property (assign) uint32_t seed;
+@property (assign) NSUInteger nodeCount;
+@property (assign) NSUInteger maximumDepth;
+@property (assign) NSUInteger textureCount;
+@property (assign) CGSize sceneSize;
+@property (copy) NSArray *nodeClasses;
+@end
@@ -0,0 +1,152 @@
+//
+//  SyntheticSceneGenerator.m
+//  GameEditorTests
+//
+
+#import "SyntheticSceneGenerator.h"
+#import "TextureRegistry.h"
+
+@implementation SyntheticSceneGenerator {
+	uint32_t _state;
+	NSMutableArray *_textures;
+}
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_seed = 1;
+		_nodeCount = 1000;
+		_maximumDepth = 6;
+		_textureCount = 16;
+		_sceneSize = CGSizeMake(4096, 4096);
+		_nodeClasses = @[[SKNode class], [SKSpriteNode class], [SKLabelNode class], [SKShapeNode class], [SKEmitterNode class]];
+	}
+	return self;
+}
+
+#pragma mark Random numbers
+
+- (uint32_t)nextRandom {
+	/* Deterministic LCG so that every run builds the same scene */
+	_state = _state * 1664525 + 1013904223;
+	return _state >> 8;
+}
+
+- (CGFloat)randomBetween:(CGFloat)min and:(CGFloat)max {
+	return min + (max - min) * [self nextRandom] / (CGFloat)(1 << 24);
+}
+
+- (NSUInteger)randomIndexWithCount:(NSUInteger)count {
+	return count ? [self nextRandom] % count : 0;
+}
+
+#pragma mark Textures
+
+- (NSString *)nameOfTextureAtIndex:(NSUInteger)index {
+	return [NSString stringWithFormat:@"synthetic-%lu.png", (unsigned long)index];
+}
+
+- (void)makeTextures {
+	/* The same texture objects are kept across scenes, the registry is emptied when the media library is reloaded */
+	static NSMutableDictionary *texturesByName = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		texturesByName = [NSMutableDictionary dictionary];
+	});
+
+	_textures = [NSMutableArray array];
+	TextureRegistry *registry = [TextureRegistry sharedRegistry];
+
+	for (NSUInteger i = 0; i < _textureCount; ++i) {
+		NSString *name = [self nameOfTextureAtIndex:i];
+		SKTexture *texture = texturesByName[name];
+
+		if (!texture) {
+			NSImage *image = [[NSImage alloc] initWithSize:NSMakeSize(32, 32)];
+			[image lockFocus];
+			[[NSColor colorWithCalibratedHue:(CGFloat)i / MAX(_textureCount, 1) saturation:1 brightness:1 alpha:1] set];
+			NSRectFill(NSMakeRect(4, 4, 24, 24));
+			[image unlockFocus];
+
+			texture = [SKTexture textureWithImage:image];
+			texturesByName[name] = texture;
+		}
+		[registry registerTexture:texture withName:name];
+		[_textures addObject:texture];
+	}
+}
+
+- (SKTexture *)randomTexture {
+	return _textures.count ? _textures[[self randomIndexWithCount:_textures.count]] : nil;
+}
+
+#pragma mark Nodes
+
+- (SKNode *)nodeWithClass:(Class)nodeClass {
+	SKNode *node = nil;
+
+	if (nodeClass == [SKSpriteNode class]) {
+		SKTexture *texture = [self randomTexture];
+		SKSpriteNode *sprite = texture ? [SKSpriteNode spriteNodeWithTexture:texture] : [SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeZero];
+		sprite.size = CGSizeMake([self randomBetween:8 and:128], [self randomBetween:8 and:128]);
+		sprite.anchorPoint = CGPointMake([self randomBetween:0 and:1], [self randomBetween:0 and:1]);
+		node = sprite;
+
+	} else if (nodeClass == [SKLabelNode class]) {
+		SKLabelNode *label = [SKLabelNode labelNodeWithText:[NSString stringWithFormat:@"Label %u", [self nextRandom] % 1000]];
+		label.fontSize = [self randomBetween:12 and:48];
+		node = label;
+
+	} else if (nodeClass == [SKShapeNode class]) {
+		CGRect rect = CGRectMake(0, 0, [self randomBetween:8 and:128], [self randomBetween:8 and:128]);
+		node = [SKShapeNode shapeNodeWithRect:rect];
+
+	} else if (nodeClass == [SKEmitterNode class]) {
+		SKEmitterNode *emitter = [[SKEmitterNode alloc] init];
+		emitter.particleTexture = [self randomTexture];
+		emitter.particleBirthRate = [self randomBetween:10 and:200];
+		emitter.particleLifetime = [self randomBetween:1 and:4];
+		emitter.particleSpeed = [self randomBetween:10 and:100];
+		emitter.emissionAngleRange = [self randomBetween:0 and:2 * M_PI];
+		node = emitter;
+
+	} else {
+		node = [[nodeClass alloc] init];
+	}
+
+	node.position = CGPointMake([self randomBetween:0 and:_sceneSize.width], [self randomBetween:0 and:_sceneSize.height]);
+	node.zRotation = [self randomBetween:0 and:2 * M_PI];
+	node.xScale = [self randomBetween:0.5 and:1.5];
+	node.yScale = [self randomBetween:0.5 and:1.5];
+	return node;
+}
+
+- (SKScene *)scene {
+	_state = _seed;
+	[self makeTextures];
+
+	SKScene *scene = [SKScene sceneWithSize:_sceneSize];
+	scene.name = @"Synthetic scene";
+
+	/* Nodes that can still take children, along with their depth */
+	NSMutableArray *parents = [NSMutableArray arrayWithObject:scene];
+	NSMutableArray *depths = [NSMutableArray arrayWithObject:@0];
+
+	for (NSUInteger i = 0; i < _nodeCount; ++i) {
+		NSUInteger parentIndex = [self randomIndexWithCount:parents.count];
+		SKNode *parent = parents[parentIndex];
+		NSUInteger depth = [depths[parentIndex] unsignedIntegerValue] + 1;
+
+		SKNode *node = [self nodeWithClass:_nodeClasses[[self randomIndexWithCount:_nodeClasses.count]]];
+		node.name = [NSString stringWithFormat:@"%@ %lu", [node class], (unsigned long)i];
+		[parent addChild:node];
+
+		if (depth < _maximumDepth) {
+			[parents addObject:node];
+			[depths addObject:@(depth)];
+		}
+	}
+
+	return scene;
+}
+
+@end
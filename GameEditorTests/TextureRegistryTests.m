@@ -0,0 +1,152 @@
+//
+//  TextureRegistryTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "TextureRegistry.h"
+#import "ValueTransformers.h"
+
+@interface TextureRegistryTests : XCTestCase
+
+@end
+
+@implementation TextureRegistryTests {
+	TextureRegistry *_registry;
+	NSString *_imagePath;
+}
+
+- (void)setUp {
+	[super setUp];
+	_registry = [TextureRegistry new];
+	_imagePath = [[NSBundle bundleForClass:NSClassFromString(@"AppDelegate")] pathForResource:@"Spaceship" ofType:@"png"];
+	XCTAssertNotNil(_imagePath);
+}
+
+- (void)tearDown {
+	[[TextureRegistry sharedRegistry] removeAllTextures];
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (SKScene *)sceneWithSpriteCount:(NSUInteger)count {
+	SKScene *scene = [SKScene sceneWithSize:CGSizeMake(1024, 768)];
+	for (NSUInteger i = 0; i < count; ++i) {
+		/* Every sprite gets its own texture object, like the ones decoded from a scene */
+		SKSpriteNode *sprite = [SKSpriteNode spriteNodeWithTexture:[SKTexture textureWithImageNamed:@"Spaceship"]];
+		[scene addChild:sprite];
+	}
+	return scene;
+}
+
+#pragma mark Tests
+
+- (void)testTexturesAreSharedByName {
+	SKTexture *texture = [_registry textureNamed:@"Spaceship"];
+	XCTAssertNotNil(texture);
+	XCTAssertEqual([_registry textureNamed:@"Spaceship"], texture);
+	XCTAssertEqualObjects([_registry nameOfTexture:texture], @"Spaceship");
+	XCTAssertEqual(_registry.residentTextureCount, 1);
+	XCTAssertGreaterThan(_registry.residentTextureBytes, 0);
+}
+
+- (void)testTexturesWithoutANameInTheirDescriptionAreNamedOnRegistration {
+	SKTexture *texture = [SKTexture textureWithImage:[[NSImage alloc] initWithContentsOfFile:_imagePath]];
+	[_registry registerTexture:texture withName:@"Spaceship"];
+	XCTAssertEqualObjects([_registry nameOfTexture:texture], @"Spaceship");
+
+	SKTexture *reloaded = [_registry reloadTextureNamed:@"Spaceship" withContentsOfFile:_imagePath];
+	XCTAssertNotEqual(reloaded, texture);
+	XCTAssertEqual([_registry textureNamed:@"Spaceship"], reloaded);
+	XCTAssertEqualObjects([_registry nameOfTexture:reloaded], @"Spaceship");
+}
+
+- (void)testReloadingKeepsTheFilteringMode {
+	SKTexture *texture = [_registry textureNamed:@"Spaceship"];
+	texture.filteringMode = SKTextureFilteringNearest;
+
+	SKTexture *reloaded = [_registry reloadTextureNamed:@"Spaceship" withContentsOfFile:_imagePath];
+	XCTAssertEqual(reloaded.filteringMode, SKTextureFilteringNearest);
+}
+
+- (void)testSharingTexturesInAScene {
+	SKScene *scene = [self sceneWithSpriteCount:100];
+	[_registry shareTexturesInNode:scene];
+
+	SKTexture *texture = [scene.children.firstObject texture];
+	for (SKSpriteNode *sprite in scene.children) {
+		XCTAssertEqual(sprite.texture, texture);
+	}
+	XCTAssertEqual(_registry.residentTextureCount, 1);
+}
+
+- (void)testTransformerUsesTheSharedRegistry {
+	NSValueTransformer *transformer = [TextureTransformer transformer];
+	SKTexture *texture = [transformer reverseTransformedValue:@"Spaceship"];
+	XCTAssertEqual([transformer reverseTransformedValue:@"Spaceship"], texture);
+	XCTAssertEqualObjects([transformer transformedValue:texture], @"Spaceship");
+}
+
+- (void)testPreloadingPacksTheImages {
+	XCTestExpectation *expectation = [self expectationWithDescription:@"preload"];
+	[_registry preloadTexturesWithFiles:@{@"Spaceship": _imagePath} packIntoAtlas:YES completionHandler:^{
+		[expectation fulfill];
+	}];
+	[self waitForExpectationsWithTimeout:30 handler:nil];
+
+	SKTexture *texture = [_registry textureNamed:@"Spaceship"];
+	XCTAssertEqualObjects([_registry nameOfTexture:texture], @"Spaceship");
+	XCTAssertEqual(_registry.residentTextureCount, 1);
+}
+
+- (void)testPreloadedTexturesAreSharedFromThenOn {
+	SKScene *scene = [self sceneWithSpriteCount:10];
+	[_registry shareTexturesInNode:scene];
+	SKTexture *oldTexture = [scene.children.firstObject texture];
+
+	XCTestExpectation *expectation = [self expectationWithDescription:@"preload"];
+	[_registry preloadTexturesWithFiles:@{@"Spaceship": _imagePath} packIntoAtlas:YES completionHandler:^{
+		[expectation fulfill];
+	}];
+	[self waitForExpectationsWithTimeout:30 handler:nil];
+
+	/* The scenes opened afterwards use the preloaded texture, the one already showing keeps its texture */
+	SKScene *newScene = [self sceneWithSpriteCount:10];
+	[_registry shareTexturesInNode:newScene];
+	SKTexture *preloadedTexture = [_registry textureNamed:@"Spaceship"];
+	XCTAssertNotEqual(preloadedTexture, oldTexture);
+	for (SKSpriteNode *sprite in newScene.children) {
+		XCTAssertEqual(sprite.texture, preloadedTexture);
+	}
+	XCTAssertEqual([scene.children.firstObject texture], oldTexture);
+}
+
+- (void)testPreloadsOutlivingAResetAreDropped {
+	XCTestExpectation *expectation = [self expectationWithDescription:@"preload"];
+	[_registry preloadTexturesWithFiles:@{@"Spaceship": _imagePath} packIntoAtlas:YES completionHandler:^{
+		[expectation fulfill];
+	}];
+	[_registry removeAllTextures];
+	[self waitForExpectationsWithTimeout:30 handler:nil];
+
+	XCTAssertEqual(_registry.residentTextureCount, 0);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceNameLookup {
+	SKScene *scene = [self sceneWithSpriteCount:1000];
+	[_registry shareTexturesInNode:scene];
+	NSValueTransformer *transformer = [TextureTransformer transformer];
+
+	[self measureBlock:^{
+		for (SKSpriteNode *sprite in scene.children) {
+			XCTAssertNotNil([transformer transformedValue:sprite.texture]);
+		}
+	}];
+}
+
+@end
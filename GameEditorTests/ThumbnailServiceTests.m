@@ -0,0 +1,160 @@
+//
+//  ThumbnailServiceTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import "ThumbnailService.h"
+
+@interface ThumbnailServiceTests : XCTestCase
+
+@end
+
+@implementation ThumbnailServiceTests {
+	NSString *_temporaryDirectory;
+}
+
+- (void)setUp {
+	[super setUp];
+	_temporaryDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+	[[NSFileManager defaultManager] createDirectoryAtPath:_temporaryDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:_temporaryDirectory error:NULL];
+	[super tearDown];
+}
+
+#pragma mark Helpers
+
+- (NSString *)writeImageNamed:(NSString *)name width:(size_t)width height:(size_t)height {
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+	CGColorSpaceRelease(colorSpace);
+
+	/* Some noise keeps the encoder from compressing the image to nothing */
+	uint32_t *pixels = CGBitmapContextGetData(context);
+	size_t pixelsPerRow = CGBitmapContextGetBytesPerRow(context) / 4;
+	uint32_t seed = (uint32_t)name.hash;
+	for (size_t i = 0; i < pixelsPerRow * height; ++i) {
+		seed = seed * 1664525 + 1013904223;
+		pixels[i] = seed | 0xff000000;
+	}
+
+	CGImageRef image = CGBitmapContextCreateImage(context);
+	CGContextRelease(context);
+
+	NSString *file = [_temporaryDirectory stringByAppendingPathComponent:name];
+	CGImageDestinationRef destination = CGImageDestinationCreateWithURL((CFURLRef)[NSURL fileURLWithPath:file], kUTTypePNG, 1, NULL);
+	CGImageDestinationAddImage(destination, image, NULL);
+	CGImageDestinationFinalize(destination);
+	CFRelease(destination);
+	CGImageRelease(image);
+
+	return file;
+}
+
+- (NSArray *)writeImagesWithCount:(NSUInteger)count size:(size_t)size {
+	NSMutableArray *files = [NSMutableArray array];
+	for (NSUInteger i = 0; i < count; ++i) {
+		[files addObject:[self writeImageNamed:[NSString stringWithFormat:@"texture%lu.png", (unsigned long)i] width:size height:size]];
+	}
+	return files;
+}
+
+- (ThumbnailService *)serviceWithCacheName:(NSString *)name {
+	NSString *cacheDirectory = [_temporaryDirectory stringByAppendingPathComponent:name];
+	return [[ThumbnailService alloc] initWithCacheDirectory:cacheDirectory thumbnailSize:48.0];
+}
+
+- (NSUInteger)loadThumbnailsOfFiles:(NSArray *)files withService:(ThumbnailService *)service {
+	__block NSUInteger count = 0;
+	XCTestExpectation *expectation = [self expectationWithDescription:@"thumbnails"];
+	[service loadThumbnailsOfFiles:files resultHandler:^(NSUInteger index, NSImage *thumbnail) {
+		if (thumbnail) {
+			count++;
+		}
+	} completionHandler:^{
+		[expectation fulfill];
+	}];
+	[self waitForExpectationsWithTimeout:120 handler:nil];
+	return count;
+}
+
+#pragma mark Tests
+
+- (void)testLibraryNames {
+	XCTAssertEqualObjects([ThumbnailService libraryNameOfFile:@"/a/Spaceship.png"], @"Spaceship");
+	XCTAssertEqualObjects([ThumbnailService libraryNameOfFile:@"/a/Spaceship~ipad.png"], @"Spaceship");
+	XCTAssertEqualObjects([ThumbnailService libraryNameOfFile:@"/a/Spaceship@2x~iphone.png"], @"Spaceship@2x");
+	XCTAssertTrue([ThumbnailService isImageFile:@"spark.png"]);
+	XCTAssertFalse([ThumbnailService isImageFile:@"Shader1.fsh"]);
+	XCTAssertFalse([ThumbnailService isImageFile:@"README"]);
+}
+
+- (void)testThumbnailKeepsTheAspectRatio {
+	ThumbnailService *service = [self serviceWithCacheName:@"Cache"];
+
+	NSImage *wide = [service thumbnailOfFile:[self writeImageNamed:@"wide.png" width:1024 height:256]];
+	XCTAssertEqualWithAccuracy(wide.size.width, 48.0, 0.5);
+	XCTAssertEqualWithAccuracy(wide.size.height, 12.0, 0.5);
+
+	/* Images smaller than the thumbnail aren't scaled up */
+	NSImage *small = [service thumbnailOfFile:[self writeImageNamed:@"small.png" width:16 height:16]];
+	XCTAssertEqualWithAccuracy(small.size.width, 16.0, 0.5);
+}
+
+- (void)testCachedThumbnailsAreInvalidatedWhenTheFileChanges {
+	ThumbnailService *service = [self serviceWithCacheName:@"Cache"];
+	NSString *file = [self writeImageNamed:@"texture.png" width:256 height:256];
+
+	XCTAssertNotNil([service thumbnailOfFile:file]);
+	NSArray *cachedFiles = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:service.cacheDirectory error:NULL];
+	XCTAssertEqual(cachedFiles.count, 1);
+
+	/* A new service finds the thumbnail on disk */
+	ThumbnailService *reopenedService = [self serviceWithCacheName:@"Cache"];
+	XCTAssertNotNil([reopenedService thumbnailOfFile:file]);
+	XCTAssertEqual([[NSFileManager defaultManager] contentsOfDirectoryAtPath:service.cacheDirectory error:NULL].count, 1);
+
+	/* Replacing the image changes its size and modification time */
+	[self writeImageNamed:@"texture.png" width:512 height:128];
+	NSImage *thumbnail = [reopenedService thumbnailOfFile:file];
+	XCTAssertEqualWithAccuracy(thumbnail.size.height, 12.0, 0.5);
+	XCTAssertEqual([[NSFileManager defaultManager] contentsOfDirectoryAtPath:service.cacheDirectory error:NULL].count, 2);
+}
+
+- (void)testUndecodableFilesHaveNoThumbnail {
+	ThumbnailService *service = [self serviceWithCacheName:@"Cache"];
+	NSString *file = [_temporaryDirectory stringByAppendingPathComponent:@"broken.png"];
+	[[@"not an image" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:file atomically:YES];
+
+	XCTAssertEqual([self loadThumbnailsOfFiles:@[file] withService:service], 0);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceColdThumbnails {
+	NSArray *files = [self writeImagesWithCount:64 size:2048];
+	__block NSUInteger run = 0;
+
+	[self measureBlock:^{
+		/* Every run starts with an empty cache */
+		ThumbnailService *service = [self serviceWithCacheName:[NSString stringWithFormat:@"Cold%lu", (unsigned long)run++]];
+		XCTAssertEqual([self loadThumbnailsOfFiles:files withService:service], files.count);
+	}];
+}
+
+- (void)testPerformanceCachedThumbnails {
+	NSArray *files = [self writeImagesWithCount:64 size:2048];
+	[self loadThumbnailsOfFiles:files withService:[self serviceWithCacheName:@"Warm"]];
+
+	[self measureBlock:^{
+		/* A new service has nothing in memory, like reopening the editor */
+		ThumbnailService *service = [self serviceWithCacheName:@"Warm"];
+		XCTAssertEqual([self loadThumbnailsOfFiles:files withService:service], files.count);
+	}];
+}
+
+@end
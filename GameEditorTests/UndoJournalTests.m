@@ -0,0 +1,220 @@
+//
+//  UndoJournalTests.m
+//  GameEditorTests
+//
+
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+#import <SpriteKit/SpriteKit.h>
+#import "UndoJournal.h"
+
+static const NSUInteger kNodeCount = 100;
+static const NSUInteger kEditSteps = 100000;
+
+@interface UndoJournalTests : XCTestCase
+
+@end
+
+@implementation UndoJournalTests {
+	NSArray *_nodes;
+}
+
+- (void)setUp {
+	[super setUp];
+	NSMutableArray *nodes = [NSMutableArray arrayWithCapacity:kNodeCount];
+	for (NSUInteger i = 0; i < kNodeCount; ++i) {
+		[nodes addObject:[SKSpriteNode spriteNodeWithColor:[NSColor redColor] size:CGSizeMake(10, 10)]];
+	}
+	_nodes = nodes;
+}
+
+#pragma mark Helpers
+
+- (void)moveNode:(SKNode *)node to:(CGPoint)position inJournal:(UndoJournal *)journal {
+	[journal recordNode:node property:UndoJournalPropertyPosition
+			   oldValue:[UndoJournal valueOfProperty:UndoJournalPropertyPosition ofNode:node]
+			   newValue:(UndoJournalValue){position.x, position.y}];
+	node.position = position;
+}
+
+#pragma mark Tests
+
+- (void)testGestureIsMergedIntoOneGroup {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	SKNode *node = _nodes[0];
+
+	[journal beginGroup];
+	for (NSUInteger step = 1; step <= 50; ++step) {
+		[self moveNode:node to:CGPointMake(step, 2 * step) inJournal:journal];
+	}
+	NSInteger group = [journal endGroup];
+
+	XCTAssertNotEqual(group, NSNotFound);
+	XCTAssertEqual(journal.groupCount, 1);
+	XCTAssertEqual(journal.recordCount, 1);
+
+	XCTAssertEqualObjects([journal revertGroup:group], @[node]);
+	XCTAssertTrue(CGPointEqualToPoint(node.position, CGPointZero));
+	[journal reapplyGroup:group];
+	XCTAssertTrue(CGPointEqualToPoint(node.position, CGPointMake(50, 100)));
+}
+
+- (void)testGroupUndoesSeveralNodes {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+
+	[journal beginGroup];
+	for (SKSpriteNode *node in _nodes) {
+		[self moveNode:node to:CGPointMake(5, 5) inJournal:journal];
+		[journal recordNode:node property:UndoJournalPropertyZRotation oldValue:(UndoJournalValue){node.zRotation, 0} newValue:(UndoJournalValue){1.0, 0}];
+		node.zRotation = 1.0;
+		[journal recordNode:node property:UndoJournalPropertySize oldValue:[UndoJournal valueOfProperty:UndoJournalPropertySize ofNode:node] newValue:(UndoJournalValue){20, 30}];
+		node.size = CGSizeMake(20, 30);
+	}
+	NSInteger group = [journal endGroup];
+
+	XCTAssertEqual([journal revertGroup:group].count, kNodeCount);
+	for (SKSpriteNode *node in _nodes) {
+		XCTAssertTrue(CGPointEqualToPoint(node.position, CGPointZero));
+		XCTAssertEqual(node.zRotation, 0);
+		XCTAssertTrue(CGSizeEqualToSize(node.size, CGSizeMake(10, 10)));
+	}
+}
+
+- (void)testUnchangedGroupIsDropped {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	SKNode *node = _nodes[0];
+
+	[journal beginGroup];
+	[self moveNode:node to:CGPointMake(10, 10) inJournal:journal];
+	[self moveNode:node to:CGPointZero inJournal:journal];
+
+	XCTAssertEqual([journal endGroup], NSNotFound);
+	XCTAssertEqual(journal.groupCount, 0);
+	XCTAssertEqual(journal.recordCount, 0);
+}
+
+- (void)testMemoryLimitDropsOldestGroups {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	journal.memoryLimit = 4096;
+
+	NSInteger firstGroup = NSNotFound;
+	NSInteger lastGroup = NSNotFound;
+	for (NSUInteger step = 1; step <= 1000; ++step) {
+		[journal beginGroup];
+		[self moveNode:_nodes[step % kNodeCount] to:CGPointMake(step, step) inJournal:journal];
+		lastGroup = [journal endGroup];
+		if (firstGroup == NSNotFound)
+			firstGroup = lastGroup;
+	}
+
+	XCTAssertLessThanOrEqual(journal.memoryUsage, 4096);
+	XCTAssertNil([journal revertGroup:firstGroup]);
+	XCTAssertNotNil([journal revertGroup:lastGroup]);
+}
+
+- (void)testMemoryLimitDropsTheNodesOfDroppedGroups {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	journal.memoryLimit = 4096;
+
+	/* Every group edits a node of its own */
+	NSMutableArray *nodes = [NSMutableArray array];
+	NSInteger lastGroup = NSNotFound;
+	for (NSUInteger step = 1; step <= 1000; ++step) {
+		SKNode *node = [SKNode node];
+		[nodes addObject:node];
+		[journal beginGroup];
+		[self moveNode:node to:CGPointMake(step, step) inJournal:journal];
+		[self moveNode:_nodes[0] to:CGPointMake(step, step) inJournal:journal];
+		lastGroup = [journal endGroup];
+	}
+
+	XCTAssertLessThanOrEqual(journal.memoryUsage, 4096);
+
+	/* The remaining records still point to their nodes */
+	NSArray *reverted = [journal revertGroup:lastGroup];
+	XCTAssertEqualObjects(reverted, (@[nodes.lastObject, _nodes[0]]));
+	XCTAssertTrue(CGPointEqualToPoint([nodes.lastObject position], CGPointZero));
+	XCTAssertTrue(CGPointEqualToPoint([_nodes[0] position], CGPointMake(999, 999)));
+}
+
+- (void)testKeyPathChangesAreMergedAndUndone {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	SKSpriteNode *node = _nodes[0];
+
+	[journal beginGroup];
+	[self moveNode:node to:CGPointMake(5, 5) inJournal:journal];
+	[journal recordObject:node keyPath:@"name" oldValue:nil newValue:@"First"];
+	[journal recordObject:node keyPath:@"name" oldValue:@"First" newValue:@"Second"];
+	[journal recordObject:node keyPath:@"alpha" oldValue:@1.0 newValue:@0.5];
+	node.name = @"Second";
+	node.alpha = 0.5;
+	NSInteger group = [journal endGroup];
+	XCTAssertEqual(journal.recordCount, 3);
+
+	XCTAssertEqualObjects([journal revertGroup:group], @[node]);
+	XCTAssertNil(node.name);
+	XCTAssertEqual(node.alpha, 1.0);
+	XCTAssertTrue(CGPointEqualToPoint(node.position, CGPointZero));
+
+	[journal reapplyGroup:group];
+	XCTAssertEqualObjects(node.name, @"Second");
+	XCTAssertEqual(node.alpha, 0.5);
+}
+
+- (void)testNodesAreNotRetained {
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	__weak SKNode *weakNode = nil;
+	NSInteger group;
+	@autoreleasepool {
+		SKNode *node = [SKNode node];
+		weakNode = node;
+		[self moveNode:node to:CGPointMake(5, 5) inJournal:journal];
+		[journal recordObject:node keyPath:@"name" oldValue:nil newValue:@"Node"];
+		group = journal.groupCount - 1;
+	}
+
+	/* The records of the node that went away are skipped */
+	XCTAssertNil(weakNode);
+	XCTAssertEqualObjects([journal revertGroup:group], @[]);
+}
+
+#pragma mark Benchmarks
+
+- (void)testPerformanceEditSteps {
+	/* Each gesture drags a node over a hundred steps */
+	__block UndoJournal *journal = nil;
+	[self measureBlock:^{
+		journal = [[UndoJournal alloc] init];
+		journal.memoryLimit = NSUIntegerMax;
+		for (NSUInteger step = 0; step < kEditSteps; ++step) {
+			if (step % 100 == 0)
+				[journal beginGroup];
+			[self moveNode:_nodes[(step / 100) % kNodeCount] to:CGPointMake(step, step) inJournal:journal];
+			if (step % 100 == 99)
+				[journal endGroup];
+		}
+	}];
+	NSLog(@"%lu gestures, %lu records, %lu bytes", (unsigned long)journal.groupCount, (unsigned long)journal.recordCount, (unsigned long)journal.memoryUsage);
+}
+
+- (void)testPerformanceReplay {
+	/* Every step is a separate group, the worst case for memory and replay */
+	UndoJournal *journal = [[UndoJournal alloc] init];
+	journal.memoryLimit = NSUIntegerMax;
+	for (NSUInteger step = 0; step < kEditSteps; ++step) {
+		[self moveNode:_nodes[step % kNodeCount] to:CGPointMake(step + 1, step + 1) inJournal:journal];
+	}
+	NSLog(@"%lu groups, %lu bytes", (unsigned long)journal.groupCount, (unsigned long)journal.memoryUsage);
+	XCTAssertEqual(journal.groupCount, kEditSteps);
+
+	[self measureBlock:^{
+		for (NSInteger group = kEditSteps; group-- > 0;) {
+			[journal revertGroup:group];
+		}
+		for (NSInteger group = 0; group < kEditSteps; ++group) {
+			[journal reapplyGroup:group];
+		}
+	}];
+}
+
+@end